@@ -0,0 +1,428 @@
+#include "PCH.hpp"
+#include "BenchmarkRunner.hpp"
+
+#include "Common/FS.hpp"
+#include "Common/Logger.hpp"
+#include "Common/Window.hpp"
+#include "Math/Interpolation/LinearInterpolator.hpp"
+#include "Renderer/HighLevel/Renderer.hpp"
+#include "Scene/Camera.hpp"
+
+#include "ResourceDir.hpp"
+
+
+namespace ABench {
+namespace Benchmark {
+
+namespace {
+
+const float FRAME_TIME_STEP = 1.0f / 60.0f; // scene animation step, in seconds
+
+const float LIGHT_AREA_X = 30.0f;
+const float LIGHT_AREA_Y = 0.0f;
+const float LIGHT_AREA_Z = 15.0f;
+const float LIGHT_RANGE = 1.5f;
+
+const float EMITTER_SPACING = 6.0f;
+const float EMITTER_HEIGHT = 10.0f;
+const float EMITTER_LIFE_TIME = 4.0f;
+
+std::string EscapeJSON(const std::string& str)
+{
+    std::string result;
+    for (char c: str)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+
+    return result;
+}
+
+void WriteStatistics(std::ostream& out, const Math::Statistics& stats)
+{
+    out << "{\"samples\":" << stats.count
+        << ",\"mean\":" << stats.mean
+        << ",\"median\":" << stats.median
+        << ",\"p99\":" << stats.p99
+        << ",\"min\":" << stats.min
+        << ",\"max\":" << stats.max
+        << ",\"stddev\":" << stats.stdDev
+        << ",\"ci95\":[" << stats.ciLow << "," << stats.ciHigh << "]}";
+}
+
+void WriteMemoryStatistics(std::ostream& out, const BenchmarkResult& result)
+{
+    const Renderer::MemoryStatisticsSnapshot& m = result.memory;
+
+    out << "{\"bytes\":" << m.bytes << ",\"allocations\":" << m.allocations
+        << ",\"objects\":{\"buffers\":" << m.objects[static_cast<size_t>(Renderer::TrackedObject::Buffer)]
+        << ",\"images\":" << m.objects[static_cast<size_t>(Renderer::TrackedObject::Image)]
+        << ",\"descriptorPools\":" << m.objects[static_cast<size_t>(Renderer::TrackedObject::DescriptorPool)]
+        << ",\"descriptorSets\":" << m.objects[static_cast<size_t>(Renderer::TrackedObject::DescriptorSet)] << "}";
+
+    out << ",\n  \"heaps\":[";
+    for (size_t i = 0; i < m.heaps.size(); ++i)
+    {
+        const Renderer::MemoryHeapStatistics& h = m.heaps[i];
+        out << ((i > 0) ? "," : "") << "{\"flags\":" << h.flags << ",\"size\":" << h.size << ",\"bytes\":" << h.bytes;
+        if (m.budgetAvailable)
+            out << ",\"budget\":" << h.budget << ",\"usage\":" << h.usage;
+        out << "}";
+    }
+
+    // types never used during the run would only clutter the output
+    out << "],\n  \"types\":[";
+    bool first = true;
+    for (size_t i = 0; i < m.types.size(); ++i)
+    {
+        const Renderer::MemoryTypeStatistics& t = m.types[i];
+        if (t.peakBytes == 0)
+            continue;
+
+        out << (first ? "" : ",") << "{\"index\":" << i << ",\"flags\":" << t.flags << ",\"heap\":" << t.heapIndex
+            << ",\"allocations\":" << t.allocations << ",\"bytes\":" << t.bytes << ",\"peak\":" << t.peakBytes << "}";
+        first = false;
+    }
+
+    out << "],\n  \"owners\":{";
+    for (size_t i = 0; i < m.owners.size(); ++i)
+    {
+        const Renderer::MemoryOwnerStatistics& o = m.owners[i];
+        out << ((i > 0) ? "," : "") << "\"" << EscapeJSON(o.name) << "\":{\"allocations\":" << o.allocations
+            << ",\"bytes\":" << o.bytes << ",\"peak\":" << o.peakBytes << "}";
+    }
+
+    out << "},\n  \"ringBuffers\":{";
+    for (size_t i = 0; i < m.ringBuffers.size(); ++i)
+    {
+        const Renderer::RingBufferStatistics& r = m.ringBuffers[i];
+        out << ((i > 0) ? "," : "") << "\"" << EscapeJSON(r.name) << "\":{\"size\":" << r.size
+            << ",\"highWater\":" << r.highWaterBytes << ",\"perFrame\":[";
+        for (size_t f = 0; f < result.memoryFrames.size(); ++f)
+        {
+            const BenchmarkMemoryFrame& frame = result.memoryFrames[f];
+            out << ((f > 0) ? "," : "") << ((i < frame.ringBufferBytes.size()) ? frame.ringBufferBytes[i] : 0);
+        }
+        out << "]}";
+    }
+
+    out << "},\n  \"perFrame\":{\"bytes\":[";
+    for (size_t f = 0; f < result.memoryFrames.size(); ++f)
+        out << ((f > 0) ? "," : "") << result.memoryFrames[f].bytes;
+    out << "],\"allocations\":[";
+    for (size_t f = 0; f < result.memoryFrames.size(); ++f)
+        out << ((f > 0) ? "," : "") << result.memoryFrames[f].allocations;
+    out << "],\"culledLights\":[";
+    for (size_t f = 0; f < result.memoryFrames.size(); ++f)
+        out << ((f > 0) ? "," : "") << result.memoryFrames[f].culledLights;
+    out << "]}}";
+}
+
+} // namespace
+
+BenchmarkRunner::BenchmarkRunner()
+    : mScenarioName()
+    , mResults()
+{
+}
+
+BenchmarkRunner::~BenchmarkRunner()
+{
+}
+
+bool BenchmarkRunner::BuildScene(const ScenarioRun& run, Scene::Scene& scene)
+{
+    if (!scene.Init(Common::FS::JoinPaths(ResourceDir::SCENES, run.scene)))
+        return false;
+
+    Scene::Light* mainLight = dynamic_cast<Scene::Light*>(scene.GetComponent(Scene::ComponentType::Light, "light").first);
+    mainLight->SetDiffuseIntensity(Math::Vector4(1.0f, 1.0f, 1.0f, 1.0f));
+    mainLight->SetPosition(3.0f, 5.0f, 0.0f);
+    scene.CreateObject()->SetComponent(mainLight);
+
+    // same placement as in interactive mode, so results of both can be compared
+    std::mt19937 randomGen(run.seed);
+    for (uint32_t i = 0; i < run.lights; ++i)
+    {
+        auto lres = scene.GetComponent(Scene::ComponentType::Light, "light" + std::to_string(i));
+        Scene::Light* light = dynamic_cast<Scene::Light*>(lres.first);
+
+        float colorX = static_cast<float>(randomGen()) / static_cast<float>(randomGen.max());
+        float colorY = static_cast<float>(randomGen()) / static_cast<float>(randomGen.max());
+        float colorZ = static_cast<float>(randomGen()) / static_cast<float>(randomGen.max());
+        light->SetDiffuseIntensity(Math::Vector4(colorX, colorY, colorZ, 1.0f));
+        light->SetPosition(colorX * LIGHT_AREA_X - (LIGHT_AREA_X / 2.0f),
+                           colorY * LIGHT_AREA_Y - (LIGHT_AREA_Y / 2.0f) + 0.5f,
+                           colorZ * LIGHT_AREA_Z - (LIGHT_AREA_Z / 2.0f));
+        light->SetRange(LIGHT_RANGE);
+
+        scene.CreateObject()->SetComponent(light);
+    }
+
+    // emitters are lined up along X axis, centered at the origin
+    for (uint32_t i = 0; i < run.emitters; ++i)
+    {
+        auto eres = scene.GetComponent(Scene::ComponentType::Emitter, "emitter" + std::to_string(i));
+        Scene::Emitter* emitter = dynamic_cast<Scene::Emitter*>(eres.first);
+
+        float offset = static_cast<float>(i) - static_cast<float>(run.emitters - 1) * 0.5f;
+        emitter->SetParticleLimit(run.particles);
+        emitter->SetSpawnPeriod(EMITTER_LIFE_TIME / static_cast<float>(run.particles));
+        emitter->SetLifeTime(EMITTER_LIFE_TIME);
+        emitter->SetPosition(Math::Vector4(offset * EMITTER_SPACING, EMITTER_HEIGHT, -0.25f, 1.0f));
+
+        scene.CreateObject()->SetComponent(emitter);
+    }
+
+    return true;
+}
+
+bool BenchmarkRunner::Execute(const ScenarioRun& run, BenchmarkResult& result)
+{
+    // declaration order matters - Scene resources have to be freed before the Renderer
+    Common::Window window;
+    if (run.headless)
+    {
+        if (!window.OpenHeadless(run.width, run.height))
+            return false;
+    }
+    else
+    {
+        if (!window.Init() || !window.Open(200, 200, run.width, run.height, "ABench - " + run.name))
+            return false;
+    }
+
+    bool debug = false;
+#ifdef _DEBUG
+    debug = true;
+#endif
+
+    Renderer::Renderer renderer;
+    Renderer::RendererDesc rendDesc;
+    rendDesc.debugEnable = debug;
+    rendDesc.debugVerbose = false;
+    rendDesc.noAsync = !run.async;
+    rendDesc.validateShaders = debug;
+    rendDesc.profile = true;
+    rendDesc.profileSamples = true;
+    rendDesc.headless = run.headless;
+    rendDesc.readbackInterval = 0;
+    rendDesc.readbackPrefix = std::string();
+    rendDesc.backbufferCount = run.framesInFlight;
+    rendDesc.fov = 60.0f;
+    rendDesc.nearZ = 0.2f;
+    rendDesc.farZ = 500.0f;
+    rendDesc.recordingThreads = run.recordingThreads;
+    rendDesc.lightCulling = run.lightCulling;
+    rendDesc.gpuCulling = run.gpuCulling;
+    rendDesc.occlusionCulling = run.occlusion;
+    rendDesc.lightBVH = run.lightBVH;
+    rendDesc.window = &window;
+    if (!renderer.Init(rendDesc))
+        return false;
+
+    Scene::Scene scene;
+    {
+        Renderer::MemoryOwnerScope owner(renderer.GetMemoryStatistics(), "Scene");
+        if (!BuildScene(run, scene))
+            return false;
+    }
+
+    Math::LinearInterpolator posTracker;
+    Math::LinearInterpolator atTracker;
+    for (auto& k: run.cameraPath)
+    {
+        posTracker.Add(k.pos);
+        atTracker.Add(k.at);
+    }
+
+    // whole path is covered by measured frames, warm-up frames stay at its beginning
+    float pathStep = static_cast<float>(run.cameraPath.size() - 1) / static_cast<float>(run.measuredFrames);
+
+    Scene::Camera camera;
+    Scene::CameraDesc cameraDesc;
+    cameraDesc.up = Math::Vector4(0.0f,-1.0f, 0.0f, 0.0f); // to comply with Vulkan's coord system
+
+    Renderer::GpuProfiler& profiler = renderer.GetProfiler();
+    Renderer::MemoryStatistics& memory = renderer.GetMemoryStatistics();
+    std::vector<double> pipelineBinds;
+    std::vector<double> descriptorSetBinds;
+    std::vector<double> vertexBufferBinds;
+    std::vector<double> indexBufferBinds;
+    std::vector<double> elidedBinds;
+    uint32_t totalFrames = run.warmupFrames + run.measuredFrames;
+    for (uint32_t frame = 0; frame < totalFrames; ++frame)
+    {
+        if (frame == run.warmupFrames)
+            profiler.ResetStatistics();
+
+        window.Update(FRAME_TIME_STEP);
+        if (!window.IsOpen())
+        {
+            LOGW("Window of " << run.name << " was closed before the run finished");
+            renderer.WaitForAll();
+            return false;
+        }
+
+        float pathMoment = (frame < run.warmupFrames) ? 0.0f : (frame - run.warmupFrames) * pathStep;
+        cameraDesc.pos = Math::Vector4(posTracker.Interpolate(pathMoment), 1.0f);
+        cameraDesc.at = Math::Vector4(atTracker.Interpolate(pathMoment), 1.0f);
+        camera.Update(cameraDesc);
+
+        renderer.Draw(scene, camera, FRAME_TIME_STEP);
+
+        if (frame >= run.warmupFrames)
+        {
+            // budget query goes to the driver, it is done only once after the last frame
+            Renderer::MemoryStatisticsSnapshot snapshot = memory.Capture(false);
+
+            BenchmarkMemoryFrame memoryFrame;
+            memoryFrame.bytes = snapshot.bytes;
+            memoryFrame.allocations = snapshot.allocations;
+            memoryFrame.culledLights = renderer.GetCulledLightCount();
+            for (auto& r: snapshot.ringBuffers)
+                memoryFrame.ringBufferBytes.push_back(r.lastFrameBytes);
+            result.memoryFrames.push_back(memoryFrame);
+
+            const Renderer::CommandBufferStats& binds = renderer.GetForwardPassStats();
+            pipelineBinds.push_back(static_cast<double>(binds.pipelineBinds));
+            descriptorSetBinds.push_back(static_cast<double>(binds.descriptorSetBinds));
+            vertexBufferBinds.push_back(static_cast<double>(binds.vertexBufferBinds));
+            indexBufferBinds.push_back(static_cast<double>(binds.indexBufferBinds));
+            elidedBinds.push_back(static_cast<double>(binds.GetElided()));
+        }
+    }
+
+    renderer.WaitForAll();
+    profiler.Flush();
+    result.memory = memory.Capture();
+
+    // frame time is measured between consecutive frames, so the last frame has no sample
+    result.frame = Math::CalculateStatistics(profiler.GetFrameSamples());
+    for (Renderer::GpuProfilerScope s = 0; s < profiler.GetScopeCount(); ++s)
+    {
+        BenchmarkStage stage;
+        stage.name = profiler.GetScopeName(s);
+        stage.gpu = Math::CalculateStatistics(profiler.GetGpuSamples(s));
+        stage.cpu = Math::CalculateStatistics(profiler.GetCpuSamples(s));
+        result.stages.push_back(stage);
+    }
+
+    result.pipelineBinds = Math::CalculateStatistics(pipelineBinds);
+    result.descriptorSetBinds = Math::CalculateStatistics(descriptorSetBinds);
+    result.vertexBufferBinds = Math::CalculateStatistics(vertexBufferBinds);
+    result.indexBufferBinds = Math::CalculateStatistics(indexBufferBinds);
+    result.elidedBinds = Math::CalculateStatistics(elidedBinds);
+
+    return true;
+}
+
+bool BenchmarkRunner::Run(const Scenario& scenario)
+{
+    mScenarioName = scenario.GetName();
+    mResults.clear();
+
+    bool succeeded = true;
+    const std::vector<ScenarioRun>& runs = scenario.GetRuns();
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        LOGI("Benchmark run " << (i + 1) << "/" << runs.size() << ": " << runs[i].name);
+
+        BenchmarkResult result;
+        result.run = runs[i];
+        result.completed = Execute(runs[i], result);
+        if (result.completed)
+        {
+            LOGI("  frame time: mean " << result.frame.mean << " ms, median " << result.frame.median
+                 << " ms, p99 " << result.frame.p99 << " ms");
+        }
+        else
+        {
+            LOGE("Benchmark run " << runs[i].name << " failed");
+            succeeded = false;
+        }
+
+        mResults.push_back(result);
+    }
+
+    return succeeded;
+}
+
+bool BenchmarkRunner::ExportJSON(const std::string& path) const
+{
+    std::ofstream file(path, std::ofstream::out | std::ofstream::trunc);
+    if (!file)
+    {
+        LOGE("Unable to open benchmark results file " << path << " for writing");
+        return false;
+    }
+
+    file.precision(4);
+    file.setf(std::ios::fixed);
+
+    file << "{\n\"scenario\":\"" << EscapeJSON(mScenarioName) << "\",\n\"unit\":\"ms\",\n\"runs\":[";
+    for (size_t i = 0; i < mResults.size(); ++i)
+    {
+        const BenchmarkResult& r = mResults[i];
+        const ScenarioRun& run = r.run;
+
+        file << ((i > 0) ? ",\n" : "\n");
+        file << "{\"name\":\"" << EscapeJSON(run.name) << "\",\"completed\":" << (r.completed ? "true" : "false");
+        file << ",\"parameters\":{\"scene\":\"" << EscapeJSON(run.scene) << "\""
+             << ",\"lights\":" << run.lights
+             << ",\"emitters\":" << run.emitters
+             << ",\"particles\":" << run.particles
+             << ",\"seed\":" << run.seed
+             << ",\"warmup\":" << run.warmupFrames
+             << ",\"frames\":" << run.measuredFrames
+             << ",\"async\":" << (run.async ? "true" : "false")
+             << ",\"framesInFlight\":" << run.framesInFlight
+             << ",\"threads\":" << run.recordingThreads
+             << ",\"culling\":\"" << (run.lightCulling == Renderer::LightCullingMode::Clustered ? "clustered" : "tiled") << "\""
+             << ",\"gpuCulling\":" << (run.gpuCulling ? "true" : "false")
+             << ",\"occlusion\":" << (run.occlusion ? "true" : "false")
+             << ",\"lightBvh\":" << (run.lightBVH ? "true" : "false")
+             << ",\"headless\":" << (run.headless ? "true" : "false")
+             << ",\"width\":" << run.width
+             << ",\"height\":" << run.height << "}";
+
+        file << ",\n \"stages\":{\"Frame\":{\"cpu\":";
+        WriteStatistics(file, r.frame);
+        file << "}";
+
+        for (auto& s: r.stages)
+        {
+            file << ",\n  \"" << EscapeJSON(s.name) << "\":{\"cpu\":";
+            WriteStatistics(file, s.cpu);
+            if (s.gpu.count > 0)
+            {
+                file << ",\"gpu\":";
+                WriteStatistics(file, s.gpu);
+            }
+            file << "}";
+        }
+
+        file << "},\n \"binds\":{\"pipeline\":";
+        WriteStatistics(file, r.pipelineBinds);
+        file << ",\"descriptorSets\":";
+        WriteStatistics(file, r.descriptorSetBinds);
+        file << ",\"vertexBuffers\":";
+        WriteStatistics(file, r.vertexBufferBinds);
+        file << ",\"indexBuffers\":";
+        WriteStatistics(file, r.indexBufferBinds);
+        file << ",\"elided\":";
+        WriteStatistics(file, r.elidedBinds);
+
+        file << "},\n \"memory\":";
+        WriteMemoryStatistics(file, r);
+        file << "}";
+    }
+
+    file << "\n]}\n";
+    return file.good();
+}
+
+} // namespace Benchmark
+} // namespace ABench
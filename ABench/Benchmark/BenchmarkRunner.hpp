@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Scenario.hpp"
+
+#include "Math/Statistics.hpp"
+#include "Renderer/LowLevel/MemoryStatistics.hpp"
+#include "Scene/Scene.hpp"
+
+
+namespace ABench {
+namespace Benchmark {
+
+struct BenchmarkStage
+{
+    std::string name;
+    Math::Statistics gpu; // empty if stage's queue does not support timestamps
+    Math::Statistics cpu;
+};
+
+// Memory state sampled after each measured frame
+struct BenchmarkMemoryFrame
+{
+    VkDeviceSize bytes;
+    uint32_t allocations;
+    std::vector<VkDeviceSize> ringBufferBytes; // reserved during the frame, in registration order
+    uint32_t culledLights; // light list entries of the previous frame, lags one frame behind
+};
+
+struct BenchmarkResult
+{
+    ScenarioRun run;
+    bool completed;
+    Math::Statistics frame;
+    std::vector<BenchmarkStage> stages;
+    Math::Statistics pipelineBinds; // bind calls issued by Forward Pass per measured frame
+    Math::Statistics descriptorSetBinds;
+    Math::Statistics vertexBufferBinds;
+    Math::Statistics indexBufferBinds;
+    Math::Statistics elidedBinds; // requested binds of all kinds which were not issued
+    Renderer::MemoryStatisticsSnapshot memory; // captured after the last frame
+    std::vector<BenchmarkMemoryFrame> memoryFrames;
+};
+
+/**
+ * Executes all runs of benchmark scenarios one after another, in a single process.
+ *
+ * Each run gets its own window, Renderer and Scene. Warm-up frames are drawn first and dropped
+ * from statistics, then the camera traverses scenario's path once during measured frames.
+ * Scene is animated with a fixed time step, so every run renders the same frames regardless of
+ * how fast they are drawn.
+ */
+class BenchmarkRunner
+{
+    std::string mScenarioName;
+    std::vector<BenchmarkResult> mResults;
+
+    bool BuildScene(const ScenarioRun& run, Scene::Scene& scene);
+    bool Execute(const ScenarioRun& run, BenchmarkResult& result);
+
+public:
+    BenchmarkRunner();
+    ~BenchmarkRunner();
+
+    // Returns false if any run failed - results of the remaining ones are still gathered
+    bool Run(const Scenario& scenario);
+
+    // Statistics of every run and stage in milliseconds, memory statistics in bytes
+    bool ExportJSON(const std::string& path) const;
+
+    ABENCH_INLINE const std::vector<BenchmarkResult>& GetResults() const
+    {
+        return mResults;
+    }
+};
+
+} // namespace Benchmark
+} // namespace ABench
@@ -0,0 +1,298 @@
+#include "PCH.hpp"
+#include "Scenario.hpp"
+
+#include "Common/Logger.hpp"
+
+
+namespace ABench {
+namespace Benchmark {
+
+namespace {
+
+const char COMMENT_CHAR = '#';
+const std::string CAMERA_KEY = "camera";
+const std::string SWEEP_KEY = "sweep";
+const std::string NAME_KEY = "name";
+
+std::string Trim(const std::string& str)
+{
+    const char* whitespace = " \t\r\n";
+    size_t begin = str.find_first_not_of(whitespace);
+    if (begin == std::string::npos)
+        return std::string();
+
+    size_t end = str.find_last_not_of(whitespace);
+    return str.substr(begin, end - begin + 1);
+}
+
+bool ParseUint(const std::string& value, uint32_t& result)
+{
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+
+    result = static_cast<uint32_t>(std::stoul(value));
+    return true;
+}
+
+bool ParseBool(const std::string& value, bool& result)
+{
+    if (value == "on" || value == "true" || value == "1")
+        result = true;
+    else if (value == "off" || value == "false" || value == "0")
+        result = false;
+    else
+        return false;
+
+    return true;
+}
+
+bool ParseLightCulling(const std::string& value, Renderer::LightCullingMode& result)
+{
+    if (value == "tiled")
+        result = Renderer::LightCullingMode::Tiled;
+    else if (value == "clustered")
+        result = Renderer::LightCullingMode::Clustered;
+    else
+        return false;
+
+    return true;
+}
+
+} // namespace
+
+ScenarioRun::ScenarioRun()
+    : name()
+    , scene("sponza.fbx")
+    , lights(128)
+    , emitters(3)
+    , particles(128)
+    , seed(0)
+    , cameraPath()
+    , warmupFrames(60)
+    , measuredFrames(600)
+    , async(true)
+    , framesInFlight(2)
+    , recordingThreads(0)
+    , lightCulling(Renderer::LightCullingMode::Tiled)
+    , gpuCulling(false)
+    , occlusion(false)
+    , lightBVH(false)
+    , headless(true)
+    , width(1280)
+    , height(720)
+{
+}
+
+Scenario::Scenario()
+    : mName()
+    , mBase()
+    , mSweeps()
+    , mRuns()
+{
+}
+
+Scenario::~Scenario()
+{
+}
+
+bool Scenario::SetParameter(ScenarioRun& run, const std::string& key, const std::string& value) const
+{
+    if (key == "scene")
+    {
+        run.scene = value;
+        return !value.empty();
+    }
+
+    if (key == "lights")
+        return ParseUint(value, run.lights);
+    if (key == "emitters")
+        return ParseUint(value, run.emitters);
+    if (key == "particles")
+        return ParseUint(value, run.particles);
+    if (key == "seed")
+        return ParseUint(value, run.seed);
+    if (key == "warmup")
+        return ParseUint(value, run.warmupFrames);
+    if (key == "frames")
+        return ParseUint(value, run.measuredFrames) && (run.measuredFrames > 0);
+    if (key == "async")
+        return ParseBool(value, run.async);
+    if (key == "framesInFlight")
+        return ParseUint(value, run.framesInFlight) && (run.framesInFlight > 0);
+    if (key == "threads")
+        return ParseUint(value, run.recordingThreads);
+    if (key == "culling")
+        return ParseLightCulling(value, run.lightCulling);
+    if (key == "gpuCulling")
+        return ParseBool(value, run.gpuCulling);
+    if (key == "occlusion")
+        return ParseBool(value, run.occlusion);
+    if (key == "lightBvh")
+        return ParseBool(value, run.lightBVH);
+    if (key == "headless")
+        return ParseBool(value, run.headless);
+    if (key == "width")
+        return ParseUint(value, run.width) && (run.width > 0);
+    if (key == "height")
+        return ParseUint(value, run.height) && (run.height > 0);
+
+    LOGE("Unknown scenario parameter " << key);
+    return false;
+}
+
+bool Scenario::ParseLine(const std::string& line, uint32_t lineNumber)
+{
+    std::string content = Trim(line.substr(0, line.find(COMMENT_CHAR)));
+    if (content.empty())
+        return true;
+
+    size_t separator = content.find('=');
+    if (separator == std::string::npos)
+    {
+        LOGE("Line " << lineNumber << " of scenario is not a key = value pair");
+        return false;
+    }
+
+    std::string key = Trim(content.substr(0, separator));
+    std::string value = Trim(content.substr(separator + 1));
+
+    if (key == NAME_KEY)
+    {
+        mName = value;
+        return true;
+    }
+
+    if (key == CAMERA_KEY)
+    {
+        std::stringstream ss(value);
+        float v[6];
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            if (!(ss >> v[i]))
+            {
+                LOGE("Camera keyframe in line " << lineNumber << " needs six numbers - position and look-at point");
+                return false;
+            }
+        }
+
+        CameraKeyframe keyframe;
+        keyframe.pos = Math::Vector3(v[0], v[1], v[2]);
+        keyframe.at = Math::Vector3(v[3], v[4], v[5]);
+        mBase.cameraPath.push_back(keyframe);
+        return true;
+    }
+
+    if (key == SWEEP_KEY)
+    {
+        std::stringstream ss(value);
+        Sweep sweep;
+        ss >> sweep.key;
+
+        std::string v;
+        while (ss >> v)
+        {
+            // validate values early, so a typo does not fail the run in the middle of a benchmark
+            ScenarioRun test;
+            if (!SetParameter(test, sweep.key, v))
+            {
+                LOGE("Invalid value " << v << " of swept parameter " << sweep.key << " in line " << lineNumber);
+                return false;
+            }
+
+            sweep.values.push_back(v);
+        }
+
+        if (sweep.values.empty())
+        {
+            LOGE("Sweep in line " << lineNumber << " has no values");
+            return false;
+        }
+
+        mSweeps.push_back(sweep);
+        return true;
+    }
+
+    if (!SetParameter(mBase, key, value))
+    {
+        LOGE("Invalid value of " << key << " in line " << lineNumber);
+        return false;
+    }
+
+    return true;
+}
+
+bool Scenario::ExpandRuns()
+{
+    mRuns.clear();
+    mBase.name = mName;
+    mRuns.push_back(mBase);
+
+    for (auto& sweep: mSweeps)
+    {
+        std::vector<ScenarioRun> expanded;
+        expanded.reserve(mRuns.size() * sweep.values.size());
+
+        for (auto& run: mRuns)
+        {
+            for (auto& v: sweep.values)
+            {
+                ScenarioRun r = run;
+                if (!SetParameter(r, sweep.key, v))
+                    return false;
+
+                r.name += "_" + sweep.key + "=" + v;
+                expanded.push_back(r);
+            }
+        }
+
+        mRuns.swap(expanded);
+    }
+
+    return true;
+}
+
+bool Scenario::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        LOGE("Unable to open scenario file " << path);
+        return false;
+    }
+
+    if (!Parse(file))
+    {
+        LOGE("Failed to parse scenario file " << path);
+        return false;
+    }
+
+    return true;
+}
+
+bool Scenario::Parse(std::istream& stream)
+{
+    mName = "scenario";
+    mBase = ScenarioRun();
+    mSweeps.clear();
+    mRuns.clear();
+
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(stream, line))
+    {
+        lineNumber++;
+        if (!ParseLine(line, lineNumber))
+            return false;
+    }
+
+    if (mBase.cameraPath.empty())
+    {
+        LOGE("Scenario " << mName << " has no camera keyframes");
+        return false;
+    }
+
+    return ExpandRuns();
+}
+
+} // namespace Benchmark
+} // namespace ABench
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Common/Common.hpp"
+#include "Math/Vector.hpp"
+#include "Renderer/HighLevel/LightCullingReference.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+
+namespace ABench {
+namespace Benchmark {
+
+struct CameraKeyframe
+{
+    Math::Vector3 pos;
+    Math::Vector3 at;
+};
+
+// Single benchmark run - a scenario with one combination of swept parameters
+struct ScenarioRun
+{
+    std::string name;
+    std::string scene; // file in scenes directory
+    uint32_t lights;
+    uint32_t emitters;
+    uint32_t particles; // per emitter
+    uint32_t seed; // seed of random light placement
+    std::vector<CameraKeyframe> cameraPath; // traversed once during measured frames
+    uint32_t warmupFrames;
+    uint32_t measuredFrames;
+    bool async;
+    uint32_t framesInFlight;
+    uint32_t recordingThreads; // 0 picks automatically
+    Renderer::LightCullingMode lightCulling;
+    bool gpuCulling;
+    bool occlusion; // occlusion culling against previous frame's depth pyramid
+    bool lightBVH; // light culling walks a BVH of lights instead of testing all of them
+    bool headless;
+    uint32_t width;
+    uint32_t height;
+
+    ScenarioRun();
+};
+
+/**
+ * Benchmark scenario read from a text file.
+ *
+ * Each line holds a "key = value" pair, "#" starts a comment. Every "camera" line adds a keyframe
+ * of camera path (six numbers - position and look-at point). A "sweep" line names a parameter
+ * followed by its values - each sweep multiplies the number of runs, so sweeping lights over
+ * 3 values and light culling over 2 values gives 6 runs:
+ *
+ *     name = sponza
+ *     lights = 128
+ *     camera = -8.0 15.0 -2.0   0.0 1.0 0.0
+ *     camera =  8.0 15.0  0.0   4.0 1.0 0.0
+ *     sweep = lights 64 256 1024
+ *     sweep = culling tiled clustered
+ */
+class Scenario
+{
+    struct Sweep
+    {
+        std::string key;
+        std::vector<std::string> values;
+    };
+
+    std::string mName;
+    ScenarioRun mBase;
+    std::vector<Sweep> mSweeps;
+    std::vector<ScenarioRun> mRuns;
+
+    bool SetParameter(ScenarioRun& run, const std::string& key, const std::string& value) const;
+    bool ParseLine(const std::string& line, uint32_t lineNumber);
+    bool ExpandRuns();
+
+public:
+    Scenario();
+    ~Scenario();
+
+    bool Load(const std::string& path);
+    bool Parse(std::istream& stream);
+
+    ABENCH_INLINE const std::string& GetName() const
+    {
+        return mName;
+    }
+
+    ABENCH_INLINE const std::vector<ScenarioRun>& GetRuns() const
+    {
+        return mRuns;
+    }
+};
+
+} // namespace Benchmark
+} // namespace ABench
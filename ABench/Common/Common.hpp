@@ -40,6 +40,7 @@
     if (!(exp)) \
     { \
         LOGE("Assertion " << #exp << " failed: " << msg); \
+        ABench::Logger::Flush(); \
         assert(exp); \
     } \
 } while(0)
@@ -43,6 +43,12 @@ uint64_t GetFileModificationTime(const std::string& path);
  */
 std::string JoinPaths(const std::string& a, const std::string& b);
 
+/**
+ * Lists names of regular files (without directories) located directly in given directory.
+ * Returned names are sorted alphabetically.
+ */
+bool ListFiles(const std::string& path, std::vector<std::string>& files);
+
 /**
  * Removes file from disk
  */
@@ -4,6 +4,9 @@
 #include "Common/Common.hpp"
 #include "Common/Logger.hpp"
 
+#include <algorithm>
+#include <dirent.h>
+
 
 namespace ABench {
 namespace Common {
@@ -89,6 +92,32 @@ std::string JoinPaths(const std::string& a, const std::string& b)
     return first + '/' + second;
 }
 
+bool ListFiles(const std::string& path, std::vector<std::string>& files)
+{
+    DIR* dir = opendir(path.c_str());
+    if (!dir)
+    {
+        LOGE("Failed to open directory " << path << ": " << errno <<
+             " (" << strerror(errno) << ")");
+        return false;
+    }
+
+    files.clear();
+    while (struct dirent* entry = readdir(dir))
+    {
+        struct ::stat attributes;
+        if (::stat(JoinPaths(path, entry->d_name).c_str(), &attributes) < 0)
+            continue;
+
+        if (S_ISREG(attributes.st_mode))
+            files.emplace_back(entry->d_name);
+    }
+
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    return true;
+}
+
 bool RemoveFile(const std::string& path)
 {
     if (unlink(path.c_str()) < 0)
@@ -4,45 +4,36 @@
 
 namespace ABench {
 namespace Logger {
+namespace Impl {
 
-std::ofstream logFile;
-
-void Log(LogLevel level, const std::stringstream& msg)
+void WriteConsole(LogLevel level, const std::string& line)
 {
-    const char* levelStr = nullptr;
     const char* colorStr = nullptr;
 
-    if (!logFile.is_open())
-    {
-        logFile.open("log.txt");
-    }
-
     switch (level)
     {
     case LogLevel::DEBUG:
-        levelStr = "DEBUG";
         colorStr = "\033[36m"; // Cyan (Blue | Green)
         break;
     case LogLevel::INFO:
-        levelStr = " INF ";
         colorStr = "\033[39m"; // Default
         break;
     case LogLevel::WARNING:
-        levelStr = " WRN ";
         colorStr = "\033[33m"; // Yellow (Red | Green)
         break;
     case LogLevel::ERROR:
-        levelStr = "ERROR";
         colorStr = "\033[91m"; // Light red
         break;
+    case LogLevel::MEMORY:
+        colorStr = "\033[93m"; // Light yellow
+        break;
+    default:
+        colorStr = "\033[39m";
     }
 
-    std::stringstream fullMsg;
-    fullMsg << colorStr << "[" << levelStr << "] " << msg.str() << "\033[39m\n";
-    std::cout << fullMsg.str();
-    if (logFile.is_open())
-        logFile << fullMsg.str();
+    std::cout << colorStr << line << "\033[39m\n";
 }
 
+} // namespace Impl
 } // namespace Logger
 } // namespace ABench
@@ -0,0 +1,71 @@
+#include "PCH.hpp"
+#include "../MappedFile.hpp"
+#include "../Common.hpp"
+#include "../Logger.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+
+namespace ABench {
+namespace Common {
+
+MappedFile::MappedFile()
+    : mFile(-1)
+    , mData(nullptr)
+    , mSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    mFile = open(path.c_str(), O_RDONLY);
+    if (mFile < 0)
+    {
+        LOGE("Failed to open file " << path << ": " << errno << " (" << strerror(errno) << ")");
+        return false;
+    }
+
+    struct ::stat attributes;
+    if (fstat(mFile, &attributes) < 0 || attributes.st_size == 0)
+    {
+        LOGE("Failed to acquire size of file " << path);
+        Close();
+        return false;
+    }
+
+    mSize = static_cast<size_t>(attributes.st_size);
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+    if (data == MAP_FAILED)
+    {
+        LOGE("Failed to map file " << path << ": " << errno << " (" << strerror(errno) << ")");
+        Close();
+        return false;
+    }
+
+    mData = data;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData != nullptr)
+        munmap(const_cast<void*>(mData), mSize);
+
+    if (mFile >= 0)
+        close(mFile);
+
+    mFile = -1;
+    mData = nullptr;
+    mSize = 0;
+}
+
+} // namespace Common
+} // namespace ABench
@@ -155,6 +155,19 @@ bool Window::Open(int x, int y, int width, int height, const std::string& title)
     return true;
 }
 
+bool Window::OpenHeadless(int width, int height)
+{
+    if (mOpened)
+        return false;
+
+    mWidth = width;
+    mHeight = height;
+
+    OnOpen();
+    mOpened = true;
+    return true;
+}
+
 bool Window::SetTitle(const std::wstring& title)
 {
     UNUSED(title);
@@ -164,7 +177,7 @@ bool Window::SetTitle(const std::wstring& title)
 
 bool Window::SetTitle(const std::string& title)
 {
-    if (mOpened)
+    if (mOpened && mWindow)
     {
         xcb_change_property(mConnection, XCB_PROP_MODE_REPLACE, mWindow, XCB_ATOM_WM_NAME,
                             XCB_ATOM_STRING, 8, title.size(), title.c_str());
@@ -280,7 +293,8 @@ void Window::ProcessMessages()
 
 void Window::Update(float deltaTime)
 {
-    ProcessMessages();
+    if (mWindow)
+        ProcessMessages();
     OnUpdate(deltaTime);
 }
 
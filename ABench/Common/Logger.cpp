@@ -0,0 +1,333 @@
+#include "PCH.hpp"
+#include "Logger.hpp"
+
+#include "MPSCQueue.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+
+namespace ABench {
+namespace Logger {
+
+namespace {
+
+const char* LOG_FILE_NAME = "log.txt";
+const size_t LOG_QUEUE_CAPACITY = 4096;
+const size_t LOG_RECORD_TEXT_LENGTH = 232; // keeps the whole record within 256 bytes
+const std::chrono::milliseconds LOG_WRITER_INTERVAL(10); // how often writer wakes up on its own
+
+const char* GetLevelString(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::ERROR: return "ERROR";
+    case LogLevel::WARNING: return " WRN ";
+    case LogLevel::INFO: return " INF ";
+    case LogLevel::DEBUG: return "DEBUG";
+    case LogLevel::MEMORY: return " MEM ";
+    default: return " ??? ";
+    }
+}
+
+int64_t GetMilliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Message is formatted by the logging thread - the writer only prepends the level tag
+struct LogRecord
+{
+    LogLevel level;
+    uint32_t length;
+    std::string* longText; // only for messages which do not fit into text, owned by the record
+    char text[LOG_RECORD_TEXT_LENGTH];
+};
+
+class LogWriter
+{
+    Common::MPSCQueue<LogRecord> mQueue;
+    std::atomic<uint32_t> mDropped;
+    std::ofstream mFile;
+    std::mutex mDrainMutex; // makes sure there is only one consumer at a time
+    std::mutex mWakeMutex;
+    std::condition_variable mWake;
+    bool mExit;
+    std::thread mThread;
+
+    void Write(LogLevel level, const char* text, size_t length);
+    void Drain();
+    void WriterLoop();
+
+public:
+    LogWriter();
+    ~LogWriter();
+
+    void Push(LogLevel level, const std::string& msg);
+    void Flush();
+};
+
+// set while the writer thread runs - messages logged outside of its lifetime are written directly
+std::atomic<bool> gWriterActive(false);
+
+LogWriter& GetWriter()
+{
+    static LogWriter writer;
+    return writer;
+}
+
+void WriteDirectly(LogLevel level, const std::string& msg)
+{
+    static std::mutex directMutex;
+    std::lock_guard<std::mutex> lock(directMutex);
+
+    std::string line = std::string("[") + GetLevelString(level) + "] " + msg;
+    Impl::WriteConsole(level, line);
+}
+
+} // namespace
+
+
+LogWriter::LogWriter()
+    : mQueue()
+    , mDropped(0)
+    , mFile(LOG_FILE_NAME)
+    , mDrainMutex()
+    , mWakeMutex()
+    , mWake()
+    , mExit(false)
+    , mThread()
+{
+    mQueue.Init(LOG_QUEUE_CAPACITY);
+    mThread = std::thread(&LogWriter::WriterLoop, this);
+    gWriterActive.store(true, std::memory_order_release);
+}
+
+LogWriter::~LogWriter()
+{
+    gWriterActive.store(false, std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mExit = true;
+    }
+
+    mWake.notify_one();
+    if (mThread.joinable())
+        mThread.join();
+
+    Drain();
+}
+
+void LogWriter::Write(LogLevel level, const char* text, size_t length)
+{
+    std::string line;
+    line.reserve(length + 8);
+    line.append("[").append(GetLevelString(level)).append("] ").append(text, length);
+
+    Impl::WriteConsole(level, line);
+    if (mFile.is_open())
+        mFile << line << '\n';
+}
+
+void LogWriter::Drain()
+{
+    std::lock_guard<std::mutex> lock(mDrainMutex);
+
+    LogRecord record;
+    while (mQueue.Pop(record))
+    {
+        if (record.longText)
+        {
+            Write(record.level, record.longText->data(), record.longText->size());
+            delete record.longText;
+        }
+        else
+        {
+            Write(record.level, record.text, record.length);
+        }
+    }
+
+    uint32_t dropped = mDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+        std::string msg = std::to_string(dropped) + " log messages dropped - queue was full";
+        Write(LogLevel::WARNING, msg.data(), msg.size());
+    }
+
+    if (mFile.is_open())
+        mFile.flush();
+}
+
+void LogWriter::WriterLoop()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWake.wait_for(lock, LOG_WRITER_INTERVAL, [this]() { return mExit; });
+            if (mExit)
+                return;
+        }
+
+        Drain();
+    }
+}
+
+void LogWriter::Push(LogLevel level, const std::string& msg)
+{
+    LogRecord record;
+    record.level = level;
+    record.length = static_cast<uint32_t>(msg.size());
+    record.longText = nullptr;
+
+    if (msg.size() <= LOG_RECORD_TEXT_LENGTH)
+        memcpy(record.text, msg.data(), msg.size());
+    else
+        record.longText = new std::string(msg);
+
+    if (!mQueue.Push(record))
+    {
+        delete record.longText;
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // errors usually come right before things go wrong, so don't let them wait for the interval
+    if (level == LogLevel::ERROR)
+        mWake.notify_one();
+}
+
+void LogWriter::Flush()
+{
+    Drain();
+}
+
+
+MessageBuffer::int_type MessageBuffer::overflow(int_type c)
+{
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+        mData.push_back(traits_type::to_char_type(c));
+
+    return traits_type::not_eof(c);
+}
+
+std::streamsize MessageBuffer::xsputn(const char* s, std::streamsize count)
+{
+    mData.append(s, static_cast<size_t>(count));
+    return count;
+}
+
+
+struct MessageStream::ThreadStream
+{
+    MessageBuffer buffer;
+    std::ostream stream;
+    std::ios_base::fmtflags defaultFlags;
+    bool inUse;
+
+    ThreadStream()
+        : buffer()
+        , stream(&buffer)
+        , defaultFlags(stream.flags())
+        , inUse(false)
+    {
+    }
+
+    void Reset()
+    {
+        // formatting set by previous message (ex. std::hex) must not leak into the next one
+        buffer.Clear();
+        stream.clear();
+        stream.flags(defaultFlags);
+        stream.precision(6);
+        stream.width(0);
+        stream.fill(' ');
+    }
+};
+
+MessageStream::MessageStream()
+    : mThreadStream(nullptr)
+    , mTemporary()
+{
+    static thread_local ThreadStream threadStream;
+
+    if (threadStream.inUse)
+    {
+        mTemporary.reset(new ThreadStream());
+        mThreadStream = mTemporary.get();
+    }
+    else
+    {
+        threadStream.Reset();
+        mThreadStream = &threadStream;
+    }
+
+    mThreadStream->inUse = true;
+}
+
+MessageStream::~MessageStream()
+{
+    mThreadStream->inUse = false;
+}
+
+std::ostream& MessageStream::Get()
+{
+    return mThreadStream->stream;
+}
+
+const std::string& MessageStream::GetData() const
+{
+    return mThreadStream->buffer.GetData();
+}
+
+
+bool RateLimiter::AllowOverLimit(uint32_t& suppressed)
+{
+    int64_t now = GetMilliseconds();
+    int64_t windowStart = mWindowStart.load(std::memory_order_relaxed);
+
+    // only one thread can open a new window, others count as suppressed
+    if ((now - windowStart < WINDOW_MS) ||
+        !mWindowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
+    {
+        mSuppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    mCount.store(1, std::memory_order_relaxed);
+    suppressed = mSuppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+
+void Log(LogLevel level, const MessageStream& msg)
+{
+    // first message starts the writer
+    LogWriter& writer = GetWriter();
+
+    if (!gWriterActive.load(std::memory_order_acquire))
+    {
+        // writer is already destroyed - happens for messages logged during static destruction
+        WriteDirectly(level, msg.GetData());
+        return;
+    }
+
+    writer.Push(level, msg.GetData());
+}
+
+void Flush()
+{
+    LogWriter& writer = GetWriter();
+    if (gWriterActive.load(std::memory_order_acquire))
+        writer.Flush();
+}
+
+} // namespace Logger
+} // namespace ABench
@@ -1,6 +1,11 @@
 #pragma once
 
-#include <sstream>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
 
 #ifdef ERROR
 #undef ERROR
@@ -18,29 +23,154 @@ enum class LogLevel: unsigned char
     MEMORY,
 };
 
-void Log(LogLevel level, const std::stringstream& msg);
+// Most verbose level compiled in, as a LogLevel value - more verbose LOG* macros generate no code
+#ifndef ABENCH_LOG_LEVEL
+#if defined(ABENCH_DEBUG_MEMORY)
+#define ABENCH_LOG_LEVEL 4
+#elif defined(_DEBUG)
+#define ABENCH_LOG_LEVEL 3
+#else
+#define ABENCH_LOG_LEVEL 2
+#endif
+#endif
+
+// Stream buffer appending to a string, which keeps its capacity between messages
+class MessageBuffer: public std::streambuf
+{
+    std::string mData;
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize count) override;
+
+public:
+    void Clear()
+    {
+        mData.clear();
+    }
+
+    const std::string& GetData() const
+    {
+        return mData;
+    }
+};
+
+/**
+ * Stream used by LOG macros to format a message.
+ *
+ * Constructing a std::ostream is far more expensive than formatting a short message, so each
+ * thread reuses one stream. Messages formatted while another one is being built on the same
+ * thread (a LOG inside of other LOG's arguments) get a temporary stream.
+ */
+class MessageStream
+{
+    struct ThreadStream;
+
+    ThreadStream* mThreadStream;
+    std::unique_ptr<ThreadStream> mTemporary;
+
+public:
+    MessageStream();
+    ~MessageStream();
+
+    std::ostream& Get();
+    const std::string& GetData() const;
+};
+
+/**
+ * Limits how often a single LOG call site can emit warnings and errors.
+ *
+ * Call sites on hot paths (ex. per-light failures in a frame) would otherwise flood the log and
+ * slow down the frame. Once the limit is reached, messages are dropped until the current
+ * window passes - the next message reports how many were dropped. Below the limit it costs one
+ * relaxed atomic increment.
+ */
+class RateLimiter
+{
+    std::atomic<int64_t> mWindowStart;
+    std::atomic<uint32_t> mCount;
+    std::atomic<uint32_t> mSuppressed;
+
+    bool AllowOverLimit(uint32_t& suppressed);
+
+public:
+    static const uint32_t MESSAGES_PER_WINDOW = 20;
+    static const int64_t WINDOW_MS = 1000;
+
+    constexpr RateLimiter()
+        : mWindowStart(0)
+        , mCount(0)
+        , mSuppressed(0)
+    {
+    }
+
+    bool Allow(LogLevel level, uint32_t& suppressed)
+    {
+        if (level > LogLevel::WARNING)
+            return true;
+
+        if (mCount.fetch_add(1, std::memory_order_relaxed) < MESSAGES_PER_WINDOW)
+            return true;
+
+        return AllowOverLimit(suppressed);
+    }
+};
+
+/**
+ * Queues a formatted message for the writer thread. Does not block - if the queue is full, the
+ * message is dropped and the number of dropped messages is reported later.
+ */
+void Log(LogLevel level, const MessageStream& msg);
+
+// Blocks until all messages queued so far are written out
+void Flush();
+
+namespace Impl {
+
+// Platform-specific console output of a formatted line (without line break), called only by one
+// thread at a time
+void WriteConsole(LogLevel level, const std::string& line);
+
+} // namespace Impl
 
 } // namespace Logger
 } // namespace ABench
 
 #define LOG(level, msg) do { \
-    std::stringstream ss; \
-    ss << msg; \
-    ABench::Logger::Log(level, ss); \
+    static ABench::Logger::RateLimiter logRateLimiter; \
+    uint32_t logSuppressed = 0; \
+    if (logRateLimiter.Allow(level, logSuppressed)) \
+    { \
+        ABench::Logger::MessageStream logStream; \
+        logStream.Get() << msg; \
+        if (logSuppressed > 0) \
+            logStream.Get() << " (" << logSuppressed << " more suppressed)"; \
+        ABench::Logger::Log(level, logStream); \
+    } \
 } while(0)
 
-#ifdef _DEBUG
+#if ABENCH_LOG_LEVEL >= 4
+#define LOGM(msg) LOG(ABench::Logger::LogLevel::MEMORY, msg)
+#else
+#define LOGM(msg) do { } while(0)
+#endif
+
+#if ABENCH_LOG_LEVEL >= 3
 #define LOGD(msg) LOG(ABench::Logger::LogLevel::DEBUG, msg)
 #else
 #define LOGD(msg) do { } while(0)
 #endif
 
-#ifdef ABENCH_DEBUG_MEMORY
-#define LOGM(msg) LOG(ABench::Logger::LogLevel::MEMORY, msg)
+#if ABENCH_LOG_LEVEL >= 2
+#define LOGI(msg) LOG(ABench::Logger::LogLevel::INFO, msg)
 #else
-#define LOGM(msg) do { } while(0)
+#define LOGI(msg) do { } while(0)
 #endif
 
-#define LOGI(msg) LOG(ABench::Logger::LogLevel::INFO, msg)
+#if ABENCH_LOG_LEVEL >= 1
 #define LOGW(msg) LOG(ABench::Logger::LogLevel::WARNING, msg)
+#else
+#define LOGW(msg) do { } while(0)
+#endif
+
 #define LOGE(msg) LOG(ABench::Logger::LogLevel::ERROR, msg)
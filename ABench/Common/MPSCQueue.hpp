@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace ABench {
+namespace Common {
+
+/**
+ * Bounded, lock-free queue with many producers and a single consumer.
+ *
+ * Every cell carries a sequence number telling whether it is free for the producer which claimed
+ * its position, or already filled for the consumer. Producers claim positions with a CAS on
+ * the enqueue counter and never wait for each other - when the queue is full, Push() fails
+ * instead of blocking.
+ *
+ * Pop() must only be called from one thread at a time.
+ */
+template <typename T>
+class MPSCQueue
+{
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> mCells;
+    size_t mMask;
+    alignas(64) std::atomic<size_t> mEnqueuePos;
+    alignas(64) size_t mDequeuePos;
+
+public:
+    MPSCQueue();
+    ~MPSCQueue();
+
+    // Capacity must be a power of two
+    bool Init(size_t capacity);
+
+    // Returns false if the queue is full
+    bool Push(const T& value);
+
+    // Returns false if the queue is empty
+    bool Pop(T& value);
+
+    size_t GetCapacity() const
+    {
+        return mMask + 1;
+    }
+};
+
+} // namespace Common
+} // namespace ABench
+
+#include "MPSCQueueImpl.hpp"
@@ -0,0 +1,86 @@
+#pragma once
+
+namespace ABench {
+namespace Common {
+
+template <typename T>
+MPSCQueue<T>::MPSCQueue()
+    : mCells()
+    , mMask(0)
+    , mEnqueuePos(0)
+    , mDequeuePos(0)
+{
+}
+
+template <typename T>
+MPSCQueue<T>::~MPSCQueue()
+{
+}
+
+template <typename T>
+bool MPSCQueue<T>::Init(size_t capacity)
+{
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        return false;
+
+    mCells.reset(new Cell[capacity]);
+    for (size_t i = 0; i < capacity; ++i)
+        mCells[i].sequence.store(i, std::memory_order_relaxed);
+
+    mMask = capacity - 1;
+    mEnqueuePos.store(0, std::memory_order_relaxed);
+    mDequeuePos = 0;
+    return true;
+}
+
+template <typename T>
+bool MPSCQueue<T>::Push(const T& value)
+{
+    Cell* cell;
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &mCells[pos & mMask];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)
+        {
+            // cell is free - try to claim it, on failure pos is reloaded and we try again
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // cell still holds a value from previous round, consumer did not catch up
+            return false;
+        }
+        else
+        {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->value = value;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool MPSCQueue<T>::Pop(T& value)
+{
+    Cell* cell = &mCells[mDequeuePos & mMask];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    if (seq != mDequeuePos + 1)
+        return false;
+
+    value = cell->value;
+
+    // mark the cell as free for the producer coming one round later
+    cell->sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+    mDequeuePos++;
+    return true;
+}
+
+} // namespace Common
+} // namespace ABench
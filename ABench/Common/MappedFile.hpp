@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Common/Common.hpp"
+
+
+namespace ABench {
+namespace Common {
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * Mapped contents stay valid until Close() is called or object is destroyed.
+ */
+class MappedFile
+{
+#ifdef WIN32
+    HANDLE mFile;
+    HANDLE mMapping;
+#elif defined(__linux__) | defined(__LINUX__)
+    int mFile;
+#else
+#error "Target platform not supported."
+#endif
+    const void* mData;
+    size_t mSize;
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    ABENCH_INLINE const void* GetData() const
+    {
+        return mData;
+    }
+
+    ABENCH_INLINE size_t GetSize() const
+    {
+        return mSize;
+    }
+
+    ABENCH_INLINE bool IsOpen() const
+    {
+        return mData != nullptr;
+    }
+};
+
+} // namespace Common
+} // namespace ABench
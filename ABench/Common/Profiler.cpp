@@ -0,0 +1,125 @@
+#include "PCH.hpp"
+#include "Profiler.hpp"
+
+#include "Common/Logger.hpp"
+
+
+namespace ABench {
+namespace Common {
+
+namespace {
+
+const uint32_t RECORDS_PER_THREAD = 1 << 16; // must be a power of two
+const uint32_t RECORDS_MASK = RECORDS_PER_THREAD - 1;
+
+} // namespace
+
+Profiler::Profiler()
+    : mEpoch(std::chrono::steady_clock::now())
+    , mZoneNames()
+    , mThreads()
+    , mMutex()
+{
+}
+
+Profiler::~Profiler()
+{
+}
+
+Profiler& Profiler::Instance()
+{
+    static Profiler instance;
+    return instance;
+}
+
+double Profiler::TicksToMicroseconds(ProfilerTicks ticks) const
+{
+    std::chrono::steady_clock::duration sinceEpoch(ticks - mEpoch.time_since_epoch().count());
+    return std::chrono::duration<double, std::micro>(sinceEpoch).count();
+}
+
+double Profiler::GetTime() const
+{
+    return TicksToMicroseconds(GetTicks());
+}
+
+ProfilerZone Profiler::RegisterZone(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mZoneNames.push_back(name);
+    return static_cast<ProfilerZone>(mZoneNames.size() - 1);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    // buffers live as long as the profiler, so the pointer never dangles
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer != nullptr)
+        return buffer;
+
+    std::unique_ptr<ThreadBuffer> newBuffer(new ThreadBuffer());
+    newBuffer->records.reset(new Record[RECORDS_PER_THREAD]);
+    newBuffer->head.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    newBuffer->id = static_cast<uint32_t>(mThreads.size());
+    newBuffer->name = "Thread " + std::to_string(newBuffer->id);
+    buffer = newBuffer.get();
+    mThreads.push_back(std::move(newBuffer));
+    return buffer;
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    buffer->name = name + " " + std::to_string(buffer->id);
+}
+
+void Profiler::AddRecord(ProfilerZone zone, ProfilerTicks start, ProfilerTicks end)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    // only owning thread writes to the buffer - release store publishes the record to readers
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    Record& record = buffer->records[head & RECORDS_MASK];
+    record.zone = zone;
+    record.start = start;
+    record.end = end;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::WriteTrace(TraceWriter& writer, uint32_t pid)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    writer.SetProcessName(pid, "CPU threads");
+
+    std::vector<Record> records;
+    for (auto& t: mThreads)
+    {
+        writer.SetThreadName(pid, t->id, t->name);
+
+        uint64_t head = t->head.load(std::memory_order_acquire);
+        uint64_t first = (head > RECORDS_PER_THREAD) ? (head - RECORDS_PER_THREAD) : 0;
+        records.clear();
+        for (uint64_t i = first; i < head; ++i)
+            records.push_back(t->records[i & RECORDS_MASK]);
+
+        // drop records which the owning thread overwrote while they were copied
+        uint64_t newHead = t->head.load(std::memory_order_acquire);
+        uint64_t valid = (newHead > RECORDS_PER_THREAD) ? (newHead - RECORDS_PER_THREAD) : 0;
+        size_t skip = (valid > first) ? static_cast<size_t>(std::min(valid - first, head - first)) : 0;
+
+        for (size_t i = skip; i < records.size(); ++i)
+        {
+            double start = TicksToMicroseconds(records[i].start);
+            double end = TicksToMicroseconds(records[i].end);
+            writer.AddEvent(pid, t->id, mZoneNames[records[i].zone], start, end - start);
+        }
+    }
+}
+
+} // namespace Common
+} // namespace ABench
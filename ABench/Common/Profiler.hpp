@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Common/Common.hpp"
+#include "Common/TraceWriter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+namespace ABench {
+namespace Common {
+
+using ProfilerZone = uint32_t;
+using ProfilerTicks = std::chrono::steady_clock::rep;
+
+/**
+ * CPU profiler collecting timings of instrumented code zones.
+ *
+ * Each thread records finished zones into its own ring buffer, which only that thread writes
+ * to, so recording takes no locks - just two clock reads and a store. When a buffer wraps, the
+ * oldest records are overwritten. Zone names are registered once per call site.
+ *
+ * Times are measured with steady clock (vDSO clock_gettime on Linux, QPC on Windows) instead of
+ * raw TSC, which would need per-platform calibration to be converted to time.
+ *
+ * Use PROFILER_SCOPE and PROFILER_THREAD macros - without ABENCH_PROFILE defined they compile
+ * to nothing.
+ */
+class Profiler
+{
+    struct Record
+    {
+        ProfilerZone zone;
+        ProfilerTicks start;
+        ProfilerTicks end;
+    };
+
+    struct ThreadBuffer
+    {
+        std::unique_ptr<Record[]> records;
+        std::atomic<uint64_t> head; // total number of records written
+        uint32_t id;
+        std::string name;
+    };
+
+    std::chrono::steady_clock::time_point mEpoch;
+    std::vector<std::string> mZoneNames;
+    std::vector<std::unique_ptr<ThreadBuffer>> mThreads;
+    std::mutex mMutex; // guards registration of zones and threads
+
+    ThreadBuffer* GetThreadBuffer();
+
+    Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler(Profiler&&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+    Profiler& operator=(Profiler&&) = delete;
+    ~Profiler();
+
+public:
+    static Profiler& Instance();
+
+    ABENCH_INLINE static ProfilerTicks GetTicks()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    // Converts ticks to microseconds since profiler creation - a time base shared with GPU Profiler
+    double TicksToMicroseconds(ProfilerTicks ticks) const;
+    double GetTime() const;
+
+    ProfilerZone RegisterZone(const std::string& name);
+    void SetThreadName(const std::string& name);
+    void AddRecord(ProfilerZone zone, ProfilerTicks start, ProfilerTicks end);
+
+    /**
+     * Writes all buffered zones as trace events, one track per thread. Can be called while other
+     * threads record - records overwritten in the meantime are skipped.
+     */
+    void WriteTrace(TraceWriter& writer, uint32_t pid);
+};
+
+class ProfilerScope
+{
+    ProfilerZone mZone;
+    ProfilerTicks mStart;
+
+public:
+    ABENCH_INLINE ProfilerScope(ProfilerZone zone)
+        : mZone(zone)
+        , mStart(Profiler::GetTicks())
+    {
+    }
+
+    ABENCH_INLINE ~ProfilerScope()
+    {
+        Profiler::Instance().AddRecord(mZone, mStart, Profiler::GetTicks());
+    }
+};
+
+} // namespace Common
+} // namespace ABench
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#ifdef ABENCH_PROFILE
+#define PROFILER_SCOPE(name) \
+    static const ABench::Common::ProfilerZone PROFILER_CONCAT(profilerZone, __LINE__) = \
+        ABench::Common::Profiler::Instance().RegisterZone(name); \
+    ABench::Common::ProfilerScope PROFILER_CONCAT(profilerScope, __LINE__)(PROFILER_CONCAT(profilerZone, __LINE__))
+#define PROFILER_THREAD(name) ABench::Common::Profiler::Instance().SetThreadName(name)
+#else
+#define PROFILER_SCOPE(name) do { } while(0)
+#define PROFILER_THREAD(name) do { } while(0)
+#endif
@@ -0,0 +1,146 @@
+#include "PCH.hpp"
+#include "ThreadPool.hpp"
+
+#include "Logger.hpp"
+#include "Profiler.hpp"
+
+
+namespace ABench {
+namespace Common {
+
+ThreadPool::ThreadPool()
+    : mWorkers()
+    , mTasks()
+    , mMutex()
+    , mTaskAvailable()
+    , mTasksFinished()
+    , mPendingTasks(0)
+    , mExit(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    Release();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    PROFILER_THREAD("Worker");
+
+    while (true)
+    {
+        QueuedTask task;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTaskAvailable.wait(lock, [this]() { return mExit || !mTasks.empty(); });
+
+            if (mExit)
+                return;
+
+            task = std::move(mTasks.front());
+            mTasks.pop();
+        }
+
+        task.task();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPendingTasks--;
+
+            // group might be destroyed by its waiter right after the lock is released
+            bool groupFinished = false;
+            if (task.group)
+            {
+                task.group->mPendingTasks--;
+                groupFinished = (task.group->mPendingTasks == 0);
+            }
+
+            if (mPendingTasks == 0 || groupFinished)
+                mTasksFinished.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::Init(uint32_t workerCount)
+{
+    if (!mWorkers.empty())
+    {
+        LOGE("Thread Pool is already initialized");
+        return false;
+    }
+
+    if (workerCount == 0)
+    {
+        // leave one hardware thread for the caller, which usually records alongside workers
+        uint32_t hwThreads = std::thread::hardware_concurrency();
+        workerCount = (hwThreads > 1) ? (hwThreads - 1) : 1;
+    }
+
+    mExit = false;
+    for (uint32_t i = 0; i < workerCount; ++i)
+        mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+
+    LOGI("Thread Pool initialized with " << workerCount << " workers");
+    return true;
+}
+
+void ThreadPool::Release()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mExit = true;
+
+        // only dropped tasks are uncounted here, running ones uncount themselves when they finish
+        while (!mTasks.empty())
+        {
+            ThreadPoolTaskGroup* group = mTasks.front().group;
+            if (group)
+                group->mPendingTasks--;
+
+            mPendingTasks--;
+            mTasks.pop();
+        }
+    }
+
+    mTaskAvailable.notify_all();
+    mTasksFinished.notify_all();
+
+    for (auto& w: mWorkers)
+        if (w.joinable())
+            w.join();
+
+    mWorkers.clear();
+}
+
+void ThreadPool::AddTask(ThreadPoolTask task, ThreadPoolTaskGroup* group)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        QueuedTask queued;
+        queued.task = std::move(task);
+        queued.group = group;
+        mTasks.push(std::move(queued));
+        mPendingTasks++;
+        if (group)
+            group->mPendingTasks++;
+    }
+
+    mTaskAvailable.notify_one();
+}
+
+void ThreadPool::WaitForTasks()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTasksFinished.wait(lock, [this]() { return mPendingTasks == 0; });
+}
+
+void ThreadPool::WaitForTasks(ThreadPoolTaskGroup& group)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTasksFinished.wait(lock, [&group]() { return group.mPendingTasks == 0; });
+}
+
+} // namespace Common
+} // namespace ABench
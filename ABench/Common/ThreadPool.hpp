@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Common/Common.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+
+
+namespace ABench {
+namespace Common {
+
+using ThreadPoolTask = std::function<void()>;
+
+// Counts tasks added with it, so their owner can wait only for them and not for unrelated
+// work which shares the same Thread Pool. Must outlive all of its tasks.
+class ThreadPoolTaskGroup
+{
+    friend class ThreadPool;
+
+    uint32_t mPendingTasks; // guarded by mutex of the Thread Pool tasks were added to
+
+public:
+    ThreadPoolTaskGroup()
+        : mPendingTasks(0)
+    {
+    }
+};
+
+// A simple pool of worker threads consuming tasks from a common queue.
+// Used mostly to spread per-frame CPU work (ex. Command Buffer recording) across cores.
+class ThreadPool
+{
+    struct QueuedTask
+    {
+        ThreadPoolTask task;
+        ThreadPoolTaskGroup* group;
+    };
+
+    std::vector<std::thread> mWorkers;
+    std::queue<QueuedTask> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    std::condition_variable mTasksFinished;
+    uint32_t mPendingTasks; // queued + currently executed
+    bool mExit;
+
+    void WorkerLoop();
+
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    /**
+     * Spawns worker threads. When workerCount is zero, one worker per available
+     * hardware thread (minus the calling one) is created.
+     */
+    bool Init(uint32_t workerCount = 0);
+
+    /**
+     * Joins all worker threads. Tasks left in queue are dropped, tasks already picked up by
+     * workers are finished first.
+     */
+    void Release();
+
+    /**
+     * Pushes a task to the queue. Task will be picked up by first free worker. When group
+     * is provided, the task is also counted in it.
+     */
+    void AddTask(ThreadPoolTask task, ThreadPoolTaskGroup* group = nullptr);
+
+    /**
+     * Blocks calling thread until all added tasks are finished.
+     */
+    void WaitForTasks();
+
+    /**
+     * Blocks calling thread until tasks added with given group are finished. Other tasks
+     * might still be queued or running.
+     */
+    void WaitForTasks(ThreadPoolTaskGroup& group);
+
+    ABENCH_INLINE uint32_t GetWorkerCount() const
+    {
+        return static_cast<uint32_t>(mWorkers.size());
+    }
+};
+
+} // namespace Common
+} // namespace ABench
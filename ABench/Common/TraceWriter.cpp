@@ -0,0 +1,96 @@
+#include "PCH.hpp"
+#include "TraceWriter.hpp"
+
+#include "Common/Logger.hpp"
+
+
+namespace ABench {
+namespace Common {
+
+TraceWriter::TraceWriter()
+    : mFile()
+    , mFirstEvent(true)
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+    Close();
+}
+
+bool TraceWriter::Open(const std::string& path)
+{
+    Close();
+
+    mFile.open(path, std::ofstream::out | std::ofstream::trunc);
+    if (!mFile)
+    {
+        LOGE("Unable to open trace file " << path << " for writing");
+        return false;
+    }
+
+    mFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    mFile.precision(3);
+    mFile.setf(std::ios::fixed);
+    mFirstEvent = true;
+    return true;
+}
+
+bool TraceWriter::Close()
+{
+    if (!mFile.is_open())
+        return true;
+
+    mFile << "\n]}\n";
+    bool result = mFile.good();
+    mFile.close();
+    return result;
+}
+
+void TraceWriter::BeginEvent()
+{
+    if (!mFirstEvent)
+        mFile << ",";
+
+    mFile << "\n";
+    mFirstEvent = false;
+}
+
+void TraceWriter::WriteString(const std::string& str)
+{
+    mFile << "\"";
+    for (char c: str)
+    {
+        if (c == '"' || c == '\\')
+            mFile << '\\';
+        mFile << c;
+    }
+    mFile << "\"";
+}
+
+void TraceWriter::SetProcessName(uint32_t pid, const std::string& name)
+{
+    BeginEvent();
+    mFile << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid << ",\"args\":{\"name\":";
+    WriteString(name);
+    mFile << "}}";
+}
+
+void TraceWriter::SetThreadName(uint32_t pid, uint32_t tid, const std::string& name)
+{
+    BeginEvent();
+    mFile << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"name\":";
+    WriteString(name);
+    mFile << "}}";
+}
+
+void TraceWriter::AddEvent(uint32_t pid, uint32_t tid, const std::string& name, double startUs, double durationUs)
+{
+    BeginEvent();
+    mFile << "{\"ph\":\"X\",\"name\":";
+    WriteString(name);
+    mFile << ",\"pid\":" << pid << ",\"tid\":" << tid << ",\"ts\":" << startUs << ",\"dur\":" << durationUs << "}";
+}
+
+} // namespace Common
+} // namespace ABench
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+
+namespace ABench {
+namespace Common {
+
+/**
+ * Writes timing events in Chrome trace event format, readable by chrome://tracing and Perfetto.
+ *
+ * Events are grouped in processes and threads (ex. CPU threads, GPU queues), which are shown
+ * as separate tracks. All times are provided in microseconds.
+ */
+class TraceWriter
+{
+    std::ofstream mFile;
+    bool mFirstEvent;
+
+    void BeginEvent();
+    void WriteString(const std::string& str);
+
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    bool Open(const std::string& path);
+    bool Close();
+
+    void SetProcessName(uint32_t pid, const std::string& name);
+    void SetThreadName(uint32_t pid, uint32_t tid, const std::string& name);
+    void AddEvent(uint32_t pid, uint32_t tid, const std::string& name, double startUs, double durationUs);
+};
+
+} // namespace Common
+} // namespace ABench
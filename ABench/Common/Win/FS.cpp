@@ -4,6 +4,8 @@
 #include "Common/Common.hpp"
 #include "Common/Logger.hpp"
 
+#include <algorithm>
+
 namespace ABench {
 namespace Common {
 namespace FS {
@@ -103,6 +105,37 @@ std::string JoinPaths(const std::string& a, const std::string& b)
     return first + '/' + second;
 }
 
+bool ListFiles(const std::string& path, std::vector<std::string>& files)
+{
+    std::wstring pathWStr;
+    if (!UTF8ToUTF16(JoinPaths(path, "*"), pathWStr))
+        return false;
+
+    WIN32_FIND_DATA findData;
+    HANDLE find = FindFirstFile(pathWStr.c_str(), &findData);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        DWORD err = GetLastError();
+        LOGE("Failed to list files in directory " << path << ": " << err);
+        return false;
+    }
+
+    files.clear();
+    do
+    {
+        if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+
+        std::string name;
+        if (UTF16ToUTF8(findData.cFileName, name))
+            files.push_back(name);
+    } while (FindNextFile(find, &findData));
+
+    FindClose(find);
+    std::sort(files.begin(), files.end());
+    return true;
+}
+
 bool RemoveFile(const std::string& path)
 {
     std::wstring pathWStr;
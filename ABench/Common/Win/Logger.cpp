@@ -2,17 +2,13 @@
 #include "../Common.hpp"
 #include "../Logger.hpp"
 
-#include <fstream>
 
 namespace ABench {
 namespace Logger {
+namespace Impl {
 
-std::ofstream logFile;
-
-void Log(LogLevel level, const std::stringstream& msg)
+void WriteConsole(LogLevel level, const std::string& line)
 {
-    const char* levelStr = nullptr;
-
     static HANDLE console = 0;
     if (!console)
         console = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -23,38 +19,29 @@ void Log(LogLevel level, const std::stringstream& msg)
     switch (level)
     {
     case LogLevel::DEBUG:
-        levelStr = "DEBUG";
         SetConsoleTextAttribute(console, FOREGROUND_BLUE | FOREGROUND_GREEN);
         break;
-    case LogLevel::INFO:
-        levelStr = " INF ";
-        break;
     case LogLevel::WARNING:
-        levelStr = " WRN ";
         SetConsoleTextAttribute(console, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY);
         break;
     case LogLevel::ERROR:
-        levelStr = "ERROR";
         SetConsoleTextAttribute(console, FOREGROUND_RED | FOREGROUND_INTENSITY);
         break;
     case LogLevel::MEMORY:
-        levelStr = " MEM ";
         SetConsoleTextAttribute(console, FOREGROUND_RED | FOREGROUND_GREEN);
+        break;
     }
 
-    std::stringstream fullMsg;
-    fullMsg << "[" << levelStr << "] " << msg.str() << "\n";
-    std::cout << fullMsg.str();
-    if (logFile.is_open())
-        logFile << fullMsg.str();
+    std::cout << line << std::endl;
 
     SetConsoleTextAttribute(console, conInfo.wAttributes);
 
     std::wstring wideMsg;
-    Common::UTF8ToUTF16(fullMsg.str(), wideMsg);
+    Common::UTF8ToUTF16(line + "\n", wideMsg);
 
     OutputDebugStringW(wideMsg.c_str());
 }
 
+} // namespace Impl
 } // namespace Logger
 } // namespace ABench
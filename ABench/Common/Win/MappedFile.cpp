@@ -0,0 +1,88 @@
+#include "PCH.hpp"
+#include "../MappedFile.hpp"
+#include "../Common.hpp"
+#include "../Logger.hpp"
+
+
+namespace ABench {
+namespace Common {
+
+MappedFile::MappedFile()
+    : mFile(INVALID_HANDLE_VALUE)
+    , mMapping(NULL)
+    , mData(nullptr)
+    , mSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+    std::wstring pathWStr;
+    if (!UTF8ToUTF16(path, pathWStr))
+        return false;
+
+    mFile = CreateFile(pathWStr.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        DWORD err = GetLastError();
+        LOGE("Failed to open file " << path << ": " << err);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+    {
+        LOGE("Failed to acquire size of file " << path);
+        Close();
+        return false;
+    }
+
+    mMapping = CreateFileMapping(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping == NULL)
+    {
+        DWORD err = GetLastError();
+        LOGE("Failed to create mapping of file " << path << ": " << err);
+        Close();
+        return false;
+    }
+
+    mData = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mData == nullptr)
+    {
+        DWORD err = GetLastError();
+        LOGE("Failed to map file " << path << ": " << err);
+        Close();
+        return false;
+    }
+
+    mSize = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData != nullptr)
+        UnmapViewOfFile(mData);
+
+    if (mMapping != NULL)
+        CloseHandle(mMapping);
+
+    if (mFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mFile);
+
+    mFile = INVALID_HANDLE_VALUE;
+    mMapping = NULL;
+    mData = nullptr;
+    mSize = 0;
+}
+
+} // namespace Common
+} // namespace ABench
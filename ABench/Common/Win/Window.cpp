@@ -170,8 +170,25 @@ bool Window::Open(int x, int y, int width, int height, const std::string& title)
     return true;
 }
 
+bool Window::OpenHeadless(int width, int height)
+{
+    if (mOpened)
+        return false;
+
+    mOpened = true;
+    mWidth = width;
+    mHeight = height;
+
+    OnOpen();
+
+    return true;
+}
+
 bool Window::SetTitle(const std::wstring& title)
 {
+    if (!mHWND)
+        return true;
+
     if (!SetWindowText(mHWND, title.c_str()))
     {
         DWORD error = GetLastError();
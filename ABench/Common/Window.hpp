@@ -64,6 +64,8 @@ public:
 
     bool Init();
     bool Open(int x, int y, int width, int height, const std::string& title);
+    // Opens the window without any platform window behind it - only callbacks are called
+    bool OpenHeadless(int width, int height);
     bool SetTitle(const std::wstring& title);
     bool SetTitle(const std::string& title);
     void SetInvisible(bool invisible);
@@ -3,6 +3,7 @@
 #include "Common/Logger.hpp"
 #include "Common/Timer.hpp"
 #include "Common/FS.hpp"
+#include "Common/Profiler.hpp"
 #include "Renderer/HighLevel/Renderer.hpp"
 #include "Math/Common.hpp"
 #include "Math/Matrix.hpp"
@@ -12,6 +13,7 @@
 #include "Scene/Light.hpp"
 #include "Scene/Scene.hpp"
 #include "Math/Interpolation/LinearInterpolator.hpp"
+#include "Benchmark/BenchmarkRunner.hpp"
 
 #include "ResourceDir.hpp"
 
@@ -30,11 +32,52 @@ std::vector<ABench::Scene::Light*> gLights;
 
 uint32_t EMITTERS_PARTICLE_LIMIT = 128;
 uint32_t LIGHT_COUNT = 128;
+uint32_t RECORDING_THREADS = 0; // 0 - pick based on available hardware threads
 
 bool gNoAsync = false;
 bool gTestMode = false;
+bool gHeadless = false;
+uint32_t gReadbackInterval = 0; // 0 - no frames are saved
+ABench::Renderer::LightCullingMode gLightCulling = ABench::Renderer::LightCullingMode::Tiled;
+bool gGpuCulling = false;
+bool gOcclusionCulling = false;
+bool gLightBVHCulling = false;
 const std::string NOASYNC_COMMAND = "noasync";
 const std::string TEST_COMMAND = "test";
+const std::string HEADLESS_COMMAND = "headless"; // optionally followed by ":N" to save every Nth frame
+const std::string BENCH_COMMAND = "bench"; // followed by scenario file and optional output path
+
+// common part of all test mode output files
+std::string GetOutputBaseName()
+{
+    std::string name = "abench_" + std::to_string(LIGHT_COUNT) + "_" + std::to_string(EMITTERS_PARTICLE_LIMIT);
+    if (gNoAsync)
+        name += "_noasync";
+
+    return name;
+}
+
+// runs all runs of a scenario, paths are relative to ABench root directory
+int RunBenchmark(const std::string& scenarioFile, const std::string& outputPath)
+{
+    std::string scenarioPath = scenarioFile;
+    if (!ABench::Common::FS::Exists(scenarioPath))
+        scenarioPath = ABench::Common::FS::JoinPaths(ABench::ResourceDir::BENCHMARKS, scenarioFile);
+
+    ABench::Benchmark::Scenario scenario;
+    if (!scenario.Load(scenarioPath))
+        return -1;
+
+    ABench::Benchmark::BenchmarkRunner runner;
+    bool succeeded = runner.Run(scenario);
+
+    std::string output = outputPath.empty() ? ("abench_bench_" + scenario.GetName() + ".json") : outputPath;
+    if (!runner.ExportJSON(output))
+        return -1;
+
+    LOGI("Benchmark results written to " << output);
+    return succeeded ? 0 : -1;
+}
 
 class ABenchWindow: public ABench::Common::Window
 {
@@ -91,13 +134,7 @@ class ABenchWindow: public ABench::Common::Window
         if (gTestMode)
             mCameraOnRails = true;
 
-        std::string csvFilename;
-        csvFilename = "abench_" + std::to_string(LIGHT_COUNT) + "_" + std::to_string(EMITTERS_PARTICLE_LIMIT);
-        if (gNoAsync)
-            csvFilename += "_noasync";
-
-        csvFilename += ".csv";
-        mCSVFile.open(csvFilename, std::fstream::out);
+        mCSVFile.open(GetOutputBaseName() + ".csv", std::fstream::out);
     }
 
     void OnClose() override
@@ -197,6 +234,23 @@ class ABenchWindow: public ABench::Common::Window
         if (key == ABench::Common::KeyCode::T)
             mLightFollowsCamera ^= true;
 
+        if (key == ABench::Common::KeyCode::C)
+        {
+            if (gLightCulling == ABench::Renderer::LightCullingMode::Tiled)
+                gLightCulling = ABench::Renderer::LightCullingMode::Clustered;
+            else
+                gLightCulling = ABench::Renderer::LightCullingMode::Tiled;
+        }
+
+        if (key == ABench::Common::KeyCode::G)
+            gGpuCulling ^= true;
+
+        if (key == ABench::Common::KeyCode::O)
+            gOcclusionCulling ^= true;
+
+        if (key == ABench::Common::KeyCode::B)
+            gLightBVHCulling ^= true;
+
         if (key == ABench::Common::KeyCode::F1)
         {
             mCameraOnRails ^= true;
@@ -217,16 +271,50 @@ public:
 
 int main(int argc, char* argv[])
 {
-    if (argc >= 2)
-        LIGHT_COUNT = std::stoi(argv[1]);
-    if (argc >= 3)
-        EMITTERS_PARTICLE_LIMIT = std::stoi(argv[2]);
-    if (argc >= 4)
-        if (TEST_COMMAND == argv[3])
-            gTestMode = true;
-    if (argc >= 5)
-        if (NOASYNC_COMMAND == argv[4])
-            gNoAsync = true;
+    PROFILER_THREAD("Main");
+
+    bool benchmark = false;
+    std::string scenarioFile;
+    std::string benchmarkOutput;
+    if (argc >= 3 && BENCH_COMMAND == argv[1])
+    {
+        benchmark = true;
+        scenarioFile = argv[2];
+        if (argc >= 4)
+            benchmarkOutput = argv[3];
+    }
+    else
+    {
+        if (argc >= 2)
+            LIGHT_COUNT = std::stoi(argv[1]);
+        if (argc >= 3)
+            EMITTERS_PARTICLE_LIMIT = std::stoi(argv[2]);
+        if (argc >= 4)
+            if (TEST_COMMAND == argv[3])
+                gTestMode = true;
+        if (argc >= 5)
+            if (NOASYNC_COMMAND == argv[4])
+                gNoAsync = true;
+        if (argc >= 6)
+            RECORDING_THREADS = std::stoi(argv[5]);
+        if (argc >= 7)
+        {
+            std::string headlessArg(argv[6]);
+            if (headlessArg.compare(0, HEADLESS_COMMAND.size(), HEADLESS_COMMAND) == 0)
+            {
+                gHeadless = true;
+                if (headlessArg.size() > HEADLESS_COMMAND.size() + 1 && headlessArg[HEADLESS_COMMAND.size()] == ':')
+                    gReadbackInterval = std::stoi(headlessArg.substr(HEADLESS_COMMAND.size() + 1));
+            }
+        }
+    }
+
+    if (gHeadless && !gTestMode)
+    {
+        // without a window there is no input, so only camera rails can drive (and finish) the run
+        LOGI("Headless mode requested - enabling test mode");
+        gTestMode = true;
+    }
 
 
     std::string path = ABench::Common::FS::GetParentDir(ABench::Common::FS::GetExecutablePath());
@@ -236,12 +324,26 @@ int main(int argc, char* argv[])
     if (!ABench::Common::FS::Exists(ABench::ResourceDir::SHADER_CACHE))
         ABench::Common::FS::CreateDir(ABench::ResourceDir::SHADER_CACHE);
 
+    if (benchmark)
+        return RunBenchmark(scenarioFile, benchmarkOutput);
+
     ABenchWindow window;
-    window.Init();
-    if (!window.Open(200, 200, windowWidth, windowHeight, "ABench"))
+    if (gHeadless)
     {
-        LOGE("Failed to initialize Window");
-        return -1;
+        if (!window.OpenHeadless(windowWidth, windowHeight))
+        {
+            LOGE("Failed to initialize headless Window");
+            return -1;
+        }
+    }
+    else
+    {
+        window.Init();
+        if (!window.Open(200, 200, windowWidth, windowHeight, "ABench"))
+        {
+            LOGE("Failed to initialize Window");
+            return -1;
+        }
     }
 
     bool debug = false;
@@ -259,6 +361,18 @@ int main(int argc, char* argv[])
     rendDesc.nearZ = 0.2f;
     rendDesc.farZ = 500.0f;
     rendDesc.noAsync = gNoAsync;
+    rendDesc.validateShaders = debug;
+    rendDesc.profile = gTestMode;
+    rendDesc.profileSamples = false;
+    rendDesc.headless = gHeadless;
+    rendDesc.readbackInterval = gReadbackInterval;
+    rendDesc.readbackPrefix = GetOutputBaseName() + "_frame";
+    rendDesc.backbufferCount = 2;
+    rendDesc.recordingThreads = RECORDING_THREADS;
+    rendDesc.lightCulling = gLightCulling;
+    rendDesc.gpuCulling = gGpuCulling;
+    rendDesc.occlusionCulling = gOcclusionCulling;
+    rendDesc.lightBVH = gLightBVHCulling;
     if (!rend.Init(rendDesc))
     {
         LOGE("Failed to initialize Renderer");
@@ -386,8 +500,15 @@ int main(int argc, char* argv[])
         float time = avgTime.Get();
         float fps = 1.0f / time;
 
-        window.SetTitle("ABench - " + std::to_string(fps) + " FPS (" + std::to_string(time * 1000.0f) + " ms)");
+        const char* cullingName = (gLightCulling == ABench::Renderer::LightCullingMode::Clustered) ? "clustered" : "tiled";
+        window.SetTitle("ABench - " + std::to_string(fps) + " FPS (" + std::to_string(time * 1000.0f) + " ms), "
+                        + cullingName + (gLightBVHCulling ? " BVH" : "") + " light culling, " + (gGpuCulling ? "GPU" : "CPU") + " object culling"
+                        + (gOcclusionCulling ? " with occlusion" : ""));
         window.Update(frameTime);
+        rend.SetLightCullingMode(gLightCulling);
+        rend.SetGpuCulling(gGpuCulling);
+        rend.SetOcclusionCulling(gOcclusionCulling);
+        rend.SetLightBVHCulling(gLightBVHCulling);
         rend.Draw(scene, window.GetCamera(), frameTime);
     }
 
@@ -397,5 +518,13 @@ int main(int argc, char* argv[])
 
     rend.WaitForAll();
 
+    if (gTestMode)
+    {
+        ABench::Renderer::GpuProfiler& profiler = rend.GetProfiler();
+        profiler.Flush();
+        profiler.ExportCSV(GetOutputBaseName() + "_passes.csv");
+        profiler.ExportTrace(GetOutputBaseName() + "_trace.json");
+    }
+
     return 0;
 }
@@ -49,6 +49,16 @@ public:
     void Init(const FrustumDesc& desc);
     void Refresh(const Vector3& pos, const Vector3& at, const Vector3& up);
     bool Intersects(const AABB& aabb) const; // true if even partially inside frustum
+
+    ABENCH_INLINE uint32_t GetPlaneCount() const
+    {
+        return PlaneSide::COUNT;
+    }
+
+    ABENCH_INLINE const Plane& GetPlane(uint32_t i) const
+    {
+        return mPlanes[i];
+    }
 };
 
 } // namespace Math
@@ -56,6 +56,9 @@ public:
     // Transposition
     Matrix& operator~();
 
+    // Inversion, returns zero matrix if this one is singular
+    const Matrix Inverse() const;
+
     // Power
     Matrix& operator^(float value);
 
@@ -23,6 +23,11 @@ public:
         return n;
     }
 
+    ABENCH_INLINE float GetDistance() const
+    {
+        return d;
+    }
+
     friend std::ostream& operator<<(std::ostream& o, const Plane& plane);
 };
 
@@ -29,5 +29,24 @@ void BitonicSort(std::vector<T>& arr, bool ascending)
     arr.resize(origSize);
 }
 
+/**
+ * Stable LSD radix sort, one byte of the key per pass. Key function returns an unsigned integer
+ * key of an element, passes over bytes equal in all keys are skipped. Temp is scratch memory of
+ * the same size as arr, it can be kept between calls to avoid reallocations.
+ */
+template <typename T, typename KeyFunc>
+void RadixSort(std::vector<T>& arr, std::vector<T>& temp, KeyFunc key)
+{
+    if (arr.size() > 1)
+        Impl::RadixSortInternal(arr, temp, key);
+}
+
+template <typename T>
+void RadixSort(std::vector<T>& arr)
+{
+    std::vector<T> temp;
+    RadixSort(arr, temp, [](const T& e) -> T { return e; });
+}
+
 } // namespace Math
 } // namespace ABench
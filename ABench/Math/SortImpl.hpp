@@ -117,6 +117,62 @@ void BitonicSortInternal(std::vector<T>& arr, bool ascending)
     }
 }
 
+// one pass of LSD radix sort, orders src by given byte of the key into dst
+template <typename T, typename KeyFunc>
+void RadixSortPass(const std::vector<T>& src, std::vector<T>& dst, const uint32_t* counts, uint32_t shift, KeyFunc& key)
+{
+    uint32_t offsets[256];
+    uint32_t offset = 0;
+    for (uint32_t b = 0; b < 256; ++b)
+    {
+        offsets[b] = offset;
+        offset += counts[b];
+    }
+
+    for (const T& e: src)
+    {
+        uint32_t b = static_cast<uint32_t>(key(e) >> shift) & 0xFF;
+        dst[offsets[b]++] = e;
+    }
+}
+
+template <typename T, typename KeyFunc>
+void RadixSortInternal(std::vector<T>& arr, std::vector<T>& temp, KeyFunc& key)
+{
+    using Key = decltype(key(arr[0]));
+    static_assert(std::is_unsigned<Key>::value, "Radix sort needs unsigned integer keys");
+    const uint32_t BYTE_COUNT = sizeof(Key);
+
+    // histograms of all bytes are gathered in a single walk over the keys
+    uint32_t counts[BYTE_COUNT * 256] = {};
+    for (const T& e: arr)
+    {
+        Key k = key(e);
+        for (uint32_t i = 0; i < BYTE_COUNT; ++i)
+            counts[i * 256 + (static_cast<uint32_t>(k >> (i * 8)) & 0xFF)]++;
+    }
+
+    temp.resize(arr.size());
+    std::vector<T>* src = &arr;
+    std::vector<T>* dst = &temp;
+    uint32_t size = static_cast<uint32_t>(arr.size());
+    for (uint32_t i = 0; i < BYTE_COUNT; ++i)
+    {
+        const uint32_t* byteCounts = &counts[i * 256];
+
+        // byte equal in all keys would not change the order
+        uint32_t firstByte = static_cast<uint32_t>(key(arr[0]) >> (i * 8)) & 0xFF;
+        if (byteCounts[firstByte] == size)
+            continue;
+
+        RadixSortPass(*src, *dst, byteCounts, i * 8, key);
+        std::swap(src, dst);
+    }
+
+    if (src != &arr)
+        arr.swap(temp);
+}
+
 } // namespace Impl
 } // namespace Math
 } // namespace ABench
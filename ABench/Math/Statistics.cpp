@@ -0,0 +1,95 @@
+#include "PCH.hpp"
+#include "Statistics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+// two-sided 95% critical values of Student's t distribution for 1..30 degrees of freedom
+const double T_CRITICAL_95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+const size_t T_CRITICAL_95_COUNT = sizeof(T_CRITICAL_95) / sizeof(T_CRITICAL_95[0]);
+const double Z_CRITICAL_95 = 1.960;
+
+double CriticalValue95(size_t degreesOfFreedom)
+{
+    if (degreesOfFreedom <= T_CRITICAL_95_COUNT)
+        return T_CRITICAL_95[degreesOfFreedom - 1];
+
+    return Z_CRITICAL_95;
+}
+
+} // namespace
+
+
+namespace ABench {
+namespace Math {
+
+Statistics::Statistics()
+    : count(0)
+    , mean(0.0)
+    , median(0.0)
+    , p99(0.0)
+    , min(0.0)
+    , max(0.0)
+    , stdDev(0.0)
+    , ciLow(0.0)
+    , ciHigh(0.0)
+{
+}
+
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    double rank = p * static_cast<double>(sorted.size() - 1);
+    size_t lower = static_cast<size_t>(std::floor(rank));
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    double fraction = rank - static_cast<double>(lower);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+Statistics CalculateStatistics(std::vector<double> samples)
+{
+    Statistics stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+
+    stats.count = samples.size();
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.median = Percentile(samples, 0.5);
+    stats.p99 = Percentile(samples, 0.99);
+
+    double sum = 0.0;
+    for (double s: samples)
+        sum += s;
+    stats.mean = sum / static_cast<double>(stats.count);
+
+    if (stats.count > 1)
+    {
+        double squares = 0.0;
+        for (double s: samples)
+            squares += (s - stats.mean) * (s - stats.mean);
+        stats.stdDev = std::sqrt(squares / static_cast<double>(stats.count - 1));
+    }
+
+    double margin = 0.0;
+    if (stats.count > 1)
+        margin = CriticalValue95(stats.count - 1) * stats.stdDev / std::sqrt(static_cast<double>(stats.count));
+    stats.ciLow = stats.mean - margin;
+    stats.ciHigh = stats.mean + margin;
+
+    return stats;
+}
+
+} // namespace Math
+} // namespace ABench
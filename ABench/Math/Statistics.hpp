@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+
+namespace ABench {
+namespace Math {
+
+struct Statistics
+{
+    size_t count;
+    double mean;
+    double median;
+    double p99;
+    double min;
+    double max;
+    double stdDev;
+    double ciLow; // 95% confidence interval of the mean
+    double ciHigh;
+
+    Statistics();
+};
+
+/**
+ * Calculates descriptive statistics of given samples.
+ *
+ * Percentiles interpolate linearly between closest ranks. Confidence interval of the mean uses
+ * Student's t distribution, so it stays honest for short runs.
+ */
+Statistics CalculateStatistics(std::vector<double> samples);
+
+// Calculates p-th percentile (p in [0, 1]) of already sorted samples
+double Percentile(const std::vector<double>& sorted, double p);
+
+} // namespace Math
+} // namespace ABench
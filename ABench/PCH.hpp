@@ -44,3 +44,6 @@
 #include <array>
 #include <numeric>
 #include <random>
+#include <thread>
+#include <mutex>
+#include <atomic>
@@ -0,0 +1,215 @@
+#include "PCH.hpp"
+#include "ClusterGrid.hpp"
+#include "LightBVH.hpp"
+
+#include "Common/Logger.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+namespace ABench {
+namespace Renderer {
+
+ClusterGrid::ClusterGrid()
+    : mDesc()
+    , mClustersX(0)
+    , mClustersY(0)
+    , mSliceScale(0.0f)
+    , mSliceBias(0.0f)
+    , mClusters()
+    , mGridLights()
+    , mCulledLights()
+{
+}
+
+bool ClusterGrid::Init(const ClusterGridDesc& desc)
+{
+    if (desc.pixelsPerCluster == 0 || desc.depthSlices == 0 || desc.viewportWidth == 0 || desc.viewportHeight == 0)
+    {
+        LOGE("Invalid cluster grid description");
+        return false;
+    }
+
+    if (desc.nearZ <= 0.0f || desc.farZ <= desc.nearZ)
+    {
+        LOGE("Cluster grid requires 0 < near < far, got " << desc.nearZ << " and " << desc.farZ);
+        return false;
+    }
+
+    mDesc = desc;
+    mClustersX = (desc.viewportWidth + desc.pixelsPerCluster - 1) / desc.pixelsPerCluster;
+    mClustersY = (desc.viewportHeight + desc.pixelsPerCluster - 1) / desc.pixelsPerCluster;
+
+    float logRange = logf(desc.farZ / desc.nearZ);
+    mSliceScale = desc.depthSlices / logRange;
+    mSliceBias = desc.depthSlices * logf(desc.nearZ) / logRange;
+
+    // directions of rays going through tile corners, scaled to unit view depth
+    Math::Matrix invProj = desc.projMat.Inverse();
+    std::vector<Math::Vector3> rays((mClustersX + 1) * (mClustersY + 1));
+    for (uint32_t y = 0; y <= mClustersY; ++y)
+    {
+        for (uint32_t x = 0; x <= mClustersX; ++x)
+        {
+            float clipX = static_cast<float>(x * desc.pixelsPerCluster) / desc.viewportWidth * 2.0f - 1.0f;
+            float clipY = static_cast<float>(y * desc.pixelsPerCluster) / desc.viewportHeight * 2.0f - 1.0f;
+            Math::Vector4 p = invProj * Math::Vector4(clipX, clipY, 1.0f, 1.0f);
+            rays[y * (mClustersX + 1) + x] = Math::Vector3(p / -p[2]);
+        }
+    }
+
+    mClusters.resize(GetClusterCount());
+    for (uint32_t z = 0; z < desc.depthSlices; ++z)
+    {
+        float sliceNear = desc.nearZ * powf(desc.farZ / desc.nearZ, static_cast<float>(z) / desc.depthSlices);
+        float sliceFar = desc.nearZ * powf(desc.farZ / desc.nearZ, static_cast<float>(z + 1) / desc.depthSlices);
+
+        for (uint32_t y = 0; y < mClustersY; ++y)
+        {
+            for (uint32_t x = 0; x < mClustersX; ++x)
+            {
+                float aabbMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+                float aabbMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+                for (uint32_t c = 0; c < 8; ++c)
+                {
+                    const Math::Vector3& ray = rays[(y + ((c >> 1) & 1)) * (mClustersX + 1) + x + (c & 1)];
+                    Math::Vector3 corner = ray * ((c & 4) ? sliceFar : sliceNear);
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        aabbMin[axis] = std::min(aabbMin[axis], corner[axis]);
+                        aabbMax[axis] = std::max(aabbMax[axis], corner[axis]);
+                    }
+                }
+
+                ClusterAABB& cluster = mClusters[(z * mClustersY + y) * mClustersX + x];
+                cluster.min = Math::Vector4(aabbMin[0], aabbMin[1], aabbMin[2], 1.0f);
+                cluster.max = Math::Vector4(aabbMax[0], aabbMax[1], aabbMax[2], 1.0f);
+            }
+        }
+    }
+
+    mGridLights.resize(mClusters.size());
+    return true;
+}
+
+float ClusterGrid::GetViewDepth(float depth) const
+{
+    // inverse of depth mapping done by CreateRHProjectionMatrix, same as in ForwardPass.frag
+    return mDesc.nearZ * mDesc.farZ / (mDesc.farZ + depth * (mDesc.nearZ - mDesc.farZ));
+}
+
+uint32_t ClusterGrid::GetSlice(float viewDepth) const
+{
+    float slice = floorf(logf(viewDepth) * mSliceScale - mSliceBias);
+    return static_cast<uint32_t>(std::min(std::max(slice, 0.0f), static_cast<float>(mDesc.depthSlices - 1)));
+}
+
+uint32_t ClusterGrid::GetClusterIndex(uint32_t pixelX, uint32_t pixelY, float viewDepth) const
+{
+    uint32_t x = pixelX / mDesc.pixelsPerCluster;
+    uint32_t y = pixelY / mDesc.pixelsPerCluster;
+    return (GetSlice(viewDepth) * mClustersY + y) * mClustersX + x;
+}
+
+void ClusterGrid::Cull(const Math::Matrix& view, const LightSphere* lights, uint32_t lightCount)
+{
+    std::vector<Math::Vector4> viewLights(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+        viewLights[i] = view * lights[i].position;
+
+    // same as ClusteredLightCuller.comp
+    mCulledLights.clear();
+    for (uint32_t c = 0; c < mClusters.size(); ++c)
+    {
+        const ClusterAABB& cluster = mClusters[c];
+        GridLight& gridLight = mGridLights[c];
+        gridLight.offset = static_cast<uint32_t>(mCulledLights.size());
+        gridLight.count = 0;
+
+        for (uint32_t i = 0; i < lightCount; ++i)
+        {
+            float distance = 0.0f;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float p = viewLights[i][axis];
+                float d = std::max(cluster.min[axis] - p, 0.0f) + std::max(p - cluster.max[axis], 0.0f);
+                distance += d * d;
+            }
+
+            if (distance > lights[i].range * lights[i].range)
+                continue;
+
+            mCulledLights.push_back(i);
+            gridLight.count++;
+        }
+    }
+}
+
+void ClusterGrid::Cull(const Math::Matrix& view, const LightBVH& bvh)
+{
+    const Math::Matrix invView = view.Inverse();
+
+    mCulledLights.clear();
+    for (uint32_t c = 0; c < mClusters.size(); ++c)
+    {
+        const ClusterAABB& cluster = mClusters[c];
+        GridLight& gridLight = mGridLights[c];
+        gridLight.offset = static_cast<uint32_t>(mCulledLights.size());
+        gridLight.count = 0;
+
+        const float clusterMin[] = { cluster.min[0], cluster.min[1], cluster.min[2] };
+        const float clusterMax[] = { cluster.max[0], cluster.max[1], cluster.max[2] };
+        float worldMin[3];
+        float worldMax[3];
+        LightBVH::BoxToWorld(invView, clusterMin, clusterMax, worldMin, worldMax);
+
+        bvh.Traverse(
+            [&](const LightBVHNode& node)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                    if (node.min[axis] > worldMax[axis] || node.max[axis] < worldMin[axis])
+                        return false;
+                return true;
+            },
+            [&](const LightBVHLight& light)
+            {
+                const Math::Vector4 pos = view * Math::Vector4(light.position[0], light.position[1], light.position[2], 1.0f);
+                float distance = 0.0f;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float p = pos[axis];
+                    float d = std::max(cluster.min[axis] - p, 0.0f) + std::max(p - cluster.max[axis], 0.0f);
+                    distance += d * d;
+                }
+
+                if (distance > light.range * light.range)
+                    return;
+
+                mCulledLights.push_back(light.index);
+                gridLight.count++;
+            });
+    }
+}
+
+float ClusterGrid::GetAverageLightsPerPixel(const float* depth) const
+{
+    uint64_t total = 0;
+    for (uint32_t y = 0; y < mDesc.viewportHeight; ++y)
+        for (uint32_t x = 0; x < mDesc.viewportWidth; ++x)
+            total += mGridLights[GetClusterIndex(x, y, GetViewDepth(depth[y * mDesc.viewportWidth + x]))].count;
+
+    return static_cast<float>(total) / (mDesc.viewportWidth * mDesc.viewportHeight);
+}
+
+uint32_t ClusterGrid::GetMaxLightsPerCluster() const
+{
+    uint32_t result = 0;
+    for (auto& g: mGridLights)
+        result = std::max(result, g.count);
+    return result;
+}
+
+} // namespace Renderer
+} // namespace ABench
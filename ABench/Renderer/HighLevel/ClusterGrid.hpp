@@ -0,0 +1,127 @@
+#pragma once
+
+#include "LightCullingReference.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+struct ClusterGridDesc
+{
+    ABench::Math::Matrix projMat;
+    uint32_t viewportWidth;
+    uint32_t viewportHeight;
+    uint32_t pixelsPerCluster;
+    uint32_t depthSlices;
+    float nearZ;
+    float farZ;
+
+    ClusterGridDesc()
+        : projMat()
+        , viewportWidth(0)
+        , viewportHeight(0)
+        , pixelsPerCluster(0)
+        , depthSlices(0)
+        , nearZ(0.0f)
+        , farZ(0.0f)
+    {
+    }
+};
+
+// Same layout as ClusterAABB structure in ClusteredLightCuller.comp, view space
+struct ClusterAABB
+{
+    Math::Vector4 min;
+    Math::Vector4 max;
+};
+
+/**
+ * View-space bounds of light clusters - screen tiles split along depth into slices.
+ *
+ * Slices grow exponentially from near to far plane, so clusters keep roughly the same
+ * proportions at every distance. Unlike tiles bounded by min/max depth of the depth buffer,
+ * clusters do not depend on the scene, so the grid is built once per projection and a tile
+ * covering both a near column and far background does not gather lights from the whole space
+ * between them.
+ *
+ * Cull() is the CPU version of ClusteredLightCuller.comp, with the output in the same layout
+ * as LightCullingReference's. With a LightBVH clusters walk the hierarchy instead of testing
+ * every light, like the shader does with LIGHT_BVH == 1 - nodes are tested against cluster's
+ * bounds moved to world space, lights of accepted leaves in view space.
+ */
+class ClusterGrid
+{
+    ClusterGridDesc mDesc;
+    uint32_t mClustersX;
+    uint32_t mClustersY;
+    float mSliceScale;
+    float mSliceBias;
+    std::vector<ClusterAABB> mClusters;
+    std::vector<GridLight> mGridLights;
+    std::vector<uint32_t> mCulledLights;
+
+public:
+    ClusterGrid();
+
+    bool Init(const ClusterGridDesc& desc);
+    void Cull(const Math::Matrix& view, const LightSphere* lights, uint32_t lightCount);
+    void Cull(const Math::Matrix& view, const LightBVH& bvh);
+
+    // Distance from the camera along view direction for a value from depth buffer
+    float GetViewDepth(float depth) const;
+    uint32_t GetSlice(float viewDepth) const;
+    uint32_t GetClusterIndex(uint32_t pixelX, uint32_t pixelY, float viewDepth) const;
+
+    // Average number of lights evaluated per pixel by ForwardPass.frag for given depth buffer
+    float GetAverageLightsPerPixel(const float* depth) const;
+    uint32_t GetMaxLightsPerCluster() const;
+
+    ABENCH_INLINE const ClusterGridDesc& GetDesc() const
+    {
+        return mDesc;
+    }
+
+    ABENCH_INLINE uint32_t GetClustersX() const
+    {
+        return mClustersX;
+    }
+
+    ABENCH_INLINE uint32_t GetClustersY() const
+    {
+        return mClustersY;
+    }
+
+    ABENCH_INLINE uint32_t GetClusterCount() const
+    {
+        return mClustersX * mClustersY * mDesc.depthSlices;
+    }
+
+    // Slice of view depth d is floor(log(d) * scale - bias)
+    ABENCH_INLINE float GetSliceScale() const
+    {
+        return mSliceScale;
+    }
+
+    ABENCH_INLINE float GetSliceBias() const
+    {
+        return mSliceBias;
+    }
+
+    ABENCH_INLINE const std::vector<ClusterAABB>& GetClusters() const
+    {
+        return mClusters;
+    }
+
+    ABENCH_INLINE const std::vector<GridLight>& GetGridLights() const
+    {
+        return mGridLights;
+    }
+
+    ABENCH_INLINE const std::vector<uint32_t>& GetCulledLights() const
+    {
+        return mCulledLights;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
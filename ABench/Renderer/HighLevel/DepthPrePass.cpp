@@ -3,6 +3,7 @@
 
 #include "Renderer/LowLevel/DescriptorAllocator.hpp"
 
+#include "Common/Profiler.hpp"
 #include "Math/Matrix.hpp"
 
 #include "ShaderMacroDefinitions.hpp"
@@ -94,54 +95,83 @@ bool DepthPrePass::Init(const DevicePtr& device, const DepthPrePassDesc& desc)
     if (!mCommandBuffer.Init(mDevice, DeviceQueueType::GRAPHICS))
         return false;
 
+    ParallelRecorderDesc recorderDesc;
+    recorderDesc.threadPool = desc.threadPool;
+    recorderDesc.queueType = DeviceQueueType::GRAPHICS;
+    recorderDesc.renderPass = mRenderPass;
+    recorderDesc.framebuffer = &mFramebuffer;
+    if (!mRecorder.Init(mDevice, recorderDesc))
+        return false;
+
 
     return true;
 }
 
-void DepthPrePass::Draw(const Scene::Scene& scene, const DepthPrePassDrawDesc& desc)
+void DepthPrePass::RecordModels(CommandBuffer* cmd, uint32_t begin, uint32_t end, const DepthPrePassDrawDesc& desc)
 {
-    // recording Command Buffer
+    PROFILER_SCOPE("DepthPrePass::RecordModels");
+
+    // secondary Command Buffers do not inherit dynamic state
+    cmd->SetViewport(0, 0, mDepthTexture.GetWidth(), mDepthTexture.GetHeight(), 0.0f, 1.0f);
+    cmd->SetScissor(0, 0, mDepthTexture.GetWidth(), mDepthTexture.GetHeight());
+
+    VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    MultiGraphicsPipelineShaderMacros emptyMacros;
+    cmd->BindPipeline(mPipeline.GetGraphicsPipeline(emptyMacros), bindPoint);
+
+    for (uint32_t i = begin; i < end; ++i)
     {
-        mCommandBuffer.Begin();
+        const DrawListEntry& entry = desc.drawList->GetEntry(i);
+        cmd->BindDescriptorSet(desc.vertexShaderSet, bindPoint, 0, mPipelineLayout, entry.transformOffset);
 
-        mCommandBuffer.SetViewport(0, 0, mDepthTexture.GetWidth(), mDepthTexture.GetHeight(), 0.0f, 1.0f);
-        mCommandBuffer.SetScissor(0, 0, mDepthTexture.GetWidth(), mDepthTexture.GetHeight());
+        uint32_t drawIndex = entry.firstDraw;
 
-        VkPipelineBindPoint bindPoint =  VK_PIPELINE_BIND_POINT_GRAPHICS;
-        mCommandBuffer.BeginRenderPass(mRenderPass, &mFramebuffer, ABENCH_CLEAR_DEPTH, nullptr, 1.0f);
+        entry.model->ForEachMesh([&](Scene::Mesh* mesh) {
+            // depth only needs positions, vertex parameters stream is not bound
+            cmd->BindVertexBuffer(mesh->GetVertexBuffer(), 0, 0);
 
-        MultiGraphicsPipelineShaderMacros emptyMacros;
-        scene.ForEachObject([&](const Scene::Object* o) -> bool {
-            if (o->GetComponent()->GetType() == Scene::ComponentType::Model)
+            VkDeviceSize commandOffset = (drawIndex++) * sizeof(VkDrawIndexedIndirectCommand);
+            if (mesh->ByIndices())
+            {
+                cmd->BindIndexBuffer(mesh->GetIndexBuffer());
+                if (desc.drawCommands)
+                    cmd->DrawIndexedIndirect(desc.drawCommands, commandOffset);
+                else
+                    cmd->DrawIndexed(mesh->GetPointCount());
+            }
+            else
             {
-                Scene::Model* model = dynamic_cast<Scene::Model*>(o->GetComponent());
-
-                if (!model->ToRender())
-                    return true;
-
-                // world matrix update
-                uint32_t offset = desc.ringBufferPtr->Write(&model->GetTransform(), sizeof(ABench::Math::Matrix));
-                mCommandBuffer.BindDescriptorSet(desc.vertexShaderSet, bindPoint, 0, mPipelineLayout, offset);
-
-                model->ForEachMesh([&](Scene::Mesh* mesh) {
-                    mCommandBuffer.BindPipeline(mPipeline.GetGraphicsPipeline(emptyMacros), bindPoint);
-                    mCommandBuffer.BindVertexBuffer(mesh->GetVertexBuffer(), 0, 0);
-
-                    if (mesh->ByIndices())
-                    {
-                        mCommandBuffer.BindIndexBuffer(mesh->GetIndexBuffer());
-                        mCommandBuffer.DrawIndexed(mesh->GetPointCount());
-                    }
-                    else
-                    {
-                        mCommandBuffer.Draw(mesh->GetPointCount(), 1);
-                    }
-                });
+                if (desc.drawCommands)
+                    cmd->DrawIndirect(desc.drawCommands, commandOffset);
+                else
+                    cmd->Draw(mesh->GetPointCount(), 1);
             }
+        });
+    }
+}
 
-            return true;
+void DepthPrePass::Draw(const DepthPrePassDrawDesc& desc)
+{
+    PROFILER_SCOPE("DepthPrePass::Draw");
+
+    // recording secondary Command Buffers, visible models are split evenly between threads
+    bool recorded = mRecorder.Record(desc.drawList->GetSize(),
+        [&](CommandBuffer* cmd, uint32_t begin, uint32_t end) {
+            RecordModels(cmd, begin, end, desc);
         });
+    if (!recorded)
+    {
+        LOGE("Failure during secondary Command Buffer recording");
+        return;
+    }
+
+    // recording primary Command Buffer
+    {
+        mCommandBuffer.Begin();
 
+        mCommandBuffer.BeginRenderPass(mRenderPass, &mFramebuffer, ABENCH_CLEAR_DEPTH, nullptr, 1.0f,
+                                       VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        mRecorder.Execute(&mCommandBuffer);
         mCommandBuffer.EndRenderPass();
 
         if (!mCommandBuffer.End())
@@ -151,8 +181,7 @@ void DepthPrePass::Draw(const Scene::Scene& scene, const DepthPrePassDrawDesc& d
         }
     }
 
-    mDevice->Execute(DeviceQueueType::GRAPHICS, &mCommandBuffer, 0,
-                     nullptr, nullptr, desc.signalSem, VK_NULL_HANDLE);
+    desc.frameGraph->Schedule(desc.node, &mCommandBuffer);
 }
 
 } // namespace Renderer
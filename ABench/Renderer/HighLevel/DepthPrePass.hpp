@@ -8,11 +8,17 @@
 #include "Renderer/LowLevel/VertexLayout.hpp"
 #include "Renderer/LowLevel/RingBuffer.hpp"
 #include "Renderer/LowLevel/MultiPipeline.hpp"
+#include "Renderer/LowLevel/ParallelRecorder.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
 #include "Renderer/LowLevel/Tools.hpp"
 
+#include "DrawList.hpp"
+
 #include "Scene/Camera.hpp"
 #include "Scene/Scene.hpp"
 
+#include "Common/ThreadPool.hpp"
+
 
 namespace ABench {
 namespace Renderer {
@@ -22,25 +28,31 @@ struct DepthPrePassDesc
     uint32_t width;
     uint32_t height;
     VkDescriptorSetLayout vertexShaderLayout;
+    Common::ThreadPool* threadPool;
 
     DepthPrePassDesc()
         : width(0)
         , height(0)
         , vertexShaderLayout(VK_NULL_HANDLE)
+        , threadPool(nullptr)
     {
     }
 };
 
 struct DepthPrePassDrawDesc
 {
-    RingBuffer* ringBufferPtr;
+    const DrawList* drawList;
+    const Buffer* drawCommands; // ObjectCuller's indirect commands, direct draws when null
     VkDescriptorSet vertexShaderSet;
-    VkSemaphore signalSem;
+    FrameGraph* frameGraph;
+    FrameGraphNode node;
 
     DepthPrePassDrawDesc()
-        : ringBufferPtr(nullptr)
+        : drawList(nullptr)
+        , drawCommands(nullptr)
         , vertexShaderSet(VK_NULL_HANDLE)
-        , signalSem(VK_NULL_HANDLE)
+        , frameGraph(nullptr)
+        , node(FRAME_GRAPH_INVALID_NODE)
     {
     }
 };
@@ -54,13 +66,16 @@ class DepthPrePass final
     VertexLayout mVertexLayout;
     MultiPipeline mPipeline;
     CommandBuffer mCommandBuffer;
+    ParallelRecorder mRecorder;
 
     VkRAII<VkRenderPass> mRenderPass;
     VkRAII<VkPipelineLayout> mPipelineLayout;
 
+    void RecordModels(CommandBuffer* cmd, uint32_t begin, uint32_t end, const DepthPrePassDrawDesc& desc);
+
 public:
     bool Init(const DevicePtr& device, const DepthPrePassDesc& desc);
-    void Draw(const Scene::Scene& scene, const DepthPrePassDrawDesc& desc);
+    void Draw(const DepthPrePassDrawDesc& desc);
 
     ABENCH_INLINE Texture* GetDepthTexture()
     {
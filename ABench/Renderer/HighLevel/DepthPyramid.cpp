@@ -0,0 +1,150 @@
+#include "PCH.hpp"
+#include "DepthPyramid.hpp"
+
+#include "Common/Logger.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+
+namespace ABench {
+namespace Renderer {
+
+DepthPyramid::DepthPyramid()
+    : mWidth(0)
+    , mHeight(0)
+    , mFirstLevel(0)
+    , mLevels()
+    , mData()
+{
+}
+
+bool DepthPyramid::Init(uint32_t width, uint32_t height)
+{
+    if (width == 0 || height == 0)
+    {
+        LOGE("Invalid depth pyramid dimensions " << width << "x" << height);
+        return false;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mFirstLevel = 0;
+
+    // nothing is occluded by an empty pyramid
+    mData.assign(CalculateLevels(width, height, mLevels), DepthBounds{ 1.0f, 1.0f });
+    return true;
+}
+
+uint32_t DepthPyramid::CalculateLevels(uint32_t width, uint32_t height, std::vector<DepthPyramidLevel>& levels)
+{
+    levels.clear();
+
+    uint32_t offset = 0;
+    do
+    {
+        DepthPyramidLevel level;
+        level.width = width = (width + 1) / 2;
+        level.height = height = (height + 1) / 2;
+        level.offset = offset;
+        levels.push_back(level);
+        offset += level.width * level.height;
+    } while (width > 1 || height > 1);
+
+    return offset;
+}
+
+void DepthPyramid::Build(const float* depth)
+{
+    // same as HiZPyramid.comp - first level reads depth buffer, others the level before them
+    for (uint32_t l = 0; l < mLevels.size(); ++l)
+    {
+        const DepthPyramidLevel& level = mLevels[l];
+        uint32_t srcWidth = (l == 0) ? mWidth : mLevels[l - 1].width;
+        uint32_t srcHeight = (l == 0) ? mHeight : mLevels[l - 1].height;
+
+        for (uint32_t y = 0; y < level.height; ++y)
+        {
+            for (uint32_t x = 0; x < level.width; ++x)
+            {
+                DepthBounds bounds = { FLT_MAX, -FLT_MAX };
+                for (uint32_t sy = y * 2; sy < std::min(y * 2 + 2, srcHeight); ++sy)
+                {
+                    for (uint32_t sx = x * 2; sx < std::min(x * 2 + 2, srcWidth); ++sx)
+                    {
+                        DepthBounds src;
+                        if (l == 0)
+                            src.min = src.max = depth[sy * mWidth + sx];
+                        else
+                            src = mData[mLevels[l - 1].offset + sy * srcWidth + sx];
+
+                        bounds.min = std::min(bounds.min, src.min);
+                        bounds.max = std::max(bounds.max, src.max);
+                    }
+                }
+
+                mData[level.offset + y * level.width + x] = bounds;
+            }
+        }
+    }
+}
+
+bool DepthPyramid::IsOccluded(const Math::AABB& aabb, const Math::Matrix& viewProj) const
+{
+    // screen rectangle and nearest depth of the box
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float minDepth = FLT_MAX;
+    for (uint32_t c = 0; c < 8; ++c)
+    {
+        const Math::Vector4& vx = aabb[(c & 1) ? Math::AABB::AABBVert::MAX : Math::AABB::AABBVert::MIN];
+        const Math::Vector4& vy = aabb[(c & 2) ? Math::AABB::AABBVert::MAX : Math::AABB::AABBVert::MIN];
+        const Math::Vector4& vz = aabb[(c & 4) ? Math::AABB::AABBVert::MAX : Math::AABB::AABBVert::MIN];
+        Math::Vector4 clip = viewProj * Math::Vector4(vx[0], vy[1], vz[2], 1.0f);
+
+        // box reaches behind the camera, its projection is unbounded
+        if (clip[3] <= 0.0f)
+            return false;
+
+        float x = (clip[0] / clip[3] * 0.5f + 0.5f) * mWidth;
+        float y = (clip[1] / clip[3] * 0.5f + 0.5f) * mHeight;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+        minDepth = std::min(minDepth, clip[2] / clip[3]);
+    }
+
+    // boxes off screen are left for frustum culling
+    if (maxX < 0.0f || maxY < 0.0f || minX >= mWidth || minY >= mHeight)
+        return false;
+
+    uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0f));
+    uint32_t y0 = static_cast<uint32_t>(std::max(minY, 0.0f));
+    uint32_t x1 = static_cast<uint32_t>(std::min(maxX, static_cast<float>(mWidth - 1)));
+    uint32_t y1 = static_cast<uint32_t>(std::min(maxY, static_cast<float>(mHeight - 1)));
+
+    // the finest level on which the rectangle spans at most 2x2 texels
+    uint32_t level = mFirstLevel;
+    while (level + 1 < mLevels.size() &&
+           ((x1 >> (level + 1)) - (x0 >> (level + 1)) > 1 || (y1 >> (level + 1)) - (y0 >> (level + 1)) > 1))
+        level++;
+
+    uint32_t shift = level + 1;
+    float maxDepth = 0.0f;
+    for (uint32_t y = y0 >> shift; y <= (y1 >> shift); ++y)
+        for (uint32_t x = x0 >> shift; x <= (x1 >> shift); ++x)
+            maxDepth = std::max(maxDepth, GetTexel(level, x, y).max);
+
+    return minDepth > maxDepth;
+}
+
+uint32_t DepthPyramid::GetLevelForTexelSize(uint32_t pixels)
+{
+    uint32_t level = 0;
+    while ((2u << level) < pixels)
+        level++;
+    return level;
+}
+
+} // namespace Renderer
+} // namespace ABench
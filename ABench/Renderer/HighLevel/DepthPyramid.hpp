@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "Math/AABB.hpp"
+
+#include <vector>
+
+
+namespace ABench {
+namespace Renderer {
+
+// Same layout as vec2 elements of depth pyramid buffer in HiZPyramid.comp
+struct DepthBounds
+{
+    float min;
+    float max;
+};
+
+struct DepthPyramidLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset; // index of level's first texel in the buffer
+};
+
+/**
+ * Min/max depth pyramid (hierarchical Z) and occlusion test against it.
+ *
+ * Level 0 holds depth bounds of 2x2 pixel blocks of the depth buffer, every next level bounds
+ * 2x2 texels of the previous one, down to a single texel. Level sizes are rounded up, so texel
+ * x of level l covers pixels [x * 2^(l+1), (x + 1) * 2^(l+1)) and screen tiles of 2^(l+1)
+ * pixels match texels of level l one to one. All levels are packed one after another.
+ *
+ * Build() is the CPU version of HiZPyramid.comp and IsOccluded() of the test done by
+ * ObjectCuller.comp. When the pyramid is read back from the GPU, only levels starting from
+ * SetFirstLevel() can be filled - finer ones are then never used.
+ */
+class DepthPyramid
+{
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mFirstLevel;
+    std::vector<DepthPyramidLevel> mLevels;
+    std::vector<DepthBounds> mData;
+
+public:
+    DepthPyramid();
+
+    bool Init(uint32_t width, uint32_t height);
+
+    // Depth holds width * height values of a depth buffer, row by row from the top
+    void Build(const float* depth);
+
+    // True if the whole box is behind depth stored in the pyramid. ViewProj has to be the
+    // matrix the depth buffer was rendered with.
+    bool IsOccluded(const Math::AABB& aabb, const Math::Matrix& viewProj) const;
+
+    // Fills sizes and offsets of pyramid's levels, returns number of texels of all levels
+    static uint32_t CalculateLevels(uint32_t width, uint32_t height, std::vector<DepthPyramidLevel>& levels);
+
+    // Level whose texels cover blocks of given number of pixels, which has to be a power of two
+    static uint32_t GetLevelForTexelSize(uint32_t pixels);
+
+    ABENCH_INLINE void SetFirstLevel(uint32_t level)
+    {
+        mFirstLevel = level;
+    }
+
+    ABENCH_INLINE uint32_t GetFirstLevel() const
+    {
+        return mFirstLevel;
+    }
+
+    ABENCH_INLINE uint32_t GetWidth() const
+    {
+        return mWidth;
+    }
+
+    ABENCH_INLINE uint32_t GetHeight() const
+    {
+        return mHeight;
+    }
+
+    ABENCH_INLINE uint32_t GetLevelCount() const
+    {
+        return static_cast<uint32_t>(mLevels.size());
+    }
+
+    ABENCH_INLINE const DepthPyramidLevel& GetLevel(uint32_t level) const
+    {
+        return mLevels[level];
+    }
+
+    ABENCH_INLINE const DepthBounds& GetTexel(uint32_t level, uint32_t x, uint32_t y) const
+    {
+        return mData[mLevels[level].offset + y * mLevels[level].width + x];
+    }
+
+    ABENCH_INLINE DepthBounds* GetData()
+    {
+        return mData.data();
+    }
+
+    // Number of texels of all levels
+    ABENCH_INLINE uint32_t GetSize() const
+    {
+        return static_cast<uint32_t>(mData.size());
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,79 @@
+#include "PCH.hpp"
+#include "DrawList.hpp"
+
+#include "Common/Logger.hpp"
+#include "Common/Profiler.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+DrawList::DrawList()
+    : mEntries()
+    , mDrawCount(0)
+{
+}
+
+void DrawList::Build(const Scene::Scene& scene, const Math::Frustum* frustum, const DrawListOcclusion* occlusion)
+{
+    PROFILER_SCOPE("DrawList::Build");
+
+    mEntries.clear();
+    mDrawCount = 0;
+    scene.ForEachObject([&](const Scene::Object* o) -> bool {
+        if (o->GetComponent()->GetType() == Scene::ComponentType::Model)
+        {
+            Scene::Model* model = dynamic_cast<Scene::Model*>(o->GetComponent());
+            Math::AABB aabb = model->GetTransform() * model->GetAABB();
+            model->SetToRender((frustum == nullptr || frustum->Intersects(aabb)) &&
+                               (occlusion == nullptr || !occlusion->depthPyramid->IsOccluded(aabb, occlusion->viewProj)));
+            if (model->ToRender())
+            {
+                DrawListEntry entry;
+                entry.model = model;
+                entry.firstDraw = mDrawCount;
+                mEntries.push_back(entry);
+                mDrawCount += model->GetMeshCount();
+            }
+        }
+
+        return true;
+    });
+}
+
+uint32_t DrawList::GetTransformStride(VkDeviceSize minUniformBufferOffsetAlignment)
+{
+    // alignment is a power of two, so rounding it up to the matrix size keeps both requirements
+    const VkDeviceSize matrixSize = sizeof(Math::Matrix);
+    VkDeviceSize stride = (minUniformBufferOffsetAlignment + matrixSize - 1) / matrixSize * matrixSize;
+    return static_cast<uint32_t>(stride);
+}
+
+bool DrawList::UploadTransforms(RingBuffer* ringBuffer, uint32_t transformStride)
+{
+    PROFILER_SCOPE("DrawList::UploadTransforms");
+
+    if (mEntries.empty())
+        return true;
+
+    uint32_t offset = 0;
+    char* data = reinterpret_cast<char*>(ringBuffer->Allocate(mEntries.size() * transformStride, offset));
+    if (data == nullptr)
+    {
+        LOGE("Not enough space in Ring Buffer for " << mEntries.size() << " transforms");
+        return false;
+    }
+
+    for (auto& entry: mEntries)
+    {
+        memcpy(data, &entry.model->GetTransform(), sizeof(ABench::Math::Matrix));
+        entry.transformOffset = offset;
+        data += transformStride;
+        offset += transformStride;
+    }
+
+    return true;
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Renderer/LowLevel/RingBuffer.hpp"
+
+#include "Math/Frustum.hpp"
+
+#include "Scene/Scene.hpp"
+
+#include "DepthPyramid.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+struct DrawListEntry
+{
+    Scene::Model* model;
+    uint32_t transformOffset; // Ring Buffer offset of model's world matrix
+    uint32_t firstDraw; // index of model's first mesh among all meshes of the list
+
+    DrawListEntry()
+        : model(nullptr)
+        , transformOffset(0)
+        , firstDraw(0)
+    {
+    }
+};
+
+struct DrawListOcclusion
+{
+    const DepthPyramid* depthPyramid;
+    Math::Matrix viewProj; // matrix the pyramid's depth was rendered with
+
+    DrawListOcclusion()
+        : depthPyramid(nullptr)
+        , viewProj()
+    {
+    }
+};
+
+/**
+ * Models which passed view frustum (and optionally occlusion) culling in current frame.
+ *
+ * Built once per frame and consumed by both Depth Pre-Pass and Forward Pass, so the scene is
+ * walked and every world matrix is written to the Ring Buffer only once. Transforms of all
+ * entries go to a single Ring Buffer allocation, one matrix per dynamic uniform offset. Offsets
+ * are also multiples of the matrix size, so bindless Forward Pass indexes the same data as an array.
+ *
+ * With culling done on GPU the list holds all models, and each mesh is drawn with an indirect
+ * command at its draw index - ObjectCuller leaves culled meshes without instances.
+ */
+class DrawList final
+{
+    std::vector<DrawListEntry> mEntries;
+    uint32_t mDrawCount;
+
+public:
+    DrawList();
+
+    // Culls scene's models against the frustum and gathers the visible ones.
+    // Without a frustum all models are gathered. Models inside the frustum can also be
+    // tested against a depth pyramid, usually read back from the previous frame.
+    void Build(const Scene::Scene& scene, const Math::Frustum* frustum, const DrawListOcclusion* occlusion = nullptr);
+
+    // Distance between transforms, valid as a dynamic uniform offset and as a matrix array index
+    static uint32_t GetTransformStride(VkDeviceSize minUniformBufferOffsetAlignment);
+
+    // Writes world matrices of gathered models to the Ring Buffer, must be called every frame after Build()
+    bool UploadTransforms(RingBuffer* ringBuffer, uint32_t transformStride);
+
+    ABENCH_INLINE uint32_t GetSize() const
+    {
+        return static_cast<uint32_t>(mEntries.size());
+    }
+
+    // Meshes of all gathered models
+    ABENCH_INLINE uint32_t GetDrawCount() const
+    {
+        return mDrawCount;
+    }
+
+    ABENCH_INLINE const DrawListEntry& GetEntry(uint32_t i) const
+    {
+        return mEntries[i];
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
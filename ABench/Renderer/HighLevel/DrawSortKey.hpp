@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Common/Common.hpp"
+
+#include <algorithm>
+
+
+namespace ABench {
+namespace Renderer {
+
+// Fields of a draw's sort key, from the most significant one. State which is most expensive
+// to change goes first, so sorted draws change it least often.
+const uint32_t DRAW_SORT_KEY_PIPELINE_BITS = 8;
+const uint32_t DRAW_SORT_KEY_MATERIAL_BITS = 20;
+const uint32_t DRAW_SORT_KEY_VERTEX_BUFFER_BITS = 20;
+const uint32_t DRAW_SORT_KEY_DEPTH_BITS = 16;
+
+const uint32_t DRAW_SORT_KEY_DEPTH_SHIFT = 0;
+const uint32_t DRAW_SORT_KEY_VERTEX_BUFFER_SHIFT = DRAW_SORT_KEY_DEPTH_SHIFT + DRAW_SORT_KEY_DEPTH_BITS;
+const uint32_t DRAW_SORT_KEY_MATERIAL_SHIFT = DRAW_SORT_KEY_VERTEX_BUFFER_SHIFT + DRAW_SORT_KEY_VERTEX_BUFFER_BITS;
+const uint32_t DRAW_SORT_KEY_PIPELINE_SHIFT = DRAW_SORT_KEY_MATERIAL_SHIFT + DRAW_SORT_KEY_MATERIAL_BITS;
+
+/**
+ * Builds a 64-bit key ordering opaque draws by pipeline variant, material, vertex buffer and
+ * then front to back. Identifiers wider than their field are clamped - draws sharing a clamped
+ * value are then only sorted by the remaining fields.
+ *
+ * Distance is stored as the upper bits of its float representation, which keeps the order of
+ * non-negative floats without knowing the range of the scene.
+ */
+inline uint64_t MakeDrawSortKey(uint32_t pipeline, uint32_t material, uint32_t vertexBuffer, float distance)
+{
+    const uint32_t pipelineMask = (1u << DRAW_SORT_KEY_PIPELINE_BITS) - 1;
+    const uint32_t materialMask = (1u << DRAW_SORT_KEY_MATERIAL_BITS) - 1;
+    const uint32_t vertexBufferMask = (1u << DRAW_SORT_KEY_VERTEX_BUFFER_BITS) - 1;
+
+    uint32_t distanceBits = 0;
+    if (distance > 0.0f)
+        memcpy(&distanceBits, &distance, sizeof(distanceBits));
+
+    uint64_t key = 0;
+    key |= static_cast<uint64_t>(std::min(pipeline, pipelineMask)) << DRAW_SORT_KEY_PIPELINE_SHIFT;
+    key |= static_cast<uint64_t>(std::min(material, materialMask)) << DRAW_SORT_KEY_MATERIAL_SHIFT;
+    key |= static_cast<uint64_t>(std::min(vertexBuffer, vertexBufferMask)) << DRAW_SORT_KEY_VERTEX_BUFFER_SHIFT;
+    key |= static_cast<uint64_t>(distanceBits >> (32 - DRAW_SORT_KEY_DEPTH_BITS)) << DRAW_SORT_KEY_DEPTH_SHIFT;
+    return key;
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -2,18 +2,31 @@
 #include "ForwardPass.hpp"
 
 #include "Renderer/LowLevel/DescriptorAllocator.hpp"
+#include "Common/Profiler.hpp"
 #include "Math/Matrix.hpp"
+#include "Math/Sort.hpp"
 
+#include "DrawSortKey.hpp"
 #include "ShaderMacroDefinitions.hpp"
 
 
 namespace {
 
+// std140 layout of lightParams uniform in ForwardPass.frag
 struct FragmentParamsCBuffer
 {
     uint32_t viewportWidth;
     uint32_t viewportHeight;
     uint32_t pixelsPerGridFrustum;
+    uint32_t cullingMode;
+    uint32_t clusterCountX;
+    uint32_t clusterCountY;
+    uint32_t clusterCountZ;
+    uint32_t pixelsPerCluster;
+    float nearZ;
+    float farZ;
+    float sliceScale;
+    float sliceBias;
 };
 
 struct MaterialCBuffer
@@ -21,6 +34,27 @@ struct MaterialCBuffer
     ABench::Math::Vector4 color;
 };
 
+// must match limits in ForwardPass.frag
+const uint32_t BINDLESS_TEXTURE_LIMIT = 256;
+const uint32_t BINDLESS_MATERIAL_LIMIT = 1024;
+const uint32_t MATERIAL_HAS_NORMAL = 0x1;
+const uint32_t MATERIAL_HAS_MASK = 0x2;
+
+// pipeline variant field of draw sort keys, one bit per material texture
+const uint32_t SORT_VARIANT_DIFFUSE = 0x1;
+const uint32_t SORT_VARIANT_NORMAL = 0x2;
+const uint32_t SORT_VARIANT_MASK = 0x4;
+
+// std430 layout of a single material in bindless material buffer
+struct BindlessMaterial
+{
+    ABench::Math::Vector4 color;
+    uint32_t diffuse;
+    uint32_t normal;
+    uint32_t mask;
+    uint32_t flags;
+};
+
 } // namespace
 
 
@@ -29,19 +63,43 @@ namespace Renderer {
 
 ForwardPass::ForwardPass()
     : mDevice()
+    , mLightContainer(nullptr)
     , mTargetTexture()
     , mDepthTexture(nullptr)
     , mFragmentParams()
+    , mLightCullingMode(LightCullingMode::Tiled)
     , mFramebuffer()
     , mVertexLayout()
     , mPipeline()
+    , mDiffuseKey(0)
+    , mNormalKey(0)
+    , mMaskKey(0)
     , mCommandBuffer()
+    , mRecorder()
     , mSampler()
     , mFragmentShaderLayout()
     , mFragmentShaderTextureLayout()
     , mRenderPass()
     , mPipelineLayout()
     , mFragmentShaderSet(VK_NULL_HANDLE)
+    , mDraws()
+    , mDrawsTemp()
+    , mMaterialBindings()
+    , mMaterialStride(0)
+    , mSortIds()
+    , mStats()
+    , mBindless(false)
+    , mUseBindless(false)
+    , mDefaultTexture()
+    , mMaterialBuffer()
+    , mBindlessVertexShader()
+    , mBindlessFragmentShader()
+    , mBindlessPipeline()
+    , mBindlessLayout()
+    , mBindlessPipelineLayout()
+    , mBindlessSet(VK_NULL_HANDLE)
+    , mBindlessTextures()
+    , mBindlessMaterials()
 {
 }
 
@@ -57,10 +115,213 @@ VkDescriptorSet ForwardPass::AcquireDescriptorSetFromTexture(const TexturePtr& t
     return set;
 }
 
+bool ForwardPass::IsBindlessSupported() const
+{
+    // Dynamically uniform indexing of sampler arrays is enough here - material index comes
+    // from a push constant, so no non-uniform indexing or update-after-bind is required.
+    if (!mDevice->GetFeatures().shaderSampledImageArrayDynamicIndexing)
+    {
+        LOGI("Sampled image array dynamic indexing not supported - bindless textures disabled");
+        return false;
+    }
+
+    const VkPhysicalDeviceLimits& limits = mDevice->GetProperties().limits;
+    if (limits.maxPerStageDescriptorSamplers < BINDLESS_TEXTURE_LIMIT ||
+        limits.maxPerStageDescriptorSampledImages < BINDLESS_TEXTURE_LIMIT ||
+        limits.maxDescriptorSetSamplers < BINDLESS_TEXTURE_LIMIT ||
+        limits.maxDescriptorSetSampledImages < BINDLESS_TEXTURE_LIMIT)
+    {
+        LOGI("Device descriptor limits too low for " << BINDLESS_TEXTURE_LIMIT << " textures - bindless textures disabled");
+        return false;
+    }
+
+    return true;
+}
+
+bool ForwardPass::InitBindless(const ForwardPassDesc& desc)
+{
+    // 1x1 white texture fills unused array slots and stands in for missing diffuse maps
+    uint32_t white = 0xFFFFFFFF;
+    TextureDataDesc whiteData(&white, sizeof(white));
+
+    TextureDesc defaultTexDesc;
+    defaultTexDesc.width = 1;
+    defaultTexDesc.height = 1;
+    defaultTexDesc.format = VK_FORMAT_B8G8R8A8_UNORM;
+    defaultTexDesc.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+    defaultTexDesc.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    defaultTexDesc.data = &whiteData;
+    if (!mDefaultTexture.Init(mDevice, defaultTexDesc))
+        return false;
+
+    BufferDesc matBufDesc;
+    matBufDesc.data = nullptr;
+    matBufDesc.dataSize = BINDLESS_MATERIAL_LIMIT * sizeof(BindlessMaterial);
+    matBufDesc.concurrent = false;
+    matBufDesc.type = BufferType::Dynamic;
+    matBufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (!mMaterialBuffer.Init(mDevice, matBufDesc))
+        return false;
+
+    std::vector<DescriptorSetLayoutDesc> bindlessLayoutDesc;
+    bindlessLayoutDesc.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, mSampler, BINDLESS_TEXTURE_LIMIT});
+    bindlessLayoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, VK_NULL_HANDLE});
+    mBindlessLayout = Tools::CreateDescriptorSetLayout(mDevice, bindlessLayoutDesc);
+    if (!mBindlessLayout)
+        return false;
+
+    mBindlessSet = DescriptorAllocator::Instance().AllocateDescriptorSet(mBindlessLayout);
+    if (mBindlessSet == VK_NULL_HANDLE)
+        return false;
+
+    // whole array is statically used by the shader, so every element has to be valid
+    for (uint32_t i = 0; i < BINDLESS_TEXTURE_LIMIT; ++i)
+        Tools::UpdateTextureDescriptorSet(mDevice, mBindlessSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0,
+                                          mDefaultTexture.GetView(), i);
+    Tools::UpdateBufferDescriptorSet(mDevice, mBindlessSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     mMaterialBuffer.GetBuffer(), mMaterialBuffer.GetSize());
+
+    std::vector<VkDescriptorSetLayout> layouts;
+    layouts.push_back(desc.vertexShaderLayout);
+    layouts.push_back(mFragmentShaderLayout);
+    layouts.push_back(mBindlessLayout);
+
+    VkPushConstantRange transformIndexRange;
+    transformIndexRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    transformIndexRange.offset = 0;
+    transformIndexRange.size = sizeof(uint32_t);
+
+    VkPushConstantRange materialIndexRange;
+    materialIndexRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    materialIndexRange.offset = sizeof(uint32_t);
+    materialIndexRange.size = sizeof(uint32_t);
+    mBindlessPipelineLayout = Tools::CreatePipelineLayout(mDevice, layouts, { transformIndexRange, materialIndexRange });
+    if (!mBindlessPipelineLayout)
+        return false;
+
+    // material features are resolved at runtime, so one shader combination covers all meshes
+    ShaderDesc vsDesc;
+    vsDesc.type = ShaderType::VERTEX;
+    vsDesc.filename = "ForwardPass.vert";
+    vsDesc.macros = {
+        { ShaderMacro::HAS_NORMAL, 1 },
+        { ShaderMacro::BINDLESS, 1 },
+    };
+    if (!mBindlessVertexShader.Init(mDevice, vsDesc))
+        return false;
+
+    ShaderDesc fsDesc;
+    fsDesc.type = ShaderType::FRAGMENT;
+    fsDesc.filename = "ForwardPass.frag";
+    fsDesc.macros = {
+        { ShaderMacro::BINDLESS, 1 },
+    };
+    if (!mBindlessFragmentShader.Init(mDevice, fsDesc))
+        return false;
+
+    GraphicsPipelineDesc pipeDesc;
+    pipeDesc.vertexShader = &mBindlessVertexShader;
+    pipeDesc.fragmentShader = &mBindlessFragmentShader;
+    pipeDesc.vertexLayout = &mVertexLayout;
+    pipeDesc.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    pipeDesc.renderPass = mRenderPass;
+    pipeDesc.pipelineLayout = mBindlessPipelineLayout;
+    pipeDesc.enableDepth = true;
+    pipeDesc.enableDepthWrite = false;
+    pipeDesc.enableColor = true;
+    if (!mBindlessPipeline.Init(mDevice, pipeDesc))
+        return false;
+
+    // material #0 is used for meshes without a material
+    BindlessMaterial defaultMaterial;
+    defaultMaterial.color = Math::Vector4(1.0f);
+    defaultMaterial.diffuse = 0;
+    defaultMaterial.normal = 0;
+    defaultMaterial.mask = 0;
+    defaultMaterial.flags = 0;
+    if (!mMaterialBuffer.Write(&defaultMaterial, sizeof(BindlessMaterial)))
+        return false;
+
+    mBindlessTextures.clear();
+    mBindlessMaterials.clear();
+    return true;
+}
+
+bool ForwardPass::AcquireBindlessTextureIndex(const TexturePtr& tex, uint32_t& index)
+{
+    auto it = mBindlessTextures.find(tex.get());
+    if (it != mBindlessTextures.end())
+    {
+        index = it->second;
+        return true;
+    }
+
+    // slot #0 is taken by default texture
+    index = static_cast<uint32_t>(mBindlessTextures.size()) + 1;
+    if (index >= BINDLESS_TEXTURE_LIMIT)
+    {
+        LOGW("Bindless texture limit (" << BINDLESS_TEXTURE_LIMIT << ") reached");
+        return false;
+    }
+
+    Tools::UpdateTextureDescriptorSet(mDevice, mBindlessSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0,
+                                      tex->GetView(), index);
+    mBindlessTextures.insert(std::make_pair(tex.get(), index));
+    return true;
+}
+
+bool ForwardPass::RegisterBindlessMaterial(const Scene::Material* material)
+{
+    if (mBindlessMaterials.find(material) != mBindlessMaterials.end())
+        return true;
+
+    // slot #0 is taken by default material
+    uint32_t materialIndex = static_cast<uint32_t>(mBindlessMaterials.size()) + 1;
+    if (materialIndex >= BINDLESS_MATERIAL_LIMIT)
+    {
+        LOGW("Bindless material limit (" << BINDLESS_MATERIAL_LIMIT << ") reached");
+        return false;
+    }
+
+    BindlessMaterial bm;
+    bm.color = material->GetColor();
+    bm.diffuse = 0;
+    bm.normal = 0;
+    bm.mask = 0;
+    bm.flags = 0;
+
+    if (material->GetDiffuse() && !AcquireBindlessTextureIndex(material->GetDiffuse(), bm.diffuse))
+        return false;
+
+    if (material->GetNormal())
+    {
+        if (!AcquireBindlessTextureIndex(material->GetNormal(), bm.normal))
+            return false;
+        bm.flags |= MATERIAL_HAS_NORMAL;
+    }
+
+    if (material->GetMask())
+    {
+        if (!AcquireBindlessTextureIndex(material->GetMask(), bm.mask))
+            return false;
+        bm.flags |= MATERIAL_HAS_MASK;
+    }
+
+    if (!mMaterialBuffer.Write(&bm, sizeof(BindlessMaterial), materialIndex * sizeof(BindlessMaterial)))
+        return false;
+
+    mBindlessMaterials.insert(std::make_pair(material, materialIndex));
+    return true;
+}
+
 bool ForwardPass::Init(const DevicePtr& device, const ForwardPassDesc& desc)
 {
     mDevice = device;
 
+    // dynamic offsets of material constants follow device's alignment, which is a power of two
+    VkDeviceSize alignment = mDevice->GetProperties().limits.minUniformBufferOffsetAlignment;
+    mMaterialStride = static_cast<uint32_t>((sizeof(MaterialCBuffer) + alignment - 1) & ~(alignment - 1));
+
     if (desc.depthTexture == nullptr)
     {
         LOGE("Forward pass needs a pregenerated depth texture to work.");
@@ -85,20 +346,41 @@ bool ForwardPass::Init(const DevicePtr& device, const ForwardPassDesc& desc)
     if (!mTargetTexture.Init(mDevice, targetTexDesc))
         return false;
 
+    if (!desc.clusterGrid)
+    {
+        LOGE("Forward Pass requires cluster grid to support clustered light culling");
+        return false;
+    }
+
+    const ClusterGrid& grid = *desc.clusterGrid;
     FragmentParamsCBuffer fpBuf;
     fpBuf.viewportWidth = desc.width;
     fpBuf.viewportHeight = desc.height;
     fpBuf.pixelsPerGridFrustum = desc.pixelsPerGridFrustum;
-
+    fpBuf.cullingMode = static_cast<uint32_t>(desc.lightCulling);
+    fpBuf.clusterCountX = grid.GetClustersX();
+    fpBuf.clusterCountY = grid.GetClustersY();
+    fpBuf.clusterCountZ = grid.GetDesc().depthSlices;
+    fpBuf.pixelsPerCluster = grid.GetDesc().pixelsPerCluster;
+    fpBuf.nearZ = grid.GetDesc().nearZ;
+    fpBuf.farZ = grid.GetDesc().farZ;
+    fpBuf.sliceScale = grid.GetSliceScale();
+    fpBuf.sliceBias = grid.GetSliceBias();
+
+    // dynamic, so culling mode can be switched at runtime
     BufferDesc bufDesc;
-    bufDesc.data = &fpBuf;
     bufDesc.dataSize = sizeof(FragmentParamsCBuffer);
     bufDesc.concurrent = false;
-    bufDesc.type = BufferType::Static;
+    bufDesc.type = BufferType::Dynamic;
     bufDesc.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     if (!mFragmentParams.Init(mDevice, bufDesc))
         return false;
 
+    if (!mFragmentParams.Write(&fpBuf, sizeof(FragmentParamsCBuffer)))
+        return false;
+
+    mLightCullingMode = desc.lightCulling;
+
 
     // Render pass
     std::vector<VkAttachmentDescription> attachments;
@@ -218,10 +500,26 @@ bool ForwardPass::Init(const DevicePtr& device, const ForwardPassDesc& desc)
     if (!mPipeline.Init(mDevice, mgpDesc))
         return false;
 
+    // per-material macro keys are combined while recording, so no macros are resolved per draw
+    mDiffuseKey = mPipeline.GetMacroKey(ShaderType::FRAGMENT, ShaderMacro::HAS_TEXTURE, 1);
+    mNormalKey = mPipeline.GetMacroKey(ShaderType::VERTEX, ShaderMacro::HAS_NORMAL, 1) |
+                 mPipeline.GetMacroKey(ShaderType::FRAGMENT, ShaderMacro::HAS_NORMAL, 1);
+    mMaskKey = mPipeline.GetMacroKey(ShaderType::FRAGMENT, ShaderMacro::HAS_COLOR_MASK, 1);
+
+    mPipeline.Precompile(desc.compileThreadPool);
+
 
     if (!mCommandBuffer.Init(mDevice, DeviceQueueType::GRAPHICS))
         return false;
 
+    ParallelRecorderDesc recorderDesc;
+    recorderDesc.threadPool = desc.threadPool;
+    recorderDesc.queueType = DeviceQueueType::GRAPHICS;
+    recorderDesc.renderPass = mRenderPass;
+    recorderDesc.framebuffer = &mFramebuffer;
+    if (!mRecorder.Init(mDevice, recorderDesc))
+        return false;
+
     Tools::UpdateBufferDescriptorSet(mDevice, mFragmentShaderSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
                                      mFragmentParams.GetBuffer(), mFragmentParams.GetSize());
     Tools::UpdateBufferDescriptorSet(mDevice, mFragmentShaderSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
@@ -233,24 +531,337 @@ bool ForwardPass::Init(const DevicePtr& device, const ForwardPassDesc& desc)
     Tools::UpdateBufferDescriptorSet(mDevice, mFragmentShaderSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4,
                                      desc.gridLightDataPtr->GetBuffer(), desc.gridLightDataPtr->GetSize());
 
+    mLightContainer = desc.lightContainerPtr;
     mCulledLights = desc.culledLightsPtr;
     mGridLightData = desc.gridLightDataPtr;
 
+    // per-texture descriptor sets above stay as a fallback
+    mBindless = desc.bindless && IsBindlessSupported();
+    if (mBindless)
+    {
+        if (!InitBindless(desc))
+        {
+            LOGE("Failed to initialize bindless material textures");
+            return false;
+        }
+
+        LOGI("Forward Pass uses bindless material textures");
+    }
+
+    mUseBindless = mBindless;
+
     return true;
 }
 
-void ForwardPass::Draw(const Scene::Scene& scene, const ForwardPassDrawDesc& desc)
+MultiPipelineKey ForwardPass::GetPipelineKey(const Scene::Material* material) const
+{
+    MultiPipelineKey key = 0;
+    if (material != nullptr)
+    {
+        if (material->GetDiffuse())
+            key |= mDiffuseKey;
+        if (material->GetNormal())
+            key |= mNormalKey;
+        if (material->GetMask())
+            key |= mMaskKey;
+    }
+
+    return key;
+}
+
+uint32_t ForwardPass::GetSortId(const void* object)
+{
+    // 0 is left for draws without given state
+    if (object == nullptr)
+        return 0;
+
+    auto it = mSortIds.find(object);
+    if (it != mSortIds.end())
+        return it->second;
+
+    uint32_t id = static_cast<uint32_t>(mSortIds.size()) + 1;
+    mSortIds.emplace(object, id);
+    return id;
+}
+
+void ForwardPass::SortDraws(const ForwardPassDrawDesc& desc)
+{
+    PROFILER_SCOPE("ForwardPass::SortDraws");
+
+    mDraws.clear();
+    mDraws.reserve(desc.drawList->GetDrawCount());
+
+    for (uint32_t i = 0; i < desc.drawList->GetSize(); ++i)
+    {
+        const DrawListEntry& entry = desc.drawList->GetEntry(i);
+        Math::AABB aabb = entry.model->GetTransform() * entry.model->GetAABB();
+        float distance = ((aabb[Math::AABB::MIN] + aabb[Math::AABB::MAX]) * 0.5f - desc.cameraPos).Length();
+
+        uint32_t drawIndex = entry.firstDraw;
+        entry.model->ForEachMesh([&](Scene::Mesh* mesh) {
+            const Scene::Material* material = mesh->GetMaterial();
+
+            // bindless path draws everything with one pipeline
+            uint32_t variant = 0;
+            if (material != nullptr && !mUseBindless)
+            {
+                if (material->GetDiffuse())
+                    variant |= SORT_VARIANT_DIFFUSE;
+                if (material->GetNormal())
+                    variant |= SORT_VARIANT_NORMAL;
+                if (material->GetMask())
+                    variant |= SORT_VARIANT_MASK;
+            }
+
+            SortedDraw draw;
+            draw.key = MakeDrawSortKey(variant, GetSortId(material), GetSortId(mesh->GetVertexBuffer()), distance);
+            draw.entry = &entry;
+            draw.mesh = mesh;
+            draw.drawIndex = drawIndex++;
+            draw.material = 0;
+            mDraws.push_back(draw);
+        });
+    }
+
+    Math::RadixSort(mDraws, mDrawsTemp, [](const SortedDraw& draw) { return draw.key; });
+}
+
+bool ForwardPass::ResolveMaterials(const ForwardPassDrawDesc& desc)
 {
-    ASSERT(desc.waitFlags.size() == desc.waitSems.size(), "Wait semaphores count does not match wait flags count");
+    PROFILER_SCOPE("ForwardPass::ResolveMaterials");
+
+    // draws of a material are next to each other after sorting, so each run gets one binding
+    mMaterialBindings.clear();
+    const Scene::Material* lastMaterial = nullptr;
+    for (SortedDraw& draw: mDraws)
+    {
+        const Scene::Material* material = draw.mesh->GetMaterial();
+        if (material == nullptr)
+            continue;
+
+        if (mMaterialBindings.empty() || material != lastMaterial)
+        {
+            MaterialBinding binding;
+            binding.material = material;
+            binding.cbufferOffset = 0;
+            binding.diffuse = material->GetDiffuse() ? AcquireDescriptorSetFromTexture(material->GetDiffuse()) : VK_NULL_HANDLE;
+            binding.normal = material->GetNormal() ? AcquireDescriptorSetFromTexture(material->GetNormal()) : VK_NULL_HANDLE;
+            binding.mask = material->GetMask() ? AcquireDescriptorSetFromTexture(material->GetMask()) : VK_NULL_HANDLE;
+            mMaterialBindings.push_back(binding);
+            lastMaterial = material;
+        }
+
+        draw.material = static_cast<uint32_t>(mMaterialBindings.size()) - 1;
+    }
+
+    if (mMaterialBindings.empty())
+        return true;
+
+    // constants of all materials go to a single Ring Buffer allocation
+    uint32_t offset = 0;
+    char* data = reinterpret_cast<char*>(desc.ringBufferPtr->Allocate(mMaterialBindings.size() * mMaterialStride, offset));
+    if (data == nullptr)
+    {
+        LOGE("Not enough space in Ring Buffer for " << mMaterialBindings.size() << " materials");
+        return false;
+    }
 
     MaterialCBuffer materialBuf;
+    for (MaterialBinding& binding: mMaterialBindings)
+    {
+        materialBuf.color = binding.material->GetColor();
+        memcpy(data, &materialBuf, sizeof(materialBuf));
+        binding.cbufferOffset = offset;
+        data += mMaterialStride;
+        offset += mMaterialStride;
+    }
 
-    // updating buffers
+    return true;
+}
+
+void ForwardPass::RecordModels(CommandBuffer* cmd, uint32_t begin, uint32_t end, const ForwardPassDrawDesc& desc)
+{
+    PROFILER_SCOPE("ForwardPass::RecordModels");
+
+    // secondary Command Buffers do not inherit dynamic state
+    cmd->SetViewport(0, 0, mTargetTexture.GetWidth(), mTargetTexture.GetHeight(), 0.0f, 1.0f);
+    cmd->SetScissor(0, 0, mTargetTexture.GetWidth(), mTargetTexture.GetHeight());
+
+    VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+    // draws are sorted, so material's data is bound once per run of its draws
+    const Scene::Material* boundMaterial = nullptr;
+    for (uint32_t i = begin; i < end; ++i)
     {
-        mCommandBuffer.Begin();
+        const SortedDraw& draw = mDraws[i];
+        Scene::Mesh* mesh = draw.mesh;
+        cmd->BindDescriptorSet(desc.vertexShaderSet, bindPoint, 0, mPipelineLayout, draw.entry->transformOffset);
+
+        const Scene::Material* material = mesh->GetMaterial();
+        if (material != nullptr && material != boundMaterial)
+        {
+            // resolved on the main thread by ResolveMaterials(), only read here
+            const MaterialBinding& binding = mMaterialBindings[draw.material];
+            cmd->BindDescriptorSet(mFragmentShaderSet, bindPoint, 1, mPipelineLayout, binding.cbufferOffset);
+
+            if (binding.diffuse != VK_NULL_HANDLE)
+                cmd->BindDescriptorSet(binding.diffuse, bindPoint, 2, mPipelineLayout);
+
+            if (binding.normal != VK_NULL_HANDLE)
+                cmd->BindDescriptorSet(binding.normal, bindPoint, 3, mPipelineLayout);
+
+            if (binding.mask != VK_NULL_HANDLE)
+                cmd->BindDescriptorSet(binding.mask, bindPoint, 4, mPipelineLayout);
+
+            boundMaterial = material;
+        }
 
-        mCommandBuffer.SetViewport(0, 0, mTargetTexture.GetWidth(), mTargetTexture.GetHeight(), 0.0f, 1.0f);
-        mCommandBuffer.SetScissor(0, 0, mTargetTexture.GetWidth(), mTargetTexture.GetHeight());
+        cmd->BindPipeline(mPipeline.GetGraphicsPipeline(GetPipelineKey(material)), bindPoint);
+        cmd->BindVertexBuffer(mesh->GetVertexBuffer(), 0, 0);
+        cmd->BindVertexBuffer(mesh->GetVertexParamsBuffer(), 1, 0);
+
+        VkDeviceSize commandOffset = draw.drawIndex * sizeof(VkDrawIndexedIndirectCommand);
+        if (mesh->ByIndices())
+        {
+            cmd->BindIndexBuffer(mesh->GetIndexBuffer());
+            if (desc.drawCommands)
+                cmd->DrawIndexedIndirect(desc.drawCommands, commandOffset);
+            else
+                cmd->DrawIndexed(mesh->GetPointCount());
+        }
+        else
+        {
+            if (desc.drawCommands)
+                cmd->DrawIndirect(desc.drawCommands, commandOffset);
+            else
+                cmd->Draw(mesh->GetPointCount(), 1);
+        }
+    }
+}
+
+void ForwardPass::RecordModelsBindless(CommandBuffer* cmd, uint32_t begin, uint32_t end, const ForwardPassDrawDesc& desc)
+{
+    PROFILER_SCOPE("ForwardPass::RecordModelsBindless");
+
+    // secondary Command Buffers do not inherit dynamic state
+    cmd->SetViewport(0, 0, mTargetTexture.GetWidth(), mTargetTexture.GetHeight(), 0.0f, 1.0f);
+    cmd->SetScissor(0, 0, mTargetTexture.GetWidth(), mTargetTexture.GetHeight());
+
+    VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+
+    // transforms and material parameters come from storage buffers indexed with push constants,
+    // so all sets are bound once and dynamic uniform offsets are irrelevant
+    cmd->BindPipeline(mBindlessPipeline.GetPipeline(), bindPoint);
+    cmd->BindDescriptorSet(desc.vertexShaderSet, bindPoint, 0, mBindlessPipelineLayout, 0);
+    cmd->BindDescriptorSet(mFragmentShaderSet, bindPoint, 1, mBindlessPipelineLayout, 0);
+    cmd->BindDescriptorSet(mBindlessSet, bindPoint, 2, mBindlessPipelineLayout);
+
+    // push constants are not inherited either, so the first draw always sets material index
+    const Scene::Material* pushedMaterial = nullptr;
+    bool materialPushed = false;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        const SortedDraw& draw = mDraws[i];
+        Scene::Mesh* mesh = draw.mesh;
+
+        // Ring Buffer allocations are 256-byte aligned, so the offset always lands on a matrix
+        uint32_t transformIndex = draw.entry->transformOffset / sizeof(Math::Matrix);
+        cmd->PushConstants(mBindlessPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &transformIndex);
+
+        const Scene::Material* material = mesh->GetMaterial();
+        if (!materialPushed || material != pushedMaterial)
+        {
+            // materials were registered in Draw(), the map is only read here
+            uint32_t materialIndex = 0;
+            if (material != nullptr)
+                materialIndex = mBindlessMaterials.find(material)->second;
+
+            cmd->PushConstants(mBindlessPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(uint32_t), sizeof(uint32_t), &materialIndex);
+            pushedMaterial = material;
+            materialPushed = true;
+        }
+
+        cmd->BindVertexBuffer(mesh->GetVertexBuffer(), 0, 0);
+        cmd->BindVertexBuffer(mesh->GetVertexParamsBuffer(), 1, 0);
+
+        VkDeviceSize commandOffset = draw.drawIndex * sizeof(VkDrawIndexedIndirectCommand);
+        if (mesh->ByIndices())
+        {
+            cmd->BindIndexBuffer(mesh->GetIndexBuffer());
+            if (desc.drawCommands)
+                cmd->DrawIndexedIndirect(desc.drawCommands, commandOffset);
+            else
+                cmd->DrawIndexed(mesh->GetPointCount());
+        }
+        else
+        {
+            if (desc.drawCommands)
+                cmd->DrawIndirect(desc.drawCommands, commandOffset);
+            else
+                cmd->Draw(mesh->GetPointCount(), 1);
+        }
+    }
+}
+
+void ForwardPass::Draw(const ForwardPassDrawDesc& desc)
+{
+    PROFILER_SCOPE("ForwardPass::Draw");
+
+    uint32_t modelCount = desc.drawList->GetSize();
+
+    // Register new materials before recording starts. GPU finished previous frame at this
+    // point, so bindless descriptors can be safely updated. Registered materials stay, so
+    // a frame which falls back does not prevent the next ones from using bindless path.
+    bool useBindless = mBindless;
+    if (mBindless)
+    {
+        for (uint32_t i = 0; i < modelCount; ++i)
+        {
+            desc.drawList->GetEntry(i).model->ForEachMesh([&](Scene::Mesh* mesh) {
+                const Scene::Material* material = mesh->GetMaterial();
+                if (useBindless && material != nullptr && !RegisterBindlessMaterial(material))
+                    useBindless = false;
+            });
+        }
+
+        // log only when the path changes, so a scene over the limits does not flood the log
+        if (useBindless != mUseBindless)
+        {
+            if (useBindless)
+                LOGI("All materials registered - Forward Pass is back on bindless path");
+            else
+                LOGW("Failed to register bindless material - falling back to per-texture descriptor sets this frame");
+        }
+    }
+
+    mUseBindless = useBindless;
+
+    // sorted draws are split evenly between threads, each one gets a continuous range of them
+    SortDraws(desc);
+    if (!mUseBindless && !ResolveMaterials(desc))
+    {
+        LOGE("Failed to resolve materials of Forward Pass draws");
+        return;
+    }
+
+    bool recorded = mRecorder.Record(static_cast<uint32_t>(mDraws.size()),
+        [&](CommandBuffer* cmd, uint32_t begin, uint32_t end) {
+            if (mUseBindless)
+                RecordModelsBindless(cmd, begin, end, desc);
+            else
+                RecordModels(cmd, begin, end, desc);
+        });
+    if (!recorded)
+    {
+        LOGE("Failure during secondary Command Buffer recording");
+        return;
+    }
+
+    mStats = mRecorder.GetStats();
+
+    // recording primary Command Buffer
+    {
+        mCommandBuffer.Begin();
 
         mTargetTexture.Transition(&mCommandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
                                   0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
@@ -258,84 +869,9 @@ void ForwardPass::Draw(const Scene::Scene& scene, const ForwardPassDrawDesc& des
                                   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 
         float clearValue[] = {0.1f, 0.1f, 0.1f, 0.0f};
-        VkPipelineBindPoint bindPoint =  VK_PIPELINE_BIND_POINT_GRAPHICS;
-        mCommandBuffer.BeginRenderPass(mRenderPass, &mFramebuffer, ABENCH_CLEAR_COLOR, clearValue, 0.0f);
-
-        MultiGraphicsPipelineShaderMacros macros;
-        macros.vertexShader = {
-            { ShaderMacro::HAS_NORMAL, 0 },
-        };
-        macros.fragmentShader = {
-            { ShaderMacro::HAS_TEXTURE, 0 },
-            { ShaderMacro::HAS_NORMAL, 0 },
-            { ShaderMacro::HAS_COLOR_MASK, 0 },
-        };
-
-        scene.ForEachObject([&](const Scene::Object* o) -> bool {
-            if (o->GetComponent()->GetType() == Scene::ComponentType::Model)
-            {
-                Scene::Model* model = dynamic_cast<Scene::Model*>(o->GetComponent());
-
-                if (!model->ToRender())
-                    return true;
-
-                // world matrix update
-                uint32_t offset = desc.ringBufferPtr->Write(&model->GetTransform(), sizeof(ABench::Math::Matrix));
-                mCommandBuffer.BindDescriptorSet(desc.vertexShaderSet, bindPoint, 0, mPipelineLayout, offset);
-
-                model->ForEachMesh([&](Scene::Mesh* mesh) {
-                    macros.vertexShader[0].value = 0;
-                    macros.fragmentShader[0].value = 0;
-                    macros.fragmentShader[1].value = 0;
-                    macros.fragmentShader[2].value = 0;
-
-                    const Scene::Material* material = mesh->GetMaterial();
-                    if (material != nullptr)
-                    {
-                        // material data update
-                        materialBuf.color = material->GetColor();
-                        offset = desc.ringBufferPtr->Write(&materialBuf, sizeof(materialBuf));
-                        mCommandBuffer.BindDescriptorSet(mFragmentShaderSet, bindPoint, 1, mPipelineLayout, offset);
-
-                        if (material->GetDiffuse())
-                        {
-                            macros.fragmentShader[0].value = 1;
-                            mCommandBuffer.BindDescriptorSet(AcquireDescriptorSetFromTexture(material->GetDiffuse()), bindPoint, 2, mPipelineLayout);
-                        }
-
-                        if (material->GetNormal())
-                        {
-                            macros.vertexShader[0].value = 1;
-                            macros.fragmentShader[1].value = 1;
-                            mCommandBuffer.BindDescriptorSet(AcquireDescriptorSetFromTexture(material->GetNormal()), bindPoint, 3, mPipelineLayout);
-                        }
-
-                        if (material->GetMask())
-                        {
-                            macros.fragmentShader[2].value = 1;
-                            mCommandBuffer.BindDescriptorSet(AcquireDescriptorSetFromTexture(material->GetMask()), bindPoint, 4, mPipelineLayout);
-                        }
-                    }
-
-                    mCommandBuffer.BindPipeline(mPipeline.GetGraphicsPipeline(macros), bindPoint);
-                    mCommandBuffer.BindVertexBuffer(mesh->GetVertexBuffer(), 0, 0);
-                    mCommandBuffer.BindVertexBuffer(mesh->GetVertexParamsBuffer(), 1, 0);
-
-                    if (mesh->ByIndices())
-                    {
-                        mCommandBuffer.BindIndexBuffer(mesh->GetIndexBuffer());
-                        mCommandBuffer.DrawIndexed(mesh->GetPointCount());
-                    }
-                    else
-                    {
-                        mCommandBuffer.Draw(mesh->GetPointCount(), 1);
-                    }
-                });
-            }
-
-            return true;
-        });
-
+        mCommandBuffer.BeginRenderPass(mRenderPass, &mFramebuffer, ABENCH_CLEAR_COLOR, clearValue, 0.0f,
+                                       VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        mRecorder.Execute(&mCommandBuffer);
         mCommandBuffer.EndRenderPass();
 
         if (!mCommandBuffer.End())
@@ -345,9 +881,35 @@ void ForwardPass::Draw(const Scene::Scene& scene, const ForwardPassDrawDesc& des
         }
     }
 
-    mDevice->Execute(DeviceQueueType::GRAPHICS, &mCommandBuffer,
-                     static_cast<uint32_t>(desc.waitSems.size()),
-                     desc.waitFlags.data(), desc.waitSems.data(), desc.signalSem, desc.fence);
+    desc.frameGraph->Schedule(desc.node, &mCommandBuffer);
+}
+
+void ForwardPass::UpdateCulledLights()
+{
+    Tools::UpdateBufferDescriptorSet(mDevice, mFragmentShaderSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3,
+                                     mCulledLights->GetBuffer(), mCulledLights->GetSize());
+}
+
+void ForwardPass::UpdateLightContainer()
+{
+    Tools::UpdateBufferDescriptorSet(mDevice, mFragmentShaderSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     mLightContainer->GetBuffer(), mLightContainer->GetSize());
+}
+
+bool ForwardPass::SetLightCullingMode(LightCullingMode mode)
+{
+    if (mode == mLightCullingMode)
+        return true;
+
+    uint32_t cullingMode = static_cast<uint32_t>(mode);
+    if (!mFragmentParams.Write(&cullingMode, sizeof(uint32_t), offsetof(FragmentParamsCBuffer, cullingMode)))
+    {
+        LOGE("Failed to update light culling mode in Forward Pass");
+        return false;
+    }
+
+    mLightCullingMode = mode;
+    return true;
 }
 
 } // namespace Renderer
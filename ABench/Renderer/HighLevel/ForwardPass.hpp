@@ -8,11 +8,19 @@
 #include "Renderer/LowLevel/VertexLayout.hpp"
 #include "Renderer/LowLevel/RingBuffer.hpp"
 #include "Renderer/LowLevel/MultiPipeline.hpp"
+#include "Renderer/LowLevel/Pipeline.hpp"
+#include "Renderer/LowLevel/ParallelRecorder.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
 #include "Renderer/LowLevel/Tools.hpp"
 
 #include "Scene/Camera.hpp"
 #include "Scene/Scene.hpp"
 
+#include "Common/ThreadPool.hpp"
+
+#include "ClusterGrid.hpp"
+#include "DrawList.hpp"
+
 namespace ABench {
 namespace Renderer {
 
@@ -28,6 +36,11 @@ struct ForwardPassDesc
     Buffer* lightContainerPtr;
     Buffer* culledLightsPtr;
     Buffer* gridLightDataPtr;
+    const ClusterGrid* clusterGrid; // cluster layout used by LightCuller in clustered mode
+    LightCullingMode lightCulling;
+    Common::ThreadPool* threadPool;
+    Common::ThreadPool* compileThreadPool; // Pipeline variants are precompiled there, should not be threadPool
+    bool bindless; // use bindless material textures if device supports it
 
     ForwardPassDesc()
         : width(0)
@@ -40,6 +53,11 @@ struct ForwardPassDesc
         , lightContainerPtr(nullptr)
         , culledLightsPtr(nullptr)
         , gridLightDataPtr(nullptr)
+        , clusterGrid(nullptr)
+        , lightCulling(LightCullingMode::Tiled)
+        , threadPool(nullptr)
+        , compileThreadPool(nullptr)
+        , bindless(true)
     {
     }
 };
@@ -47,36 +65,64 @@ struct ForwardPassDesc
 struct ForwardPassDrawDesc
 {
     RingBuffer* ringBufferPtr;
+    const DrawList* drawList;
+    const Buffer* drawCommands; // ObjectCuller's indirect commands, direct draws when null
     VkDescriptorSet vertexShaderSet;
-    std::vector<VkPipelineStageFlags> waitFlags;
-    std::vector<VkSemaphore> waitSems;
-    VkSemaphore signalSem;
-    VkFence fence;
+    Math::Vector4 cameraPos; // draws sharing state are ordered front to back from it
+    FrameGraph* frameGraph;
+    FrameGraphNode node;
 
     ForwardPassDrawDesc()
         : ringBufferPtr(nullptr)
+        , drawList(nullptr)
+        , drawCommands(nullptr)
         , vertexShaderSet(VK_NULL_HANDLE)
-        , waitFlags()
-        , waitSems()
-        , signalSem(VK_NULL_HANDLE)
-        , fence(VK_NULL_HANDLE)
+        , cameraPos()
+        , frameGraph(nullptr)
+        , node(FRAME_GRAPH_INVALID_NODE)
     {
     }
 };
 
 class ForwardPass final
 {
+    // Single mesh of a visible model, draws are recorded in order of their sort keys
+    struct SortedDraw
+    {
+        uint64_t key;
+        const DrawListEntry* entry;
+        Scene::Mesh* mesh;
+        uint32_t drawIndex; // index of mesh's indirect command
+        uint32_t material; // index in mMaterialBindings, per-texture set path only
+    };
+
+    // Material data resolved before recording, so recording threads share no locks
+    struct MaterialBinding
+    {
+        const Scene::Material* material;
+        uint32_t cbufferOffset; // Ring Buffer offset of material's constants
+        VkDescriptorSet diffuse;
+        VkDescriptorSet normal;
+        VkDescriptorSet mask;
+    };
+
     DevicePtr mDevice;
 
+    Buffer* mLightContainer;
     Buffer* mCulledLights;
     Buffer* mGridLightData;
     Texture mTargetTexture;
     Texture* mDepthTexture;
     Buffer mFragmentParams;
+    LightCullingMode mLightCullingMode;
     Framebuffer mFramebuffer;
     VertexLayout mVertexLayout;
     MultiPipeline mPipeline;
+    MultiPipelineKey mDiffuseKey;
+    MultiPipelineKey mNormalKey;
+    MultiPipelineKey mMaskKey;
     CommandBuffer mCommandBuffer;
+    ParallelRecorder mRecorder;
 
     VkRAII<VkSampler> mSampler;
     VkRAII<VkDescriptorSetLayout> mFragmentShaderLayout;
@@ -86,18 +132,79 @@ class ForwardPass final
 
     VkDescriptorSet mFragmentShaderSet;
 
+    std::vector<SortedDraw> mDraws;
+    std::vector<SortedDraw> mDrawsTemp;
+    std::vector<MaterialBinding> mMaterialBindings; // one per run of sorted draws sharing a material
+    uint32_t mMaterialStride; // between material constants in the Ring Buffer
+    std::unordered_map<const void*, uint32_t> mSortIds; // materials and vertex buffers, in order of appearance
+    CommandBufferStats mStats;
+
+    // Bindless path - all material textures live in one descriptor array and material
+    // parameters in one storage buffer, draws select their material and transform with
+    // push constants. Frames with a material which could not be registered fall back to
+    // per-texture descriptor sets.
+    bool mBindless; // bindless path was initialized
+    bool mUseBindless; // current frame is drawn with bindless path
+    Texture mDefaultTexture;
+    Buffer mMaterialBuffer;
+    Shader mBindlessVertexShader;
+    Shader mBindlessFragmentShader;
+    Pipeline mBindlessPipeline;
+    VkRAII<VkDescriptorSetLayout> mBindlessLayout;
+    VkRAII<VkPipelineLayout> mBindlessPipelineLayout;
+    VkDescriptorSet mBindlessSet;
+    std::unordered_map<const Texture*, uint32_t> mBindlessTextures;
+    std::unordered_map<const Scene::Material*, uint32_t> mBindlessMaterials;
+
     VkDescriptorSet AcquireDescriptorSetFromTexture(const TexturePtr& tex);
+    MultiPipelineKey GetPipelineKey(const Scene::Material* material) const;
+    uint32_t GetSortId(const void* object);
+    void SortDraws(const ForwardPassDrawDesc& desc);
+    bool ResolveMaterials(const ForwardPassDrawDesc& desc);
+    void RecordModels(CommandBuffer* cmd, uint32_t begin, uint32_t end, const ForwardPassDrawDesc& desc);
+
+    bool IsBindlessSupported() const;
+    bool InitBindless(const ForwardPassDesc& desc);
+    bool AcquireBindlessTextureIndex(const TexturePtr& tex, uint32_t& index);
+    bool RegisterBindlessMaterial(const Scene::Material* material);
+    void RecordModelsBindless(CommandBuffer* cmd, uint32_t begin, uint32_t end, const ForwardPassDrawDesc& desc);
 
 public:
     ForwardPass();
 
     bool Init(const DevicePtr& device, const ForwardPassDesc& desc);
-    void Draw(const Scene::Scene& scene, const ForwardPassDrawDesc& desc);
+    void Draw(const ForwardPassDrawDesc& desc);
+
+    // Selects which light grid is read, must match mode LightCuller dispatched with.
+    // Buffer is updated in place, so no frame using it can be in flight.
+    bool SetLightCullingMode(LightCullingMode mode);
+
+    // Binds Culled Lights buffer again after it was recreated, no frame using it can be in flight
+    void UpdateCulledLights();
+
+    // Same as above for Light Container buffer
+    void UpdateLightContainer();
 
     ABENCH_INLINE Texture& GetTargetTexture()
     {
         return mTargetTexture;
     }
+
+    ABENCH_INLINE bool IsBindless() const
+    {
+        return mUseBindless;
+    }
+
+    ABENCH_INLINE LightCullingMode GetLightCullingMode() const
+    {
+        return mLightCullingMode;
+    }
+
+    // Binds recorded by last Draw(), summed over all secondary Command Buffers
+    ABENCH_INLINE const CommandBufferStats& GetStats() const
+    {
+        return mStats;
+    }
 };
 
 } // namespace Renderer
@@ -4,15 +4,17 @@
 #include "Renderer/LowLevel/Extensions.hpp"
 
 #include "Math/Matrix.hpp"
-#include "Math/Plane.hpp"
 
 
 namespace {
 
+// must match local_size in GridFrustumsGenerator.comp
+const uint32_t GRID_FRUSTUMS_GROUP_SIZE = 16;
+
 ABENCH_ALIGN(16)
 struct GridFrustumsInfoBuffer
 {
-    ABench::Math::Matrix proj;
+    ABench::Math::Matrix invProj;
     uint32_t viewportWidth;
     uint32_t viewportHeight;
     uint32_t threadLimitX;
@@ -87,7 +89,7 @@ bool GridFrustumsGenerator::Generate(const GridFrustumsGenerationDesc& desc)
         frustumsPerHeight++;
 
     GridFrustumsInfoBuffer info;
-    info.proj = desc.projMat; // TODO inverse matrix here instead of GLSL shader
+    info.invProj = desc.projMat.Inverse();
     info.viewportWidth = desc.viewportWidth;
     info.viewportHeight = desc.viewportHeight;
     info.threadLimitX = frustumsPerWidth;
@@ -97,25 +99,24 @@ bool GridFrustumsGenerator::Generate(const GridFrustumsGenerationDesc& desc)
         return false;
 
     // allocate new buffer for output data
-    // size includes 4 planes per each frustum in the grid
     mGridFrustumsData.Free();
     BufferDesc gridFrustumsDataDesc;
     gridFrustumsDataDesc.data = nullptr;
     gridFrustumsDataDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     gridFrustumsDataDesc.type = BufferType::Dynamic;
-    gridFrustumsDataDesc.dataSize = sizeof(Math::Plane) * 4 * frustumsPerWidth * frustumsPerHeight;
+    gridFrustumsDataDesc.dataSize = sizeof(GridFrustum) * frustumsPerWidth * frustumsPerHeight;
     if (!mGridFrustumsData.Init(mDevice, gridFrustumsDataDesc))
         return false;
 
     Tools::UpdateBufferDescriptorSet(mDevice, mGridFrustumsDataSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
                                      mGridFrustumsData.GetBuffer(), mGridFrustumsData.GetSize());
 
-    uint32_t dispatchThreadsX = frustumsPerWidth / desc.pixelsPerGridFrustum;
-    uint32_t dispatchThreadsY = frustumsPerHeight / desc.pixelsPerGridFrustum;
+    uint32_t dispatchThreadsX = frustumsPerWidth / GRID_FRUSTUMS_GROUP_SIZE;
+    uint32_t dispatchThreadsY = frustumsPerHeight / GRID_FRUSTUMS_GROUP_SIZE;
 
-    if (frustumsPerWidth % desc.pixelsPerGridFrustum > 0)
+    if (frustumsPerWidth % GRID_FRUSTUMS_GROUP_SIZE > 0)
         dispatchThreadsX++;
-    if (frustumsPerHeight % desc.pixelsPerGridFrustum > 0)
+    if (frustumsPerHeight % GRID_FRUSTUMS_GROUP_SIZE > 0)
         dispatchThreadsY++;
 
     {
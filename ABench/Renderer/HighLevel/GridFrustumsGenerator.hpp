@@ -6,27 +6,11 @@
 #include "Renderer/LowLevel/CommandBuffer.hpp"
 #include "Renderer/LowLevel/Tools.hpp"
 #include "Renderer/LowLevel/Device.hpp"
-#include "Math/Matrix.hpp"
+#include "LightCullingReference.hpp"
 
 namespace ABench {
 namespace Renderer {
 
-struct GridFrustumsGenerationDesc
-{
-    ABench::Math::Matrix projMat;
-    uint32_t viewportWidth;
-    uint32_t viewportHeight;
-    uint32_t pixelsPerGridFrustum;
-
-    GridFrustumsGenerationDesc()
-        : projMat()
-        , viewportWidth(0)
-        , viewportHeight(0)
-        , pixelsPerGridFrustum(0)
-    {
-    }
-};
-
 class GridFrustumsGenerator
 {
     DevicePtr mDevice;
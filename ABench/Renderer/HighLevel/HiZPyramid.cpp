@@ -0,0 +1,193 @@
+#include "PCH.hpp"
+#include "HiZPyramid.hpp"
+
+#include "Renderer/LowLevel/MemoryStatistics.hpp"
+#include "Common/Profiler.hpp"
+
+
+namespace {
+
+const uint32_t HIZ_PYRAMID_THREADS = 8; // local_size_x and local_size_y of HiZPyramid.comp
+
+} // namespace
+
+
+namespace ABench {
+namespace Renderer {
+
+HiZPyramid::HiZPyramid()
+    : mDevice()
+    , mPyramidParams()
+    , mPyramid()
+    , mLevels()
+    , mPyramidParamsData()
+    , mDescriptorSet(VK_NULL_HANDLE)
+    , mSampler()
+    , mDescriptorSetLayout()
+    , mPipelineLayout()
+    , mShader()
+    , mPipeline()
+    , mCommandBuffer()
+{
+}
+
+bool HiZPyramid::Init(const DevicePtr& device, const HiZPyramidDesc& desc)
+{
+    mDevice = device;
+
+    uint32_t texelCount = DepthPyramid::CalculateLevels(desc.width, desc.height, mLevels);
+    if (mLevels.size() > HIZ_PYRAMID_MAX_LEVELS)
+    {
+        LOGE("Depth pyramid of " << desc.width << "x" << desc.height << " viewport needs " << mLevels.size()
+             << " levels, only " << HIZ_PYRAMID_MAX_LEVELS << " are supported");
+        return false;
+    }
+
+    GetLevelParams(mPyramidParamsData.levels);
+    mPyramidParamsData.viewportWidth = desc.width;
+    mPyramidParamsData.viewportHeight = desc.height;
+
+    BufferDesc bufDesc;
+    bufDesc.data = &mPyramidParamsData;
+    bufDesc.dataSize = sizeof(PyramidParams);
+    bufDesc.type = BufferType::Static;
+    bufDesc.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (!mPyramidParams.Init(mDevice, bufDesc))
+        return false;
+
+    // until the first dispatch finishes, pyramid of a cleared depth buffer does not occlude anything
+    std::vector<DepthBounds> clearData(texelCount, DepthBounds{ 1.0f, 1.0f });
+    bufDesc.data = nullptr;
+    bufDesc.dataSize = texelCount * sizeof(DepthBounds);
+    bufDesc.type = BufferType::Dynamic;
+    bufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufDesc.concurrent = true;
+    if (!mPyramid.Init(mDevice, bufDesc))
+        return false;
+
+    if (!mPyramid.Write(clearData.data(), clearData.size() * sizeof(DepthBounds)))
+        return false;
+
+    mSampler = Tools::CreateSampler(mDevice);
+    if (!mSampler)
+        return false;
+
+    std::vector<DescriptorSetLayoutDesc> layoutDesc;
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, mSampler});
+    mDescriptorSetLayout = Tools::CreateDescriptorSetLayout(mDevice, layoutDesc);
+    if (!mDescriptorSetLayout)
+        return false;
+
+    VkPushConstantRange levelRange;
+    levelRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    levelRange.offset = 0;
+    levelRange.size = sizeof(uint32_t);
+
+    std::vector<VkDescriptorSetLayout> pipeDesc;
+    pipeDesc.push_back(mDescriptorSetLayout);
+    mPipelineLayout = Tools::CreatePipelineLayout(mDevice, pipeDesc, { levelRange });
+    if (!mPipelineLayout)
+        return false;
+
+    ShaderDesc sDesc;
+    sDesc.filename = "HiZPyramid.comp";
+    sDesc.type = ShaderType::COMPUTE;
+    if (!mShader.Init(mDevice, sDesc))
+        return false;
+
+    ComputePipelineDesc pDesc;
+    pDesc.computeShader = &mShader;
+    pDesc.pipelineLayout = mPipelineLayout;
+    if (!mPipeline.Init(mDevice, pDesc))
+        return false;
+
+    if (!mCommandBuffer.Init(mDevice, DeviceQueueType::COMPUTE))
+        return false;
+
+    mDescriptorSet = DescriptorAllocator::Instance().AllocateDescriptorSet(mDescriptorSetLayout);
+    if (mDescriptorSet == VK_NULL_HANDLE)
+        return false;
+
+    Tools::UpdateBufferDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+                                     mPyramidParams.GetBuffer(), mPyramidParams.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     mPyramid.GetBuffer(), mPyramid.GetSize());
+    Tools::UpdateTextureDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2,
+                                      desc.depthTexture->GetView());
+
+    return true;
+}
+
+void HiZPyramid::Dispatch(const HiZPyramidDispatchDesc& desc)
+{
+    PROFILER_SCOPE("HiZPyramid::Dispatch");
+
+    {
+        mCommandBuffer.Begin();
+
+        // previous frame's readers are done, which is ensured by frame fence
+        mCommandBuffer.BufferBarrier(&mPyramid, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                     0, VK_ACCESS_SHADER_WRITE_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        mCommandBuffer.BindPipeline(mPipeline.GetPipeline(), VK_PIPELINE_BIND_POINT_COMPUTE);
+        mCommandBuffer.BindDescriptorSet(mDescriptorSet, VK_PIPELINE_BIND_POINT_COMPUTE, 0, mPipelineLayout);
+
+        // each level is reduced from the one before it
+        for (uint32_t level = 0; level < mLevels.size(); ++level)
+        {
+            if (level > 0)
+                mCommandBuffer.BufferBarrier(&mPyramid, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                             VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                             VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+            mCommandBuffer.PushConstants(mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &level);
+            mCommandBuffer.Dispatch((mLevels[level].width + HIZ_PYRAMID_THREADS - 1) / HIZ_PYRAMID_THREADS,
+                                    (mLevels[level].height + HIZ_PYRAMID_THREADS - 1) / HIZ_PYRAMID_THREADS, 1);
+        }
+
+        // Light Culler reads the pyramid right after, Object Culler and CPU culling in the next frame
+        mCommandBuffer.BufferBarrier(&mPyramid, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        if (!mCommandBuffer.End())
+            LOGW("Hi-Z pyramid failed to record command buffer");
+    }
+
+    desc.frameGraph->Schedule(desc.node, &mCommandBuffer);
+}
+
+bool HiZPyramid::ReadBack(DepthPyramid* pyramid)
+{
+    PROFILER_SCOPE("HiZPyramid::ReadBack");
+
+    if (pyramid->GetWidth() != mPyramidParamsData.viewportWidth || pyramid->GetHeight() != mPyramidParamsData.viewportHeight)
+    {
+        LOGE("Depth pyramid has different dimensions than the Hi-Z pyramid");
+        return false;
+    }
+
+    // levels are packed from the finest one, so the used ones form a single range at the end
+    uint32_t firstTexel = mLevels[pyramid->GetFirstLevel()].offset;
+    uint32_t texelCount = pyramid->GetSize() - firstTexel;
+    return mPyramid.Read(pyramid->GetData() + firstTexel, texelCount * sizeof(DepthBounds), firstTexel * sizeof(DepthBounds));
+}
+
+uint32_t HiZPyramid::GetLevelParams(HiZPyramidLevelParams* levels) const
+{
+    for (uint32_t i = 0; i < mLevels.size(); ++i)
+    {
+        levels[i].width = mLevels[i].width;
+        levels[i].height = mLevels[i].height;
+        levels[i].offset = mLevels[i].offset;
+        levels[i].padding = 0;
+    }
+
+    return static_cast<uint32_t>(mLevels.size());
+}
+
+} // namespace Renderer
+} // namespace ABench
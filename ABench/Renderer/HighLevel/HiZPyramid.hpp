@@ -0,0 +1,132 @@
+#pragma once
+
+#include "Renderer/LowLevel/CommandBuffer.hpp"
+#include "Renderer/LowLevel/DescriptorAllocator.hpp"
+#include "Renderer/LowLevel/Pipeline.hpp"
+#include "Renderer/LowLevel/Tools.hpp"
+#include "Renderer/LowLevel/Device.hpp"
+#include "Renderer/LowLevel/Buffer.hpp"
+#include "Renderer/LowLevel/Texture.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
+
+#include "DepthPyramid.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+// size of levels array in HiZPyramid.comp and ObjectCuller.comp
+const uint32_t HIZ_PYRAMID_MAX_LEVELS = 16;
+
+// Same layout as uvec4 elements of levels array in HiZPyramid.comp and ObjectCuller.comp
+struct HiZPyramidLevelParams
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t offset;
+    uint32_t padding;
+};
+
+struct HiZPyramidDesc
+{
+    uint32_t width;
+    uint32_t height;
+    Texture* depthTexture;
+
+    HiZPyramidDesc()
+        : width(0)
+        , height(0)
+        , depthTexture(nullptr)
+    {
+    }
+};
+
+struct HiZPyramidDispatchDesc
+{
+    FrameGraph* frameGraph;
+    FrameGraphNode node;
+
+    HiZPyramidDispatchDesc()
+        : frameGraph(nullptr)
+        , node(FRAME_GRAPH_INVALID_NODE)
+    {
+    }
+};
+
+/**
+ * Builds min/max depth pyramid of Depth Pre-Pass output on GPU.
+ *
+ * Levels have the layout described in DepthPyramid and are packed into one storage buffer,
+ * each level built by its own dispatch of HiZPyramid.comp from the level before it.
+ * The buffer is shared by both queues - Light Culler reads tile depth bounds from it on the
+ * compute queue and Object Culler tests meshes against the previous frame's pyramid on the
+ * graphics queue. Being host visible, it can also be read back for culling on CPU.
+ */
+class HiZPyramid final
+{
+    ABENCH_ALIGN(16)
+    struct PyramidParams
+    {
+        HiZPyramidLevelParams levels[HIZ_PYRAMID_MAX_LEVELS];
+        uint32_t viewportWidth;
+        uint32_t viewportHeight;
+
+        PyramidParams()
+            : levels()
+            , viewportWidth(0)
+            , viewportHeight(0)
+        {
+        }
+    };
+
+    DevicePtr mDevice;
+
+    Buffer mPyramidParams;
+    Buffer mPyramid;
+    std::vector<DepthPyramidLevel> mLevels;
+    PyramidParams mPyramidParamsData;
+
+    VkDescriptorSet mDescriptorSet;
+    VkRAII<VkSampler> mSampler;
+    VkRAII<VkDescriptorSetLayout> mDescriptorSetLayout;
+    VkRAII<VkPipelineLayout> mPipelineLayout;
+    Shader mShader;
+    Pipeline mPipeline;
+    CommandBuffer mCommandBuffer;
+
+public:
+    HiZPyramid();
+
+    bool Init(const DevicePtr& device, const HiZPyramidDesc& desc);
+    void Dispatch(const HiZPyramidDispatchDesc& desc);
+
+    // Copies levels of the last finished dispatch, starting from pyramid's first level.
+    // Pyramid must be initialized with the same dimensions.
+    bool ReadBack(DepthPyramid* pyramid);
+
+    // Fills levels array of shaders reading the pyramid, returns number of levels
+    uint32_t GetLevelParams(HiZPyramidLevelParams* levels) const;
+
+    ABENCH_INLINE const Buffer* GetBuffer() const
+    {
+        return &mPyramid;
+    }
+
+    ABENCH_INLINE const DepthPyramidLevel& GetLevel(uint32_t level) const
+    {
+        return mLevels[level];
+    }
+
+    ABENCH_INLINE uint32_t GetWidth() const
+    {
+        return mPyramidParamsData.viewportWidth;
+    }
+
+    ABENCH_INLINE uint32_t GetHeight() const
+    {
+        return mPyramidParamsData.viewportHeight;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
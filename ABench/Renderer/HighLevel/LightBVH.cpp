@@ -0,0 +1,225 @@
+#include "PCH.hpp"
+#include "LightBVH.hpp"
+#include "LightCullingReference.hpp"
+
+#include "Scene/Light.hpp"
+#include "Math/Sort.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+
+namespace {
+
+// bits of Morton code per axis, three of them fit into 32-bit radix sort keys
+const uint32_t MORTON_BITS = 10;
+const float MORTON_CELLS = static_cast<float>((1u << MORTON_BITS) - 1);
+
+// spreads lower 10 bits of value, so there are two zero bits between each of them
+uint32_t ExpandBits(uint32_t value)
+{
+    value = (value * 0x00010001u) & 0xFF0000FFu;
+    value = (value * 0x00000101u) & 0x0F00F00Fu;
+    value = (value * 0x00000011u) & 0xC30C30C3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
+
+// margin of bounds moved to world space, relative to their size and distance from the origin
+const float WORLD_BOUNDS_MARGIN = 1e-4f;
+
+// works for both LightSphere and Scene::LightData, which share member names
+template <typename T>
+void CopyLights(const T* lights, uint32_t lightCount, std::vector<ABench::Renderer::LightBVHLight>& result)
+{
+    result.resize(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        ABench::Renderer::LightBVHLight& l = result[i];
+        l.position[0] = lights[i].position[0];
+        l.position[1] = lights[i].position[1];
+        l.position[2] = lights[i].position[2];
+        l.range = lights[i].range;
+        l.index = i;
+        l.padding[0] = l.padding[1] = l.padding[2] = 0;
+    }
+}
+
+} // namespace
+
+
+namespace ABench {
+namespace Renderer {
+
+LightBVH::LightBVH()
+    : mNodes()
+    , mLights()
+    , mLightsTemp()
+    , mCodes()
+    , mCodesTemp()
+    , mDepth(0)
+{
+}
+
+void LightBVH::Build(const LightSphere* lights, uint32_t lightCount)
+{
+    CopyLights(lights, lightCount, mLights);
+    BuildTree();
+}
+
+void LightBVH::Build(const Scene::LightData* lights, uint32_t lightCount)
+{
+    CopyLights(lights, lightCount, mLights);
+    BuildTree();
+}
+
+uint32_t LightBVH::GetNodeCount(uint32_t lightCount)
+{
+    if (lightCount == 0)
+        return 0;
+
+    uint32_t leafCount = (lightCount + LIGHT_BVH_LEAF_SIZE - 1) / LIGHT_BVH_LEAF_SIZE;
+    uint32_t depth = 0;
+    while ((1u << depth) < leafCount)
+        depth++;
+
+    return (2u << depth) - 1;
+}
+
+void LightBVH::BoxToWorld(const Math::Matrix& invView, const float* boxMin, const float* boxMax,
+                          float* worldMin, float* worldMax)
+{
+    // center is transformed as a point, extent by absolute values of the matrix
+    float center[3];
+    float extent[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis] = (boxMin[axis] + boxMax[axis]) * 0.5f;
+        extent[axis] = (boxMax[axis] - boxMin[axis]) * 0.5f;
+    }
+
+    for (int row = 0; row < 3; ++row)
+    {
+        float c = invView[12 + row];
+        float e = 0.0f;
+        for (int col = 0; col < 3; ++col)
+        {
+            c += invView[col * 4 + row] * center[col];
+            e += fabsf(invView[col * 4 + row]) * extent[col];
+        }
+
+        e += (e + fabsf(c)) * WORLD_BOUNDS_MARGIN;
+        worldMin[row] = c - e;
+        worldMax[row] = c + e;
+    }
+}
+
+void LightBVH::PlaneToWorld(const Math::Matrix& view, const float* normal, float distance,
+                            float* worldNormal, float& worldDistance)
+{
+    // dot(n, view * p) - d == dot(transpose(rotation) * n, p) - (d - dot(n, translation))
+    worldDistance = distance;
+    for (int col = 0; col < 3; ++col)
+    {
+        worldNormal[col] = 0.0f;
+        for (int row = 0; row < 3; ++row)
+            worldNormal[col] += view[col * 4 + row] * normal[row];
+
+        worldDistance -= normal[col] * view[12 + col];
+    }
+
+    worldDistance -= (fabsf(worldDistance) + 1.0f) * WORLD_BOUNDS_MARGIN;
+}
+
+void LightBVH::BuildTree()
+{
+    const uint32_t lightCount = static_cast<uint32_t>(mLights.size());
+    mNodes.resize(GetNodeCount(lightCount));
+    mDepth = 0;
+    if (lightCount == 0)
+        return;
+
+    while ((2u << mDepth) - 1 < mNodes.size())
+        mDepth++;
+
+    // Morton codes of centers, quantized within bounds of all centers
+    float centerMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float centerMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (const auto& l: mLights)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            centerMin[axis] = std::min(centerMin[axis], l.position[axis]);
+            centerMax[axis] = std::max(centerMax[axis], l.position[axis]);
+        }
+    }
+
+    float scale[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float extent = centerMax[axis] - centerMin[axis];
+        scale[axis] = (extent > 0.0f) ? (MORTON_CELLS / extent) : 0.0f;
+    }
+
+    mCodes.resize(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        uint32_t code = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            uint32_t cell = static_cast<uint32_t>((mLights[i].position[axis] - centerMin[axis]) * scale[axis]);
+            code |= ExpandBits(cell) << axis;
+        }
+
+        mCodes[i].code = code;
+        mCodes[i].light = i;
+    }
+
+    Math::RadixSort(mCodes, mCodesTemp, [](const MortonCode& c) -> uint32_t { return c.code; });
+
+    mLightsTemp.resize(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+        mLightsTemp[i] = mLights[mCodes[i].light];
+    mLights.swap(mLightsTemp);
+
+    // leaves enclose whole spheres of their lights, padding leaves stay empty
+    const uint32_t firstLeaf = GetFirstLeaf();
+    const uint32_t leafCount = 1u << mDepth;
+    for (uint32_t leaf = 0; leaf < leafCount; ++leaf)
+    {
+        LightBVHNode& node = mNodes[firstLeaf + leaf];
+        node.min[0] = node.min[1] = node.min[2] = FLT_MAX;
+        node.max[0] = node.max[1] = node.max[2] = -FLT_MAX;
+        node.padding0 = node.padding1 = 0.0f;
+
+        uint32_t first = leaf * LIGHT_BVH_LEAF_SIZE;
+        uint32_t last = std::min(first + LIGHT_BVH_LEAF_SIZE, lightCount);
+        for (uint32_t i = first; i < last; ++i)
+        {
+            const LightBVHLight& l = mLights[i];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                node.min[axis] = std::min(node.min[axis], l.position[axis] - l.range);
+                node.max[axis] = std::max(node.max[axis], l.position[axis] + l.range);
+            }
+        }
+    }
+
+    // inner nodes bottom-up, children always come after their parent
+    for (uint32_t n = firstLeaf; n-- > 0; )
+    {
+        const LightBVHNode& left = mNodes[n * 2 + 1];
+        const LightBVHNode& right = mNodes[n * 2 + 2];
+        LightBVHNode& node = mNodes[n];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            node.min[axis] = std::min(left.min[axis], right.min[axis]);
+            node.max[axis] = std::max(left.max[axis], right.max[axis]);
+        }
+        node.padding0 = node.padding1 = 0.0f;
+    }
+}
+
+} // namespace Renderer
+} // namespace ABench
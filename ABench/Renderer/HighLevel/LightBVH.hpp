@@ -0,0 +1,166 @@
+#pragma once
+
+#include "Common/Common.hpp"
+#include "Math/Matrix.hpp"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace ABench {
+
+namespace Scene {
+struct LightData;
+} // namespace Scene
+
+namespace Renderer {
+
+struct LightSphere;
+
+// must match LIGHT_BVH_LEAF_SIZE in LightCuller.comp and ClusteredLightCuller.comp
+const uint32_t LIGHT_BVH_LEAF_SIZE = 8;
+
+// Same layout as BVHNode structure in LightCuller.comp and ClusteredLightCuller.comp, world space.
+// Plain floats instead of vectors, as the tree is built from scratch.
+struct LightBVHNode
+{
+    float min[3];
+    float padding0;
+    float max[3];
+    float padding1;
+};
+
+// Same layout as BVHLight structure in LightCuller.comp and ClusteredLightCuller.comp
+struct LightBVHLight
+{
+    float position[3]; // world space
+    float range;
+    uint32_t index; // in the array the BVH was built from, which matches Light Container
+    uint32_t padding[3];
+};
+
+/**
+ * Bounding volume hierarchy over world-space light spheres, so light culling can skip whole groups
+ * of lights far from a tile or cluster instead of testing every light against it.
+ *
+ * The tree does not depend on the camera, so it only has to be rebuilt when lights change.
+ * Culling moves view-space bounds of tiles and clusters to world space to test the nodes (see
+ * BoxToWorld() and PlaneToWorld()) and tests lights of accepted leaves in view space, as brute
+ * force does.
+ *
+ * Built from scratch as a linear BVH - lights are sorted along a Morton curve of their
+ * centers and split into leaves of LIGHT_BVH_LEAF_SIZE neighbours. Leaf count is rounded up to
+ * a power of two and the tree above them is complete, stored like a heap (children of node N are
+ * 2N + 1 and 2N + 2), so it needs no child pointers and is walked without a stack. Padding leaves
+ * have empty bounds and never pass any test.
+ *
+ * Node bounds enclose whole spheres, so a node rejected by a test of a sphere's bounding box
+ * cannot hold any light which the sphere test would accept - lists built with the BVH are the
+ * same as with brute force, only in a different order.
+ */
+class LightBVH
+{
+    struct MortonCode
+    {
+        uint32_t code;
+        uint32_t light;
+    };
+
+    std::vector<LightBVHNode> mNodes;
+    std::vector<LightBVHLight> mLights;
+    std::vector<LightBVHLight> mLightsTemp;
+    std::vector<MortonCode> mCodes;
+    std::vector<MortonCode> mCodesTemp;
+    uint32_t mDepth;
+
+    void BuildTree();
+
+public:
+    LightBVH();
+
+    // Tree is rebuilt from scratch
+    void Build(const LightSphere* lights, uint32_t lightCount);
+    void Build(const Scene::LightData* lights, uint32_t lightCount);
+
+    // Nodes needed by a BVH of lightCount lights
+    static uint32_t GetNodeCount(uint32_t lightCount);
+
+    /**
+     * View-space bounds moved to world space, same as boxToWorld() and planeToWorld() in light
+     * culling shaders. Box is enclosed by a world-space box, plane with normal pointing inside
+     * keeps the same half-space. Both are grown by a small margin, so rounding never makes
+     * a node test reject a node which touches the original bounds.
+     */
+    static void BoxToWorld(const Math::Matrix& invView, const float* boxMin, const float* boxMax,
+                           float* worldMin, float* worldMax);
+    static void PlaneToWorld(const Math::Matrix& view, const float* normal, float distance,
+                             float* worldNormal, float& worldDistance);
+
+    // Node visited after whole subtree of given node, or root when root's subtree is finished
+    ABENCH_INLINE static uint32_t GetNextNode(uint32_t node, uint32_t root)
+    {
+        // climb up while the node is a right child, then go to its right sibling
+        while (node != root && (node & 1) == 0)
+            node = (node - 1) / 2;
+        return (node == root) ? root : node + 1;
+    }
+
+    /**
+     * Walks nodes accepted by nodeTest(const LightBVHNode&) and calls lightFunc(const LightBVHLight&)
+     * for every light of accepted leaves.
+     */
+    template <typename NodeTest, typename LightFunc>
+    void Traverse(NodeTest nodeTest, LightFunc lightFunc) const
+    {
+        if (mNodes.empty())
+            return;
+
+        const uint32_t firstLeaf = GetFirstLeaf();
+        const uint32_t lightCount = static_cast<uint32_t>(mLights.size());
+        uint32_t node = 0;
+        do
+        {
+            if (!nodeTest(mNodes[node]))
+            {
+                node = GetNextNode(node, 0);
+            }
+            else if (node < firstLeaf)
+            {
+                node = node * 2 + 1;
+            }
+            else
+            {
+                uint32_t first = (node - firstLeaf) * LIGHT_BVH_LEAF_SIZE;
+                uint32_t last = std::min(first + LIGHT_BVH_LEAF_SIZE, lightCount);
+                for (uint32_t i = first; i < last; ++i)
+                    lightFunc(mLights[i]);
+                node = GetNextNode(node, 0);
+            }
+        } while (node != 0);
+    }
+
+    // Levels below the root, leaves are on the last one
+    ABENCH_INLINE uint32_t GetDepth() const
+    {
+        return mDepth;
+    }
+
+    ABENCH_INLINE uint32_t GetFirstLeaf() const
+    {
+        return (1u << mDepth) - 1;
+    }
+
+    ABENCH_INLINE const std::vector<LightBVHNode>& GetNodes() const
+    {
+        return mNodes;
+    }
+
+    // Lights in Morton order, leaf L holds LIGHT_BVH_LEAF_SIZE of them starting at L * LIGHT_BVH_LEAF_SIZE
+    ABENCH_INLINE const std::vector<LightBVHLight>& GetLights() const
+    {
+        return mLights;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -2,17 +2,23 @@
 #include "LightCuller.hpp"
 
 #include "Renderer/LowLevel/DescriptorAllocator.hpp"
+#include "Renderer/LowLevel/MemoryStatistics.hpp"
+#include "Common/Profiler.hpp"
+
+#include "ShaderMacroDefinitions.hpp"
 
 
 namespace {
 
-ABENCH_ALIGN(16)
-struct GridLightData
-{
-    uint32_t offset;
-    uint32_t count;
-    uint32_t padding[2];
-};
+// initial room for light list entries of each tile/cluster, the buffer grows when needed
+const uint32_t INITIAL_CULLED_LIGHTS_PER_TILE = 16;
+
+// over-allocation when growing, so a slowly increasing light count does not recreate buffers every frame
+const float CULLED_LIGHTS_GROWTH = 1.5f;
+
+// initial room of light BVH buffers, they grow with the number of lights
+const uint32_t INITIAL_BVH_LIGHTS = 4096;
+const float LIGHT_BVH_GROWTH = 1.5f;
 
 } // namespace
 
@@ -22,26 +28,73 @@ namespace Renderer {
 
 LightCuller::LightCuller()
     : mDevice()
+    , mLightContainer(nullptr)
     , mCullingParams()
     , mCulledLights()
     , mGridLightData()
+    , mGlobalLightCounter()
+    , mBVHNodes()
+    , mBVHLights()
     , mLightCullerSet(VK_NULL_HANDLE)
-    , mSampler()
     , mDescriptorSetLayout()
     , mPipelineLayout()
-    , mShader()
-    , mPipeline()
+    , mShaders()
+    , mPipelines()
     , mCommandBuffer()
+    , mClusterGrid()
+    , mClusteredCullingParams()
+    , mClusters()
+    , mClusteredCullerSet(VK_NULL_HANDLE)
+    , mClusteredDescriptorSetLayout()
+    , mClusteredPipelineLayout()
+    , mClusteredShaders()
+    , mClusteredPipelines()
+    , mScanSet(VK_NULL_HANDLE)
+    , mScanDescriptorSetLayout()
+    , mScanPipelineLayout()
+    , mScanShader()
+    , mScanPipeline()
+    , mRequiredCulledLights(0)
 {
 }
 
+bool LightCuller::InitPipelines(const std::string& filename, VkPipelineLayout layout,
+                                Shader (*shaders)[CULLING_PASS_COUNT], Pipeline (*pipelines)[CULLING_PASS_COUNT])
+{
+    for (uint32_t search = 0; search < LIGHT_SEARCH_COUNT; ++search)
+    {
+        for (uint32_t pass = 0; pass < CULLING_PASS_COUNT; ++pass)
+        {
+            ShaderDesc sDesc;
+            sDesc.filename = filename;
+            sDesc.type = ShaderType::COMPUTE;
+            sDesc.macros = {
+                { ShaderMacro::WRITE_LIGHTS, (pass == WRITE_LIGHTS) ? 1u : 0u },
+                { ShaderMacro::LIGHT_BVH, (search == LIGHT_BVH) ? 1u : 0u },
+            };
+            if (!shaders[search][pass].Init(mDevice, sDesc))
+                return false;
+
+            ComputePipelineDesc pDesc;
+            pDesc.computeShader = &shaders[search][pass];
+            pDesc.pipelineLayout = layout;
+            if (!pipelines[search][pass].Init(mDevice, pDesc))
+                return false;
+        }
+    }
+
+    return true;
+}
+
 bool LightCuller::Init(const DevicePtr& device, const LightCullerDesc& desc)
 {
     mDevice = device;
+    mLightContainer = desc.lightContainer;
 
     mPixelsPerGridFrustum = desc.pixelsPerGridFrustum;
     mCullingParamsData.viewportWidth = desc.viewportWidth;
     mCullingParamsData.viewportHeight = desc.viewportHeight;
+    mCullingParamsData.depthPyramidOffset = desc.depthPyramidOffset;
     mFrustumsPerWidth = desc.viewportWidth / mPixelsPerGridFrustum;
     mFrustumsPerHeight = desc.viewportHeight / mPixelsPerGridFrustum;
 
@@ -50,29 +103,51 @@ bool LightCuller::Init(const DevicePtr& device, const LightCullerDesc& desc)
     if (desc.viewportHeight % mPixelsPerGridFrustum > 0)
         mFrustumsPerHeight++;
 
+    ClusterGridDesc clusterDesc;
+    clusterDesc.projMat = desc.projMat;
+    clusterDesc.viewportWidth = desc.viewportWidth;
+    clusterDesc.viewportHeight = desc.viewportHeight;
+    clusterDesc.pixelsPerCluster = desc.pixelsPerCluster;
+    clusterDesc.depthSlices = desc.clusterDepthSlices;
+    clusterDesc.nearZ = desc.nearZ;
+    clusterDesc.farZ = desc.farZ;
+    if (!mClusterGrid.Init(clusterDesc))
+        return false;
+
+    // shared by both modes
+    uint32_t gridSize = std::max(mFrustumsPerWidth * mFrustumsPerHeight, mClusterGrid.GetClusterCount());
+
     BufferDesc bufDesc;
-    bufDesc.dataSize = 1024 * mFrustumsPerWidth * mFrustumsPerHeight * 4;
+    bufDesc.dataSize = gridSize * INITIAL_CULLED_LIGHTS_PER_TILE * sizeof(uint32_t);
     bufDesc.type = BufferType::Dynamic;
     bufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     if (!mCulledLights.Init(mDevice, bufDesc))
         return false;
 
-    bufDesc.dataSize = mFrustumsPerWidth * mFrustumsPerHeight * sizeof(GridLightData);
+    bufDesc.dataSize = gridSize * sizeof(GridLight);
     if (!mGridLightData.Init(mDevice, bufDesc))
         return false;
 
-    bufDesc.dataSize = sizeof(uint32_t) * 4;
+    // filled by LightListScan.comp, read back by ReserveCulledLights()
+    uint32_t lightCounter[] = { 0, 0, 0, 0 };
+    bufDesc.dataSize = sizeof(lightCounter);
     if (!mGlobalLightCounter.Init(mDevice, bufDesc))
         return false;
 
-    bufDesc.dataSize = sizeof(CullingParams);
-    bufDesc.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    if (!mCullingParams.Init(mDevice, bufDesc))
+    if (!mGlobalLightCounter.Write(lightCounter, sizeof(lightCounter)))
         return false;
 
+    bufDesc.dataSize = LightBVH::GetNodeCount(INITIAL_BVH_LIGHTS) * sizeof(LightBVHNode);
+    if (!mBVHNodes.Init(mDevice, bufDesc))
+        return false;
+
+    bufDesc.dataSize = INITIAL_BVH_LIGHTS * sizeof(LightBVHLight);
+    if (!mBVHLights.Init(mDevice, bufDesc))
+        return false;
 
-    mSampler = Tools::CreateSampler(mDevice);
-    if (!mSampler)
+    bufDesc.dataSize = sizeof(CullingParams);
+    bufDesc.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (!mCullingParams.Init(mDevice, bufDesc))
         return false;
 
 
@@ -83,7 +158,8 @@ bool LightCuller::Init(const DevicePtr& device, const LightCullerDesc& desc)
     layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
     layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
     layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
-    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT, mSampler});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
     mDescriptorSetLayout = Tools::CreateDescriptorSetLayout(mDevice, layoutDesc);
     if (!mDescriptorSetLayout)
         return false;
@@ -94,16 +170,7 @@ bool LightCuller::Init(const DevicePtr& device, const LightCullerDesc& desc)
     if (!mPipelineLayout)
         return false;
 
-    ShaderDesc sDesc;
-    sDesc.filename = "LightCuller.comp";
-    sDesc.type = ShaderType::COMPUTE;
-    if (!mShader.Init(mDevice, sDesc))
-        return false;
-
-    ComputePipelineDesc pDesc;
-    pDesc.computeShader = &mShader;
-    pDesc.pipelineLayout = mPipelineLayout;
-    if (!mPipeline.Init(mDevice, pDesc))
+    if (!InitPipelines("LightCuller.comp", mPipelineLayout, mShaders, mPipelines))
         return false;
 
     if (!mCommandBuffer.Init(mDevice, DeviceQueueType::COMPUTE))
@@ -116,40 +183,288 @@ bool LightCuller::Init(const DevicePtr& device, const LightCullerDesc& desc)
     Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
                                      mCullingParams.GetBuffer(), mCullingParams.GetSize());
     Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
-                                     mGlobalLightCounter.GetBuffer(), mGlobalLightCounter.GetSize());
-    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
                                      desc.gridFrustums->GetBuffer(), desc.gridFrustums->GetSize());
-    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3,
+    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
                                      desc.lightContainer->GetBuffer(), desc.lightContainer->GetSize());
     Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4,
-                                     mCulledLights.GetBuffer(), mCulledLights.GetSize());
+                                     mGridLightData.GetBuffer(), mGridLightData.GetSize());
     Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5,
+                                     desc.depthPyramid->GetBuffer(), desc.depthPyramid->GetSize());
+
+    if (!InitClustered(desc))
+        return false;
+
+    if (!InitScan())
+        return false;
+
+    UpdateCulledLightsDescriptors();
+    UpdateLightBVHDescriptors();
+    return true;
+}
+
+bool LightCuller::InitClustered(const LightCullerDesc& desc)
+{
+    // cluster bounds depend only on projection, so they are uploaded once
+    BufferDesc clustersDesc;
+    clustersDesc.data = mClusterGrid.GetClusters().data();
+    clustersDesc.dataSize = mClusterGrid.GetClusters().size() * sizeof(ClusterAABB);
+    clustersDesc.type = BufferType::Static;
+    clustersDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (!mClusters.Init(mDevice, clustersDesc))
+        return false;
+
+    BufferDesc paramsDesc;
+    paramsDesc.dataSize = sizeof(ClusteredCullingParams);
+    paramsDesc.type = BufferType::Dynamic;
+    paramsDesc.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (!mClusteredCullingParams.Init(mDevice, paramsDesc))
+        return false;
+
+    mClusteredCullingParamsData.clusterCountX = mClusterGrid.GetClustersX();
+    mClusteredCullingParamsData.clusterCountY = mClusterGrid.GetClustersY();
+    mClusteredCullingParamsData.clusterCountZ = mClusterGrid.GetDesc().depthSlices;
+
+    std::vector<DescriptorSetLayoutDesc> layoutDesc;
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    mClusteredDescriptorSetLayout = Tools::CreateDescriptorSetLayout(mDevice, layoutDesc);
+    if (!mClusteredDescriptorSetLayout)
+        return false;
+
+    std::vector<VkDescriptorSetLayout> pipeDesc;
+    pipeDesc.push_back(mClusteredDescriptorSetLayout);
+    mClusteredPipelineLayout = Tools::CreatePipelineLayout(mDevice, pipeDesc);
+    if (!mClusteredPipelineLayout)
+        return false;
+
+    if (!InitPipelines("ClusteredLightCuller.comp", mClusteredPipelineLayout, mClusteredShaders, mClusteredPipelines))
+        return false;
+
+    mClusteredCullerSet = DescriptorAllocator::Instance().AllocateDescriptorSet(mClusteredDescriptorSetLayout);
+    if (mClusteredCullerSet == VK_NULL_HANDLE)
+        return false;
+
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+                                     mClusteredCullingParams.GetBuffer(), mClusteredCullingParams.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     mClusters.GetBuffer(), mClusters.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     desc.lightContainer->GetBuffer(), desc.lightContainer->GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4,
+                                     mGridLightData.GetBuffer(), mGridLightData.GetSize());
+
+    return true;
+}
+
+bool LightCuller::InitScan()
+{
+    std::vector<DescriptorSetLayoutDesc> layoutDesc;
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    mScanDescriptorSetLayout = Tools::CreateDescriptorSetLayout(mDevice, layoutDesc);
+    if (!mScanDescriptorSetLayout)
+        return false;
+
+    VkPushConstantRange gridSizeRange;
+    gridSizeRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    gridSizeRange.offset = 0;
+    gridSizeRange.size = sizeof(uint32_t);
+
+    std::vector<VkDescriptorSetLayout> pipeDesc;
+    pipeDesc.push_back(mScanDescriptorSetLayout);
+    mScanPipelineLayout = Tools::CreatePipelineLayout(mDevice, pipeDesc, { gridSizeRange });
+    if (!mScanPipelineLayout)
+        return false;
+
+    ShaderDesc sDesc;
+    sDesc.filename = "LightListScan.comp";
+    sDesc.type = ShaderType::COMPUTE;
+    if (!mScanShader.Init(mDevice, sDesc))
+        return false;
+
+    ComputePipelineDesc pDesc;
+    pDesc.computeShader = &mScanShader;
+    pDesc.pipelineLayout = mScanPipelineLayout;
+    if (!mScanPipeline.Init(mDevice, pDesc))
+        return false;
+
+    mScanSet = DescriptorAllocator::Instance().AllocateDescriptorSet(mScanDescriptorSetLayout);
+    if (mScanSet == VK_NULL_HANDLE)
+        return false;
+
+    Tools::UpdateBufferDescriptorSet(mDevice, mScanSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0,
+                                     mGlobalLightCounter.GetBuffer(), mGlobalLightCounter.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mScanSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
                                      mGridLightData.GetBuffer(), mGridLightData.GetSize());
-    Tools::UpdateTextureDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6,
-                                      desc.depthTexture->GetView());
 
-    mDepthTexture = desc.depthTexture;
+    return true;
+}
+
+void LightCuller::UpdateLightContainer()
+{
+    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     mLightContainer->GetBuffer(), mLightContainer->GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     mLightContainer->GetBuffer(), mLightContainer->GetSize());
+}
+
+void LightCuller::UpdateCulledLightsDescriptors()
+{
+    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3,
+                                     mCulledLights.GetBuffer(), mCulledLights.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3,
+                                     mCulledLights.GetBuffer(), mCulledLights.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mScanSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     mCulledLights.GetBuffer(), mCulledLights.GetSize());
+}
+
+void LightCuller::UpdateLightBVHDescriptors()
+{
+    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6,
+                                     mBVHNodes.GetBuffer(), mBVHNodes.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mLightCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 7,
+                                     mBVHLights.GetBuffer(), mBVHLights.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5,
+                                     mBVHNodes.GetBuffer(), mBVHNodes.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mClusteredCullerSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6,
+                                     mBVHLights.GetBuffer(), mBVHLights.GetSize());
+}
+
+bool LightCuller::ReserveBVHBuffer(Buffer& buffer, VkDeviceSize requiredSize, const char* name)
+{
+    if (requiredSize <= buffer.GetSize())
+        return true;
+
+    VkDeviceSize newSize = static_cast<VkDeviceSize>(requiredSize * LIGHT_BVH_GROWTH);
+    newSize -= newSize % 16;
+    LOGI("Growing " << name << " buffer from " << buffer.GetSize() << " to " << newSize << " bytes");
+
+    MemoryOwnerScope owner(mDevice->GetStatistics(), "LightCuller");
+    buffer.Free();
+
+    BufferDesc bufDesc;
+    bufDesc.dataSize = newSize;
+    bufDesc.type = BufferType::Dynamic;
+    bufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (!buffer.Init(mDevice, bufDesc))
+    {
+        LOGE("Failed to grow " << name << " buffer");
+        return false;
+    }
+
+    return true;
+}
+
+bool LightCuller::UploadLightBVH(const LightBVH& bvh)
+{
+    PROFILER_SCOPE("LightCuller::UploadLightBVH");
+
+    const std::vector<LightBVHNode>& nodes = bvh.GetNodes();
+    const std::vector<LightBVHLight>& lights = bvh.GetLights();
+    if (nodes.empty())
+        return true;
+
+    VkDeviceSize nodesSize = nodes.size() * sizeof(LightBVHNode);
+    VkDeviceSize lightsSize = lights.size() * sizeof(LightBVHLight);
+    bool grow = (nodesSize > mBVHNodes.GetSize()) || (lightsSize > mBVHLights.GetSize());
+    if (!ReserveBVHBuffer(mBVHNodes, nodesSize, "Light BVH Nodes") ||
+        !ReserveBVHBuffer(mBVHLights, lightsSize, "Light BVH Lights"))
+        return false;
+
+    if (grow)
+        UpdateLightBVHDescriptors();
+
+    if (!mBVHNodes.Write(nodes.data(), static_cast<size_t>(nodesSize)) ||
+        !mBVHLights.Write(lights.data(), static_cast<size_t>(lightsSize)))
+    {
+        LOGW("Light culler failed to update light BVH");
+        return false;
+    }
+
+    return true;
+}
+
+bool LightCuller::ReserveCulledLights()
+{
+    uint32_t lightCounter[4];
+    if (!mGlobalLightCounter.Read(lightCounter, sizeof(lightCounter)))
+    {
+        LOGW("Light culler failed to read global light counter");
+        return false;
+    }
+
+    mRequiredCulledLights = lightCounter[0];
+
+    VkDeviceSize requiredSize = static_cast<VkDeviceSize>(mRequiredCulledLights) * sizeof(uint32_t);
+    if (requiredSize <= mCulledLights.GetSize())
+        return false;
+
+    // lists of last frame were trimmed, next one will fit
+    VkDeviceSize newSize = static_cast<VkDeviceSize>(requiredSize * CULLED_LIGHTS_GROWTH);
+    newSize -= newSize % sizeof(uint32_t);
+    LOGI("Growing Culled Lights buffer from " << mCulledLights.GetSize() << " to " << newSize << " bytes");
+
+    MemoryOwnerScope owner(mDevice->GetStatistics(), "LightCuller");
+    mCulledLights.Free();
+
+    BufferDesc bufDesc;
+    bufDesc.dataSize = newSize;
+    bufDesc.type = BufferType::Dynamic;
+    bufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (!mCulledLights.Init(mDevice, bufDesc))
+    {
+        LOGE("Failed to grow Culled Lights buffer");
+        return false;
+    }
 
+    UpdateCulledLightsDescriptors();
     return true;
 }
 
 void LightCuller::Dispatch(const LightCullerDispatchDesc& desc)
 {
-    mCullingParamsData.projMat = desc.projMat;
-    mCullingParamsData.viewMat = desc.viewMat;
-    mCullingParamsData.lightCount = desc.lightCount;
-    if (!mCullingParams.Write(&mCullingParamsData, sizeof(CullingParams)))
-        LOGW("Light culler failed to update Light data");
+    PROFILER_SCOPE("LightCuller::Dispatch");
 
-    uint32_t lightCounter[] = { 0, 0, 0, 0 };
-    if (!mGlobalLightCounter.Write(&lightCounter, sizeof(lightCounter)))
-        LOGW("Light culler failed to initialize global light counter.");
+    uint32_t search = desc.lightBVH ? LIGHT_BVH : BRUTE_FORCE;
+    uint32_t bvhDepth = desc.lightBVH ? desc.lightBVH->GetDepth() : 0;
 
+    if (desc.mode == LightCullingMode::Clustered)
     {
-        mCommandBuffer.Begin();
+        mClusteredCullingParamsData.viewMat = desc.viewMat;
+        mClusteredCullingParamsData.invViewMat = desc.viewMat.Inverse();
+        mClusteredCullingParamsData.lightCount = desc.lightCount;
+        mClusteredCullingParamsData.bvhDepth = bvhDepth;
+        if (!mClusteredCullingParams.Write(&mClusteredCullingParamsData, sizeof(ClusteredCullingParams)))
+            LOGW("Light culler failed to update Light data");
+    }
+    else
+    {
+        mCullingParamsData.invProjMat = desc.projMat.Inverse();
+        mCullingParamsData.viewMat = desc.viewMat;
+        mCullingParamsData.invViewMat = desc.viewMat.Inverse();
+        mCullingParamsData.lightCount = desc.lightCount;
+        mCullingParamsData.bvhDepth = bvhDepth;
+        if (!mCullingParams.Write(&mCullingParamsData, sizeof(CullingParams)))
+            LOGW("Light culler failed to update Light data");
+    }
 
-        mCommandBuffer.BindPipeline(mPipeline.GetPipeline(), VK_PIPELINE_BIND_POINT_COMPUTE);
-        mCommandBuffer.BindDescriptorSet(mLightCullerSet, VK_PIPELINE_BIND_POINT_COMPUTE, 0, mPipelineLayout);
+    bool clustered = (desc.mode == LightCullingMode::Clustered);
+    VkDescriptorSet set = clustered ? mClusteredCullerSet : mLightCullerSet;
+    VkPipelineLayout layout = clustered ? mClusteredPipelineLayout : mPipelineLayout;
+    Pipeline* pipelines = clustered ? mClusteredPipelines[search] : mPipelines[search];
+    uint32_t groupsX = clustered ? mClusteredCullingParamsData.clusterCountX : mFrustumsPerWidth;
+    uint32_t groupsY = clustered ? mClusteredCullingParamsData.clusterCountY : mFrustumsPerHeight;
+    uint32_t groupsZ = clustered ? mClusteredCullingParamsData.clusterCountZ : 1;
+    uint32_t gridSize = groupsX * groupsY * groupsZ;
+
+    {
+        mCommandBuffer.Begin();
 
         mCommandBuffer.BufferBarrier(&mCulledLights, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                                      0, VK_ACCESS_SHADER_WRITE_BIT,
@@ -158,7 +473,32 @@ void LightCuller::Dispatch(const LightCullerDispatchDesc& desc)
                                      0, VK_ACCESS_SHADER_WRITE_BIT,
                                      mDevice->GetQueueIndex(DeviceQueueType::GRAPHICS), mDevice->GetQueueIndex(DeviceQueueType::COMPUTE));
 
-        mCommandBuffer.Dispatch(mFrustumsPerWidth, mFrustumsPerHeight, 1);
+        // count lights of each tile
+        mCommandBuffer.BindPipeline(pipelines[COUNT_LIGHTS].GetPipeline(), VK_PIPELINE_BIND_POINT_COMPUTE);
+        mCommandBuffer.BindDescriptorSet(set, VK_PIPELINE_BIND_POINT_COMPUTE, 0, layout);
+        mCommandBuffer.Dispatch(groupsX, groupsY, groupsZ);
+
+        mCommandBuffer.BufferBarrier(&mGridLightData, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        // turn counts into offsets
+        mCommandBuffer.BindPipeline(mScanPipeline.GetPipeline(), VK_PIPELINE_BIND_POINT_COMPUTE);
+        mCommandBuffer.BindDescriptorSet(mScanSet, VK_PIPELINE_BIND_POINT_COMPUTE, 0, mScanPipelineLayout);
+        mCommandBuffer.PushConstants(mScanPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &gridSize);
+        mCommandBuffer.Dispatch(1, 1, 1);
+
+        mCommandBuffer.BufferBarrier(&mGridLightData, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+        mCommandBuffer.BufferBarrier(&mGlobalLightCounter, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        // write lights at their offsets
+        mCommandBuffer.BindPipeline(pipelines[WRITE_LIGHTS].GetPipeline(), VK_PIPELINE_BIND_POINT_COMPUTE);
+        mCommandBuffer.BindDescriptorSet(set, VK_PIPELINE_BIND_POINT_COMPUTE, 0, layout);
+        mCommandBuffer.Dispatch(groupsX, groupsY, groupsZ);
 
         mCommandBuffer.BufferBarrier(&mCulledLights, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
                                      VK_ACCESS_SHADER_WRITE_BIT, 0,
@@ -171,9 +511,7 @@ void LightCuller::Dispatch(const LightCullerDispatchDesc& desc)
             LOGW("Light culler failed to record command buffer");
     }
 
-    mDevice->Execute(DeviceQueueType::COMPUTE, &mCommandBuffer,
-                     static_cast<uint32_t>(desc.waitFlags.size()),
-                     desc.waitFlags.data(), desc.waitSems.data(), desc.signalSem, VK_NULL_HANDLE);
+    desc.frameGraph->Schedule(desc.node, &mCommandBuffer);
 }
 
 } // namespace Renderer
@@ -6,7 +6,9 @@
 #include "Renderer/LowLevel/Tools.hpp"
 #include "Renderer/LowLevel/Device.hpp"
 #include "Renderer/LowLevel/Buffer.hpp"
-#include "Renderer/LowLevel/Texture.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
+#include "ClusterGrid.hpp"
+#include "LightBVH.hpp"
 
 #include "Scene/Scene.hpp"
 
@@ -21,7 +23,15 @@ struct LightCullerDesc
     uint32_t pixelsPerGridFrustum;
     Buffer* gridFrustums;
     Buffer* lightContainer;
-    Texture* depthTexture;
+    const Buffer* depthPyramid;
+    uint32_t depthPyramidOffset; // first texel of pyramid level matching tiles
+
+    // clustered mode
+    ABench::Math::Matrix projMat;
+    float nearZ;
+    float farZ;
+    uint32_t pixelsPerCluster;
+    uint32_t clusterDepthSlices;
 
     LightCullerDesc()
         : viewportWidth(0)
@@ -29,7 +39,13 @@ struct LightCullerDesc
         , pixelsPerGridFrustum(0)
         , gridFrustums(nullptr)
         , lightContainer(nullptr)
-        , depthTexture(nullptr)
+        , depthPyramid(nullptr)
+        , depthPyramidOffset(0)
+        , projMat()
+        , nearZ(0.0f)
+        , farZ(0.0f)
+        , pixelsPerCluster(0)
+        , clusterDepthSlices(0)
     {
     }
 };
@@ -40,47 +56,110 @@ struct LightCullerDispatchDesc
     ABench::Math::Matrix projMat;
     ABench::Math::Matrix viewMat;
     uint32_t lightCount;
-    std::vector<VkPipelineStageFlags> waitFlags;
-    std::vector<VkSemaphore> waitSems;
-    VkSemaphore signalSem;
+    LightCullingMode mode;
+    const LightBVH* lightBVH; // uploaded with UploadLightBVH(), null tests every light against every tile
+    FrameGraph* frameGraph;
+    FrameGraphNode node;
 };
 
 
+/**
+ * Assigns lights to screen tiles (tiled mode) or to clusters (clustered mode).
+ *
+ * Tiled mode takes depth bounds of each tile from the level of HiZPyramid whose texels match
+ * the tiles, so no workgroup has to reduce depth of its tile's pixels.
+ *
+ * Both modes write to the same Grid Light and Culled Lights buffers, so Forward Pass reads lists
+ * of either mode with the same bindings. The mode can change from frame to frame.
+ *
+ * Lists are built in two passes. First pass only counts lights of every tile, LightListScan.comp
+ * turns the counts into offsets and second pass writes the lists there. Lists are packed without
+ * gaps, so Culled Lights buffer only has to hold lights actually assigned to tiles - it starts
+ * small and grows when a frame needs more entries than it has.
+ *
+ * With a LightBVH, tiles and clusters walk the hierarchy instead of testing every light, which
+ * stops the cost from growing with tiles times lights once there are tens of thousands of them.
+ * Both ways produce the same lists.
+ */
 class LightCuller final
 {
+    enum CullingPass
+    {
+        COUNT_LIGHTS = 0,
+        WRITE_LIGHTS,
+        CULLING_PASS_COUNT
+    };
+
+    enum LightSearch
+    {
+        BRUTE_FORCE = 0,
+        LIGHT_BVH,
+        LIGHT_SEARCH_COUNT
+    };
+
     ABENCH_ALIGN(16)
     struct CullingParams
     {
-        ABench::Math::Matrix projMat;
+        ABench::Math::Matrix invProjMat;
         ABench::Math::Matrix viewMat;
+        ABench::Math::Matrix invViewMat; // moves tile's bounds to world space of light BVH
         uint32_t viewportWidth;
         uint32_t viewportHeight;
         uint32_t lightCount;
+        uint32_t depthPyramidOffset;
+        uint32_t bvhDepth;
 
         CullingParams()
-            : projMat()
+            : invProjMat()
             , viewMat()
+            , invViewMat()
             , viewportWidth(0)
             , viewportHeight(0)
             , lightCount(0)
+            , depthPyramidOffset(0)
+            , bvhDepth(0)
+        {
+        }
+    };
+
+    ABENCH_ALIGN(16)
+    struct ClusteredCullingParams
+    {
+        ABench::Math::Matrix viewMat;
+        ABench::Math::Matrix invViewMat;
+        uint32_t clusterCountX;
+        uint32_t clusterCountY;
+        uint32_t clusterCountZ;
+        uint32_t lightCount;
+        uint32_t bvhDepth;
+
+        ClusteredCullingParams()
+            : viewMat()
+            , invViewMat()
+            , clusterCountX(0)
+            , clusterCountY(0)
+            , clusterCountZ(0)
+            , lightCount(0)
+            , bvhDepth(0)
         {
         }
     };
 
     DevicePtr mDevice;
 
+    Buffer* mLightContainer;
     Buffer mCullingParams;
     Buffer mCulledLights;
     Buffer mGridLightData;
     Buffer mGlobalLightCounter;
+    Buffer mBVHNodes;
+    Buffer mBVHLights;
 
-    Texture* mDepthTexture;
     VkDescriptorSet mLightCullerSet;
-    VkRAII<VkSampler> mSampler;
     VkRAII<VkDescriptorSetLayout> mDescriptorSetLayout;
     VkRAII<VkPipelineLayout> mPipelineLayout;
-    Shader mShader;
-    Pipeline mPipeline;
+    Shader mShaders[LIGHT_SEARCH_COUNT][CULLING_PASS_COUNT];
+    Pipeline mPipelines[LIGHT_SEARCH_COUNT][CULLING_PASS_COUNT];
     CommandBuffer mCommandBuffer;
 
     CullingParams mCullingParamsData;
@@ -88,12 +167,55 @@ class LightCuller final
     uint32_t mFrustumsPerWidth;
     uint32_t mFrustumsPerHeight;
 
+    ClusterGrid mClusterGrid;
+    Buffer mClusteredCullingParams;
+    Buffer mClusters;
+    VkDescriptorSet mClusteredCullerSet;
+    VkRAII<VkDescriptorSetLayout> mClusteredDescriptorSetLayout;
+    VkRAII<VkPipelineLayout> mClusteredPipelineLayout;
+    Shader mClusteredShaders[LIGHT_SEARCH_COUNT][CULLING_PASS_COUNT];
+    Pipeline mClusteredPipelines[LIGHT_SEARCH_COUNT][CULLING_PASS_COUNT];
+    ClusteredCullingParams mClusteredCullingParamsData;
+
+    VkDescriptorSet mScanSet;
+    VkRAII<VkDescriptorSetLayout> mScanDescriptorSetLayout;
+    VkRAII<VkPipelineLayout> mScanPipelineLayout;
+    Shader mScanShader;
+    Pipeline mScanPipeline;
+    uint32_t mRequiredCulledLights;
+
+    bool InitPipelines(const std::string& filename, VkPipelineLayout layout,
+                       Shader (*shaders)[CULLING_PASS_COUNT], Pipeline (*pipelines)[CULLING_PASS_COUNT]);
+    bool InitClustered(const LightCullerDesc& desc);
+    bool InitScan();
+    void UpdateCulledLightsDescriptors();
+    void UpdateLightBVHDescriptors();
+    bool ReserveBVHBuffer(Buffer& buffer, VkDeviceSize requiredSize, const char* name);
+
 public:
     LightCuller();
 
     bool Init(const DevicePtr& device, const LightCullerDesc& desc);
     void Dispatch(const LightCullerDispatchDesc& desc);
 
+    // Reads how many light list entries last dispatch needed and grows Culled Lights buffer if
+    // they did not fit. Returns true if the buffer was recreated and has to be bound again.
+    // Last dispatch must be finished.
+    bool ReserveCulledLights();
+
+    // Binds Light Container buffer again after it was recreated, no frame using it can be in flight
+    void UpdateLightContainer();
+
+    // Copies light BVH of this frame to GPU, growing its buffers when it does not fit.
+    // No frame using them can be in flight.
+    bool UploadLightBVH(const LightBVH& bvh);
+
+    // Light list entries needed by the last finished dispatch
+    ABENCH_INLINE uint32_t GetRequiredCulledLights() const
+    {
+        return mRequiredCulledLights;
+    }
+
     ABENCH_INLINE Buffer* GetCulledLights()
     {
         return &mCulledLights;
@@ -103,6 +225,11 @@ public:
     {
         return &mGridLightData;
     }
+
+    ABENCH_INLINE const ClusterGrid& GetClusterGrid() const
+    {
+        return mClusterGrid;
+    }
 };
 
 } // namespace Renderer
@@ -0,0 +1,310 @@
+#include "PCH.hpp"
+#include "LightCullingReference.hpp"
+#include "LightBVH.hpp"
+
+#include "Common/Logger.hpp"
+
+#include <algorithm>
+
+
+namespace ABench {
+namespace Renderer {
+
+uint32_t ScanLightCounts(GridLight* gridLights, uint32_t gridSize, uint32_t capacity)
+{
+    // the shader scans per-thread ranges in parallel, which gives the same offsets
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < gridSize; ++i)
+    {
+        uint32_t count = gridLights[i].count;
+        gridLights[i].offset = offset;
+        gridLights[i].count = (offset < capacity) ? std::min(count, capacity - offset) : 0;
+        offset += count;
+    }
+
+    return offset;
+}
+
+LightCullingReference::LightCullingReference()
+    : mDesc()
+    , mInvProj()
+    , mTilesX(0)
+    , mTilesY(0)
+    , mFrustums()
+    , mGridLights()
+    , mCulledLights()
+{
+}
+
+bool LightCullingReference::Init(const GridFrustumsGenerationDesc& desc)
+{
+    if (desc.pixelsPerGridFrustum == 0 || desc.viewportWidth == 0 || desc.viewportHeight == 0)
+    {
+        LOGE("Invalid light culling grid description");
+        return false;
+    }
+
+    mDesc = desc;
+    mInvProj = desc.projMat.Inverse();
+    mTilesX = (desc.viewportWidth + desc.pixelsPerGridFrustum - 1) / desc.pixelsPerGridFrustum;
+    mTilesY = (desc.viewportHeight + desc.pixelsPerGridFrustum - 1) / desc.pixelsPerGridFrustum;
+
+    // same as computeFrustum() in GridFrustumsGenerator.comp
+    const Math::Vector3 eye;
+    const float ppf = static_cast<float>(desc.pixelsPerGridFrustum);
+    mFrustums.resize(mTilesX * mTilesY);
+    for (uint32_t y = 0; y < mTilesY; ++y)
+    {
+        for (uint32_t x = 0; x < mTilesX; ++x)
+        {
+            Math::Vector3 topLeft = Unproject(x * ppf, y * ppf, 1.0f);
+            Math::Vector3 topRight = Unproject((x + 1) * ppf, y * ppf, 1.0f);
+            Math::Vector3 bottomLeft = Unproject(x * ppf, (y + 1) * ppf, 1.0f);
+            Math::Vector3 bottomRight = Unproject((x + 1) * ppf, (y + 1) * ppf, 1.0f);
+
+            GridFrustum& f = mFrustums[y * mTilesX + x];
+            f.planes[GridFrustum::LEFT] = Math::Plane(eye, topLeft, bottomLeft);
+            f.planes[GridFrustum::RIGHT] = Math::Plane(eye, bottomRight, topRight);
+            f.planes[GridFrustum::TOP] = Math::Plane(eye, topRight, topLeft);
+            f.planes[GridFrustum::BOTTOM] = Math::Plane(eye, bottomLeft, bottomRight);
+        }
+    }
+
+    mGridLights.resize(mTilesX * mTilesY);
+    return true;
+}
+
+Math::Vector3 LightCullingReference::Unproject(float x, float y, float depth) const
+{
+    // Vulkan's viewport puts -1 at the top, so unlike in OpenGL Y is not flipped
+    Math::Vector4 clip(x / mDesc.viewportWidth * 2.0f - 1.0f, y / mDesc.viewportHeight * 2.0f - 1.0f, depth, 1.0f);
+    Math::Vector4 view = mInvProj * clip;
+    return Math::Vector3(view / view[3]);
+}
+
+void LightCullingReference::GetTileDepthRange(uint32_t tileX, uint32_t tileY, const float* depth,
+                                              float& minDepth, float& maxDepth) const
+{
+    if (!depth)
+    {
+        minDepth = 0.0f;
+        maxDepth = 1.0f;
+        return;
+    }
+
+    // same as min/max reduction in LightCuller.comp, which skips threads outside of the viewport
+    uint32_t startX = tileX * mDesc.pixelsPerGridFrustum;
+    uint32_t startY = tileY * mDesc.pixelsPerGridFrustum;
+    uint32_t endX = std::min(startX + mDesc.pixelsPerGridFrustum, mDesc.viewportWidth);
+    uint32_t endY = std::min(startY + mDesc.pixelsPerGridFrustum, mDesc.viewportHeight);
+
+    minDepth = 1.0f;
+    maxDepth = 0.0f;
+    for (uint32_t y = startY; y < endY; ++y)
+    {
+        const float* row = depth + y * mDesc.viewportWidth;
+        for (uint32_t x = startX; x < endX; ++x)
+        {
+            minDepth = std::min(minDepth, row[x]);
+            maxDepth = std::max(maxDepth, row[x]);
+        }
+    }
+}
+
+void LightCullingReference::GetTileBounds(uint32_t tileX, uint32_t tileY, const float* depth, TileBounds& bounds) const
+{
+    float minDepth, maxDepth;
+    GetTileDepthRange(tileX, tileY, depth, minDepth, maxDepth);
+
+    // view space looks towards -Z, so the near end has greater Z
+    bounds.nearZ = Unproject(0.0f, 0.0f, minDepth)[2];
+    bounds.farZ = Unproject(0.0f, 0.0f, maxDepth)[2];
+
+    // bounds of the part of tile's frustum between min and max depth
+    const float ppf = static_cast<float>(mDesc.pixelsPerGridFrustum);
+    Math::Vector3 corners[8];
+    for (uint32_t c = 0; c < 8; ++c)
+        corners[c] = Unproject((tileX + (c & 1)) * ppf, (tileY + ((c >> 1) & 1)) * ppf,
+                               (c & 4) ? maxDepth : minDepth);
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        bounds.aabbMin[axis] = corners[0][axis];
+        bounds.aabbMax[axis] = corners[0][axis];
+        for (uint32_t c = 1; c < 8; ++c)
+        {
+            bounds.aabbMin[axis] = std::min(bounds.aabbMin[axis], corners[c][axis]);
+            bounds.aabbMax[axis] = std::max(bounds.aabbMax[axis], corners[c][axis]);
+        }
+    }
+}
+
+bool LightCullingReference::SphereInTile(const GridFrustum& f, const TileBounds& bounds, const Math::Vector3& pos, float r)
+{
+    if (pos[2] - r > bounds.nearZ || pos[2] + r < bounds.farZ)
+        return false;
+
+    for (uint32_t p = 0; p < GridFrustum::COUNT; ++p)
+        if (f.planes[p].GetNormal().Dot(pos) - f.planes[p].GetDistance() < -r)
+            return false;
+
+    float distance = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float d = std::max(bounds.aabbMin[axis] - pos[axis], 0.0f) + std::max(pos[axis] - bounds.aabbMax[axis], 0.0f);
+        distance += d * d;
+    }
+
+    return distance <= r * r;
+}
+
+void LightCullingReference::GetWorldTileBounds(const Math::Matrix& view, const Math::Matrix& invView, const GridFrustum& f,
+                                               const TileBounds& bounds, WorldTileBounds& worldBounds)
+{
+    // view space looks towards -Z, so near plane keeps Z below nearZ and far plane above farZ
+    float normals[GridFrustum::COUNT + 2][3];
+    float distances[GridFrustum::COUNT + 2];
+    for (uint32_t p = 0; p < GridFrustum::COUNT; ++p)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            normals[p][axis] = f.planes[p].GetNormal()[axis];
+        distances[p] = f.planes[p].GetDistance();
+    }
+
+    const uint32_t nearPlane = GridFrustum::COUNT;
+    const uint32_t farPlane = GridFrustum::COUNT + 1;
+    normals[nearPlane][0] = normals[nearPlane][1] = 0.0f;
+    normals[nearPlane][2] = -1.0f;
+    distances[nearPlane] = -bounds.nearZ;
+    normals[farPlane][0] = normals[farPlane][1] = 0.0f;
+    normals[farPlane][2] = 1.0f;
+    distances[farPlane] = bounds.farZ;
+
+    for (uint32_t p = 0; p < GridFrustum::COUNT + 2; ++p)
+        LightBVH::PlaneToWorld(view, normals[p], distances[p], worldBounds.normals[p], worldBounds.distances[p]);
+
+    LightBVH::BoxToWorld(invView, bounds.aabbMin, bounds.aabbMax, worldBounds.aabbMin, worldBounds.aabbMax);
+}
+
+bool LightCullingReference::BoxInTile(const WorldTileBounds& bounds, const float* boxMin, const float* boxMax)
+{
+    for (int axis = 0; axis < 3; ++axis)
+        if (boxMin[axis] > bounds.aabbMax[axis] || boxMax[axis] < bounds.aabbMin[axis])
+            return false;
+
+    // corner of the box furthest along plane's normal
+    for (uint32_t p = 0; p < GridFrustum::COUNT + 2; ++p)
+    {
+        const float* n = bounds.normals[p];
+        float d = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+            d += n[axis] * (n[axis] >= 0.0f ? boxMax[axis] : boxMin[axis]);
+
+        if (d - bounds.distances[p] < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+void LightCullingReference::Cull(const Math::Matrix& view, const LightSphere* lights, uint32_t lightCount,
+                                 const float* depth)
+{
+    // lights are transformed once, the shader does that per tile
+    std::vector<Math::Vector4> viewLights(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+        viewLights[i] = view * lights[i].position;
+
+    mCulledLights.clear();
+    for (uint32_t tileY = 0; tileY < mTilesY; ++tileY)
+    {
+        for (uint32_t tileX = 0; tileX < mTilesX; ++tileX)
+        {
+            uint32_t tile = tileY * mTilesX + tileX;
+            const GridFrustum& f = mFrustums[tile];
+
+            TileBounds bounds;
+            GetTileBounds(tileX, tileY, depth, bounds);
+
+            GridLight& gridLight = mGridLights[tile];
+            gridLight.offset = static_cast<uint32_t>(mCulledLights.size());
+            gridLight.count = 0;
+
+            for (uint32_t i = 0; i < lightCount; ++i)
+            {
+                if (!SphereInTile(f, bounds, Math::Vector3(viewLights[i]), lights[i].range))
+                    continue;
+
+                mCulledLights.push_back(i);
+                gridLight.count++;
+            }
+        }
+    }
+}
+
+void LightCullingReference::Cull(const Math::Matrix& view, const LightBVH& bvh, const float* depth)
+{
+    const Math::Matrix invView = view.Inverse();
+
+    mCulledLights.clear();
+    for (uint32_t tileY = 0; tileY < mTilesY; ++tileY)
+    {
+        for (uint32_t tileX = 0; tileX < mTilesX; ++tileX)
+        {
+            uint32_t tile = tileY * mTilesX + tileX;
+            const GridFrustum& f = mFrustums[tile];
+
+            TileBounds bounds;
+            GetTileBounds(tileX, tileY, depth, bounds);
+
+            WorldTileBounds worldBounds;
+            GetWorldTileBounds(view, invView, f, bounds, worldBounds);
+
+            GridLight& gridLight = mGridLights[tile];
+            gridLight.offset = static_cast<uint32_t>(mCulledLights.size());
+            gridLight.count = 0;
+
+            bvh.Traverse(
+                [&](const LightBVHNode& node)
+                {
+                    return BoxInTile(worldBounds, node.min, node.max);
+                },
+                [&](const LightBVHLight& light)
+                {
+                    const Math::Vector4 pos = view * Math::Vector4(light.position[0], light.position[1], light.position[2], 1.0f);
+                    if (!SphereInTile(f, bounds, Math::Vector3(pos), light.range))
+                        return;
+
+                    mCulledLights.push_back(light.index);
+                    gridLight.count++;
+                });
+        }
+    }
+}
+
+float LightCullingReference::GetAverageLightsPerPixel() const
+{
+    uint64_t total = 0;
+    for (uint32_t y = 0; y < mTilesY; ++y)
+    {
+        uint32_t height = std::min(mDesc.pixelsPerGridFrustum, mDesc.viewportHeight - y * mDesc.pixelsPerGridFrustum);
+        for (uint32_t x = 0; x < mTilesX; ++x)
+        {
+            uint32_t width = std::min(mDesc.pixelsPerGridFrustum, mDesc.viewportWidth - x * mDesc.pixelsPerGridFrustum);
+            total += static_cast<uint64_t>(mGridLights[y * mTilesX + x].count) * width * height;
+        }
+    }
+
+    return static_cast<float>(total) / (mDesc.viewportWidth * mDesc.viewportHeight);
+}
+
+uint32_t LightCullingReference::GetMaxLightsPerTile() const
+{
+    uint32_t result = 0;
+    for (auto& g: mGridLights)
+        result = std::max(result, g.count);
+    return result;
+}
+
+} // namespace Renderer
+} // namespace ABench
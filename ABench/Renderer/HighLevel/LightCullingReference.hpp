@@ -0,0 +1,189 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "Math/Plane.hpp"
+
+#include <vector>
+
+
+namespace ABench {
+namespace Renderer {
+
+class LightBVH;
+
+// must match LIGHT_CULLING_* values in ForwardPass.frag
+enum class LightCullingMode: unsigned char
+{
+    Tiled = 0, // 2D screen tiles bounded by min/max depth of the tile
+    Clustered, // 3D grid of screen tiles split into exponential depth slices
+};
+
+struct GridFrustumsGenerationDesc
+{
+    ABench::Math::Matrix projMat;
+    uint32_t viewportWidth;
+    uint32_t viewportHeight;
+    uint32_t pixelsPerGridFrustum;
+
+    GridFrustumsGenerationDesc()
+        : projMat()
+        , viewportWidth(0)
+        , viewportHeight(0)
+        , pixelsPerGridFrustum(0)
+    {
+    }
+};
+
+// Same layout as Frustum structure in GridFrustumsGenerator.comp - normals point inside
+struct GridFrustum
+{
+    enum Side
+    {
+        LEFT = 0,
+        RIGHT,
+        TOP,
+        BOTTOM,
+        COUNT
+    };
+
+    Math::Plane planes[Side::COUNT];
+};
+
+// Same layout as GridLight structure in LightCuller.comp, LightListScan.comp and ForwardPass.frag
+struct GridLight
+{
+    uint32_t offset;
+    uint32_t count;
+    uint32_t padding[2];
+};
+
+struct LightSphere
+{
+    Math::Vector4 position; // world space
+    float range;
+
+    LightSphere()
+        : position()
+        , range(0.0f)
+    {
+    }
+
+    LightSphere(const Math::Vector4& position, float range)
+        : position(position)
+        , range(range)
+    {
+    }
+};
+
+/**
+ * CPU version of LightListScan.comp - replaces light counts with offsets of packed light lists
+ * and trims lists which do not fit into capacity entries. Returns the number of entries needed
+ * to fit all of them.
+ */
+uint32_t ScanLightCounts(GridLight* gridLights, uint32_t gridSize, uint32_t capacity);
+
+/**
+ * CPU implementation of tiled light culling.
+ *
+ * Follows GridFrustumsGenerator.comp and LightCuller.comp step by step, so light lists produced
+ * on GPU can be checked against it and light counts can be measured without a Device. A light
+ * is assigned to a tile when its sphere passes both tests done by the shader - against side
+ * planes and depth range of tile's frustum, then against the view-space AABB enclosing the part
+ * of the frustum between tile's min and max depth. Each test alone lets through lights which
+ * only touch the frustum near its corners.
+ *
+ * Lists are packed tile after tile without gaps, the same way GPU lays them out after counting
+ * lights of each tile and scanning the counts with ScanLightCounts().
+ *
+ * With a LightBVH each tile walks the hierarchy like LightCuller.comp does with LIGHT_BVH == 1,
+ * so only lights of nodes touching the tile are tested. Nodes are tested against tile's bounds
+ * moved to world space, lights of accepted leaves the same way as with brute force. The lists
+ * hold the same lights as with brute force, in BVH order.
+ */
+class LightCullingReference
+{
+    // part of tile's frustum between its min and max depth
+    struct TileBounds
+    {
+        float nearZ;
+        float farZ;
+        float aabbMin[3];
+        float aabbMax[3];
+    };
+
+    // the same bounds in world space, planes are side planes followed by near and far one
+    struct WorldTileBounds
+    {
+        float normals[GridFrustum::COUNT + 2][3];
+        float distances[GridFrustum::COUNT + 2];
+        float aabbMin[3];
+        float aabbMax[3];
+    };
+
+    GridFrustumsGenerationDesc mDesc;
+    Math::Matrix mInvProj;
+    uint32_t mTilesX;
+    uint32_t mTilesY;
+    std::vector<GridFrustum> mFrustums;
+    std::vector<GridLight> mGridLights;
+    std::vector<uint32_t> mCulledLights;
+
+    void GetTileDepthRange(uint32_t tileX, uint32_t tileY, const float* depth, float& minDepth, float& maxDepth) const;
+    void GetTileBounds(uint32_t tileX, uint32_t tileY, const float* depth, TileBounds& bounds) const;
+    static bool SphereInTile(const GridFrustum& f, const TileBounds& bounds, const Math::Vector3& pos, float r);
+    static void GetWorldTileBounds(const Math::Matrix& view, const Math::Matrix& invView, const GridFrustum& f,
+                                   const TileBounds& bounds, WorldTileBounds& worldBounds);
+    static bool BoxInTile(const WorldTileBounds& bounds, const float* boxMin, const float* boxMax);
+
+public:
+    LightCullingReference();
+
+    bool Init(const GridFrustumsGenerationDesc& desc);
+
+    // Depth holds viewportWidth * viewportHeight values of a depth buffer, row by row from the top.
+    // Without it, every tile spans whole depth range.
+    void Cull(const Math::Matrix& view, const LightSphere* lights, uint32_t lightCount, const float* depth);
+
+    // Same as above, with lights taken from a BVH
+    void Cull(const Math::Matrix& view, const LightBVH& bvh, const float* depth);
+
+    // Returns view space position of a point in the viewport, with depth in depth buffer range
+    Math::Vector3 Unproject(float x, float y, float depth) const;
+
+    // Average number of lights evaluated per pixel by ForwardPass.frag
+    float GetAverageLightsPerPixel() const;
+    uint32_t GetMaxLightsPerTile() const;
+
+    ABENCH_INLINE uint32_t GetTileIndex(uint32_t pixelX, uint32_t pixelY) const
+    {
+        return (pixelY / mDesc.pixelsPerGridFrustum) * mTilesX + (pixelX / mDesc.pixelsPerGridFrustum);
+    }
+
+    ABENCH_INLINE uint32_t GetTilesX() const
+    {
+        return mTilesX;
+    }
+
+    ABENCH_INLINE uint32_t GetTilesY() const
+    {
+        return mTilesY;
+    }
+
+    ABENCH_INLINE const std::vector<GridFrustum>& GetFrustums() const
+    {
+        return mFrustums;
+    }
+
+    ABENCH_INLINE const std::vector<GridLight>& GetGridLights() const
+    {
+        return mGridLights;
+    }
+
+    ABENCH_INLINE const std::vector<uint32_t>& GetCulledLights() const
+    {
+        return mCulledLights;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,209 @@
+#include "PCH.hpp"
+#include "ObjectCuller.hpp"
+
+#include "Renderer/LowLevel/MemoryStatistics.hpp"
+#include "Common/Profiler.hpp"
+
+
+namespace {
+
+const uint32_t OBJECT_CULLER_THREADS = 64; // local_size_x of ObjectCuller.comp
+const uint32_t INITIAL_DRAW_CAPACITY = 1024;
+const float DRAW_CAPACITY_GROWTH = 1.5f;
+
+} // namespace
+
+
+namespace ABench {
+namespace Renderer {
+
+ObjectCuller::ObjectCuller()
+    : mDevice()
+    , mCullingParams()
+    , mObjects()
+    , mDrawCommands()
+    , mDrawCapacity(0)
+    , mObjectData()
+    , mDescriptorSet(VK_NULL_HANDLE)
+    , mDescriptorSetLayout()
+    , mPipelineLayout()
+    , mShader()
+    , mPipeline()
+    , mCommandBuffer()
+    , mCullingParamsData()
+{
+}
+
+bool ObjectCuller::Init(const DevicePtr& device, const ObjectCullerDesc& desc)
+{
+    mDevice = device;
+
+    mCullingParamsData.levelCount = desc.hiZPyramid->GetLevelParams(mCullingParamsData.levels);
+    mCullingParamsData.viewportWidth = desc.hiZPyramid->GetWidth();
+    mCullingParamsData.viewportHeight = desc.hiZPyramid->GetHeight();
+
+    BufferDesc bufDesc;
+    bufDesc.dataSize = sizeof(CullingParams);
+    bufDesc.type = BufferType::Dynamic;
+    bufDesc.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    if (!mCullingParams.Init(mDevice, bufDesc))
+        return false;
+
+    std::vector<DescriptorSetLayoutDesc> layoutDesc;
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    layoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
+    mDescriptorSetLayout = Tools::CreateDescriptorSetLayout(mDevice, layoutDesc);
+    if (!mDescriptorSetLayout)
+        return false;
+
+    std::vector<VkDescriptorSetLayout> pipeDesc;
+    pipeDesc.push_back(mDescriptorSetLayout);
+    mPipelineLayout = Tools::CreatePipelineLayout(mDevice, pipeDesc);
+    if (!mPipelineLayout)
+        return false;
+
+    ShaderDesc sDesc;
+    sDesc.filename = "ObjectCuller.comp";
+    sDesc.type = ShaderType::COMPUTE;
+    if (!mShader.Init(mDevice, sDesc))
+        return false;
+
+    ComputePipelineDesc pDesc;
+    pDesc.computeShader = &mShader;
+    pDesc.pipelineLayout = mPipelineLayout;
+    if (!mPipeline.Init(mDevice, pDesc))
+        return false;
+
+    // indirect draws are consumed on graphics queue, so culling is dispatched there as well
+    if (!mCommandBuffer.Init(mDevice, DeviceQueueType::GRAPHICS))
+        return false;
+
+    mDescriptorSet = DescriptorAllocator::Instance().AllocateDescriptorSet(mDescriptorSetLayout);
+    if (mDescriptorSet == VK_NULL_HANDLE)
+        return false;
+
+    Tools::UpdateBufferDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+                                     mCullingParams.GetBuffer(), mCullingParams.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3,
+                                     desc.hiZPyramid->GetBuffer()->GetBuffer(), desc.hiZPyramid->GetBuffer()->GetSize());
+
+    return ReserveDraws(INITIAL_DRAW_CAPACITY);
+}
+
+bool ObjectCuller::ReserveDraws(uint32_t drawCount)
+{
+    if (drawCount <= mDrawCapacity)
+        return true;
+
+    uint32_t capacity = std::max(drawCount, static_cast<uint32_t>(mDrawCapacity * DRAW_CAPACITY_GROWTH));
+    if (mDrawCapacity > 0)
+        LOGI("Growing Object Culler buffers from " << mDrawCapacity << " to " << capacity << " draws");
+
+    MemoryOwnerScope owner(mDevice->GetStatistics(), "ObjectCuller");
+    mObjects.Free();
+    mDrawCommands.Free();
+
+    BufferDesc bufDesc;
+    bufDesc.dataSize = capacity * sizeof(CullingObject);
+    bufDesc.type = BufferType::Dynamic;
+    bufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (!mObjects.Init(mDevice, bufDesc))
+        return false;
+
+    bufDesc.dataSize = capacity * sizeof(VkDrawIndexedIndirectCommand);
+    bufDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    if (!mDrawCommands.Init(mDevice, bufDesc))
+        return false;
+
+    Tools::UpdateBufferDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+                                     mObjects.GetBuffer(), mObjects.GetSize());
+    Tools::UpdateBufferDescriptorSet(mDevice, mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     mDrawCommands.GetBuffer(), mDrawCommands.GetSize());
+
+    mDrawCapacity = capacity;
+    return true;
+}
+
+bool ObjectCuller::Update(const DrawList& drawList, const Math::Frustum& frustum, const Math::Matrix* occlusionViewProj)
+{
+    PROFILER_SCOPE("ObjectCuller::Update");
+
+    if (!ReserveDraws(drawList.GetDrawCount()))
+    {
+        LOGE("Failed to grow Object Culler buffers");
+        return false;
+    }
+
+    mObjectData.resize(drawList.GetDrawCount());
+    for (uint32_t i = 0; i < drawList.GetSize(); ++i)
+    {
+        const DrawListEntry& entry = drawList.GetEntry(i);
+        const Math::AABB& aabb = entry.model->GetAABB();
+        uint32_t drawIndex = entry.firstDraw;
+        entry.model->ForEachMesh([&](Scene::Mesh* mesh) {
+            CullingObject& object = mObjectData[drawIndex++];
+            object.transform = entry.model->GetTransform();
+            object.aabbMin = aabb[Math::AABB::AABBVert::MIN];
+            object.aabbMax = aabb[Math::AABB::AABBVert::MAX];
+            object.pointCount = mesh->GetPointCount();
+            object.indexed = mesh->ByIndices() ? 1 : 0;
+        });
+    }
+
+    if (!mObjectData.empty() && !mObjects.Write(mObjectData.data(), mObjectData.size() * sizeof(CullingObject)))
+    {
+        LOGE("Object culler failed to update object data");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < frustum.GetPlaneCount(); ++i)
+        mCullingParamsData.planes[i] = Math::Vector4(frustum.GetPlane(i).GetNormal(), frustum.GetPlane(i).GetDistance());
+    mCullingParamsData.drawCount = drawList.GetDrawCount();
+    mCullingParamsData.occlusion = (occlusionViewProj != nullptr) ? 1 : 0;
+    if (occlusionViewProj != nullptr)
+        mCullingParamsData.occlusionViewProj = *occlusionViewProj;
+    if (!mCullingParams.Write(&mCullingParamsData, sizeof(CullingParams)))
+    {
+        LOGE("Object culler failed to update culling parameters");
+        return false;
+    }
+
+    return true;
+}
+
+void ObjectCuller::Dispatch(const ObjectCullerDispatchDesc& desc)
+{
+    PROFILER_SCOPE("ObjectCuller::Dispatch");
+
+    {
+        mCommandBuffer.Begin();
+
+        // previous frame's passes are done reading the commands, which is ensured by frame fence
+        mCommandBuffer.BufferBarrier(&mDrawCommands, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                     0, VK_ACCESS_SHADER_WRITE_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        uint32_t groups = (mCullingParamsData.drawCount + OBJECT_CULLER_THREADS - 1) / OBJECT_CULLER_THREADS;
+        if (groups > 0)
+        {
+            mCommandBuffer.BindPipeline(mPipeline.GetPipeline(), VK_PIPELINE_BIND_POINT_COMPUTE);
+            mCommandBuffer.BindDescriptorSet(mDescriptorSet, VK_PIPELINE_BIND_POINT_COMPUTE, 0, mPipelineLayout);
+            mCommandBuffer.Dispatch(groups, 1, 1);
+        }
+
+        // Depth Pre-Pass and Forward Pass are submitted later on the same queue
+        mCommandBuffer.BufferBarrier(&mDrawCommands, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                                     VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                                     VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+        if (!mCommandBuffer.End())
+            LOGW("Object culler failed to record command buffer");
+    }
+
+    desc.frameGraph->Schedule(desc.node, &mCommandBuffer);
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Renderer/LowLevel/CommandBuffer.hpp"
+#include "Renderer/LowLevel/DescriptorAllocator.hpp"
+#include "Renderer/LowLevel/Pipeline.hpp"
+#include "Renderer/LowLevel/Tools.hpp"
+#include "Renderer/LowLevel/Device.hpp"
+#include "Renderer/LowLevel/Buffer.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
+
+#include "Math/Frustum.hpp"
+
+#include "DrawList.hpp"
+#include "HiZPyramid.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+struct ObjectCullerDesc
+{
+    const HiZPyramid* hiZPyramid;
+
+    ObjectCullerDesc()
+        : hiZPyramid(nullptr)
+    {
+    }
+};
+
+struct ObjectCullerDispatchDesc
+{
+    FrameGraph* frameGraph;
+    FrameGraphNode node;
+
+    ObjectCullerDispatchDesc()
+        : frameGraph(nullptr)
+        , node(FRAME_GRAPH_INVALID_NODE)
+    {
+    }
+};
+
+/**
+ * View frustum culling of meshes done on GPU.
+ *
+ * ObjectCuller.comp tests bounds of every mesh from the Draw List against the frustum and
+ * writes one VkDrawIndexedIndirectCommand per mesh at mesh's draw index. Culled meshes get
+ * zero instances instead of being removed, so passes recording the Draw List know where each
+ * mesh's command is without reading anything back.
+ *
+ * Non-indexed meshes use the same command - its first four fields are laid out the same way
+ * as VkDrawIndirectCommand's.
+ *
+ * Meshes inside the frustum can also be tested against HiZPyramid. Culling runs before this
+ * frame's depth is known, so the test uses previous frame's pyramid together with the matrix
+ * it was rendered with - same as DepthPyramid::IsOccluded() on CPU.
+ */
+class ObjectCuller final
+{
+    ABENCH_ALIGN(16)
+    struct CullingParams
+    {
+        ABench::Math::Vector4 planes[6];
+        ABench::Math::Matrix occlusionViewProj;
+        HiZPyramidLevelParams levels[HIZ_PYRAMID_MAX_LEVELS];
+        uint32_t drawCount;
+        uint32_t viewportWidth;
+        uint32_t viewportHeight;
+        uint32_t levelCount;
+        uint32_t occlusion;
+
+        CullingParams()
+            : planes()
+            , occlusionViewProj()
+            , levels()
+            , drawCount(0)
+            , viewportWidth(0)
+            , viewportHeight(0)
+            , levelCount(0)
+            , occlusion(0)
+        {
+        }
+    };
+
+    // Same layout as Object structure in ObjectCuller.comp
+    struct CullingObject
+    {
+        ABench::Math::Matrix transform;
+        ABench::Math::Vector4 aabbMin;
+        ABench::Math::Vector4 aabbMax;
+        uint32_t pointCount;
+        uint32_t indexed;
+        uint32_t padding[2];
+    };
+
+    DevicePtr mDevice;
+
+    Buffer mCullingParams;
+    Buffer mObjects;
+    Buffer mDrawCommands;
+    uint32_t mDrawCapacity;
+    std::vector<CullingObject> mObjectData;
+
+    VkDescriptorSet mDescriptorSet;
+    VkRAII<VkDescriptorSetLayout> mDescriptorSetLayout;
+    VkRAII<VkPipelineLayout> mPipelineLayout;
+    Shader mShader;
+    Pipeline mPipeline;
+    CommandBuffer mCommandBuffer;
+
+    CullingParams mCullingParamsData;
+
+    bool ReserveDraws(uint32_t drawCount);
+
+public:
+    ObjectCuller();
+
+    bool Init(const DevicePtr& device, const ObjectCullerDesc& desc);
+
+    // Uploads bounds of Draw List's meshes and the frustum. Previous dispatch must be finished.
+    // With occlusionViewProj meshes are also tested against Hi-Z pyramid rendered with that matrix.
+    bool Update(const DrawList& drawList, const Math::Frustum& frustum, const Math::Matrix* occlusionViewProj);
+    void Dispatch(const ObjectCullerDispatchDesc& desc);
+
+    ABENCH_INLINE const Buffer* GetDrawCommands() const
+    {
+        return &mDrawCommands;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -3,6 +3,7 @@
 
 #include "Math/Vector.hpp"
 #include "Renderer/LowLevel/DescriptorAllocator.hpp"
+#include "Common/Profiler.hpp"
 
 
 namespace {
@@ -107,10 +108,6 @@ bool ParticleEngine::Init(const DevicePtr& device)
 
     // Sorting-related parameters
     {
-        mParticleFinishedSem = Tools::CreateSem(mDevice);
-        if (!mParticleFinishedSem)
-            return false;
-
         std::vector<DescriptorSetLayoutDesc> setLayoutDescs;
         setLayoutDescs.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
         setLayoutDescs.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE});
@@ -140,7 +137,7 @@ bool ParticleEngine::Init(const DevicePtr& device)
         if (!mSortPipeline.Init(mDevice, cpDesc))
             return false;
 
-        if (!mSortParams.Init(mDevice, 1024 * 32))
+        if (!mSortParams.Init(mDevice, 1024 * 32, "ParticleSortParams"))
             return false;
 
         Tools::UpdateBufferDescriptorSet(mDevice, mSortSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
@@ -236,6 +233,8 @@ bool ParticleEngine::UpdateEmitters(const Scene::Scene& scene)
 
 void ParticleEngine::Dispatch(const ParticleEngineDispatchDesc& desc)
 {
+    PROFILER_SCOPE("ParticleEngine::Dispatch");
+
     if (mEmitters.empty())
         return;
 
@@ -276,8 +275,7 @@ void ParticleEngine::Dispatch(const ParticleEngineDispatchDesc& desc)
             LOGW("Particle Engine failed to record command buffer for Particle update");
     }
 
-    mDevice->Execute(DeviceQueueType::COMPUTE, &mParticleCommandBuffer,
-                     0, nullptr, nullptr, mParticleFinishedSem, desc.simulationFence);
+    desc.frameGraph->Schedule(desc.simulationNode, &mParticleCommandBuffer);
 
     {
         mSortCommandBuffer.Begin();
@@ -314,10 +312,7 @@ void ParticleEngine::Dispatch(const ParticleEngineDispatchDesc& desc)
             LOGW("Particle Engine failed to record command buffer for Particle sorting");
     }
 
-    VkPipelineStageFlags waitFlag = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-    VkSemaphore waitSem = mParticleFinishedSem;
-    mDevice->Execute(DeviceQueueType::COMPUTE, &mSortCommandBuffer,
-                     1, &waitFlag, &waitSem, desc.signalSem, VK_NULL_HANDLE);
+    desc.frameGraph->Schedule(desc.sortNode, &mSortCommandBuffer);
 
     mSortParams.MarkFinishedFrame();
 }
@@ -6,6 +6,7 @@
 #include "Renderer/LowLevel/Tools.hpp"
 #include "Renderer/LowLevel/Shader.hpp"
 #include "Renderer/LowLevel/RingBuffer.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
 
 #include "Scene/Scene.hpp"
 
@@ -17,8 +18,9 @@ struct ParticleEngineDispatchDesc
 {
     Math::Vector4 cameraPos;
     float deltaTime;
-    VkSemaphore signalSem;
-    VkFence simulationFence;
+    FrameGraph* frameGraph;
+    FrameGraphNode simulationNode;
+    FrameGraphNode sortNode; // should depend on simulationNode
 };
 
 class ParticleEngine final
@@ -36,7 +38,6 @@ class ParticleEngine final
     Pipeline mParticlePipeline;
     CommandBuffer mParticleCommandBuffer;
 
-    VkRAII<VkSemaphore> mParticleFinishedSem;
     RingBuffer mSortParams;
     VkDescriptorSet mSortSet;
     VkRAII<VkDescriptorSetLayout> mSortSetLayout;
@@ -4,6 +4,7 @@
 #include "Renderer/LowLevel/Translations.hpp"
 #include "Renderer/LowLevel/Extensions.hpp"
 #include "Common/Image.hpp"
+#include "Common/Profiler.hpp"
 
 
 namespace ABench {
@@ -182,6 +183,8 @@ bool ParticlePass::Init(const DevicePtr& device, const ParticlePassDesc& desc)
 
 void ParticlePass::Draw(const ParticlePassDrawDesc& desc)
 {
+    PROFILER_SCOPE("ParticlePass::Draw");
+
     std::vector<Scene::EmitterData> emitterData(desc.emitterCount);
 
     {
@@ -242,10 +245,7 @@ void ParticlePass::Draw(const ParticlePassDrawDesc& desc)
         }
     }
 
-    mDevice->Execute(DeviceQueueType::GRAPHICS, &mCommandBuffer,
-                     static_cast<uint32_t>(desc.waitSems.size()),
-                     desc.waitFlags.data(), desc.waitSems.data(),
-                     desc.signalSem, desc.fence);
+    desc.frameGraph->Schedule(desc.node, &mCommandBuffer);
 }
 
 } // namespace Renderer
@@ -3,6 +3,7 @@
 #include "Renderer/LowLevel/Device.hpp"
 #include "Renderer/LowLevel/MultiPipeline.hpp"
 #include "Renderer/LowLevel/Tools.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
 
 #include "Scene/Scene.hpp"
 
@@ -25,11 +26,9 @@ struct ParticlePassDrawDesc
     Buffer* emitterDataBuffer;
     uint32_t emitterCount;
     Math::Vector4 cameraPos;
-    VkFence simulationFinishedFence;
-    std::vector<VkPipelineStageFlags> waitFlags;
-    std::vector<VkSemaphore> waitSems;
-    VkSemaphore signalSem;
-    VkFence fence;
+    VkFence simulationFinishedFence; // simulation must be already submitted
+    FrameGraph* frameGraph;
+    FrameGraphNode node;
 };
 
 class ParticlePass final
@@ -1,13 +1,17 @@
 #include "PCH.hpp"
 #include "Renderer.hpp"
+#include "ResourceManager.hpp"
 
 #include "Renderer/LowLevel/DescriptorAllocator.hpp"
+#include "Renderer/LowLevel/PipelineCache.hpp"
+#include "Renderer/LowLevel/ShaderCache.hpp"
 #include "Renderer/LowLevel/Extensions.hpp"
 #include "Renderer/LowLevel/Translations.hpp"
 
 #include "ResourceDir.hpp"
 #include "Common/FS.hpp"
 #include "Common/Logger.hpp"
+#include "Common/Profiler.hpp"
 #include "Math/Plane.hpp"
 
 #include <glslang/Public/ShaderLang.h>
@@ -16,6 +20,13 @@
 namespace {
 
 const uint32_t PIXELS_PER_GRID_FRUSTUM = 16;
+const uint32_t PIXELS_PER_CLUSTER = 64;
+const uint32_t CLUSTER_DEPTH_SLICES = 32;
+const uint32_t CPU_OCCLUSION_FIRST_LEVEL = 2; // texels of 8x8 pixels are fine enough for whole models
+const uint32_t LIGHT_CONTAINER_INITIAL_LIGHTS = 32768; // 1 MB of light data
+const float LIGHT_CONTAINER_GROWTH = 1.5f;
+const std::string PIPELINE_CACHE_FILE = "PipelineCache.bin";
+const uint32_t PIPELINE_COMPILE_THREADS = 2; // separate from recording threads, so frames never wait for compilation
 
 struct VertexShaderCBuffer
 {
@@ -40,17 +51,41 @@ Renderer::Renderer()
     , mDevice(nullptr)
     , mBackbuffer()
     , mImageAcquiredSem()
-    , mParticleEngineSem()
-    , mDepthSem()
-    , mCullingSem()
-    , mRenderSem()
+    , mParticlePassSem()
+    , mParticleEngineFence()
     , mFrameFence()
+    , mGpuProfiler()
+    , mFrameGraph()
+    , mParticleSimulationNode(FRAME_GRAPH_INVALID_NODE)
+    , mParticleSortNode(FRAME_GRAPH_INVALID_NODE)
+    , mObjectCullerNode(FRAME_GRAPH_INVALID_NODE)
+    , mDepthPrePassNode(FRAME_GRAPH_INVALID_NODE)
+    , mHiZPyramidNode(FRAME_GRAPH_INVALID_NODE)
+    , mLightCullerNode(FRAME_GRAPH_INVALID_NODE)
+    , mForwardPassNode(FRAME_GRAPH_INVALID_NODE)
+    , mParticlePassNode(FRAME_GRAPH_INVALID_NODE)
+    , mDrawList()
+    , mTransformStride(0)
+    , mDepthPyramidReadback()
+    , mPrevViewProj(Math::MATRIX_IDENTITY)
+    , mHiZPyramidValid(false)
     , mVertexShaderSet(VK_NULL_HANDLE)
     , mVertexShaderCBuffer()
     , mRingBuffer()
     , mLightContainer()
+    , mLightBVH()
+    , mLightBVHGeneration(0)
+    , mLightBVHValid(false)
+    , mLightCullingMode(LightCullingMode::Tiled)
+    , mGpuCulling(false)
+    , mOcclusionCulling(false)
+    , mLightBVHCulling(false)
+    , mThreadPool()
+    , mCompileThreadPool()
     , mGridFrustumsGenerator()
+    , mObjectCuller()
     , mDepthPrePass()
+    , mHiZPyramid()
     , mLightCuller()
     , mForwardPass()
 {
@@ -58,6 +93,17 @@ Renderer::Renderer()
 
 Renderer::~Renderer()
 {
+    // Pipelines might still be precompiled in the background
+    mCompileThreadPool.WaitForTasks();
+    if (mDevice)
+        WaitForAll();
+
+    // singletons keep the Device alive - release them, so next Renderer starts from scratch
+    ResourceManager::Instance().Release();
+    DescriptorAllocator::Instance().Release();
+    PipelineCache::Instance().Release();
+    ShaderCache::Instance().Release();
+
     glslang::FinalizeProcess();
 }
 
@@ -69,6 +115,9 @@ bool Renderer::Init(const RendererDesc& desc)
         return false;
     }
 
+    if (!ShaderCache::Instance().Init(desc.validateShaders))
+        return false;
+
     VkDebugReportFlagsEXT debugFlags = 0;
 
     if (desc.debugEnable)
@@ -79,26 +128,38 @@ bool Renderer::Init(const RendererDesc& desc)
     }
 
     mInstance = std::make_shared<Instance>();
-    if (!mInstance->Init(debugFlags))
+    if (!mInstance->Init(debugFlags, desc.headless))
         return false;
 
     mDevice = std::make_shared<Device>();
     if (!mDevice->Init(mInstance, desc.noAsync))
         return false;
 
+    if (desc.profile)
+    {
+        GpuProfilerDesc profilerDesc;
+        profilerDesc.keepSamples = desc.profileSamples;
+        if (!mGpuProfiler.Init(mDevice, profilerDesc))
+            return false;
+    }
+
     // initialize Descriptor Allocator
+    // limits of a single pool - more pools are created when these run out
     DescriptorAllocatorDesc daDesc;
-    ZERO_MEMORY(daDesc);
     daDesc.limits[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER] = 12;
     daDesc.limits[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER] = 7;
     daDesc.limits[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC] = 3;
-    daDesc.limits[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] = 1000;
+    daDesc.limits[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] = 256;
+    daDesc.maxSets = 256; // mostly single-texture material sets
     if (!DescriptorAllocator::Instance().Init(mDevice, daDesc))
         return false;
 
     if (!ResourceManager::Instance().Init(mDevice))
         return false;
 
+    if (!PipelineCache::Instance().Init(mDevice, Common::FS::JoinPaths(ResourceDir::SHADER_CACHE, PIPELINE_CACHE_FILE)))
+        return false;
+
     if (!mGridFrustumsGenerator.Init(mDevice))
         return false;
 
@@ -121,30 +182,21 @@ bool Renderer::Init(const RendererDesc& desc)
     bbDesc.width = desc.window->GetWidth();
     bbDesc.height = desc.window->GetHeight();
     bbDesc.vsync = false;
-    if (!mBackbuffer.Init(mDevice, bbDesc))
-        return false;
+    bbDesc.bufferCount = desc.backbufferCount;
+    bbDesc.headless = desc.headless;
+    bbDesc.readbackInterval = desc.readbackInterval;
+    bbDesc.readbackPrefix = desc.readbackPrefix;
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "Backbuffer");
+        if (!mBackbuffer.Init(mDevice, bbDesc))
+            return false;
+    }
 
     // Synchronization primitives
     mImageAcquiredSem = Tools::CreateSem(mDevice);
     if (!mImageAcquiredSem)
         return false;
 
-    mParticleEngineSem = Tools::CreateSem(mDevice);
-    if (!mParticleEngineSem)
-        return false;
-
-    mDepthSem = Tools::CreateSem(mDevice);
-    if (!mDepthSem)
-        return false;
-
-    mCullingSem = Tools::CreateSem(mDevice);
-    if (!mCullingSem)
-        return false;
-
-    mRenderSem = Tools::CreateSem(mDevice);
-    if (!mRenderSem)
-        return false;
-
     mParticlePassSem = Tools::CreateSem(mDevice);
     if (!mParticlePassSem)
         return false;
@@ -157,6 +209,9 @@ bool Renderer::Init(const RendererDesc& desc)
     if (!mFrameFence)
         return false;
 
+    if (!BuildFrameGraph())
+        return false;
+
     // View frustum definition
     float aspect = static_cast<float>(desc.window->GetWidth()) / static_cast<float>(desc.window->GetHeight());
     mProjection = Math::CreateRHProjectionMatrix(desc.fov, aspect, desc.nearZ, desc.farZ);
@@ -171,6 +226,7 @@ bool Renderer::Init(const RendererDesc& desc)
     std::vector<DescriptorSetLayoutDesc> vsLayoutDesc;
     vsLayoutDesc.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, VK_NULL_HANDLE});
     vsLayoutDesc.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, VK_NULL_HANDLE});
+    vsLayoutDesc.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, VK_NULL_HANDLE});
     mVertexShaderLayout = Tools::CreateDescriptorSetLayout(mDevice, vsLayoutDesc);
     if (!mVertexShaderLayout)
         return false;
@@ -180,9 +236,13 @@ bool Renderer::Init(const RendererDesc& desc)
         return false;
 
     // Common shader buffers
-    if (!mRingBuffer.Init(mDevice, 1024 * 1024))
+    MemoryOwnerScope commonOwner(mDevice->GetStatistics(), "Renderer");
+    if (!mRingBuffer.Init(mDevice, 1024 * 1024, "Renderer"))
         return false;
 
+    // Ring Buffer allocations start at multiples of 256 bytes, the largest alignment Vulkan allows
+    mTransformStride = DrawList::GetTransformStride(mDevice->GetProperties().limits.minUniformBufferOffsetAlignment);
+
     BufferDesc vsBufferDesc;
     vsBufferDesc.data = nullptr;
     vsBufferDesc.dataSize = sizeof(VertexShaderCBuffer);
@@ -193,7 +253,7 @@ bool Renderer::Init(const RendererDesc& desc)
 
     BufferDesc lightBufferDesc;
     lightBufferDesc.data = nullptr;
-    lightBufferDesc.dataSize = 1024 * 1024;
+    lightBufferDesc.dataSize = LIGHT_CONTAINER_INITIAL_LIGHTS * sizeof(Scene::LightData);
     lightBufferDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     lightBufferDesc.type = BufferType::Dynamic;
     if (!mLightContainer.Init(mDevice, lightBufferDesc))
@@ -205,6 +265,9 @@ bool Renderer::Init(const RendererDesc& desc)
                                      mRingBuffer.GetBuffer(), sizeof(VertexShaderDynamicCBuffer));
     Tools::UpdateBufferDescriptorSet(mDevice, mVertexShaderSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
                                      mVertexShaderCBuffer.GetBuffer(), sizeof(VertexShaderCBuffer));
+    // whole Ring Buffer, so bindless Forward Pass can index transforms without rebinding the set
+    Tools::UpdateBufferDescriptorSet(mDevice, mVertexShaderSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2,
+                                     mRingBuffer.GetBuffer(), VK_WHOLE_SIZE);
 
 
     // Rendering stages
@@ -216,25 +279,72 @@ bool Renderer::Init(const RendererDesc& desc)
     if (!mGridFrustumsGenerator.Generate(genDesc))
         return false;
 
-    if (!mParticleEngine.Init(mDevice))
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "ParticleEngine");
+        if (!mParticleEngine.Init(mDevice))
+            return false;
+    }
+
+    if (!mThreadPool.Init(desc.recordingThreads))
+        return false;
+
+    if (!mCompileThreadPool.Init(PIPELINE_COMPILE_THREADS))
         return false;
 
     DepthPrePassDesc dppDesc;
     dppDesc.width = mBackbuffer.GetWidth();
     dppDesc.height = mBackbuffer.GetHeight();
     dppDesc.vertexShaderLayout = mVertexShaderLayout;
-    if (!mDepthPrePass.Init(mDevice, dppDesc))
+    dppDesc.threadPool = &mThreadPool;
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "DepthPrePass");
+        if (!mDepthPrePass.Init(mDevice, dppDesc))
+            return false;
+    }
+
+    HiZPyramidDesc hizDesc;
+    hizDesc.width = mBackbuffer.GetWidth();
+    hizDesc.height = mBackbuffer.GetHeight();
+    hizDesc.depthTexture = mDepthPrePass.GetDepthTexture();
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "HiZPyramid");
+        if (!mHiZPyramid.Init(mDevice, hizDesc))
+            return false;
+    }
+
+    if (!mDepthPyramidReadback.Init(mBackbuffer.GetWidth(), mBackbuffer.GetHeight()))
         return false;
+    mDepthPyramidReadback.SetFirstLevel(CPU_OCCLUSION_FIRST_LEVEL);
+    mOcclusionCulling = desc.occlusionCulling;
+    mLightBVHCulling = desc.lightBVH;
+
+    mGpuCulling = desc.gpuCulling;
+    ObjectCullerDesc ocDesc;
+    ocDesc.hiZPyramid = &mHiZPyramid;
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "ObjectCuller");
+        if (!mObjectCuller.Init(mDevice, ocDesc))
+            return false;
+    }
 
     LightCullerDesc lcDesc;
     lcDesc.viewportWidth = desc.window->GetWidth();
     lcDesc.viewportHeight = desc.window->GetHeight();
     lcDesc.pixelsPerGridFrustum = PIXELS_PER_GRID_FRUSTUM;
+    lcDesc.projMat = mProjection;
+    lcDesc.nearZ = desc.nearZ;
+    lcDesc.farZ = desc.farZ;
+    lcDesc.pixelsPerCluster = PIXELS_PER_CLUSTER;
+    lcDesc.clusterDepthSlices = CLUSTER_DEPTH_SLICES;
     lcDesc.gridFrustums = mGridFrustumsGenerator.GetGridFrustums();
     lcDesc.lightContainer = &mLightContainer;
-    lcDesc.depthTexture = mDepthPrePass.GetDepthTexture();
-    if (!mLightCuller.Init(mDevice, lcDesc))
-        return false;
+    lcDesc.depthPyramid = mHiZPyramid.GetBuffer();
+    lcDesc.depthPyramidOffset = mHiZPyramid.GetLevel(DepthPyramid::GetLevelForTexelSize(PIXELS_PER_GRID_FRUSTUM)).offset;
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "LightCuller");
+        if (!mLightCuller.Init(mDevice, lcDesc))
+            return false;
+    }
 
     ForwardPassDesc fpDesc;
     fpDesc.width = mBackbuffer.GetWidth();
@@ -247,8 +357,16 @@ bool Renderer::Init(const RendererDesc& desc)
     fpDesc.lightContainerPtr = &mLightContainer;
     fpDesc.culledLightsPtr = mLightCuller.GetCulledLights();
     fpDesc.gridLightDataPtr = mLightCuller.GetGridLightData();
-    if (!mForwardPass.Init(mDevice, fpDesc))
-        return false;
+    fpDesc.clusterGrid = &mLightCuller.GetClusterGrid();
+    fpDesc.lightCulling = desc.lightCulling;
+    mLightCullingMode = desc.lightCulling;
+    fpDesc.threadPool = &mThreadPool;
+    fpDesc.compileThreadPool = &mCompileThreadPool;
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "ForwardPass");
+        if (!mForwardPass.Init(mDevice, fpDesc))
+            return false;
+    }
 
     ParticlePassDesc ppDesc;
     ppDesc.targetTexture = &mForwardPass.GetTargetTexture();
@@ -257,25 +375,104 @@ bool Renderer::Init(const RendererDesc& desc)
     ppDesc.outputFormat = mBackbuffer.GetFormat();
     ppDesc.particleTexturePath = Common::FS::JoinPaths(
         Common::FS::JoinPaths(ResourceDir::DATA_ROOT, ResourceDir::TEXTURES), "particle.png");
-    if (!mParticlePass.Init(mDevice, ppDesc))
-        return false;
+    {
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "ParticlePass");
+        if (!mParticlePass.Init(mDevice, ppDesc))
+            return false;
+    }
 
     return true;
 }
 
-void Renderer::Draw(const Scene::Scene& scene, const Scene::Camera& camera, float deltaTime)
+bool Renderer::BuildFrameGraph()
 {
-    // Perform view frustum culling for next scene
-    mViewFrustum.Refresh(camera.GetPosition(), camera.GetAtPosition(), camera.GetUpVector());
-    scene.ForEachObject([&](const Scene::Object* o) -> bool {
-        if (o->GetComponent()->GetType() == Scene::ComponentType::Model)
+    if (!mFrameGraph.Init(mDevice))
+        return false;
+
+    if (mGpuProfiler.IsEnabled())
+        mFrameGraph.SetProfiler(&mGpuProfiler);
+
+    mParticleSimulationNode = mFrameGraph.AddNode("ParticleSimulation", DeviceQueueType::COMPUTE);
+    mParticleSortNode = mFrameGraph.AddNode("ParticleSort", DeviceQueueType::COMPUTE);
+    mObjectCullerNode = mFrameGraph.AddNode("ObjectCuller", DeviceQueueType::GRAPHICS);
+    mDepthPrePassNode = mFrameGraph.AddNode("DepthPrePass", DeviceQueueType::GRAPHICS);
+    mHiZPyramidNode = mFrameGraph.AddNode("HiZPyramid", DeviceQueueType::COMPUTE);
+    mLightCullerNode = mFrameGraph.AddNode("LightCuller", DeviceQueueType::COMPUTE);
+    mForwardPassNode = mFrameGraph.AddNode("ForwardPass", DeviceQueueType::GRAPHICS);
+    mParticlePassNode = mFrameGraph.AddNode("ParticlePass", DeviceQueueType::GRAPHICS);
+
+    bool result = true;
+    result &= mFrameGraph.AddDependency(mParticleSortNode, mParticleSimulationNode, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    result &= mFrameGraph.AddDependency(mHiZPyramidNode, mDepthPrePassNode, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    result &= mFrameGraph.AddDependency(mLightCullerNode, mHiZPyramidNode, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    result &= mFrameGraph.AddDependency(mForwardPassNode, mLightCullerNode, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    result &= mFrameGraph.AddExternalWait(mForwardPassNode, mImageAcquiredSem, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    result &= mFrameGraph.AddDependency(mParticlePassNode, mParticleSortNode, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+    result &= mFrameGraph.AddDependency(mParticlePassNode, mForwardPassNode, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    result &= mFrameGraph.AddExternalSignal(mParticlePassNode, mParticlePassSem);
+    result &= mFrameGraph.SetFence(mParticleSimulationNode, mParticleEngineFence);
+    result &= mFrameGraph.SetFence(mParticlePassNode, mFrameFence);
+
+    return result;
+}
+
+uint32_t Renderer::UploadLights(const Scene::Scene& scene)
+{
+    PROFILER_SCOPE("Renderer::UploadLights");
+
+    const std::vector<Scene::LightData>& lights = scene.GetLightData();
+    VkDeviceSize requiredSize = lights.size() * sizeof(Scene::LightData);
+    if (requiredSize > mLightContainer.GetSize())
+    {
+        // called after the frame fence, so no frame reads the old buffer anymore
+        VkDeviceSize newSize = static_cast<VkDeviceSize>(requiredSize * LIGHT_CONTAINER_GROWTH);
+        newSize -= newSize % sizeof(Scene::LightData);
+        LOGI("Growing Light Container buffer from " << mLightContainer.GetSize() << " to " << newSize << " bytes");
+
+        MemoryOwnerScope owner(mDevice->GetStatistics(), "Renderer");
+        mLightContainer.Free();
+
+        BufferDesc lightBufferDesc;
+        lightBufferDesc.data = nullptr;
+        lightBufferDesc.dataSize = newSize;
+        lightBufferDesc.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        lightBufferDesc.type = BufferType::Dynamic;
+        if (!mLightContainer.Init(mDevice, lightBufferDesc))
         {
-            Scene::Model* model = dynamic_cast<Scene::Model*>(o->GetComponent());
-            model->SetToRender(mViewFrustum.Intersects(model->GetTransform() * model->GetAABB()));
+            LOGE("Failed to grow Light Container buffer - no lights are drawn");
+            return 0;
         }
 
-        return true;
-    });
+        mLightCuller.UpdateLightContainer();
+        mForwardPass.UpdateLightContainer();
+    }
+
+    if (lights.empty())
+        return 0;
+
+    // scene keeps lights packed, so all of them go with a single copy
+    if (!mLightContainer.Write(lights.data(), static_cast<size_t>(requiredSize)))
+    {
+        LOGW("Failed to update Light Container Storage Buffer");
+        return 0;
+    }
+
+    return static_cast<uint32_t>(lights.size());
+}
+
+void Renderer::Draw(const Scene::Scene& scene, const Scene::Camera& camera, float deltaTime)
+{
+    PROFILER_SCOPE("Renderer::Draw");
+
+    // Perform view frustum culling for next scene, visible models are shared by all geometry passes.
+    // With GPU culling all models are recorded and ObjectCuller decides which meshes are drawn.
+    // Occlusion culling on CPU needs previous frame's depth pyramid, so it waits for the frame fence.
+    bool gpuCulling = mGpuCulling;
+    bool occlusionCulling = mOcclusionCulling && mHiZPyramidValid;
+    bool cpuOcclusionCulling = occlusionCulling && !gpuCulling;
+    mViewFrustum.Refresh(camera.GetPosition(), camera.GetAtPosition(), camera.GetUpVector());
+    if (!cpuOcclusionCulling)
+        mDrawList.Build(scene, gpuCulling ? nullptr : &mViewFrustum);
 
     // Wait for previous frame
     VkFence fences[] = { mFrameFence };
@@ -287,17 +484,28 @@ void Renderer::Draw(const Scene::Scene& scene, const Scene::Camera& camera, floa
     if (result != VK_SUCCESS)
         LOGW("Failed to reset frame fence: " << result << " (" << TranslateVkResultToString(result) << ")");
 
+    // previous frame finished, so the oldest profiled frame can be read back
+    mGpuProfiler.NextFrame();
 
-    ////////////////////////////
-    // Particle Engine update //
-    ////////////////////////////
-    mParticleEngine.UpdateEmitters(scene);
-    ParticleEngineDispatchDesc peDesc;
-    peDesc.cameraPos = camera.GetPosition();
-    peDesc.deltaTime = deltaTime;
-    peDesc.signalSem = mParticleEngineSem;
-    peDesc.simulationFence = mParticleEngineFence;
-    mParticleEngine.Dispatch(peDesc);
+    // no frame reads Forward Pass parameters now, so culling mode can be switched safely
+    if (!mForwardPass.SetLightCullingMode(mLightCullingMode))
+        LOGW("Failed to switch light culling mode");
+
+    // the same goes for light lists - if previous frame's lists did not fit, the buffer grows
+    if (mLightCuller.ReserveCulledLights())
+        mForwardPass.UpdateCulledLights();
+
+    // previous frame's depth pyramid is complete as well
+    if (cpuOcclusionCulling)
+    {
+        DrawListOcclusion occlusion;
+        occlusion.depthPyramid = &mDepthPyramidReadback;
+        occlusion.viewProj = mPrevViewProj;
+        bool readBack = mHiZPyramid.ReadBack(&mDepthPyramidReadback);
+        if (!readBack)
+            LOGW("Failed to read back depth pyramid - occlusion culling skipped this frame");
+        mDrawList.Build(scene, &mViewFrustum, readBack ? &occlusion : nullptr);
+    }
 
 
     //////////////////////////////////
@@ -309,35 +517,109 @@ void Renderer::Draw(const Scene::Scene& scene, const Scene::Camera& camera, floa
     if (!mVertexShaderCBuffer.Write(&vsBuffer, sizeof(vsBuffer)))
         LOGW("Failed to update Vertex Shader Uniform Buffer");
 
-    uint32_t lightCount = 0;
-    scene.ForEachLight([&](const ABench::Scene::Light* l) -> bool {
-        if (!mLightContainer.Write(l->GetData(), sizeof(Scene::LightData), lightCount * sizeof(Scene::LightData)))
-            LOGW("Failed to update Light Container Storage Buffer");
-        lightCount++;
-        return true;
-    });
+    if (!mDrawList.UploadTransforms(&mRingBuffer, mTransformStride))
+        LOGW("Failed to upload world matrices of visible models");
+
+    // previous frame finished reading indirect commands, so culling data can be updated
+    if (gpuCulling && !mObjectCuller.Update(mDrawList, mViewFrustum, occlusionCulling ? &mPrevViewProj : nullptr))
+    {
+        LOGW("Failed to update GPU culling data - all models are drawn this frame");
+        gpuCulling = false;
+    }
+
+    uint32_t lightCount = UploadLights(scene);
+
+    // light BVH is built in world space, so it is rebuilt only when lights change - on the
+    // Thread Pool, while depth pass is recorded
+    bool lightBVH = mLightBVHCulling && (lightCount > 0);
+    bool buildLightBVH = lightBVH && (!mLightBVHValid || scene.GetLightDataGeneration() != mLightBVHGeneration);
+    Common::ThreadPoolTaskGroup lightBVHGroup;
+    if (buildLightBVH)
+    {
+        mLightBVHValid = false;
+        mLightBVHGeneration = scene.GetLightDataGeneration();
+        const Scene::LightData* lights = scene.GetLightData().data();
+        mThreadPool.AddTask([this, lights, lightCount]() {
+            PROFILER_SCOPE("Renderer::BuildLightBVH");
+            mLightBVH.Build(lights, lightCount);
+        }, &lightBVHGroup);
+    }
 
 
     ///////////////
     // Rendering //
     ///////////////
 
+    // Object culling on GPU, submitted before depth pass on the same queue
+    if (gpuCulling)
+    {
+        ObjectCullerDispatchDesc ocDesc;
+        ocDesc.frameGraph = &mFrameGraph;
+        ocDesc.node = mObjectCullerNode;
+        mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mObjectCullerNode));
+        mObjectCuller.Dispatch(ocDesc);
+        mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mObjectCullerNode));
+    }
+
+    const Buffer* drawCommands = gpuCulling ? mObjectCuller.GetDrawCommands() : nullptr;
+
     // Depth pass
     DepthPrePassDrawDesc depthDesc;
-    depthDesc.ringBufferPtr = &mRingBuffer;
+    depthDesc.drawList = &mDrawList;
+    depthDesc.drawCommands = drawCommands;
     depthDesc.vertexShaderSet = mVertexShaderSet;
-    depthDesc.signalSem = mDepthSem;
-    mDepthPrePass.Draw(scene, depthDesc);
+    depthDesc.frameGraph = &mFrameGraph;
+    depthDesc.node = mDepthPrePassNode;
+    mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mDepthPrePassNode));
+    mDepthPrePass.Draw(depthDesc);
+    mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mDepthPrePassNode));
+
+    // Particle Engine update
+    mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mParticleSimulationNode));
+    mParticleEngine.UpdateEmitters(scene);
+    ParticleEngineDispatchDesc peDesc;
+    peDesc.cameraPos = camera.GetPosition();
+    peDesc.deltaTime = deltaTime;
+    peDesc.frameGraph = &mFrameGraph;
+    peDesc.simulationNode = mParticleSimulationNode;
+    peDesc.sortNode = mParticleSortNode;
+    mParticleEngine.Dispatch(peDesc);
+    mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mParticleSimulationNode));
+
+    // Depth pyramid, used by light culling below and by occlusion culling of the next frame
+    HiZPyramidDispatchDesc hizDesc;
+    hizDesc.frameGraph = &mFrameGraph;
+    hizDesc.node = mHiZPyramidNode;
+    mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mHiZPyramidNode));
+    mHiZPyramid.Dispatch(hizDesc);
+    mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mHiZPyramidNode));
+
+    if (buildLightBVH)
+    {
+        mThreadPool.WaitForTasks(lightBVHGroup);
+        mLightBVHValid = mLightCuller.UploadLightBVH(mLightBVH);
+        if (!mLightBVHValid)
+            LOGW("Failed to upload light BVH - lights are culled by brute force this frame");
+    }
+
+    lightBVH = lightBVH && mLightBVHValid;
 
     // Light culling dispatch
     LightCullerDispatchDesc cullingDesc;
     cullingDesc.lightCount = lightCount;
     cullingDesc.projMat = mProjection;
     cullingDesc.viewMat = camera.GetView();
-    cullingDesc.waitFlags = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
-    cullingDesc.waitSems = { mDepthSem };
-    cullingDesc.signalSem = mCullingSem;
+    cullingDesc.mode = mForwardPass.GetLightCullingMode();
+    cullingDesc.lightBVH = lightBVH ? &mLightBVH : nullptr;
+    cullingDesc.frameGraph = &mFrameGraph;
+    cullingDesc.node = mLightCullerNode;
+    mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mLightCullerNode));
     mLightCuller.Dispatch(cullingDesc);
+    mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mLightCullerNode));
+
+    // Particle Pass waits for simulation results on CPU, so the work has to be submitted by now
+    if (!mFrameGraph.Submit())
+        LOGE("Failed to submit depth pass and compute work");
 
     // Forward pass
     if (!mBackbuffer.AcquireNextImage(mImageAcquiredSem))
@@ -345,11 +627,15 @@ void Renderer::Draw(const Scene::Scene& scene, const Scene::Camera& camera, floa
 
     ForwardPassDrawDesc forwardDesc;
     forwardDesc.ringBufferPtr = &mRingBuffer;
+    forwardDesc.drawList = &mDrawList;
+    forwardDesc.drawCommands = drawCommands;
     forwardDesc.vertexShaderSet = mVertexShaderSet;
-    forwardDesc.waitFlags = { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    forwardDesc.waitSems = { mCullingSem, mImageAcquiredSem };
-    forwardDesc.signalSem = mRenderSem;
-    mForwardPass.Draw(scene, forwardDesc);
+    forwardDesc.cameraPos = camera.GetPosition();
+    forwardDesc.frameGraph = &mFrameGraph;
+    forwardDesc.node = mForwardPassNode;
+    mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mForwardPassNode));
+    mForwardPass.Draw(forwardDesc);
+    mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mForwardPassNode));
 
     // Particle pass
     ParticlePassDrawDesc particleDesc;
@@ -358,14 +644,24 @@ void Renderer::Draw(const Scene::Scene& scene, const Scene::Camera& camera, floa
     particleDesc.emitterDataBuffer = mParticleEngine.GetEmitterDataBuffer();
     particleDesc.emitterCount = scene.GetEmitterCount();
     particleDesc.simulationFinishedFence = mParticleEngineFence;
-    particleDesc.waitFlags = { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    particleDesc.waitSems = { mParticleEngineSem, mRenderSem };
-    particleDesc.signalSem = mParticlePassSem;
-    particleDesc.fence = mFrameFence;
+    particleDesc.frameGraph = &mFrameGraph;
+    particleDesc.node = mParticlePassNode;
+    mGpuProfiler.BeginCpuScope(mFrameGraph.GetProfilerScope(mParticlePassNode));
     mParticlePass.Draw(particleDesc);
+    mGpuProfiler.EndCpuScope(mFrameGraph.GetProfilerScope(mParticlePassNode));
+
+    if (!mFrameGraph.Submit())
+        LOGE("Failed to submit rendering work");
+
+    if (!mFrameGraph.EndFrame())
+        LOGW("Failed to finish Frame Graph submission");
 
     mRingBuffer.MarkFinishedFrame();
 
+    // next frame culls against the pyramid built above
+    mPrevViewProj = mProjection * camera.GetView();
+    mHiZPyramidValid = true;
+
     if (!mBackbuffer.Present(mForwardPass.GetTargetTexture(), mParticlePassSem))
         LOGE("Error during image presentation");
 }
@@ -4,8 +4,11 @@
 #include "Renderer/LowLevel/Device.hpp"
 #include "Renderer/LowLevel/Backbuffer.hpp"
 #include "Renderer/LowLevel/Tools.hpp"
+#include "Renderer/LowLevel/FrameGraph.hpp"
+#include "Renderer/LowLevel/GpuProfiler.hpp"
 
 #include "Common/Window.hpp"
+#include "Common/ThreadPool.hpp"
 
 #include "Math/Frustum.hpp"
 
@@ -13,9 +16,12 @@
 #include "Scene/Mesh.hpp"
 #include "Scene/Scene.hpp"
 
+#include "DrawList.hpp"
+#include "ObjectCuller.hpp"
 #include "GridFrustumsGenerator.hpp"
 #include "ParticleEngine.hpp"
 #include "DepthPrePass.hpp"
+#include "HiZPyramid.hpp"
 #include "LightCuller.hpp"
 #include "ForwardPass.hpp"
 #include "ParticlePass.hpp"
@@ -29,9 +35,21 @@ struct RendererDesc
     bool debugEnable;
     bool debugVerbose;
     bool noAsync;
+    bool validateShaders; // check cached shaders against their sources, recompiling outdated ones
+    bool profile; // measure GPU and CPU time of each pass
+    bool profileSamples; // keep every profiler sample, so percentiles can be calculated
+    bool headless; // render offscreen, without a window surface - window only provides dimensions
+    uint32_t readbackInterval; // headless only - save every Nth frame to disk, 0 disables
+    std::string readbackPrefix;
+    uint32_t backbufferCount; // images rendered to in turns, limits how many frames are queued
     float fov;
     float nearZ;
     float farZ;
+    uint32_t recordingThreads; // worker threads recording Command Buffers, 0 picks automatically
+    LightCullingMode lightCulling; // can be changed later with SetLightCullingMode()
+    bool gpuCulling; // frustum culling of meshes in a compute shader, drawn indirectly; can be changed later
+    bool occlusionCulling; // cull against previous frame's depth pyramid, on GPU or CPU along with frustum culling; can be changed later
+    bool lightBVH; // light culling walks a BVH of lights built on CPU when lights change instead of testing all of them; can be changed later
     Common::Window* window;
 };
 
@@ -42,29 +60,58 @@ class Renderer final
 
     Backbuffer mBackbuffer;
     VkRAII<VkSemaphore> mImageAcquiredSem;
-    VkRAII<VkSemaphore> mParticleEngineSem;
-    VkRAII<VkSemaphore> mDepthSem;
-    VkRAII<VkSemaphore> mCullingSem;
-    VkRAII<VkSemaphore> mRenderSem;
     VkRAII<VkSemaphore> mParticlePassSem;
     VkRAII<VkFence> mParticleEngineFence;
     VkRAII<VkFence> mFrameFence;
 
+    GpuProfiler mGpuProfiler; // must outlive Frame Graph
+    FrameGraph mFrameGraph;
+    FrameGraphNode mParticleSimulationNode;
+    FrameGraphNode mParticleSortNode;
+    FrameGraphNode mObjectCullerNode;
+    FrameGraphNode mDepthPrePassNode;
+    FrameGraphNode mHiZPyramidNode;
+    FrameGraphNode mLightCullerNode;
+    FrameGraphNode mForwardPassNode;
+    FrameGraphNode mParticlePassNode;
+
     Math::Matrix mProjection;
     Math::Frustum mViewFrustum;
+    DrawList mDrawList;
+    uint32_t mTransformStride; // between world matrices of Draw List entries in the Ring Buffer
+    DepthPyramid mDepthPyramidReadback; // previous frame's Hi-Z pyramid for occlusion culling on CPU
+    Math::Matrix mPrevViewProj;
+    bool mHiZPyramidValid; // false until the first frame builds the pyramid
     VkRAII<VkDescriptorSetLayout> mVertexShaderLayout;
     VkDescriptorSet mVertexShaderSet;
     Buffer mVertexShaderCBuffer;
     RingBuffer mRingBuffer;
     Buffer mLightContainer;
-
+    LightBVH mLightBVH;
+    uint32_t mLightBVHGeneration; // Scene's light data generation the BVH was built from
+    bool mLightBVHValid; // BVH was built and uploaded, false until the first upload succeeds
+    LightCullingMode mLightCullingMode;
+    bool mGpuCulling;
+    bool mOcclusionCulling;
+    bool mLightBVHCulling;
+
+    Common::ThreadPool mThreadPool;
+    Common::ThreadPool mCompileThreadPool;
     GridFrustumsGenerator mGridFrustumsGenerator;
     ParticleEngine mParticleEngine;
+    ObjectCuller mObjectCuller;
     DepthPrePass mDepthPrePass;
+    HiZPyramid mHiZPyramid;
     LightCuller mLightCuller;
     ForwardPass mForwardPass;
     ParticlePass mParticlePass;
 
+    bool BuildFrameGraph();
+
+    // Copies scene's lights to Light Container, growing it when they do not fit.
+    // Returns number of uploaded lights, frame fence has to be waited for.
+    uint32_t UploadLights(const Scene::Scene& scene);
+
 public:
     Renderer();
     ~Renderer();
@@ -72,8 +119,74 @@ public:
     bool Init(const RendererDesc& desc);
     void Draw(const Scene::Scene& scene, const Scene::Camera& camera, float deltaTime);
 
+    // Takes effect from the next Draw() call
+    ABENCH_INLINE void SetLightCullingMode(LightCullingMode mode)
+    {
+        mLightCullingMode = mode;
+    }
+
+    ABENCH_INLINE LightCullingMode GetLightCullingMode() const
+    {
+        return mLightCullingMode;
+    }
+
+    // Takes effect from the next Draw() call
+    ABENCH_INLINE void SetGpuCulling(bool gpuCulling)
+    {
+        mGpuCulling = gpuCulling;
+    }
+
+    ABENCH_INLINE bool GetGpuCulling() const
+    {
+        return mGpuCulling;
+    }
+
+    // Takes effect from the next Draw() call
+    ABENCH_INLINE void SetOcclusionCulling(bool occlusionCulling)
+    {
+        mOcclusionCulling = occlusionCulling;
+    }
+
+    ABENCH_INLINE bool GetOcclusionCulling() const
+    {
+        return mOcclusionCulling;
+    }
+
+    // Takes effect from the next Draw() call
+    ABENCH_INLINE void SetLightBVHCulling(bool lightBVHCulling)
+    {
+        mLightBVHCulling = lightBVHCulling;
+    }
+
+    ABENCH_INLINE bool GetLightBVHCulling() const
+    {
+        return mLightBVHCulling;
+    }
+
+    // Light list entries written by light culling of the last finished frame
+    ABENCH_INLINE uint32_t GetCulledLightCount() const
+    {
+        return mLightCuller.GetRequiredCulledLights();
+    }
+
+    // Bind calls issued and elided by Forward Pass in the last frame
+    ABENCH_INLINE const CommandBufferStats& GetForwardPassStats() const
+    {
+        return mForwardPass.GetStats();
+    }
+
     // this function should be used only when application finishes
     void WaitForAll() const;
+
+    ABENCH_INLINE GpuProfiler& GetProfiler()
+    {
+        return mGpuProfiler;
+    }
+
+    ABENCH_INLINE MemoryStatistics& GetMemoryStatistics()
+    {
+        return mDevice->GetStatistics();
+    }
 };
 
 } // namespace Renderer
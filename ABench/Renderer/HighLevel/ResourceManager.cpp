@@ -24,6 +24,13 @@ bool ResourceManager::Init(const DevicePtr& device)
     return true;
 }
 
+void ResourceManager::Release()
+{
+    mTextures.clear();
+    mBuffers.clear();
+    mDevice.reset();
+}
+
 BufferPtr ResourceManager::GetBuffer(const BufferDesc& desc)
 {
     mBuffers.emplace_back(std::make_shared<Buffer>());
@@ -29,6 +29,8 @@ public:
     static ResourceManager& Instance();
 
     bool Init(const DevicePtr& device);
+    // drops all resources, so a new Renderer can be created after the old one finished
+    void Release();
 
     BufferPtr GetBuffer(const BufferDesc& desc);
     TexturePtr GetTexture(const TextureDesc& desc);
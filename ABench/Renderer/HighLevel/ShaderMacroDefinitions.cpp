@@ -9,6 +9,9 @@ namespace ShaderMacro {
 const std::string HAS_TEXTURE = "HAS_TEXTURE";
 const std::string HAS_NORMAL = "HAS_NORMAL";
 const std::string HAS_COLOR_MASK = "HAS_COLOR_MASK";
+const std::string BINDLESS = "BINDLESS";
+const std::string WRITE_LIGHTS = "WRITE_LIGHTS";
+const std::string LIGHT_BVH = "LIGHT_BVH";
 
 } // namespace ShaderMacro
 } // namespace Renderer
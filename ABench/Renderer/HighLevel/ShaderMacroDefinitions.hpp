@@ -8,6 +8,9 @@ namespace ShaderMacro {
 extern const std::string HAS_TEXTURE;
 extern const std::string HAS_NORMAL;
 extern const std::string HAS_COLOR_MASK;
+extern const std::string BINDLESS;
+extern const std::string WRITE_LIGHTS;
+extern const std::string LIGHT_BVH;
 
 } // namespace ShaderMacro
 } // namespace Renderer
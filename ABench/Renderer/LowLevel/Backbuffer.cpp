@@ -7,12 +7,23 @@
 
 #include "Common/Common.hpp"
 
+#include <iomanip>
+
+
+namespace {
+
+const uint32_t READBACK_FRAME_DIGITS = 6;
+
+} // namespace
+
+
 namespace ABench {
 namespace Renderer {
 
 Backbuffer::Backbuffer()
     : mInstance()
     , mDevice()
+    , mCurrentBuffer(0)
     , mSurface(VK_NULL_HANDLE)
     , mPresentQueueIndex(0)
     , mPresentQueue(VK_NULL_HANDLE)
@@ -20,11 +31,27 @@ Backbuffer::Backbuffer()
     , mPresentMode(VK_PRESENT_MODE_FIFO_KHR)
     , mSwapchain(VK_NULL_HANDLE)
     , mBufferCount(0)
+    , mHeadless(false)
+    , mOffscreenImages()
+    , mReadbackBuffer()
+    , mReadbackInterval(0)
+    , mReadbackPrefix()
+    , mPresentedFrames(0)
+    , mReadbackFrame(0)
+    , mReadbackPending(false)
 {
 }
 
 Backbuffer::~Backbuffer()
 {
+    if (mReadbackPending)
+    {
+        // last read back frame is still in flight
+        VkFence fences[] = { mCopyFence };
+        vkWaitForFences(mDevice->GetDevice(), 1, fences, VK_TRUE, UINT64_MAX);
+        WriteReadback();
+    }
+
     if (mSwapchain != VK_NULL_HANDLE)
         vkDestroySwapchainKHR(mDevice->GetDevice(), mSwapchain, nullptr);
     if (mSurface != VK_NULL_HANDLE)
@@ -228,18 +255,112 @@ bool Backbuffer::AllocateImageViews()
 
     LOGD(mBufferCount << " swapchain images acquired.");
 
-    ZERO_MEMORY(mSubresourceRange);
-    mSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    mSubresourceRange.baseMipLevel = 0;
-    mSubresourceRange.levelCount = 1;
-    mSubresourceRange.baseArrayLayer = 0;
-    mSubresourceRange.layerCount = 1;
-
     mDefaultLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     return true;
 }
 
+bool Backbuffer::CreateOffscreenImages(const BackbufferDesc& desc)
+{
+    mFormat = desc.requestedFormat;
+    mBufferCount = std::max(desc.bufferCount, 1u);
+    mDefaultLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    mImages.resize(mBufferCount);
+    for (uint32_t i = 0; i < mBufferCount; ++i)
+    {
+        TextureDesc texDesc;
+        texDesc.format = mFormat;
+        texDesc.width = mWidth;
+        texDesc.height = mHeight;
+        texDesc.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        texDesc.layout = mDefaultLayout;
+
+        std::unique_ptr<Texture> texture(new Texture());
+        if (!texture->Init(mDevice, texDesc))
+        {
+            LOGE("Failed to create offscreen image #" << i);
+            return false;
+        }
+
+        mImages[i].image = texture->GetImage();
+        mImages[i].layout = texture->GetImageLayout();
+        mOffscreenImages.push_back(std::move(texture));
+    }
+
+    LOGD(mBufferCount << " offscreen images created.");
+
+    mReadbackInterval = desc.readbackInterval;
+    mReadbackPrefix = desc.readbackPrefix;
+    if (mReadbackInterval > 0)
+    {
+        uint32_t pixelSize = TranslateVkFormatToFormatSize(mFormat);
+        if (pixelSize != 4)
+        {
+            LOGE("Frame read back supports only 32-bit formats, got " << TranslateVkFormatToString(mFormat));
+            return false;
+        }
+
+        BufferDesc readbackDesc;
+        readbackDesc.data = nullptr;
+        readbackDesc.dataSize = mWidth * mHeight * pixelSize;
+        readbackDesc.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        readbackDesc.type = BufferType::Dynamic;
+        if (!mReadbackBuffer.Init(mDevice, readbackDesc))
+            return false;
+    }
+
+    return true;
+}
+
+bool Backbuffer::WriteReadback()
+{
+    mReadbackPending = false;
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(mReadbackBuffer.GetSize()));
+    if (!mReadbackBuffer.Read(pixels.data(), pixels.size()))
+    {
+        LOGE("Failed to read back frame " << mReadbackFrame);
+        return false;
+    }
+
+    std::stringstream path;
+    path << mReadbackPrefix << "_" << std::setw(READBACK_FRAME_DIGITS) << std::setfill('0') << mReadbackFrame << ".ppm";
+
+    std::ofstream file(path.str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    if (!file)
+    {
+        LOGE("Unable to open " << path.str() << " for writing");
+        return false;
+    }
+
+    // binary PPM stores RGB triplets, without alpha
+    bool bgra = (mFormat == VK_FORMAT_B8G8R8A8_UNORM) || (mFormat == VK_FORMAT_B8G8R8A8_SRGB);
+    file << "P6\n" << mWidth << " " << mHeight << "\n255\n";
+
+    std::vector<uint8_t> row(mWidth * 3);
+    for (uint32_t y = 0; y < mHeight; ++y)
+    {
+        const uint8_t* src = &pixels[y * mWidth * 4];
+        for (uint32_t x = 0; x < mWidth; ++x)
+        {
+            row[x * 3 + 0] = bgra ? src[x * 4 + 2] : src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = bgra ? src[x * 4 + 0] : src[x * 4 + 2];
+        }
+        file.write(reinterpret_cast<const char*>(row.data()), row.size());
+    }
+
+    if (!file.good())
+    {
+        LOGE("Failed to write read back frame to " << path.str());
+        return false;
+    }
+
+    LOGD("Frame " << mReadbackFrame << " saved to " << path.str());
+    return true;
+}
+
 void Backbuffer::Transition(CommandBuffer* cmdBuffer, VkPipelineStageFlags fromStage, VkPipelineStageFlags toStage,
                             VkAccessFlags fromAccess, VkAccessFlags toAccess,
                             uint32_t fromQueueFamily, uint32_t toQueueFamily,
@@ -272,15 +393,30 @@ bool Backbuffer::Init(const DevicePtr& device, const BackbufferDesc& desc)
 
     mWidth = desc.width;
     mHeight = desc.height;
+    mHeadless = desc.headless;
 
-    if (!CreateSurface(desc)) return false;
-    if (!GetPresentQueue()) return false;
-    if (!SelectSurfaceFormat(desc)) return false;
-    if (!SelectPresentMode(desc)) return false;
-    if (!AcquireSurfaceCaps()) return false;
-    SelectBufferCount(desc);
-    if (!CreateSwapchain(desc)) return false;
-    if (!AllocateImageViews()) return false;
+    ZERO_MEMORY(mSubresourceRange);
+    mSubresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    mSubresourceRange.baseMipLevel = 0;
+    mSubresourceRange.levelCount = 1;
+    mSubresourceRange.baseArrayLayer = 0;
+    mSubresourceRange.layerCount = 1;
+
+    if (mHeadless)
+    {
+        if (!CreateOffscreenImages(desc)) return false;
+    }
+    else
+    {
+        if (!CreateSurface(desc)) return false;
+        if (!GetPresentQueue()) return false;
+        if (!SelectSurfaceFormat(desc)) return false;
+        if (!SelectPresentMode(desc)) return false;
+        if (!AcquireSurfaceCaps()) return false;
+        SelectBufferCount(desc);
+        if (!CreateSwapchain(desc)) return false;
+        if (!AllocateImageViews()) return false;
+    }
 
     if (!mCopyCommandBuffer.Init(mDevice, DeviceQueueType::TRANSFER))
         return false;
@@ -299,6 +435,20 @@ bool Backbuffer::Init(const DevicePtr& device, const BackbufferDesc& desc)
 
 bool Backbuffer::AcquireNextImage(VkSemaphore semaphore)
 {
+    if (mHeadless)
+    {
+        // images are reused in order - Present() waits until previous copy is done, so the next
+        // one is free already and the semaphore can be signalled right away
+        mCurrentBuffer = (mCurrentBuffer + 1) % mBufferCount;
+
+        VkSubmitInfo submitInfo;
+        ZERO_MEMORY(submitInfo);
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &semaphore;
+        return mDevice->Execute(DeviceQueueType::GRAPHICS, 1, &submitInfo, VK_NULL_HANDLE);
+    }
+
     VkResult result = vkAcquireNextImageKHR(mDevice->GetDevice(), mSwapchain, UINT64_MAX,
                                             semaphore, VK_NULL_HANDLE, &mCurrentBuffer);
     RETURN_FALSE_IF_FAILED(result, "Failed to preacquire next image for presenting");
@@ -318,6 +468,15 @@ bool Backbuffer::Present(Texture& texture, VkSemaphore waitSemaphore)
     if (result != VK_SUCCESS)
         LOGW("Failed to reset Backbuffer fence: " << result << " (" << TranslateVkResultToString(result) << ")");
 
+    // read back frame was copied together with previous copy, so it is available by now
+    if (mReadbackPending)
+        WriteReadback();
+
+    bool readback = (mReadbackInterval > 0) && (mPresentedFrames % mReadbackInterval == 0);
+    if (readback)
+        mReadbackFrame = mPresentedFrames;
+    mPresentedFrames++;
+
     // copy provided texture to backbuffer
     mCopyCommandBuffer.Begin();
 
@@ -337,14 +496,35 @@ bool Backbuffer::Present(Texture& texture, VkSemaphore waitSemaphore)
                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
     Transition(&mCopyCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                       0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                       VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT,
                        VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
-                       VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+                       mDefaultLayout);
+
+    if (readback)
+    {
+        mCopyCommandBuffer.CopyBackbufferToBuffer(this, &mReadbackBuffer);
+        mCopyCommandBuffer.BufferBarrier(&mReadbackBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                                         VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+                                         VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+    }
+
     if (!mCopyCommandBuffer.End())
         return false;
 
     VkPipelineStageFlags waitFlags[] = { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT };
     VkSemaphore waitSemaphores[] = { waitSemaphore };
+
+    // there is nothing to present, so nobody would wait for the copy semaphore
+    if (mHeadless)
+    {
+        if (!mDevice->Execute(DeviceQueueType::TRANSFER, &mCopyCommandBuffer, 1,
+                              waitFlags, waitSemaphores, VK_NULL_HANDLE, mCopyFence))
+            return false;
+
+        mReadbackPending = readback;
+        return true;
+    }
+
     mDevice->Execute(DeviceQueueType::TRANSFER, &mCopyCommandBuffer, 1,
                      waitFlags, waitSemaphores, mCopySemaphore, mCopyFence);
 
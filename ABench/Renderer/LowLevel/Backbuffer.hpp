@@ -4,6 +4,8 @@
 #include "Instance.hpp"
 #include "Device.hpp"
 #include "CommandBuffer.hpp"
+#include "Texture.hpp"
+#include "Buffer.hpp"
 #include "Tools.hpp"
 
 #ifdef WIN32
@@ -29,12 +31,19 @@ struct BackbufferDesc
     uint32_t width;
     uint32_t height;
 
+    bool headless; // render to offscreen images instead of a window, windowDesc is ignored
+    uint32_t readbackInterval; // headless only - every Nth presented frame is saved to disk, 0 disables
+    std::string readbackPrefix; // path prefix of saved frames
+
     BackbufferDesc()
         : requestedFormat(VK_FORMAT_UNDEFINED)
         , vsync(false)
         , bufferCount(2)
         , width(0)
         , height(0)
+        , headless(false)
+        , readbackInterval(0)
+        , readbackPrefix()
     {
     }
 };
@@ -51,6 +60,14 @@ struct BackbufferImageData
     }
 };
 
+/**
+ * Images presented at the end of each frame.
+ *
+ * Normally these come from a swapchain of a window surface. In headless mode the Backbuffer
+ * keeps a ring of plain Textures instead, so no surface or presentation support is needed and
+ * the renderer can run on any device, including software implementations. Headless Backbuffer
+ * can also read back every Nth frame and save it as a binary PPM for golden image comparisons.
+ */
 class Backbuffer
 {
     friend class CommandBuffer;
@@ -79,6 +96,15 @@ class Backbuffer
     VkRAII<VkSemaphore> mCopySemaphore;
     VkRAII<VkFence> mCopyFence;
 
+    bool mHeadless;
+    std::vector<std::unique_ptr<Texture>> mOffscreenImages;
+    Buffer mReadbackBuffer;
+    uint32_t mReadbackInterval;
+    std::string mReadbackPrefix;
+    uint64_t mPresentedFrames;
+    uint64_t mReadbackFrame;
+    bool mReadbackPending;
+
     bool CreateSurface(const BackbufferDesc& desc);
     bool GetPresentQueue();
     bool SelectSurfaceFormat(const BackbufferDesc& desc);
@@ -87,6 +113,8 @@ class Backbuffer
     void SelectBufferCount(const BackbufferDesc& desc);
     bool CreateSwapchain(const BackbufferDesc& desc);
     bool AllocateImageViews();
+    bool CreateOffscreenImages(const BackbufferDesc& desc);
+    bool WriteReadback();
 
     void Transition(CommandBuffer* cmdBuffer, VkPipelineStageFlags fromStage, VkPipelineStageFlags toStage,
                     VkAccessFlags fromAccess, VkAccessFlags toAccess,
@@ -105,6 +133,11 @@ public:
     // Present current image on screen. This should be usually called at the end of current frame.
     bool Present(Texture& texture, VkSemaphore waitSemaphore);
 
+    ABENCH_INLINE bool IsHeadless() const
+    {
+        return mHeadless;
+    }
+
     ABENCH_INLINE uint32_t GetWidth() const
     {
         return mWidth;
@@ -55,6 +55,7 @@ bool Buffer::Init(const DevicePtr& device, const BufferDesc& desc)
     }
     VkResult result = vkCreateBuffer(mDevice->GetDevice(), &bufInfo, nullptr, &mBuffer);
     RETURN_FALSE_IF_FAILED(result, "Failed to create device buffer");
+    mDevice->GetStatistics().OnCreate(TrackedObject::Buffer);
 
     VkMemoryRequirements deviceMemReqs;
     vkGetBufferMemoryRequirements(mDevice->GetDevice(), mBuffer, &deviceMemReqs);
@@ -68,7 +69,7 @@ bool Buffer::Init(const DevicePtr& device, const BufferDesc& desc)
     memInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     memInfo.allocationSize = deviceMemReqs.size;
     memInfo.memoryTypeIndex = mDevice->GetMemoryTypeIndex(deviceMemReqs.memoryTypeBits, memFlags);
-    result = vkAllocateMemory(mDevice->GetDevice(), &memInfo, nullptr, &mBufferMemory);
+    result = mDevice->AllocateMemory(memInfo, mBufferMemory);
     RETURN_FALSE_IF_FAILED(result, "Failed to allocate device memory");
 
     result = vkBindBufferMemory(mDevice->GetDevice(), mBuffer, mBufferMemory, 0);
@@ -80,6 +81,7 @@ bool Buffer::Init(const DevicePtr& device, const BufferDesc& desc)
         bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
         result = vkCreateBuffer(mDevice->GetDevice(), &bufInfo, nullptr, &staging);
         RETURN_FALSE_IF_FAILED(result, "Failed to create staging buffer");
+        mDevice->GetStatistics().OnCreate(TrackedObject::Buffer);
 
         // get staging buffer's memory requirements
         VkMemoryRequirements stagingMemReqs;
@@ -89,7 +91,7 @@ bool Buffer::Init(const DevicePtr& device, const BufferDesc& desc)
         memInfo.allocationSize = stagingMemReqs.size;
         memInfo.memoryTypeIndex = mDevice->GetMemoryTypeIndex(stagingMemReqs.memoryTypeBits,
                                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        result = vkAllocateMemory(mDevice->GetDevice(), &memInfo, nullptr, &stagingMemory);
+        result = mDevice->AllocateMemory(memInfo, stagingMemory);
         RETURN_FALSE_IF_FAILED(result, "Failed to allocate memory for staging buffer");
 
         // map the memory and copy data to it
@@ -117,8 +119,9 @@ bool Buffer::Init(const DevicePtr& device, const BufferDesc& desc)
         mDevice->Wait(DeviceQueueType::GRAPHICS); // TODO this should be removed
 
         // cleanup
-        vkFreeMemory(mDevice->GetDevice(), stagingMemory, nullptr);
+        mDevice->FreeMemory(stagingMemory);
         vkDestroyBuffer(mDevice->GetDevice(), staging, nullptr);
+        mDevice->GetStatistics().OnDestroy(TrackedObject::Buffer);
     }
 
     mType = desc.type;
@@ -176,9 +179,12 @@ bool Buffer::Read(void* data, size_t size, size_t offset)
 void Buffer::Free()
 {
     if (mBufferMemory != VK_NULL_HANDLE)
-        vkFreeMemory(mDevice->GetDevice(), mBufferMemory, nullptr);
+        mDevice->FreeMemory(mBufferMemory);
     if (mBuffer != VK_NULL_HANDLE)
+    {
         vkDestroyBuffer(mDevice->GetDevice(), mBuffer, nullptr);
+        mDevice->GetStatistics().OnDestroy(TrackedObject::Buffer);
+    }
 
     mBufferMemory = VK_NULL_HANDLE;
     mBuffer = VK_NULL_HANDLE;
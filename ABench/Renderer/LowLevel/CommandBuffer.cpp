@@ -15,6 +15,11 @@ CommandBuffer::CommandBuffer()
     : mOwningPool(VK_NULL_HANDLE)
     , mCommandBuffer(VK_NULL_HANDLE)
     , mCurrentFramebuffer(nullptr)
+    , mBindPoints()
+    , mVertexBuffers()
+    , mPendingVertexBuffers(0)
+    , mIndexBuffer(VK_NULL_HANDLE)
+    , mStats()
 {
 }
 
@@ -25,14 +30,19 @@ CommandBuffer::~CommandBuffer()
 }
 
 bool CommandBuffer::Init(const DevicePtr& device, DeviceQueueType queueType)
+{
+    return Init(device, device->GetCommandPool(queueType), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+}
+
+bool CommandBuffer::Init(const DevicePtr& device, VkCommandPool pool, VkCommandBufferLevel level)
 {
     mDevice = device;
-    mOwningPool = mDevice->GetCommandPool(queueType);
+    mOwningPool = pool;
 
     VkCommandBufferAllocateInfo allocInfo;
     ZERO_MEMORY(allocInfo);
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.level = level;
     allocInfo.commandBufferCount = 1;
     allocInfo.commandPool = mOwningPool;
     VkResult result = vkAllocateCommandBuffers(mDevice->GetDevice(), &allocInfo, &mCommandBuffer);
@@ -41,6 +51,122 @@ bool CommandBuffer::Init(const DevicePtr& device, DeviceQueueType queueType)
     return true;
 }
 
+void CommandBuffer::ResetBoundState()
+{
+    // binds which never reached a draw are dropped
+    for (auto& state: mBindPoints)
+        for (uint32_t slot = 0; slot < COMMAND_BUFFER_MAX_TRACKED_SETS; ++slot)
+            if (state.pendingSets & (1 << slot))
+                mStats.descriptorSetBindsElided++;
+
+    for (uint32_t binding = 0; binding < COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS; ++binding)
+        if (mPendingVertexBuffers & (1 << binding))
+            mStats.vertexBufferBindsElided++;
+
+    memset(mBindPoints, 0, sizeof(mBindPoints));
+    memset(mVertexBuffers, 0, sizeof(mVertexBuffers));
+    mPendingVertexBuffers = 0;
+    mIndexBuffer = VK_NULL_HANDLE;
+}
+
+void CommandBuffer::BindDescriptorSetInternal(VkDescriptorSet set, VkPipelineBindPoint point, uint32_t setSlot, VkPipelineLayout layout,
+                                              uint32_t dynamicOffset, bool hasDynamicOffset)
+{
+    ASSERT(set != VK_NULL_HANDLE, "Provided descriptor set is not initialized");
+    ASSERT(layout != VK_NULL_HANDLE, "Provided pipeline layout is not initialized");
+    ASSERT(point <= VK_PIPELINE_BIND_POINT_COMPUTE, "Unsupported pipeline bind point");
+
+    BindPointState& state = mBindPoints[point];
+
+    // binding with another layout can disturb sets in other slots, so none of them can be trusted
+    if (state.layout != layout)
+    {
+        FlushDescriptorSets(point);
+        memset(state.sets, 0, sizeof(state.sets));
+        state.layout = layout;
+    }
+
+    if (setSlot >= COMMAND_BUFFER_MAX_TRACKED_SETS)
+    {
+        FlushDescriptorSets(point);
+        vkCmdBindDescriptorSets(mCommandBuffer, point, layout, setSlot, 1, &set,
+                                hasDynamicOffset ? 1 : 0, hasDynamicOffset ? &dynamicOffset : nullptr);
+        mStats.descriptorSetBinds++;
+        return;
+    }
+
+    BoundDescriptorSet& bound = state.sets[setSlot];
+    bool unchanged = (bound.set == set && bound.hasDynamicOffset == hasDynamicOffset && bound.dynamicOffset == dynamicOffset);
+
+    // either nothing changes or previous bind of the slot is replaced before it was used
+    if (unchanged || (state.pendingSets & (1 << setSlot)))
+        mStats.descriptorSetBindsElided++;
+    if (unchanged)
+        return;
+
+    bound.set = set;
+    bound.dynamicOffset = dynamicOffset;
+    bound.hasDynamicOffset = hasDynamicOffset;
+    state.pendingSets |= 1 << setSlot;
+}
+
+void CommandBuffer::FlushDescriptorSets(VkPipelineBindPoint point)
+{
+    BindPointState& state = mBindPoints[point];
+
+    // every run of adjacent pending slots goes to a single call, dynamic offsets in slot order
+    uint32_t slot = 0;
+    while (state.pendingSets != 0)
+    {
+        while (!(state.pendingSets & (1 << slot)))
+            slot++;
+
+        VkDescriptorSet sets[COMMAND_BUFFER_MAX_TRACKED_SETS];
+        uint32_t dynamicOffsets[COMMAND_BUFFER_MAX_TRACKED_SETS];
+        uint32_t setCount = 0;
+        uint32_t dynamicOffsetCount = 0;
+        uint32_t firstSlot = slot;
+        for (; slot < COMMAND_BUFFER_MAX_TRACKED_SETS && (state.pendingSets & (1 << slot)); ++slot)
+        {
+            sets[setCount++] = state.sets[slot].set;
+            if (state.sets[slot].hasDynamicOffset)
+                dynamicOffsets[dynamicOffsetCount++] = state.sets[slot].dynamicOffset;
+            state.pendingSets &= ~(1 << slot);
+        }
+
+        vkCmdBindDescriptorSets(mCommandBuffer, point, state.layout, firstSlot, setCount, sets,
+                                dynamicOffsetCount, dynamicOffsets);
+        mStats.descriptorSetBinds++;
+        mStats.descriptorSetBindsElided += setCount - 1;
+    }
+}
+
+void CommandBuffer::FlushVertexBuffers()
+{
+    uint32_t binding = 0;
+    while (mPendingVertexBuffers != 0)
+    {
+        while (!(mPendingVertexBuffers & (1 << binding)))
+            binding++;
+
+        VkBuffer buffers[COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS];
+        VkDeviceSize offsets[COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS];
+        uint32_t count = 0;
+        uint32_t firstBinding = binding;
+        for (; binding < COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS && (mPendingVertexBuffers & (1 << binding)); ++binding)
+        {
+            buffers[count] = mVertexBuffers[binding].buffer;
+            offsets[count] = mVertexBuffers[binding].offset;
+            count++;
+            mPendingVertexBuffers &= ~(1 << binding);
+        }
+
+        vkCmdBindVertexBuffers(mCommandBuffer, firstBinding, count, buffers, offsets);
+        mStats.vertexBufferBinds++;
+        mStats.vertexBufferBindsElided += count - 1;
+    }
+}
+
 void CommandBuffer::Barrier(VkPipelineStageFlags fromStage, VkPipelineStageFlags toStage,
                             VkAccessFlags accessFrom, VkAccessFlags accessTo)
 {
@@ -97,9 +223,38 @@ void CommandBuffer::Begin()
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(mCommandBuffer, &beginInfo);
+
+    ResetBoundState();
+    mStats = CommandBufferStats();
+}
+
+void CommandBuffer::Begin(VkRenderPass rp, Framebuffer* fb)
+{
+    ASSERT(rp != VK_NULL_HANDLE, "Provided render pass is not initialized");
+    ASSERT(fb != nullptr, "Provided framebuffer is null");
+
+    VkCommandBufferInheritanceInfo inheritanceInfo;
+    ZERO_MEMORY(inheritanceInfo);
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = rp;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = fb->mFramebuffer;
+
+    VkCommandBufferBeginInfo beginInfo;
+    ZERO_MEMORY(beginInfo);
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+    vkBeginCommandBuffer(mCommandBuffer, &beginInfo);
+
+    // secondary Command Buffers do not inherit any bound state
+    ResetBoundState();
+    mStats = CommandBufferStats();
+    mCurrentFramebuffer = fb;
 }
 
-void CommandBuffer::BeginRenderPass(VkRenderPass rp, Framebuffer* fb, ClearType types, float clearValues[4], float depthValue)
+void CommandBuffer::BeginRenderPass(VkRenderPass rp, Framebuffer* fb, ClearType types, float clearValues[4], float depthValue,
+                                    VkSubpassContents contents)
 {
     VkClearValue clear[2];
     uint32_t clearCount = 0;
@@ -126,7 +281,7 @@ void CommandBuffer::BeginRenderPass(VkRenderPass rp, Framebuffer* fb, ClearType
     rpInfo.clearValueCount = clearCount;
     rpInfo.pClearValues = clear;
     rpInfo.framebuffer = fb->mFramebuffer;
-    vkCmdBeginRenderPass(mCommandBuffer, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(mCommandBuffer, &rpInfo, contents);
 
     mCurrentFramebuffer = fb;
 }
@@ -136,7 +291,26 @@ void CommandBuffer::BindVertexBuffer(const Buffer* buffer, uint32_t binding, VkD
     ASSERT(buffer != nullptr, "Provided buffer is null");
     ASSERT(buffer->mBuffer != VK_NULL_HANDLE, "Provided buffer is not initialized");
 
-    vkCmdBindVertexBuffers(mCommandBuffer, binding, 1, &buffer->mBuffer, &offset);
+    if (binding >= COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS)
+    {
+        FlushVertexBuffers();
+        vkCmdBindVertexBuffers(mCommandBuffer, binding, 1, &buffer->mBuffer, &offset);
+        mStats.vertexBufferBinds++;
+        return;
+    }
+
+    BoundVertexBuffer& bound = mVertexBuffers[binding];
+    bool unchanged = (bound.buffer == buffer->mBuffer && bound.offset == offset);
+
+    // either nothing changes or previous bind of the binding is replaced before it was used
+    if (unchanged || (mPendingVertexBuffers & (1 << binding)))
+        mStats.vertexBufferBindsElided++;
+    if (unchanged)
+        return;
+
+    bound.buffer = buffer->mBuffer;
+    bound.offset = offset;
+    mPendingVertexBuffers |= 1 << binding;
 }
 
 void CommandBuffer::BindIndexBuffer(const Buffer* buffer)
@@ -144,30 +318,41 @@ void CommandBuffer::BindIndexBuffer(const Buffer* buffer)
     ASSERT(buffer != nullptr, "Provided buffer is null");
     ASSERT(buffer->mBuffer != VK_NULL_HANDLE, "Provided buffer is not initialized");
 
+    if (mIndexBuffer == buffer->mBuffer)
+    {
+        mStats.indexBufferBindsElided++;
+        return;
+    }
+
     vkCmdBindIndexBuffer(mCommandBuffer, buffer->mBuffer, 0, VK_INDEX_TYPE_UINT32);
+    mIndexBuffer = buffer->mBuffer;
+    mStats.indexBufferBinds++;
 }
 
 void CommandBuffer::BindPipeline(VkPipeline pipeline, VkPipelineBindPoint point)
 {
     ASSERT(pipeline != VK_NULL_HANDLE, "Provided pipeline is not initialized");
+    ASSERT(point <= VK_PIPELINE_BIND_POINT_COMPUTE, "Unsupported pipeline bind point");
+
+    if (mBindPoints[point].pipeline == pipeline)
+    {
+        mStats.pipelineBindsElided++;
+        return;
+    }
 
     vkCmdBindPipeline(mCommandBuffer, point, pipeline);
+    mBindPoints[point].pipeline = pipeline;
+    mStats.pipelineBinds++;
 }
 
 void CommandBuffer::BindDescriptorSet(VkDescriptorSet set, VkPipelineBindPoint point, uint32_t setSlot, VkPipelineLayout layout)
 {
-    ASSERT(set != VK_NULL_HANDLE, "Provided descriptor set is not initialized");
-    ASSERT(layout != VK_NULL_HANDLE, "Provided pipeline layout is not initialized");
-
-    vkCmdBindDescriptorSets(mCommandBuffer, point, layout, setSlot, 1, &set, 0, nullptr);
+    BindDescriptorSetInternal(set, point, setSlot, layout, 0, false);
 }
 
 void CommandBuffer::BindDescriptorSet(VkDescriptorSet set, VkPipelineBindPoint point, uint32_t setSlot, VkPipelineLayout layout, uint32_t dynamicOffset)
 {
-    ASSERT(set != VK_NULL_HANDLE, "Provided descriptor set is not initialized");
-    ASSERT(layout != VK_NULL_HANDLE, "Provided pipeline layout is not initialized");
-
-    vkCmdBindDescriptorSets(mCommandBuffer, point, layout, setSlot, 1, &set, 1, &dynamicOffset);
+    BindDescriptorSetInternal(set, point, setSlot, layout, dynamicOffset, true);
 }
 
 void CommandBuffer::Clear(ClearType types, float clearValues[4], float depthValue)
@@ -299,21 +484,58 @@ void CommandBuffer::CopyTextureToBackbuffer(Texture* src, Backbuffer* dst)
                    dst->mImages[dst->mCurrentBuffer].image, dst->mImages[dst->mCurrentBuffer].layout, 1, &region);
 }
 
+void CommandBuffer::CopyBackbufferToBuffer(Backbuffer* src, Buffer* dst)
+{
+    ASSERT(!src->mImages.empty(), "Provided Backbuffer is not initialized");
+    ASSERT(dst->mBuffer != VK_NULL_HANDLE, "Provided destination buffer is not initialized");
+
+    VkBufferImageCopy region;
+    ZERO_MEMORY(region);
+    region.imageExtent.width = src->mWidth;
+    region.imageExtent.height = src->mHeight;
+    region.imageExtent.depth = 1;
+    region.imageSubresource.aspectMask = src->mSubresourceRange.aspectMask;
+    region.imageSubresource.baseArrayLayer = src->mSubresourceRange.baseArrayLayer;
+    region.imageSubresource.layerCount = src->mSubresourceRange.layerCount;
+    region.imageSubresource.mipLevel = 0;
+    vkCmdCopyImageToBuffer(mCommandBuffer, src->mImages[src->mCurrentBuffer].image, src->mImages[src->mCurrentBuffer].layout,
+                           dst->mBuffer, 1, &region);
+}
+
 void CommandBuffer::Dispatch(uint32_t x, uint32_t y, uint32_t z)
 {
+    FlushDescriptorSets(VK_PIPELINE_BIND_POINT_COMPUTE);
     vkCmdDispatch(mCommandBuffer, x, y, z);
 }
 
 void CommandBuffer::Draw(uint32_t vertCount, uint32_t instanceCount)
 {
+    FlushDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS);
+    FlushVertexBuffers();
     vkCmdDraw(mCommandBuffer, vertCount, instanceCount, 0, 0);
 }
 
 void CommandBuffer::DrawIndexed(uint32_t indexCount)
 {
+    FlushDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS);
+    FlushVertexBuffers();
     vkCmdDrawIndexed(mCommandBuffer, indexCount, 1, 0, 0, 0);
 }
 
+void CommandBuffer::DrawIndirect(const Buffer* buffer, VkDeviceSize offset)
+{
+    FlushDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS);
+    FlushVertexBuffers();
+    vkCmdDrawIndirect(mCommandBuffer, buffer->mBuffer, offset, 1, sizeof(VkDrawIndirectCommand));
+}
+
+void CommandBuffer::DrawIndexedIndirect(const Buffer* buffer, VkDeviceSize offset)
+{
+    FlushDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS);
+    FlushVertexBuffers();
+    vkCmdDrawIndexedIndirect(mCommandBuffer, buffer->mBuffer, offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+}
+
 void CommandBuffer::EndRenderPass()
 {
     vkCmdEndRenderPass(mCommandBuffer);
@@ -322,11 +544,40 @@ void CommandBuffer::EndRenderPass()
 
 bool CommandBuffer::End()
 {
+    ResetBoundState();
+
     VkResult result = vkEndCommandBuffer(mCommandBuffer);
     RETURN_FALSE_IF_FAILED(result, "Failure during Command Buffer recording");
     return true;
 }
 
+void CommandBuffer::ExecuteCommands(const std::vector<CommandBuffer*>& commandBuffers)
+{
+    std::vector<VkCommandBuffer> buffers;
+    buffers.reserve(commandBuffers.size());
+    for (auto& cb: commandBuffers)
+    {
+        ASSERT(cb->mCommandBuffer != VK_NULL_HANDLE, "Provided secondary Command Buffer is not initialized");
+        buffers.push_back(cb->mCommandBuffer);
+    }
+
+    if (!buffers.empty())
+        vkCmdExecuteCommands(mCommandBuffer, static_cast<uint32_t>(buffers.size()), buffers.data());
+
+    // state left by secondary Command Buffers is undefined
+    ResetBoundState();
+}
+
+void CommandBuffer::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data)
+{
+    vkCmdPushConstants(mCommandBuffer, layout, stages, offset, size, data);
+}
+
+void CommandBuffer::ResetQueryPool(VkQueryPool pool, uint32_t firstQuery, uint32_t queryCount)
+{
+    vkCmdResetQueryPool(mCommandBuffer, pool, firstQuery, queryCount);
+}
+
 void CommandBuffer::SetViewport(int32_t x, int32_t y, uint32_t width, uint32_t height, float minDepth, float maxDepth)
 {
     VkViewport viewport;
@@ -349,5 +600,10 @@ void CommandBuffer::SetScissor(int32_t x, int32_t y, uint32_t width, uint32_t he
     vkCmdSetScissor(mCommandBuffer, 0, 1, &scissor);
 }
 
+void CommandBuffer::WriteTimestamp(VkPipelineStageFlagBits stage, VkQueryPool pool, uint32_t query)
+{
+    vkCmdWriteTimestamp(mCommandBuffer, stage, pool, query);
+}
+
 } // namespace Renderer
 } // namespace ABench
@@ -12,22 +12,119 @@
 namespace ABench {
 namespace Renderer {
 
+// descriptor sets and vertex buffers above these limits are bound right away, without shadowing
+const uint32_t COMMAND_BUFFER_MAX_TRACKED_SETS = 8;
+const uint32_t COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS = 8;
+
+/**
+ * Bind calls of a Command Buffer since last Begin().
+ *
+ * Issued counters are vkCmd* calls actually recorded. Elided ones are requested binds which did
+ * not need a call of their own - redundant, overwritten before use or merged into a call with
+ * adjacent slots. Every requested bind is counted exactly once in one of them.
+ */
+struct CommandBufferStats
+{
+    uint32_t pipelineBinds;
+    uint32_t pipelineBindsElided;
+    uint32_t descriptorSetBinds;
+    uint32_t descriptorSetBindsElided;
+    uint32_t vertexBufferBinds;
+    uint32_t vertexBufferBindsElided;
+    uint32_t indexBufferBinds;
+    uint32_t indexBufferBindsElided;
+
+    CommandBufferStats()
+        : pipelineBinds(0)
+        , pipelineBindsElided(0)
+        , descriptorSetBinds(0)
+        , descriptorSetBindsElided(0)
+        , vertexBufferBinds(0)
+        , vertexBufferBindsElided(0)
+        , indexBufferBinds(0)
+        , indexBufferBindsElided(0)
+    {
+    }
+
+    ABENCH_INLINE uint32_t GetElided() const
+    {
+        return pipelineBindsElided + descriptorSetBindsElided + vertexBufferBindsElided + indexBufferBindsElided;
+    }
+
+    ABENCH_INLINE CommandBufferStats& operator+=(const CommandBufferStats& other)
+    {
+        pipelineBinds += other.pipelineBinds;
+        pipelineBindsElided += other.pipelineBindsElided;
+        descriptorSetBinds += other.descriptorSetBinds;
+        descriptorSetBindsElided += other.descriptorSetBindsElided;
+        vertexBufferBinds += other.vertexBufferBinds;
+        vertexBufferBindsElided += other.vertexBufferBindsElided;
+        indexBufferBinds += other.indexBufferBinds;
+        indexBufferBindsElided += other.indexBufferBindsElided;
+        return *this;
+    }
+};
+
+/**
+ * Wrapper over a Vulkan Command Buffer.
+ *
+ * Bound state is shadowed per bind point, so binding the same pipeline, descriptor set or buffer
+ * again is not recorded. Descriptor set and vertex buffer binds are deferred until the next draw
+ * or dispatch, when binds of adjacent slots are merged into a single call - sets with dynamic
+ * offsets included. Shadowed state is reset by Begin() and after executing secondary Command Buffers.
+ */
 class CommandBuffer
 {
     friend class Device;
     friend class Texture;
     friend class Backbuffer;
+    friend class FrameGraph;
 
     DevicePtr mDevice;
     VkCommandPool mOwningPool;
     VkCommandBuffer mCommandBuffer;
     Framebuffer* mCurrentFramebuffer;
 
+    struct BoundDescriptorSet
+    {
+        VkDescriptorSet set;
+        uint32_t dynamicOffset;
+        bool hasDynamicOffset;
+    };
+
+    struct BindPointState
+    {
+        VkPipeline pipeline;
+        VkPipelineLayout layout; // layout bound sets are compatible with
+        BoundDescriptorSet sets[COMMAND_BUFFER_MAX_TRACKED_SETS];
+        uint32_t pendingSets; // mask of slots bound since last flush
+    };
+
+    struct BoundVertexBuffer
+    {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+    };
+
+    BindPointState mBindPoints[2]; // graphics and compute
+    BoundVertexBuffer mVertexBuffers[COMMAND_BUFFER_MAX_TRACKED_VERTEX_BUFFERS];
+    uint32_t mPendingVertexBuffers; // mask of bindings bound since last flush
+    VkBuffer mIndexBuffer;
+    CommandBufferStats mStats;
+
+    void ResetBoundState();
+    void BindDescriptorSetInternal(VkDescriptorSet set, VkPipelineBindPoint point, uint32_t setSlot, VkPipelineLayout layout,
+                                   uint32_t dynamicOffset, bool hasDynamicOffset);
+    void FlushDescriptorSets(VkPipelineBindPoint point);
+    void FlushVertexBuffers();
+
 public:
     CommandBuffer();
     ~CommandBuffer();
 
     bool Init(const DevicePtr& device, DeviceQueueType queueType);
+    // allocates Command Buffer from a user-provided pool (ex. per-thread pools for secondary buffers)
+    bool Init(const DevicePtr& device, VkCommandPool pool, VkCommandBufferLevel level);
 
     void Barrier(VkPipelineStageFlags fromStage, VkPipelineStageFlags toStage,
                  VkAccessFlags accessFrom, VkAccessFlags accessTo);
@@ -39,7 +136,10 @@ public:
                       VkImageLayout fromLayout, VkImageLayout toLayout,
                       uint32_t fromQueueFamily, uint32_t toQueueFamily);
     void Begin();
-    void BeginRenderPass(VkRenderPass rp, Framebuffer* fb, ClearType types, float clearValues[4], float depthValue = 0.0f);
+    // begins a secondary Command Buffer, which will be executed inside render pass rp
+    void Begin(VkRenderPass rp, Framebuffer* fb);
+    void BeginRenderPass(VkRenderPass rp, Framebuffer* fb, ClearType types, float clearValues[4], float depthValue = 0.0f,
+                         VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
     void BindVertexBuffer(const Buffer* buffer, uint32_t binding, VkDeviceSize offset);
     void BindIndexBuffer(const Buffer* buffer);
     void BindPipeline(VkPipeline pipeline, VkPipelineBindPoint point);
@@ -50,13 +150,26 @@ public:
     void CopyBufferToTexture(Buffer* src, Texture* dst);
     void CopyTexture(Texture* src, Texture* dst);
     void CopyTextureToBackbuffer(Texture* src, Backbuffer* dst);
+    void CopyBackbufferToBuffer(Backbuffer* src, Buffer* dst);
     void Dispatch(uint32_t x, uint32_t y, uint32_t z);
     void Draw(uint32_t vertCount, uint32_t instanceCount);
     void DrawIndexed(uint32_t vertCount);
+    // single draw with parameters read from buffer at given offset
+    void DrawIndirect(const Buffer* buffer, VkDeviceSize offset);
+    void DrawIndexedIndirect(const Buffer* buffer, VkDeviceSize offset);
     void EndRenderPass();
     bool End();
+    void ExecuteCommands(const std::vector<CommandBuffer*>& commandBuffers);
+    void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+    void ResetQueryPool(VkQueryPool pool, uint32_t firstQuery, uint32_t queryCount);
     void SetViewport(int32_t x, int32_t y, uint32_t width, uint32_t height, float minDepth, float maxDepth);
     void SetScissor(int32_t x, int32_t y, uint32_t width, uint32_t height);
+    void WriteTimestamp(VkPipelineStageFlagBits stage, VkQueryPool pool, uint32_t query);
+
+    ABENCH_INLINE const CommandBufferStats& GetStats() const
+    {
+        return mStats;
+    }
 };
 
 } // namespace Renderer
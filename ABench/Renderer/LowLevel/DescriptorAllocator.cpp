@@ -4,6 +4,7 @@
 #include "Util.hpp"
 #include "Extensions.hpp"
 #include "Device.hpp"
+#include "Translations.hpp"
 
 #include "Common/Common.hpp"
 #include "Common/Logger.hpp"
@@ -12,12 +13,25 @@
 namespace ABench {
 namespace Renderer {
 
+namespace {
+
+// Each new pool in a chain is bigger than the previous one, up to this multiplier
+const uint32_t MAX_POOL_GROWTH_SHIFT = 3;
+
+} // namespace
+
 DescriptorAllocator::DescriptorAllocator()
-    : mMaxSets(0)
+    : mDevice()
     , mLimits()
-    , mPoolSizes()
-    , mDescriptorPools()
+    , mThreadPools()
+    , mLayouts()
+    , mFreeSets()
+    , mPoolCount(0)
+    , mAllocatedSets(0)
+    , mRecycledSets(0)
 {
+    for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+        mDescriptors[i] = 0;
 }
 
 DescriptorAllocator::~DescriptorAllocator()
@@ -25,30 +39,197 @@ DescriptorAllocator::~DescriptorAllocator()
     Release();
 }
 
-bool DescriptorAllocator::AllocateNewPool()
+bool DescriptorAllocator::AllocateNewPool(DescriptorPoolChain& chain, const LayoutInfo* layoutInfo)
 {
-    mDescriptorPools.emplace_back();
+    uint32_t growth = 1 << std::min(static_cast<uint32_t>(chain.pools.size()), MAX_POOL_GROWTH_SHIFT);
+
+    DescriptorPool pool;
+    pool.maxSets = mLimits.maxSets * growth;
+
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+    {
+        pool.limits[i] = mLimits.limits[i] * growth;
+
+        // make sure the set we are allocating for fits even in a freshly created pool
+        if (layoutInfo && pool.limits[i] < layoutInfo->counts[i])
+            pool.limits[i] = layoutInfo->counts[i];
+
+        // zero-sized entries are not allowed by Vulkan
+        if (pool.limits[i] == 0)
+            continue;
+
+        VkDescriptorPoolSize size;
+        size.type = static_cast<VkDescriptorType>(i);
+        size.descriptorCount = pool.limits[i];
+        sizes.push_back(size);
+    }
+
+    if (sizes.empty())
+    {
+        LOGE("Cannot create Descriptor Pool - all descriptor limits are zero");
+        return false;
+    }
 
     VkDescriptorPoolCreateInfo info;
     ZERO_MEMORY(info);
     info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    info.poolSizeCount = static_cast<uint32_t>(mPoolSizes.size());
-    info.pPoolSizes = mPoolSizes.data();
-    info.maxSets = mMaxSets;
-    VkResult result = vkCreateDescriptorPool(mDevice->GetDevice(), &info, nullptr, &mDescriptorPools.back().pool);
-    RETURN_NULL_HANDLE_IF_FAILED(result, "Failed to create Descriptor Pool");
+    info.poolSizeCount = static_cast<uint32_t>(sizes.size());
+    info.pPoolSizes = sizes.data();
+    info.maxSets = pool.maxSets;
+    VkResult result = vkCreateDescriptorPool(mDevice->GetDevice(), &info, nullptr, &pool.pool);
+    RETURN_FALSE_IF_FAILED(result, "Failed to create Descriptor Pool");
+    mDevice->GetStatistics().OnCreate(TrackedObject::DescriptorPool);
 
-    LOGD("Created Descriptor Pool 0x" << std::hex << reinterpret_cast<size_t*>(mDescriptorPools.back().pool));
+    LOGD("Created Descriptor Pool 0x" << std::hex << reinterpret_cast<size_t*>(pool.pool) << std::dec
+         << " for " << pool.maxSets << " sets");
 
-    for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+    chain.pools.push_back(pool);
+    return true;
+}
+
+VkDescriptorSet DescriptorAllocator::AllocateFromChain(DescriptorPoolChain& chain, VkDescriptorSetLayout layout)
+{
+    LayoutInfo layoutInfo;
+    bool known = GetLayoutInfo(layout, layoutInfo);
+
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    VkDescriptorSetAllocateInfo info;
+    ZERO_MEMORY(info);
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &layout;
+
+    // Vulkan headers we use do not report VK_ERROR_OUT_OF_POOL_MEMORY, so pool capacity is
+    // tracked here and a pool is tried only when the set should fit in it
+    bool newPool = false;
+    for (size_t p = chain.current; p <= chain.pools.size(); ++p)
     {
-        mDescriptorPools.back().limits[i] = mLimits.limits[i];
-        mDescriptorPools.back().taken[i] = 0;
+        if (p == chain.pools.size())
+        {
+            if (newPool)
+                break; // even a fresh pool could not fit the set
+
+            if (!AllocateNewPool(chain, known ? &layoutInfo : nullptr))
+                return VK_NULL_HANDLE;
+
+            newPool = true;
+            mPoolCount++;
+        }
+
+        DescriptorPool& pool = chain.pools[p];
+
+        if (pool.takenSets >= pool.maxSets)
+        {
+            if (p == chain.current)
+                chain.current++;
+            continue;
+        }
+
+        bool fits = true;
+        if (known)
+        {
+            for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+            {
+                if (pool.taken[i] + layoutInfo.counts[i] > pool.limits[i])
+                {
+                    fits = false;
+                    break;
+                }
+            }
+        }
+
+        if (!fits)
+            continue;
+
+        info.descriptorPool = pool.pool;
+        VkResult result = vkAllocateDescriptorSets(mDevice->GetDevice(), &info, &set);
+        if (result != VK_SUCCESS)
+        {
+            // unknown layout or fragmented pool - try the next one
+            LOGD("Descriptor Set allocation failed in pool #" << p << " ("
+                 << TranslateVkResultToString(result) << "), trying next one");
+            set = VK_NULL_HANDLE;
+            continue;
+        }
+
+        pool.takenSets++;
+        mDevice->GetStatistics().OnCreate(TrackedObject::DescriptorSet);
+        if (known)
+        {
+            for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+            {
+                pool.taken[i] += layoutInfo.counts[i];
+                mDescriptors[i] += layoutInfo.counts[i];
+            }
+        }
+
+        mAllocatedSets++;
+        return set;
     }
 
+    LOGE("Failed to allocate Descriptor Set");
+    return VK_NULL_HANDLE;
+}
+
+DescriptorPoolChain* DescriptorAllocator::GetThreadPools()
+{
+    std::lock_guard<std::mutex> lock(mThreadPoolsMutex);
+
+    std::unique_ptr<DescriptorPoolChain>& pools = mThreadPools[std::this_thread::get_id()];
+    if (!pools)
+        pools.reset(new DescriptorPoolChain());
+
+    return pools.get();
+}
+
+bool DescriptorAllocator::GetLayoutInfo(VkDescriptorSetLayout layout, LayoutInfo& info)
+{
+    std::lock_guard<std::mutex> lock(mLayoutsMutex);
+
+    auto it = mLayouts.find(layout);
+    if (it == mLayouts.end())
+        return false;
+
+    info = it->second;
     return true;
 }
 
+void DescriptorAllocator::CheckDeviceLimits(const uint32_t counts[VK_DESCRIPTOR_TYPE_RANGE_SIZE], const std::string& what) const
+{
+    const VkPhysicalDeviceLimits& limits = mDevice->GetProperties().limits;
+
+    uint32_t samplers = counts[VK_DESCRIPTOR_TYPE_SAMPLER] + counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER];
+    uint32_t sampledImages = counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] + counts[VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE]
+                           + counts[VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER];
+    uint32_t storageImages = counts[VK_DESCRIPTOR_TYPE_STORAGE_IMAGE] + counts[VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER];
+    uint32_t uniformBuffers = counts[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER] + counts[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC];
+    uint32_t storageBuffers = counts[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER] + counts[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC];
+
+    struct
+    {
+        const char* name;
+        uint32_t used;
+        uint32_t limit;
+    } checks[] = {
+        { "samplers", samplers, limits.maxDescriptorSetSamplers },
+        { "sampled images", sampledImages, limits.maxDescriptorSetSampledImages },
+        { "storage images", storageImages, limits.maxDescriptorSetStorageImages },
+        { "uniform buffers", uniformBuffers, limits.maxDescriptorSetUniformBuffers },
+        { "dynamic uniform buffers", counts[VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC], limits.maxDescriptorSetUniformBuffersDynamic },
+        { "storage buffers", storageBuffers, limits.maxDescriptorSetStorageBuffers },
+        { "dynamic storage buffers", counts[VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC], limits.maxDescriptorSetStorageBuffersDynamic },
+        { "input attachments", counts[VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT], limits.maxDescriptorSetInputAttachments },
+    };
+
+    for (auto& c: checks)
+    {
+        if (c.used > c.limit)
+            LOGW(what << " uses " << c.used << " " << c.name << ", device limit is " << c.limit);
+    }
+}
+
 DescriptorAllocator& DescriptorAllocator::Instance()
 {
     static DescriptorAllocator instance;
@@ -58,47 +239,159 @@ DescriptorAllocator& DescriptorAllocator::Instance()
 bool DescriptorAllocator::Init(const DevicePtr& device, const DescriptorAllocatorDesc& desc)
 {
     mDevice = device;
+    mLimits = desc;
+
+    if (mLimits.maxSets == 0)
+    {
+        LOGE("Descriptor Allocator requires a non-zero set limit");
+        return false;
+    }
+
+    // limits are read inside LOGD, which compiles to nothing with lower log levels
+    LOGD("Device descriptor limits per set:");
+    LOGD("  Samplers:         " << mDevice->GetProperties().limits.maxDescriptorSetSamplers);
+    LOGD("  Sampled images:   " << mDevice->GetProperties().limits.maxDescriptorSetSampledImages);
+    LOGD("  Storage images:   " << mDevice->GetProperties().limits.maxDescriptorSetStorageImages);
+    LOGD("  Uniform buffers:  " << mDevice->GetProperties().limits.maxDescriptorSetUniformBuffers);
+    LOGD("  Storage buffers:  " << mDevice->GetProperties().limits.maxDescriptorSetStorageBuffers);
+
+    // pre-create first pool for calling thread, so misconfigured limits are caught early
+    DescriptorPoolChain* pools = GetThreadPools();
+    if (!AllocateNewPool(*pools, nullptr))
+        return false;
+
+    mPoolCount++;
+    return true;
+}
+
+void DescriptorAllocator::Release()
+{
+    if (!mDevice)
+        return;
+
+    LogStats();
 
-    VkDescriptorPoolSize size;
+    {
+        MemoryStatistics& statistics = mDevice->GetStatistics();
+
+        std::lock_guard<std::mutex> lock(mThreadPoolsMutex);
+        for (auto& tp: mThreadPools)
+        {
+            for (auto& p: tp.second->pools)
+            {
+                vkDestroyDescriptorPool(mDevice->GetDevice(), p.pool, nullptr);
+                statistics.OnDestroy(TrackedObject::DescriptorPool);
+                statistics.OnDestroy(TrackedObject::DescriptorSet, p.takenSets);
+            }
+        }
+
+        mThreadPools.clear();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mFreeSetsMutex);
+        mFreeSets.clear();
+    }
+
+    mPoolCount = 0;
+    mAllocatedSets = 0;
+    mRecycledSets = 0;
     for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+        mDescriptors[i] = 0;
+
+    mDevice.reset();
+}
+
+void DescriptorAllocator::RegisterLayout(VkDescriptorSetLayout layout, const uint32_t counts[VK_DESCRIPTOR_TYPE_RANGE_SIZE])
+{
+    LayoutInfo info;
+    for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+        info.counts[i] = counts[i];
+
+    if (mDevice)
+        CheckDeviceLimits(info.counts, "Descriptor Set Layout");
+
+    std::lock_guard<std::mutex> lock(mLayoutsMutex);
+    mLayouts[layout] = info;
+}
+
+void DescriptorAllocator::UnregisterLayout(VkDescriptorSetLayout layout)
+{
     {
-        mLimits.limits[i] = desc.limits[i];
+        std::lock_guard<std::mutex> lock(mLayoutsMutex);
+        mLayouts.erase(layout);
+    }
 
-        mMaxSets += mLimits.limits[i];
-        size.descriptorCount = mLimits.limits[i];
-        size.type = static_cast<VkDescriptorType>(i);
-        mPoolSizes.push_back(size);
+    {
+        // sets on the free-list stay allocated in their pools, but can no longer be reused
+        std::lock_guard<std::mutex> lock(mFreeSetsMutex);
+        mFreeSets.erase(layout);
     }
+}
 
-    // TODO check if we do not exceed device's limits
-    return AllocateNewPool();
+VkDescriptorSet DescriptorAllocator::AllocateDescriptorSet(VkDescriptorSetLayout layout)
+{
+    {
+        std::lock_guard<std::mutex> lock(mFreeSetsMutex);
+        auto it = mFreeSets.find(layout);
+        if (it != mFreeSets.end() && !it->second.empty())
+        {
+            VkDescriptorSet set = it->second.back();
+            it->second.pop_back();
+            mRecycledSets++;
+            return set;
+        }
+    }
+
+    DescriptorPoolChain* pools = GetThreadPools();
+    return AllocateFromChain(*pools, layout);
 }
 
-void DescriptorAllocator::Release()
+void DescriptorAllocator::FreeDescriptorSet(VkDescriptorSetLayout layout, VkDescriptorSet set)
 {
-    for (auto& p: mDescriptorPools)
-        vkDestroyDescriptorPool(mDevice->GetDevice(), p.pool, nullptr);
+    if (!mDevice || set == VK_NULL_HANDLE)
+        return;
+
+    // layout could have been destroyed already - its sets cannot be reused anymore
+    LayoutInfo info;
+    if (!GetLayoutInfo(layout, info))
+        return;
 
-    mDescriptorPools.clear();
+    std::lock_guard<std::mutex> lock(mFreeSetsMutex);
+    mFreeSets[layout].push_back(set);
 }
 
-VkDescriptorSet DescriptorAllocator::AllocateDescriptorSet(const VkDescriptorSetLayout layout)
+DescriptorAllocatorStats DescriptorAllocator::GetStats()
 {
-    // TODO memory tracking (somehow)
+    DescriptorAllocatorStats stats;
+    stats.poolCount = mPoolCount;
+    stats.allocatedSets = mAllocatedSets;
+    stats.recycledSets = mRecycledSets;
+    for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+        stats.descriptors[i] = mDescriptors[i];
 
-    VkDescriptorSet set = VK_NULL_HANDLE;
+    std::lock_guard<std::mutex> lock(mFreeSetsMutex);
+    for (auto& fs: mFreeSets)
+        stats.freeSets += static_cast<uint32_t>(fs.second.size());
 
-    VkDescriptorSetAllocateInfo info;
-    ZERO_MEMORY(info);
-    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    info.descriptorPool = mDescriptorPools.back().pool;
-    info.descriptorSetCount = 1;
-    info.pSetLayouts = &layout;
-    VkResult result = vkAllocateDescriptorSets(mDevice->GetDevice(), &info, &set);
-    // TODO add new pool if limits are exceeded
-    RETURN_NULL_HANDLE_IF_FAILED(result, "Failed to allocate Descriptor Set");
+    return stats;
+}
+
+void DescriptorAllocator::LogStats()
+{
+    DescriptorAllocatorStats stats = GetStats();
 
-    return set;
+    LOGI("Descriptor Allocator stats:");
+    LOGI("  Pools:          " << stats.poolCount);
+    LOGI("  Allocated sets: " << stats.allocatedSets);
+    LOGI("  Recycled sets:  " << stats.recycledSets);
+    LOGI("  Free sets:      " << stats.freeSets);
+    for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+    {
+        if (stats.descriptors[i] > 0)
+            LOGI("  " << TranslateVkDescriptorTypeToString(static_cast<VkDescriptorType>(i))
+                 << ": " << stats.descriptors[i]);
+    }
 }
 
 } // namespace Renderer
@@ -9,9 +9,11 @@ namespace Renderer {
 
 struct DescriptorAllocatorDesc
 {
-    uint32_t limits[VK_DESCRIPTOR_TYPE_RANGE_SIZE];
+    uint32_t limits[VK_DESCRIPTOR_TYPE_RANGE_SIZE]; // descriptor counts of a single pool
+    uint32_t maxSets; // set count of a single pool
 
     DescriptorAllocatorDesc()
+        : maxSets(0)
     {
         for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
             limits[i] = 0;
@@ -23,9 +25,13 @@ struct DescriptorPool
     VkDescriptorPool pool;
     uint32_t limits[VK_DESCRIPTOR_TYPE_RANGE_SIZE];
     uint32_t taken[VK_DESCRIPTOR_TYPE_RANGE_SIZE];
+    uint32_t maxSets;
+    uint32_t takenSets;
 
     DescriptorPool()
         : pool(VK_NULL_HANDLE)
+        , maxSets(0)
+        , takenSets(0)
     {
         for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
         {
@@ -35,19 +41,78 @@ struct DescriptorPool
     }
 };
 
-// A wrapper for VkDescriptorPool objects.
-// Holds preallocated Descriptor Pools with high-limit descriptor sets.
+// A list of pools, where the ones before current are already full.
+struct DescriptorPoolChain
+{
+    std::vector<DescriptorPool> pools;
+    size_t current;
+
+    DescriptorPoolChain()
+        : pools()
+        , current(0)
+    {
+    }
+};
+
+struct DescriptorAllocatorStats
+{
+    uint32_t poolCount;
+    uint32_t allocatedSets; // sets allocated from pools
+    uint32_t recycledSets; // sets reused from the free-list
+    uint32_t freeSets; // sets currently waiting in the free-list
+    uint32_t descriptors[VK_DESCRIPTOR_TYPE_RANGE_SIZE]; // descriptors taken by allocated sets
+
+    DescriptorAllocatorStats()
+        : poolCount(0)
+        , allocatedSets(0)
+        , recycledSets(0)
+        , freeSets(0)
+    {
+        for (uint32_t i = 0; i < VK_DESCRIPTOR_TYPE_RANGE_SIZE; ++i)
+            descriptors[i] = 0;
+    }
+};
+
+/**
+ * A wrapper for VkDescriptorPool objects.
+ *
+ * Each thread gets its own pools, so sets can be allocated during parallel Command Buffer
+ * recording without locking Vulkan pools. Pools are added automatically when existing ones
+ * run out of space.
+ *
+ * Sets can be returned with FreeDescriptorSet() - they are kept on a free-list per layout
+ * and reused by further allocations with the same layout.
+ */
 class DescriptorAllocator
 {
+    struct LayoutInfo
+    {
+        uint32_t counts[VK_DESCRIPTOR_TYPE_RANGE_SIZE];
+    };
+
     DevicePtr mDevice;
 
-    uint32_t mMaxSets;
     DescriptorAllocatorDesc mLimits;
-    std::vector<VkDescriptorPoolSize> mPoolSizes;
 
-    std::vector<DescriptorPool> mDescriptorPools;
+    std::unordered_map<std::thread::id, std::unique_ptr<DescriptorPoolChain>> mThreadPools;
+    std::mutex mThreadPoolsMutex;
 
-    bool AllocateNewPool();
+    std::unordered_map<VkDescriptorSetLayout, LayoutInfo> mLayouts;
+    std::mutex mLayoutsMutex;
+
+    std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> mFreeSets;
+    std::mutex mFreeSetsMutex;
+
+    std::atomic<uint32_t> mPoolCount;
+    std::atomic<uint32_t> mAllocatedSets;
+    std::atomic<uint32_t> mRecycledSets;
+    std::atomic<uint32_t> mDescriptors[VK_DESCRIPTOR_TYPE_RANGE_SIZE];
+
+    bool AllocateNewPool(DescriptorPoolChain& chain, const LayoutInfo* layoutInfo);
+    VkDescriptorSet AllocateFromChain(DescriptorPoolChain& chain, VkDescriptorSetLayout layout);
+    DescriptorPoolChain* GetThreadPools();
+    bool GetLayoutInfo(VkDescriptorSetLayout layout, LayoutInfo& info);
+    void CheckDeviceLimits(const uint32_t counts[VK_DESCRIPTOR_TYPE_RANGE_SIZE], const std::string& what) const;
 
     DescriptorAllocator();
     DescriptorAllocator(const DescriptorAllocator&) = delete;
@@ -62,7 +127,19 @@ public:
     bool Init(const DevicePtr& device, const DescriptorAllocatorDesc& desc);
     void Release();
 
+    /**
+     * Informs the allocator how many descriptors of each type a layout consumes. This lets
+     * the allocator pick a pool with enough space before calling Vulkan and warn about
+     * layouts exceeding per-set device limits. Called by Tools::CreateDescriptorSetLayout.
+     */
+    void RegisterLayout(VkDescriptorSetLayout layout, const uint32_t counts[VK_DESCRIPTOR_TYPE_RANGE_SIZE]);
+    void UnregisterLayout(VkDescriptorSetLayout layout);
+
     VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout);
+    void FreeDescriptorSet(VkDescriptorSetLayout layout, VkDescriptorSet set);
+
+    DescriptorAllocatorStats GetStats();
+    void LogStats();
 };
 
 } // namespace Renderer
@@ -16,7 +16,11 @@ Device::Device()
     : mDevice(VK_NULL_HANDLE)
     , mPhysicalDevice(VK_NULL_HANDLE)
     , mMemoryProperties()
+    , mProperties()
+    , mFeatures()
+    , mTimelineSemaphores(false)
     , mQueueManager()
+    , mStatistics()
 {
 }
 
@@ -85,6 +89,25 @@ VkPhysicalDevice Device::SelectPhysicalDevice()
     return VK_NULL_HANDLE;
 }
 
+bool Device::IsExtensionAvailable(const char* name) const
+{
+    uint32_t count = 0;
+    VkResult result = vkEnumerateDeviceExtensionProperties(mPhysicalDevice, nullptr, &count, nullptr);
+    if (result != VK_SUCCESS)
+        return false;
+
+    std::vector<VkExtensionProperties> extensions(count);
+    result = vkEnumerateDeviceExtensionProperties(mPhysicalDevice, nullptr, &count, extensions.data());
+    if (result != VK_SUCCESS)
+        return false;
+
+    for (auto& e: extensions)
+        if (strcmp(e.extensionName, name) == 0)
+            return true;
+
+    return false;
+}
+
 bool Device::Init(const InstancePtr& inst, bool noAsync)
 {
     mInstance = inst;
@@ -93,6 +116,15 @@ bool Device::Init(const InstancePtr& inst, bool noAsync)
     // Memory properties (for further use)
     vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &mMemoryProperties);
 
+    // Device properties and limits (for further use)
+    vkGetPhysicalDeviceProperties(mPhysicalDevice, &mProperties);
+
+    // Enable only optional features we can make use of
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+    ZERO_MEMORY(mFeatures);
+    mFeatures.shaderSampledImageArrayDynamicIndexing = supportedFeatures.shaderSampledImageArrayDynamicIndexing;
+
     if (!mQueueManager.Init(mPhysicalDevice, !noAsync))
     {
         LOGE("Failed to initialize Queue Manager");
@@ -100,9 +132,42 @@ bool Device::Init(const InstancePtr& inst, bool noAsync)
     }
 
     // device extensions
-    const char* enabledExtensions[] = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-    };
+    std::vector<const char*> enabledExtensions;
+    if (!mInstance->IsHeadless())
+        enabledExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    bool memoryBudget = mInstance->HasPhysicalDeviceProperties2() &&
+                        IsExtensionAvailable(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudget)
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    else
+        LOGI("VK_EXT_memory_budget not available - memory statistics will not report heap budgets");
+
+    // extension alone is not enough, the feature has to be supported too
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures;
+    ZERO_MEMORY(timelineFeatures);
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    mTimelineSemaphores = false;
+    if (mInstance->HasPhysicalDeviceProperties2() && vkGetPhysicalDeviceFeatures2KHR &&
+        IsExtensionAvailable(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2KHR features2;
+        ZERO_MEMORY(features2);
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features2.pNext = &timelineFeatures;
+        vkGetPhysicalDeviceFeatures2KHR(mPhysicalDevice, &features2);
+        mTimelineSemaphores = (timelineFeatures.timelineSemaphore == VK_TRUE);
+    }
+
+    if (mTimelineSemaphores)
+    {
+        enabledExtensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        timelineFeatures.pNext = nullptr;
+    }
+    else
+    {
+        LOGI("VK_KHR_timeline_semaphore not available - Frame Graph will use binary semaphores");
+    }
 
     const char* enabledLayers[] = {
         "VK_LAYER_LUNARG_standard_validation" // for debugging
@@ -112,10 +177,12 @@ bool Device::Init(const InstancePtr& inst, bool noAsync)
     VkDeviceCreateInfo devInfo;
     ZERO_MEMORY(devInfo);
     devInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    devInfo.pNext = mTimelineSemaphores ? &timelineFeatures : nullptr;
     devInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
     devInfo.pQueueCreateInfos = queueInfos.data();
-    devInfo.enabledExtensionCount = 1;
-    devInfo.ppEnabledExtensionNames = enabledExtensions;
+    devInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    devInfo.ppEnabledExtensionNames = enabledExtensions.data();
+    devInfo.pEnabledFeatures = &mFeatures;
     if (mInstance->IsDebuggingEnabled())
     {
         LOGW("Debug enabled - adding Vulkan Validation layer");
@@ -127,7 +194,7 @@ bool Device::Init(const InstancePtr& inst, bool noAsync)
     RETURN_FALSE_IF_FAILED(result, "Failed to create Vulkan Device");
 
     // acquire per-device extensions
-    if (!InitDeviceExtensions(mDevice))
+    if (!InitDeviceExtensions(mDevice, mInstance->IsHeadless()))
     {
         LOGE("Failed to initailize needed device extensions");
         return false;
@@ -140,6 +207,8 @@ bool Device::Init(const InstancePtr& inst, bool noAsync)
         return false;
     }
 
+    mStatistics.Init(mPhysicalDevice, mMemoryProperties, memoryBudget);
+
     LOGI("Vulkan Device initialized successfully");
     return true;
 }
@@ -156,6 +225,24 @@ uint32_t Device::GetMemoryTypeIndex(uint32_t typeBits, VkFlags properties) const
     return UINT32_MAX;
 }
 
+VkResult Device::AllocateMemory(const VkMemoryAllocateInfo& info, VkDeviceMemory& memory)
+{
+    VkResult result = vkAllocateMemory(mDevice, &info, nullptr, &memory);
+    if (result == VK_SUCCESS)
+        mStatistics.OnAllocate(memory, info.memoryTypeIndex, info.allocationSize);
+
+    return result;
+}
+
+void Device::FreeMemory(VkDeviceMemory memory)
+{
+    if (memory == VK_NULL_HANDLE)
+        return;
+
+    mStatistics.OnFree(memory);
+    vkFreeMemory(mDevice, memory, nullptr);
+}
+
 void Device::Wait(DeviceQueueType queueType) const
 {
     vkQueueWaitIdle(mQueueManager.GetQueue(queueType));
@@ -186,7 +273,7 @@ bool Device::Execute(DeviceQueueType queueType, CommandBuffer* cmd, uint32_t wai
     submitInfo.waitSemaphoreCount = waitSemaphoresCount;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitFlags;
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = (signalSemaphore != VK_NULL_HANDLE) ? 1 : 0;
     submitInfo.pSignalSemaphores = &signalSemaphore;
     VkResult result = vkQueueSubmit(mQueueManager.GetQueue(queueType), 1, &submitInfo, waitFence);
     RETURN_FALSE_IF_FAILED(result, "Failed to execute command buffer");
@@ -194,5 +281,13 @@ bool Device::Execute(DeviceQueueType queueType, CommandBuffer* cmd, uint32_t wai
     return true;
 }
 
+bool Device::Execute(DeviceQueueType queueType, uint32_t batchCount, const VkSubmitInfo* batches, VkFence waitFence) const
+{
+    VkResult result = vkQueueSubmit(mQueueManager.GetQueue(queueType), batchCount, batches, waitFence);
+    RETURN_FALSE_IF_FAILED(result, "Failed to submit command buffer batches");
+
+    return true;
+}
+
 } // namespace Renderer
 } // namespace ABench
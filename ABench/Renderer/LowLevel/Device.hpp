@@ -4,6 +4,7 @@
 #include "Instance.hpp"
 #include "CommandBuffer.hpp"
 #include "QueueManager.hpp"
+#include "MemoryStatistics.hpp"
 #include "Common/Common.hpp"
 
 
@@ -19,9 +20,14 @@ class Device
     VkDevice mDevice;
     VkPhysicalDevice mPhysicalDevice;
     VkPhysicalDeviceMemoryProperties mMemoryProperties;
+    VkPhysicalDeviceProperties mProperties;
+    VkPhysicalDeviceFeatures mFeatures; // features enabled on created device
+    bool mTimelineSemaphores; // VK_KHR_timeline_semaphore is enabled
     QueueManager mQueueManager;
+    MemoryStatistics mStatistics;
 
     VkPhysicalDevice SelectPhysicalDevice();
+    bool IsExtensionAvailable(const char* name) const;
 
 public:
     Device();
@@ -31,17 +37,38 @@ public:
 
     uint32_t GetMemoryTypeIndex(uint32_t typeBits, VkFlags properties) const;
 
+    // vkAllocateMemory/vkFreeMemory counted in Memory Statistics
+    VkResult AllocateMemory(const VkMemoryAllocateInfo& info, VkDeviceMemory& memory);
+    void FreeMemory(VkDeviceMemory memory);
+
     void Wait(DeviceQueueType queueType) const;
     bool Execute(DeviceQueueType queueType, CommandBuffer* cmd) const;
     bool Execute(DeviceQueueType queueType, CommandBuffer* cmd, uint32_t waitSemaphoresCount,
                  const VkPipelineStageFlags* waitFlags, const VkSemaphore* waitSemaphores,
                  VkSemaphore signalSemaphore, VkFence waitFence) const;
+    // submits multiple batches at once, in a single vkQueueSubmit call
+    bool Execute(DeviceQueueType queueType, uint32_t batchCount, const VkSubmitInfo* batches, VkFence waitFence) const;
 
     ABENCH_INLINE VkDevice GetDevice() const
     {
         return mDevice;
     }
 
+    ABENCH_INLINE const VkPhysicalDeviceProperties& GetProperties() const
+    {
+        return mProperties;
+    }
+
+    ABENCH_INLINE const VkPhysicalDeviceFeatures& GetFeatures() const
+    {
+        return mFeatures;
+    }
+
+    ABENCH_INLINE bool HasTimelineSemaphores() const
+    {
+        return mTimelineSemaphores;
+    }
+
     ABENCH_INLINE VkCommandPool GetCommandPool(DeviceQueueType queueType) const
     {
         return mQueueManager.GetCommandPool(queueType);
@@ -52,6 +79,11 @@ public:
         return mQueueManager.GetQueueIndex(queueType);
     }
 
+    ABENCH_INLINE uint32_t GetTimestampValidBits(DeviceQueueType queueType) const
+    {
+        return mQueueManager.GetTimestampValidBits(queueType);
+    }
+
     ABENCH_INLINE uint32_t GetQueueCount() const
     {
         return mQueueManager.GetQueueCount();
@@ -61,6 +93,11 @@ public:
     {
         return mQueueManager.GetQueueIndices();
     }
+
+    ABENCH_INLINE MemoryStatistics& GetStatistics()
+    {
+        return mStatistics;
+    }
 };
 
 using DevicePtr = std::shared_ptr<Device>;
@@ -60,6 +60,7 @@ namespace Renderer {
 PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = VK_NULL_HANDLE;
 PFN_vkCreateInstance vkCreateInstance = VK_NULL_HANDLE;
 PFN_vkDestroyInstance vkDestroyInstance = VK_NULL_HANDLE;
+PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties = VK_NULL_HANDLE;
 
 bool InitLibraryExtensions(Common::Library& library)
 {
@@ -68,6 +69,7 @@ bool InitLibraryExtensions(Common::Library& library)
     VK_GET_LIBPROC(library, vkGetInstanceProcAddr);
     VK_GET_LIBPROC(library, vkCreateInstance);
     VK_GET_LIBPROC(library, vkDestroyInstance);
+    VK_GET_LIBPROC(library, vkEnumerateInstanceExtensionProperties);
 
     return allExtensionsAvailable;
 }
@@ -86,6 +88,9 @@ PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr = VK_NULL_HANDLE;
 PFN_vkCreateDevice vkCreateDevice = VK_NULL_HANDLE;
 PFN_vkDestroyDevice vkDestroyDevice = VK_NULL_HANDLE;
 PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR = VK_NULL_HANDLE;
+PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties = VK_NULL_HANDLE;
+PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR = VK_NULL_HANDLE;
+PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2KHR = VK_NULL_HANDLE;
 
 #ifdef WIN32
 PFN_vkCreateWin32SurfaceKHR vkCreateWin32SurfaceKHR = VK_NULL_HANDLE;
@@ -95,7 +100,7 @@ PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR = VK_NULL_HANDLE;
 #error "Target platform not supported"
 #endif
 
-bool InitInstanceExtensions(const VkInstance& instance)
+bool InitInstanceExtensions(const VkInstance& instance, bool headless)
 {
     bool allExtensionsAvailable = true;
 
@@ -104,13 +109,24 @@ bool InitInstanceExtensions(const VkInstance& instance)
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceFeatures);
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceMemoryProperties);
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceQueueFamilyProperties);
+    VK_GET_INSTANCEPROC(instance, vkGetDeviceProcAddr);
+    VK_GET_INSTANCEPROC(instance, vkCreateDevice);
+    VK_GET_INSTANCEPROC(instance, vkDestroyDevice);
+    VK_GET_INSTANCEPROC(instance, vkEnumerateDeviceExtensionProperties);
+
+    // optional, Instance knows whether its extension was enabled
+    vkGetPhysicalDeviceFeatures2KHR = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+    vkGetPhysicalDeviceMemoryProperties2KHR = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+
+    if (headless)
+        return allExtensionsAvailable;
+
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceSurfaceCapabilitiesKHR);
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceSurfaceFormatsKHR);
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceSurfacePresentModesKHR);
     VK_GET_INSTANCEPROC(instance, vkGetPhysicalDeviceSurfaceSupportKHR);
-    VK_GET_INSTANCEPROC(instance, vkGetDeviceProcAddr);
-    VK_GET_INSTANCEPROC(instance, vkCreateDevice);
-    VK_GET_INSTANCEPROC(instance, vkDestroyDevice);
     VK_GET_INSTANCEPROC(instance, vkDestroySurfaceKHR);
 
 #ifdef WIN32
@@ -170,6 +186,7 @@ PFN_vkCreateCommandPool vkCreateCommandPool = VK_NULL_HANDLE;
 PFN_vkDestroyCommandPool vkDestroyCommandPool = VK_NULL_HANDLE;
 PFN_vkEndCommandBuffer vkEndCommandBuffer = VK_NULL_HANDLE;
 PFN_vkFreeCommandBuffers vkFreeCommandBuffers = VK_NULL_HANDLE;
+PFN_vkResetCommandPool vkResetCommandPool = VK_NULL_HANDLE;
 
 // Render Passes / Framebuffers
 PFN_vkCreateFramebuffer vkCreateFramebuffer = VK_NULL_HANDLE;
@@ -185,6 +202,7 @@ PFN_vkCreatePipelineLayout vkCreatePipelineLayout = VK_NULL_HANDLE;
 PFN_vkDestroyPipeline vkDestroyPipeline = VK_NULL_HANDLE;
 PFN_vkDestroyPipelineCache vkDestroyPipelineCache = VK_NULL_HANDLE;
 PFN_vkDestroyPipelineLayout vkDestroyPipelineLayout = VK_NULL_HANDLE;
+PFN_vkGetPipelineCacheData vkGetPipelineCacheData = VK_NULL_HANDLE;
 
 // Shader
 PFN_vkCreateShaderModule vkCreateShaderModule = VK_NULL_HANDLE;
@@ -197,8 +215,14 @@ PFN_vkCreateDescriptorSetLayout vkCreateDescriptorSetLayout = VK_NULL_HANDLE;
 PFN_vkDestroyDescriptorPool vkDestroyDescriptorPool = VK_NULL_HANDLE;
 PFN_vkDestroyDescriptorSetLayout vkDestroyDescriptorSetLayout = VK_NULL_HANDLE;
 PFN_vkFreeDescriptorSets vkFreeDescriptorSets = VK_NULL_HANDLE;
+PFN_vkResetDescriptorPool vkResetDescriptorPool = VK_NULL_HANDLE;
 PFN_vkUpdateDescriptorSets vkUpdateDescriptorSets = VK_NULL_HANDLE;
 
+// Queries
+PFN_vkCreateQueryPool vkCreateQueryPool = VK_NULL_HANDLE;
+PFN_vkDestroyQueryPool vkDestroyQueryPool = VK_NULL_HANDLE;
+PFN_vkGetQueryPoolResults vkGetQueryPoolResults = VK_NULL_HANDLE;
+
 // Commands
 PFN_vkCmdBeginRenderPass vkCmdBeginRenderPass = VK_NULL_HANDLE;
 PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets = VK_NULL_HANDLE;
@@ -209,24 +233,34 @@ PFN_vkCmdClearAttachments vkCmdClearAttachments = VK_NULL_HANDLE;
 PFN_vkCmdCopyBuffer vkCmdCopyBuffer = VK_NULL_HANDLE;
 PFN_vkCmdCopyBufferToImage vkCmdCopyBufferToImage = VK_NULL_HANDLE;
 PFN_vkCmdCopyImage vkCmdCopyImage = VK_NULL_HANDLE;
+PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer = VK_NULL_HANDLE;
 PFN_vkCmdDispatch vkCmdDispatch = VK_NULL_HANDLE;
 PFN_vkCmdDraw vkCmdDraw = VK_NULL_HANDLE;
 PFN_vkCmdDrawIndexed vkCmdDrawIndexed = VK_NULL_HANDLE;
+PFN_vkCmdDrawIndexedIndirect vkCmdDrawIndexedIndirect = VK_NULL_HANDLE;
+PFN_vkCmdDrawIndirect vkCmdDrawIndirect = VK_NULL_HANDLE;
 PFN_vkCmdEndRenderPass vkCmdEndRenderPass = VK_NULL_HANDLE;
+PFN_vkCmdExecuteCommands vkCmdExecuteCommands = VK_NULL_HANDLE;
 PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier = VK_NULL_HANDLE;
+PFN_vkCmdPushConstants vkCmdPushConstants = VK_NULL_HANDLE;
+PFN_vkCmdResetQueryPool vkCmdResetQueryPool = VK_NULL_HANDLE;
 PFN_vkCmdSetScissor vkCmdSetScissor = VK_NULL_HANDLE;
 PFN_vkCmdSetViewport vkCmdSetViewport = VK_NULL_HANDLE;
+PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp = VK_NULL_HANDLE;
 
-bool InitDeviceExtensions(const VkDevice& device)
+bool InitDeviceExtensions(const VkDevice& device, bool headless)
 {
     bool allExtensionsAvailable = true;
 
     // Swapchain
-    VK_GET_DEVICEPROC(device, vkAcquireNextImageKHR);
-    VK_GET_DEVICEPROC(device, vkCreateSwapchainKHR);
-    VK_GET_DEVICEPROC(device, vkDestroySwapchainKHR);
-    VK_GET_DEVICEPROC(device, vkGetSwapchainImagesKHR);
-    VK_GET_DEVICEPROC(device, vkQueuePresentKHR);
+    if (!headless)
+    {
+        VK_GET_DEVICEPROC(device, vkAcquireNextImageKHR);
+        VK_GET_DEVICEPROC(device, vkCreateSwapchainKHR);
+        VK_GET_DEVICEPROC(device, vkDestroySwapchainKHR);
+        VK_GET_DEVICEPROC(device, vkGetSwapchainImagesKHR);
+        VK_GET_DEVICEPROC(device, vkQueuePresentKHR);
+    }
 
     // Queues
     VK_GET_DEVICEPROC(device, vkGetDeviceQueue);
@@ -266,6 +300,7 @@ bool InitDeviceExtensions(const VkDevice& device)
     VK_GET_DEVICEPROC(device, vkDestroyCommandPool);
     VK_GET_DEVICEPROC(device, vkEndCommandBuffer);
     VK_GET_DEVICEPROC(device, vkFreeCommandBuffers);
+    VK_GET_DEVICEPROC(device, vkResetCommandPool);
 
     // Render Passes / Framebuffers
     VK_GET_DEVICEPROC(device, vkCreateFramebuffer);
@@ -281,6 +316,7 @@ bool InitDeviceExtensions(const VkDevice& device)
     VK_GET_DEVICEPROC(device, vkDestroyPipeline);
     VK_GET_DEVICEPROC(device, vkDestroyPipelineCache);
     VK_GET_DEVICEPROC(device, vkDestroyPipelineLayout);
+    VK_GET_DEVICEPROC(device, vkGetPipelineCacheData);
 
     // Shader
     VK_GET_DEVICEPROC(device, vkCreateShaderModule);
@@ -293,8 +329,14 @@ bool InitDeviceExtensions(const VkDevice& device)
     VK_GET_DEVICEPROC(device, vkDestroyDescriptorPool);
     VK_GET_DEVICEPROC(device, vkDestroyDescriptorSetLayout);
     VK_GET_DEVICEPROC(device, vkFreeDescriptorSets);
+    VK_GET_DEVICEPROC(device, vkResetDescriptorPool);
     VK_GET_DEVICEPROC(device, vkUpdateDescriptorSets);
 
+    // Queries
+    VK_GET_DEVICEPROC(device, vkCreateQueryPool);
+    VK_GET_DEVICEPROC(device, vkDestroyQueryPool);
+    VK_GET_DEVICEPROC(device, vkGetQueryPoolResults);
+
     // Commands
     VK_GET_DEVICEPROC(device, vkCmdBeginRenderPass);
     VK_GET_DEVICEPROC(device, vkCmdBindDescriptorSets);
@@ -305,13 +347,20 @@ bool InitDeviceExtensions(const VkDevice& device)
     VK_GET_DEVICEPROC(device, vkCmdCopyBuffer);
     VK_GET_DEVICEPROC(device, vkCmdCopyBufferToImage);
     VK_GET_DEVICEPROC(device, vkCmdCopyImage);
+    VK_GET_DEVICEPROC(device, vkCmdCopyImageToBuffer);
     VK_GET_DEVICEPROC(device, vkCmdDispatch);
     VK_GET_DEVICEPROC(device, vkCmdDraw);
     VK_GET_DEVICEPROC(device, vkCmdDrawIndexed);
+    VK_GET_DEVICEPROC(device, vkCmdDrawIndexedIndirect);
+    VK_GET_DEVICEPROC(device, vkCmdDrawIndirect);
     VK_GET_DEVICEPROC(device, vkCmdEndRenderPass);
+    VK_GET_DEVICEPROC(device, vkCmdExecuteCommands);
     VK_GET_DEVICEPROC(device, vkCmdPipelineBarrier);
+    VK_GET_DEVICEPROC(device, vkCmdPushConstants);
+    VK_GET_DEVICEPROC(device, vkCmdResetQueryPool);
     VK_GET_DEVICEPROC(device, vkCmdSetScissor);
     VK_GET_DEVICEPROC(device, vkCmdSetViewport);
+    VK_GET_DEVICEPROC(device, vkCmdWriteTimestamp);
 
     return allExtensionsAvailable;
 }
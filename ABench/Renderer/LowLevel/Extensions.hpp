@@ -2,6 +2,76 @@
 
 #include <Common/Library.hpp>
 
+
+// Vulkan headers we use predate VK_EXT_memory_budget and VK_KHR_timeline_semaphore - declare the parts we need
+#ifndef VK_KHR_get_physical_device_properties2
+#define VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME "VK_KHR_get_physical_device_properties2"
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR static_cast<VkStructureType>(1000059000)
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR static_cast<VkStructureType>(1000059006)
+
+typedef struct VkPhysicalDeviceFeatures2KHR {
+    VkStructureType sType;
+    void* pNext;
+    VkPhysicalDeviceFeatures features;
+} VkPhysicalDeviceFeatures2KHR;
+
+typedef struct VkPhysicalDeviceMemoryProperties2KHR {
+    VkStructureType sType;
+    void* pNext;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+} VkPhysicalDeviceMemoryProperties2KHR;
+
+typedef void (VKAPI_PTR *PFN_vkGetPhysicalDeviceFeatures2KHR)(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2KHR* pFeatures);
+typedef void (VKAPI_PTR *PFN_vkGetPhysicalDeviceMemoryProperties2KHR)(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2KHR* pMemoryProperties);
+#endif
+
+#ifndef VK_EXT_memory_budget
+#define VK_EXT_MEMORY_BUDGET_EXTENSION_NAME "VK_EXT_memory_budget"
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT static_cast<VkStructureType>(1000237000)
+
+typedef struct VkPhysicalDeviceMemoryBudgetPropertiesEXT {
+    VkStructureType sType;
+    void* pNext;
+    VkDeviceSize heapBudget[VK_MAX_MEMORY_HEAPS];
+    VkDeviceSize heapUsage[VK_MAX_MEMORY_HEAPS];
+} VkPhysicalDeviceMemoryBudgetPropertiesEXT;
+#endif
+
+#ifndef VK_KHR_timeline_semaphore
+#define VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME "VK_KHR_timeline_semaphore"
+#define VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR static_cast<VkStructureType>(1000207000)
+#define VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR static_cast<VkStructureType>(1000207002)
+#define VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR static_cast<VkStructureType>(1000207003)
+
+typedef enum VkSemaphoreTypeKHR {
+    VK_SEMAPHORE_TYPE_BINARY_KHR = 0,
+    VK_SEMAPHORE_TYPE_TIMELINE_KHR = 1,
+} VkSemaphoreTypeKHR;
+
+typedef struct VkPhysicalDeviceTimelineSemaphoreFeaturesKHR {
+    VkStructureType sType;
+    void* pNext;
+    VkBool32 timelineSemaphore;
+} VkPhysicalDeviceTimelineSemaphoreFeaturesKHR;
+
+typedef struct VkSemaphoreTypeCreateInfoKHR {
+    VkStructureType sType;
+    const void* pNext;
+    VkSemaphoreTypeKHR semaphoreType;
+    uint64_t initialValue;
+} VkSemaphoreTypeCreateInfoKHR;
+
+typedef struct VkTimelineSemaphoreSubmitInfoKHR {
+    VkStructureType sType;
+    const void* pNext;
+    uint32_t waitSemaphoreValueCount;
+    const uint64_t* pWaitSemaphoreValues;
+    uint32_t signalSemaphoreValueCount;
+    const uint64_t* pSignalSemaphoreValues;
+} VkTimelineSemaphoreSubmitInfoKHR;
+#endif
+
+
 namespace ABench {
 namespace Renderer {
 
@@ -9,6 +79,7 @@ namespace Renderer {
 extern PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
 extern PFN_vkCreateInstance vkCreateInstance;
 extern PFN_vkDestroyInstance vkDestroyInstance;
+extern PFN_vkEnumerateInstanceExtensionProperties vkEnumerateInstanceExtensionProperties;
 
 bool InitLibraryExtensions(Common::Library& library);
 
@@ -27,6 +98,11 @@ extern PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
 extern PFN_vkCreateDevice vkCreateDevice;
 extern PFN_vkDestroyDevice vkDestroyDevice;
 extern PFN_vkDestroySurfaceKHR vkDestroySurfaceKHR;
+extern PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
+
+// Optional - valid only if VK_KHR_get_physical_device_properties2 was enabled on the Instance
+extern PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR;
+extern PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2KHR;
 
 #ifdef WIN32
 extern PFN_vkCreateWin32SurfaceKHR vkCreateWin32SurfaceKHR;
@@ -36,7 +112,8 @@ extern PFN_vkCreateXcbSurfaceKHR vkCreateXcbSurfaceKHR;
 #error "Target platform not supported"
 #endif
 
-bool InitInstanceExtensions(const VkInstance& instance);
+// surface functions are skipped for headless instances
+bool InitInstanceExtensions(const VkInstance& instance, bool headless);
 
 
 // Functions extracted per VkDevice
@@ -86,6 +163,7 @@ extern PFN_vkCreateCommandPool vkCreateCommandPool;
 extern PFN_vkDestroyCommandPool vkDestroyCommandPool;
 extern PFN_vkEndCommandBuffer vkEndCommandBuffer;
 extern PFN_vkFreeCommandBuffers vkFreeCommandBuffers;
+extern PFN_vkResetCommandPool vkResetCommandPool;
 
 // Render Passes / Framebuffers
 extern PFN_vkCreateFramebuffer vkCreateFramebuffer;
@@ -101,6 +179,7 @@ extern PFN_vkCreatePipelineLayout vkCreatePipelineLayout;
 extern PFN_vkDestroyPipeline vkDestroyPipeline;
 extern PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
 extern PFN_vkDestroyPipelineLayout vkDestroyPipelineLayout;
+extern PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 
 // Shaders
 extern PFN_vkCreateShaderModule vkCreateShaderModule;
@@ -113,8 +192,14 @@ extern PFN_vkCreateDescriptorSetLayout vkCreateDescriptorSetLayout;
 extern PFN_vkDestroyDescriptorPool vkDestroyDescriptorPool;
 extern PFN_vkDestroyDescriptorSetLayout vkDestroyDescriptorSetLayout;
 extern PFN_vkFreeDescriptorSets vkFreeDescriptorSets;
+extern PFN_vkResetDescriptorPool vkResetDescriptorPool;
 extern PFN_vkUpdateDescriptorSets vkUpdateDescriptorSets;
 
+// Queries
+extern PFN_vkCreateQueryPool vkCreateQueryPool;
+extern PFN_vkDestroyQueryPool vkDestroyQueryPool;
+extern PFN_vkGetQueryPoolResults vkGetQueryPoolResults;
+
 // Commands
 extern PFN_vkCmdBeginRenderPass vkCmdBeginRenderPass;
 extern PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets;
@@ -125,15 +210,23 @@ extern PFN_vkCmdClearAttachments vkCmdClearAttachments;
 extern PFN_vkCmdCopyBuffer vkCmdCopyBuffer;
 extern PFN_vkCmdCopyBufferToImage vkCmdCopyBufferToImage;
 extern PFN_vkCmdCopyImage vkCmdCopyImage;
+extern PFN_vkCmdCopyImageToBuffer vkCmdCopyImageToBuffer;
 extern PFN_vkCmdDispatch vkCmdDispatch;
 extern PFN_vkCmdDraw vkCmdDraw;
 extern PFN_vkCmdDrawIndexed vkCmdDrawIndexed;
+extern PFN_vkCmdDrawIndexedIndirect vkCmdDrawIndexedIndirect;
+extern PFN_vkCmdDrawIndirect vkCmdDrawIndirect;
 extern PFN_vkCmdEndRenderPass vkCmdEndRenderPass;
+extern PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
 extern PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier;
+extern PFN_vkCmdPushConstants vkCmdPushConstants;
+extern PFN_vkCmdResetQueryPool vkCmdResetQueryPool;
 extern PFN_vkCmdSetScissor vkCmdSetScissor;
 extern PFN_vkCmdSetViewport vkCmdSetViewport;
+extern PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp;
 
-bool InitDeviceExtensions(const VkDevice& device);
+// swapchain functions are skipped for headless devices
+bool InitDeviceExtensions(const VkDevice& device, bool headless);
 
 } // namespace Renderer
 } // namespace ABench
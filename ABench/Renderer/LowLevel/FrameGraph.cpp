@@ -0,0 +1,367 @@
+#include "PCH.hpp"
+#include "FrameGraph.hpp"
+#include "Tools.hpp"
+#include "Util.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+FrameGraph::FrameGraph()
+    : mDevice()
+    , mTimelineSemaphores(false)
+    , mNodes()
+    , mEdges()
+    , mScheduleOrder()
+    , mProfiler(nullptr)
+    , mFrameSubmitCount(0)
+    , mFrameBatchCount(0)
+    , mSubmitCount(0)
+    , mBatchCount(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+}
+
+bool FrameGraph::Init(const DevicePtr& device)
+{
+    mDevice = device;
+    mTimelineSemaphores = mDevice->HasTimelineSemaphores();
+    LOGD("Frame Graph uses " << (mTimelineSemaphores ? "timeline" : "binary") << " semaphores");
+    return true;
+}
+
+FrameGraphNode FrameGraph::AddNode(const std::string& name, DeviceQueueType queueType)
+{
+    std::unique_ptr<Node> node(new Node());
+    node->name = name;
+    node->queueType = queueType;
+    node->fence = VK_NULL_HANDLE;
+    node->profilerScope = (mProfiler != nullptr) ? mProfiler->AddScope(name, queueType) : GPU_PROFILER_INVALID_SCOPE;
+    node->timelineValue = 0;
+    node->commandBuffer = nullptr;
+    node->scheduled = false;
+    node->submitted = false;
+
+    if (mTimelineSemaphores)
+    {
+        node->timeline = Tools::CreateTimelineSem(mDevice, node->timelineValue);
+        if (!node->timeline)
+        {
+            LOGE("Failed to create timeline semaphore for Frame Graph node " << name);
+            return FRAME_GRAPH_INVALID_NODE;
+        }
+    }
+
+    mNodes.push_back(std::move(node));
+    return static_cast<FrameGraphNode>(mNodes.size() - 1);
+}
+
+bool FrameGraph::AddDependency(FrameGraphNode node, FrameGraphNode dependsOn, VkPipelineStageFlags waitStage)
+{
+    if (node >= mNodes.size() || dependsOn >= mNodes.size() || node == dependsOn)
+    {
+        LOGE("Invalid Frame Graph dependency provided");
+        return false;
+    }
+
+    std::unique_ptr<Edge> edge(new Edge());
+    edge->from = dependsOn;
+    edge->to = node;
+    edge->waitStage = waitStage;
+    edge->signaled = false;
+    edge->resolved = false;
+    edge->value = 0;
+    if (!mTimelineSemaphores)
+    {
+        edge->semaphore = Tools::CreateSem(mDevice);
+        if (!edge->semaphore)
+            return false;
+    }
+
+    uint32_t edgeIndex = static_cast<uint32_t>(mEdges.size());
+    mNodes[dependsOn]->outgoingEdges.push_back(edgeIndex);
+    mNodes[node]->incomingEdges.push_back(edgeIndex);
+    mEdges.push_back(std::move(edge));
+
+    LOGD("Frame Graph: " << mNodes[node]->name << " depends on " << mNodes[dependsOn]->name);
+    return true;
+}
+
+bool FrameGraph::AddExternalWait(FrameGraphNode node, VkSemaphore semaphore, VkPipelineStageFlags waitStage)
+{
+    if (node >= mNodes.size())
+    {
+        LOGE("Invalid Frame Graph node provided");
+        return false;
+    }
+
+    mNodes[node]->externalWaitSems.push_back(semaphore);
+    mNodes[node]->externalWaitFlags.push_back(waitStage);
+    return true;
+}
+
+bool FrameGraph::AddExternalSignal(FrameGraphNode node, VkSemaphore semaphore)
+{
+    if (node >= mNodes.size())
+    {
+        LOGE("Invalid Frame Graph node provided");
+        return false;
+    }
+
+    mNodes[node]->externalSignalSems.push_back(semaphore);
+    return true;
+}
+
+bool FrameGraph::SetFence(FrameGraphNode node, VkFence fence)
+{
+    if (node >= mNodes.size())
+    {
+        LOGE("Invalid Frame Graph node provided");
+        return false;
+    }
+
+    mNodes[node]->fence = fence;
+    return true;
+}
+
+void FrameGraph::SetProfiler(GpuProfiler* profiler)
+{
+    mProfiler = profiler;
+
+    for (auto& n: mNodes)
+        n->profilerScope = (mProfiler != nullptr) ? mProfiler->AddScope(n->name, n->queueType) : GPU_PROFILER_INVALID_SCOPE;
+}
+
+void FrameGraph::Schedule(FrameGraphNode node, CommandBuffer* commandBuffer)
+{
+    ASSERT(node < mNodes.size(), "Invalid Frame Graph node provided");
+    ASSERT(!mNodes[node]->scheduled, "Frame Graph node was already scheduled this frame");
+
+    mNodes[node]->commandBuffer = commandBuffer;
+    mNodes[node]->scheduled = true;
+    mScheduleOrder.push_back(node);
+}
+
+void FrameGraph::PrepareBatch(FrameGraphNode node, Batch& batch)
+{
+    Node* n = mNodes[node].get();
+
+    for (uint32_t e: n->incomingEdges)
+    {
+        Edge* edge = mEdges[e].get();
+        if (edge->signaled)
+        {
+            if (mTimelineSemaphores)
+            {
+                batch.waitSems.push_back(mNodes[edge->from]->timeline);
+                batch.waitValues.push_back(edge->value);
+            }
+            else
+            {
+                batch.waitSems.push_back(edge->semaphore);
+            }
+
+            batch.waitFlags.push_back(edge->waitStage);
+            edge->signaled = false;
+        }
+
+        // producer which did not run until now is considered inactive for this frame
+        edge->resolved = true;
+    }
+
+    batch.waitSems.insert(batch.waitSems.end(), n->externalWaitSems.begin(), n->externalWaitSems.end());
+    batch.waitFlags.insert(batch.waitFlags.end(), n->externalWaitFlags.begin(), n->externalWaitFlags.end());
+
+    // timeline is signaled once, no matter how many dependents wait for it
+    bool signalTimeline = false;
+    for (uint32_t e: n->outgoingEdges)
+    {
+        Edge* edge = mEdges[e].get();
+        if (!edge->resolved)
+        {
+            if (mTimelineSemaphores)
+            {
+                if (!signalTimeline)
+                {
+                    n->timelineValue++;
+                    batch.signalSems.push_back(n->timeline);
+                    batch.signalValues.push_back(n->timelineValue);
+                    signalTimeline = true;
+                }
+
+                edge->value = n->timelineValue;
+            }
+            else
+            {
+                batch.signalSems.push_back(edge->semaphore);
+            }
+
+            edge->signaled = true;
+        }
+    }
+
+    batch.signalSems.insert(batch.signalSems.end(), n->externalSignalSems.begin(), n->externalSignalSems.end());
+
+    if (mTimelineSemaphores)
+    {
+        // values of external binary semaphores are ignored
+        batch.waitValues.resize(batch.waitSems.size(), 0);
+        batch.signalValues.resize(batch.signalSems.size(), 0);
+
+        ZERO_MEMORY(batch.timelineInfo);
+        batch.timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        batch.timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(batch.waitValues.size());
+        batch.timelineInfo.pWaitSemaphoreValues = batch.waitValues.data();
+        batch.timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(batch.signalValues.size());
+        batch.timelineInfo.pSignalSemaphoreValues = batch.signalValues.data();
+    }
+
+    CommandBuffer* profilerBegin = nullptr;
+    CommandBuffer* profilerEnd = nullptr;
+    if (mProfiler != nullptr)
+    {
+        profilerBegin = mProfiler->RecordBegin(n->profilerScope);
+        profilerEnd = mProfiler->RecordEnd(n->profilerScope);
+    }
+
+    if (profilerBegin != nullptr)
+        batch.commandBuffers.push_back(profilerBegin->mCommandBuffer);
+    batch.commandBuffers.push_back(n->commandBuffer->mCommandBuffer);
+    if (profilerEnd != nullptr)
+        batch.commandBuffers.push_back(profilerEnd->mCommandBuffer);
+
+    n->submitted = true;
+}
+
+bool FrameGraph::SubmitGroup(DeviceQueueType queueType, const std::vector<FrameGraphNode>& group)
+{
+    std::vector<Batch> batches(group.size());
+    std::vector<VkSubmitInfo> submitInfos(group.size());
+
+    for (size_t i = 0; i < group.size(); ++i)
+    {
+        PrepareBatch(group[i], batches[i]);
+
+        VkSubmitInfo& info = submitInfos[i];
+        ZERO_MEMORY(info);
+        info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        info.pNext = mTimelineSemaphores ? &batches[i].timelineInfo : nullptr;
+        info.waitSemaphoreCount = static_cast<uint32_t>(batches[i].waitSems.size());
+        info.pWaitSemaphores = batches[i].waitSems.data();
+        info.pWaitDstStageMask = batches[i].waitFlags.data();
+        info.commandBufferCount = static_cast<uint32_t>(batches[i].commandBuffers.size());
+        info.pCommandBuffers = batches[i].commandBuffers.data();
+        info.signalSemaphoreCount = static_cast<uint32_t>(batches[i].signalSems.size());
+        info.pSignalSemaphores = batches[i].signalSems.data();
+    }
+
+    // only the last node of a group can have a fence
+    VkFence fence = mNodes[group.back()]->fence;
+
+    mFrameSubmitCount++;
+    mFrameBatchCount += static_cast<uint32_t>(group.size());
+    return mDevice->Execute(queueType, static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), fence);
+}
+
+bool FrameGraph::Submit()
+{
+    if (mScheduleOrder.empty())
+        return true;
+
+    // producers scheduled in earlier Submit() calls are already on the GPU, so only
+    // dependencies between nodes scheduled since then are planned
+    std::vector<uint32_t> planIndices(mNodes.size(), UINT32_MAX);
+    for (size_t i = 0; i < mScheduleOrder.size(); ++i)
+        planIndices[mScheduleOrder[i]] = static_cast<uint32_t>(i);
+
+    std::vector<FrameGraphPlanNode> planNodes(mScheduleOrder.size());
+    for (size_t i = 0; i < mScheduleOrder.size(); ++i)
+    {
+        const Node* n = mNodes[mScheduleOrder[i]].get();
+        planNodes[i].queueType = n->queueType;
+        planNodes[i].hasFence = (n->fence != VK_NULL_HANDLE);
+        for (uint32_t e: n->incomingEdges)
+        {
+            uint32_t producer = planIndices[mEdges[e]->from];
+            if (producer != UINT32_MAX)
+                planNodes[i].dependencies.push_back(producer);
+        }
+    }
+
+    std::vector<FrameGraphPlanGroup> planGroups;
+    bool planned = PlanFrameGraphSubmission(planNodes, planGroups);
+
+    bool result = true;
+    uint32_t submittedCount = 0;
+    for (const auto& g: planGroups)
+    {
+        std::vector<FrameGraphNode> group;
+        for (uint32_t i: g.nodes)
+            group.push_back(mScheduleOrder[i]);
+
+        result &= SubmitGroup(g.queueType, group);
+        submittedCount += static_cast<uint32_t>(group.size());
+    }
+
+    if (!planned)
+    {
+        LOGE("Frame Graph contains a dependency cycle, " << mScheduleOrder.size() - submittedCount << " nodes were not submitted");
+        result = false;
+    }
+
+    mScheduleOrder.clear();
+    return result;
+}
+
+bool FrameGraph::EndFrame()
+{
+    bool result = true;
+
+    if (!mScheduleOrder.empty())
+    {
+        LOGW("Frame Graph has unsubmitted work at the end of frame, submitting");
+        result &= Submit();
+    }
+
+    // consume binary semaphores which were signaled, but their consumers did not run;
+    // timeline values which nobody waited for need no cleanup
+    for (auto& e: mEdges)
+    {
+        if (!mTimelineSemaphores && e->signaled && !e->resolved)
+        {
+            VkSemaphore sem = e->semaphore;
+            VkPipelineStageFlags flags = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+            VkSubmitInfo info;
+            ZERO_MEMORY(info);
+            info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            info.waitSemaphoreCount = 1;
+            info.pWaitSemaphores = &sem;
+            info.pWaitDstStageMask = &flags;
+            result &= mDevice->Execute(mNodes[e->to]->queueType, 1, &info, VK_NULL_HANDLE);
+            mFrameSubmitCount++;
+        }
+
+        e->signaled = false;
+        e->resolved = false;
+    }
+
+    for (auto& n: mNodes)
+    {
+        n->commandBuffer = nullptr;
+        n->scheduled = false;
+        n->submitted = false;
+    }
+
+    mSubmitCount = mFrameSubmitCount;
+    mBatchCount = mFrameBatchCount;
+    mFrameSubmitCount = 0;
+    mFrameBatchCount = 0;
+    return result;
+}
+
+} // namespace Renderer
+} // namespace ABench
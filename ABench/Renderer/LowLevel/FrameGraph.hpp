@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Prerequisites.hpp"
+#include "Device.hpp"
+#include "CommandBuffer.hpp"
+#include "GpuProfiler.hpp"
+#include "Extensions.hpp"
+#include "FrameGraphPlan.hpp"
+#include "VkRAII.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+using FrameGraphNode = uint32_t;
+const FrameGraphNode FRAME_GRAPH_INVALID_NODE = UINT32_MAX;
+
+/**
+ * Submission layer collecting all GPU work recorded in a frame.
+ *
+ * Graph structure (nodes, dependencies between them, external semaphores and fences)
+ * is declared once during initialization. Each frame passes schedule their recorded
+ * Command Buffers on their nodes and Submit() sends all scheduled work to the GPU:
+ *   - nodes are grouped so consecutive work on the same queue lands in one vkQueueSubmit
+ *     call, one batch per node (see PlanFrameGraphSubmission()),
+ *   - semaphores between nodes are derived from declared dependencies,
+ *   - work on each queue keeps the order in which it was scheduled.
+ *
+ * Submit() can be called multiple times per frame, ex. when CPU has to wait for results
+ * of some already scheduled work. A node which was not scheduled until its dependents
+ * were submitted is considered inactive for this frame and is not waited on.
+ *
+ * With a GPU Profiler attached, each node is a profiler scope and its batch is bracketed with
+ * timestamp-writing Command Buffers.
+ *
+ * When Device has VK_KHR_timeline_semaphore enabled, each node owns a timeline semaphore
+ * which it signals with an increasing value and dependents wait for that value - no
+ * semaphore is left signaled when a dependent does not run. Otherwise each dependency
+ * gets its own binary semaphore and EndFrame() consumes the ones left signaled.
+ */
+class FrameGraph
+{
+    struct Edge
+    {
+        FrameGraphNode from;
+        FrameGraphNode to;
+        VkPipelineStageFlags waitStage;
+        VkRAII<VkSemaphore> semaphore; // binary mode only
+        uint64_t value; // value of producer's timeline to wait for, timeline mode only
+        bool signaled; // signal was submitted this frame
+        bool resolved; // consumer was submitted (or skipped) this frame
+    };
+
+    struct Node
+    {
+        std::string name;
+        DeviceQueueType queueType;
+        VkFence fence;
+        std::vector<VkSemaphore> externalWaitSems;
+        std::vector<VkPipelineStageFlags> externalWaitFlags;
+        std::vector<VkSemaphore> externalSignalSems;
+        std::vector<uint32_t> incomingEdges;
+        std::vector<uint32_t> outgoingEdges;
+        GpuProfilerScope profilerScope;
+        VkRAII<VkSemaphore> timeline; // timeline mode only
+        uint64_t timelineValue; // last value signaled on timeline
+
+        // per-frame state
+        CommandBuffer* commandBuffer;
+        bool scheduled;
+        bool submitted;
+    };
+
+    // Vk structures of a single batch have to live until vkQueueSubmit is called
+    struct Batch
+    {
+        std::vector<VkSemaphore> waitSems;
+        std::vector<VkPipelineStageFlags> waitFlags;
+        std::vector<VkSemaphore> signalSems;
+        std::vector<VkCommandBuffer> commandBuffers;
+        std::vector<uint64_t> waitValues; // timeline mode only, binary semaphores get 0
+        std::vector<uint64_t> signalValues;
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo;
+    };
+
+    DevicePtr mDevice;
+    bool mTimelineSemaphores;
+    std::vector<std::unique_ptr<Node>> mNodes;
+    std::vector<std::unique_ptr<Edge>> mEdges;
+    std::vector<FrameGraphNode> mScheduleOrder; // nodes scheduled since last Submit()
+    GpuProfiler* mProfiler;
+    uint32_t mFrameSubmitCount; // vkQueueSubmit calls issued in current frame
+    uint32_t mFrameBatchCount; // batches submitted in current frame
+    uint32_t mSubmitCount; // same as above, but for last finished frame
+    uint32_t mBatchCount;
+
+    void PrepareBatch(FrameGraphNode node, Batch& batch);
+    bool SubmitGroup(DeviceQueueType queueType, const std::vector<FrameGraphNode>& group);
+
+public:
+    FrameGraph();
+    ~FrameGraph();
+
+    bool Init(const DevicePtr& device);
+
+    // Graph declaration
+    FrameGraphNode AddNode(const std::string& name, DeviceQueueType queueType);
+    bool AddDependency(FrameGraphNode node, FrameGraphNode dependsOn, VkPipelineStageFlags waitStage);
+    bool AddExternalWait(FrameGraphNode node, VkSemaphore semaphore, VkPipelineStageFlags waitStage);
+    bool AddExternalSignal(FrameGraphNode node, VkSemaphore semaphore);
+    // node closes its vkQueueSubmit, so the fence covers the node and work submitted before it
+    bool SetFence(FrameGraphNode node, VkFence fence);
+    // registers all current and future nodes as scopes of provided profiler
+    void SetProfiler(GpuProfiler* profiler);
+
+    // Per-frame usage
+    void Schedule(FrameGraphNode node, CommandBuffer* commandBuffer);
+    bool Submit();
+
+    /**
+     * Finishes the frame. In binary mode, semaphores signaled for nodes which did not run this
+     * frame are consumed with empty batches, so the graph can be safely submitted again.
+     */
+    bool EndFrame();
+
+    ABENCH_INLINE GpuProfilerScope GetProfilerScope(FrameGraphNode node) const
+    {
+        return mNodes[node]->profilerScope;
+    }
+
+    ABENCH_INLINE uint32_t GetSubmitCount() const
+    {
+        return mSubmitCount;
+    }
+
+    ABENCH_INLINE uint32_t GetBatchCount() const
+    {
+        return mBatchCount;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,95 @@
+#include "PCH.hpp"
+#include "FrameGraphPlan.hpp"
+
+
+namespace {
+
+using namespace ABench::Renderer;
+
+bool IsReady(const std::vector<FrameGraphPlanNode>& nodes, uint32_t node, const std::vector<bool>& placed)
+{
+    for (uint32_t d: nodes[node].dependencies)
+        if (!placed[d])
+            return false;
+
+    // work on one queue keeps the scheduling order
+    for (uint32_t i = 0; i < node; ++i)
+        if (!placed[i] && nodes[i].queueType == nodes[node].queueType)
+            return false;
+
+    return true;
+}
+
+} // namespace
+
+
+namespace ABench {
+namespace Renderer {
+
+bool PlanFrameGraphSubmission(const std::vector<FrameGraphPlanNode>& nodes, std::vector<FrameGraphPlanGroup>& groups)
+{
+    groups.clear();
+    if (nodes.empty())
+        return true;
+
+    const uint32_t nodeCount = static_cast<uint32_t>(nodes.size());
+    std::vector<bool> placed(nodeCount, false);
+    uint32_t placedCount = 0;
+
+    DeviceQueueType currentQueue = nodes[0].queueType;
+    while (placedCount < nodeCount)
+    {
+        // gather as much ready work for current queue as possible
+        FrameGraphPlanGroup group;
+        group.queueType = currentQueue;
+        bool closed = false;
+        bool progress = true;
+        while (progress && !closed)
+        {
+            progress = false;
+            for (uint32_t i = 0; i < nodeCount; ++i)
+            {
+                if (placed[i] || nodes[i].queueType != currentQueue || !IsReady(nodes, i, placed))
+                    continue;
+
+                placed[i] = true;
+                placedCount++;
+                group.nodes.push_back(i);
+                progress = true;
+
+                // anything submitted after a fenced node would delay whoever waits for the fence
+                if (nodes[i].hasFence)
+                {
+                    closed = true;
+                    break;
+                }
+            }
+        }
+
+        if (!group.nodes.empty())
+            groups.push_back(std::move(group));
+
+        if (placedCount == nodeCount)
+            break;
+
+        // switch to the queue of first node which can be submitted now
+        bool found = false;
+        for (uint32_t i = 0; i < nodeCount; ++i)
+        {
+            if (!placed[i] && IsReady(nodes, i, placed))
+            {
+                currentQueue = nodes[i].queueType;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <vector>
+#include <cstdint>
+
+
+namespace ABench {
+namespace Renderer {
+
+struct FrameGraphPlanNode
+{
+    DeviceQueueType queueType;
+    bool hasFence;
+    std::vector<uint32_t> dependencies; // indices of planned nodes which have to be submitted first
+};
+
+struct FrameGraphPlanGroup
+{
+    DeviceQueueType queueType;
+    std::vector<uint32_t> nodes; // one batch per node, in submission order
+};
+
+/**
+ * Splits nodes, given in scheduling order, into groups submitted with a single vkQueueSubmit each.
+ *
+ * Consecutive work ready on the same queue lands in one group, work on each queue keeps the
+ * scheduling order and every node comes after the nodes it depends on. A node with a fence
+ * closes its group - the fence signals when whole vkQueueSubmit finishes, so it covers only
+ * the node and work placed before it.
+ *
+ * Returns false when dependencies form a cycle. Groups hold nodes which could be placed until then.
+ */
+bool PlanFrameGraphSubmission(const std::vector<FrameGraphPlanNode>& nodes, std::vector<FrameGraphPlanGroup>& groups);
+
+} // namespace Renderer
+} // namespace ABench
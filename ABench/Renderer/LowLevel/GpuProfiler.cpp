@@ -0,0 +1,453 @@
+#include "PCH.hpp"
+#include "GpuProfiler.hpp"
+
+#include "Tools.hpp"
+#include "Extensions.hpp"
+#include "Util.hpp"
+
+#include "Common/Logger.hpp"
+#include "Common/Profiler.hpp"
+#include "Common/TraceWriter.hpp"
+
+#include <limits>
+
+
+namespace ABench {
+namespace Renderer {
+
+namespace {
+
+const uint32_t QUERIES_PER_SCOPE = 2;
+
+const uint32_t TRACE_CPU_PID = 1;
+const uint32_t TRACE_GPU_PID = 2;
+const uint32_t TRACE_CPU_ZONES_PID = 3;
+const uint32_t TRACE_CPU_FRAME_TID = 0;
+const uint32_t TRACE_CPU_PASS_TID = 1;
+
+const char* QUEUE_NAMES[] = {
+    "Graphics",
+    "Transfer",
+    "Compute",
+};
+
+} // namespace
+
+GpuProfiler::Accumulator::Accumulator()
+    : samples(0)
+    , sum(0.0)
+    , min(std::numeric_limits<double>::max())
+    , max(0.0)
+    , keepValues(false)
+    , values()
+{
+}
+
+void GpuProfiler::Accumulator::Add(double value)
+{
+    samples++;
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+
+    if (keepValues)
+        values.push_back(value);
+}
+
+GpuProfilerTiming GpuProfiler::Accumulator::Get() const
+{
+    GpuProfilerTiming timing;
+    timing.samples = samples;
+    timing.avgMs = (samples > 0) ? (sum / samples) : 0.0;
+    timing.minMs = (samples > 0) ? min : 0.0;
+    timing.maxMs = max;
+    return timing;
+}
+
+GpuProfiler::GpuProfiler()
+    : mDevice()
+    , mDesc()
+    , mScopes()
+    , mSlots()
+    , mTraceEvents()
+    , mFrameTime()
+    , mFrameStart(0.0)
+    , mFrame(0)
+    , mStatsFrame(0)
+    , mCurrentSlot(0)
+    , mDroppedSamples(0)
+    , mTimestampPeriod(1.0f)
+{
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    if (mDroppedSamples > 0)
+        LOGW("GPU Profiler dropped " << mDroppedSamples << " samples which were not ready on time");
+}
+
+bool GpuProfiler::Init(const DevicePtr& device, const GpuProfilerDesc& desc)
+{
+    if (desc.frameLatency < 2)
+    {
+        LOGE("GPU Profiler needs at least 2 frames of latency to avoid stalling on query results");
+        return false;
+    }
+
+    mDesc = desc;
+    mTimestampPeriod = device->GetProperties().limits.timestampPeriod;
+
+    mSlots.clear();
+    mSlots.resize(mDesc.frameLatency);
+    for (auto& slot: mSlots)
+    {
+        slot.queryPool = Tools::CreateTimestampQueryPool(device, mDesc.maxScopes * QUERIES_PER_SCOPE);
+        if (!slot.queryPool)
+            return false;
+
+        slot.frame = 0;
+        slot.submitTime = -1.0;
+    }
+
+    // device is set last - IsEnabled() reports true only for a fully initialized profiler
+    mDevice = device;
+    mScopes.clear();
+    mTraceEvents.clear();
+    mFrameTime = Accumulator();
+    mFrameTime.keepValues = mDesc.keepSamples;
+    mFrame = 0;
+    mStatsFrame = 0;
+    mCurrentSlot = 0;
+    mFrameStart = GetCpuTime();
+
+    LOGI("GPU Profiler initialized, timestamp period " << mTimestampPeriod << " ns");
+    return true;
+}
+
+double GpuProfiler::GetCpuTime() const
+{
+    return Common::Profiler::Instance().GetTime();
+}
+
+bool GpuProfiler::InitScopeCommandBuffers(GpuProfilerScope scope)
+{
+    for (auto& slot: mSlots)
+    {
+        // every scope has an entry, so scope IDs can index slot's arrays directly
+        slot.beginCommandBuffers.emplace_back();
+        slot.endCommandBuffers.emplace_back();
+        slot.written.push_back(false);
+    }
+
+    if (!mScopes[scope].supported)
+        return true;
+
+    for (auto& slot: mSlots)
+    {
+        std::unique_ptr<CommandBuffer> begin(new CommandBuffer());
+        if (!begin->Init(mDevice, mScopes[scope].queueType))
+            return false;
+
+        std::unique_ptr<CommandBuffer> end(new CommandBuffer());
+        if (!end->Init(mDevice, mScopes[scope].queueType))
+            return false;
+
+        slot.beginCommandBuffers[scope] = std::move(begin);
+        slot.endCommandBuffers[scope] = std::move(end);
+    }
+
+    return true;
+}
+
+GpuProfilerScope GpuProfiler::AddScope(const std::string& name, DeviceQueueType queueType)
+{
+    if (!IsEnabled())
+        return GPU_PROFILER_INVALID_SCOPE;
+
+    if (mScopes.size() >= mDesc.maxScopes)
+    {
+        LOGE("GPU Profiler scope limit (" << mDesc.maxScopes << ") reached, " << name << " will not be measured");
+        return GPU_PROFILER_INVALID_SCOPE;
+    }
+
+    uint32_t validBits = mDevice->GetTimestampValidBits(queueType);
+
+    Scope scope;
+    scope.name = name;
+    scope.queueType = queueType;
+    scope.supported = (validBits > 0);
+    scope.timestampMask = (validBits >= 64) ? UINT64_MAX : ((1ULL << validBits) - 1);
+    scope.cpuStart = 0.0;
+    scope.gpu.keepValues = mDesc.keepSamples;
+    scope.cpu.keepValues = mDesc.keepSamples;
+    mScopes.push_back(scope);
+
+    GpuProfilerScope id = static_cast<GpuProfilerScope>(mScopes.size() - 1);
+    if (!scope.supported)
+        LOGW("Queue of " << name << " does not support timestamps - only CPU time will be measured");
+
+    if (!InitScopeCommandBuffers(id))
+    {
+        LOGE("Failed to allocate GPU Profiler Command Buffers for " << name);
+        mScopes[id].supported = false;
+    }
+
+    return id;
+}
+
+CommandBuffer* GpuProfiler::RecordBegin(GpuProfilerScope scope)
+{
+    if (!IsEnabled() || scope >= mScopes.size() || !mScopes[scope].supported)
+        return nullptr;
+
+    FrameSlot& slot = mSlots[mCurrentSlot];
+    if (slot.submitTime < 0.0)
+        slot.submitTime = GetCpuTime();
+
+    uint32_t query = scope * QUERIES_PER_SCOPE;
+    CommandBuffer* cmd = slot.beginCommandBuffers[scope].get();
+    cmd->Begin();
+    cmd->ResetQueryPool(slot.queryPool, query, QUERIES_PER_SCOPE);
+    cmd->WriteTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, query);
+    if (!cmd->End())
+        return nullptr;
+
+    return cmd;
+}
+
+CommandBuffer* GpuProfiler::RecordEnd(GpuProfilerScope scope)
+{
+    if (!IsEnabled() || scope >= mScopes.size() || !mScopes[scope].supported)
+        return nullptr;
+
+    FrameSlot& slot = mSlots[mCurrentSlot];
+
+    CommandBuffer* cmd = slot.endCommandBuffers[scope].get();
+    cmd->Begin();
+    cmd->WriteTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slot.queryPool, scope * QUERIES_PER_SCOPE + 1);
+    if (!cmd->End())
+        return nullptr;
+
+    // only scopes with both timestamps submitted are read back
+    slot.written[scope] = true;
+    return cmd;
+}
+
+void GpuProfiler::BeginCpuScope(GpuProfilerScope scope)
+{
+    if (!IsEnabled() || scope >= mScopes.size())
+        return;
+
+    mScopes[scope].cpuStart = GetCpuTime();
+}
+
+void GpuProfiler::EndCpuScope(GpuProfilerScope scope)
+{
+    if (!IsEnabled() || scope >= mScopes.size())
+        return;
+
+    double start = mScopes[scope].cpuStart;
+    double duration = GetCpuTime() - start;
+    mScopes[scope].cpu.Add(duration / 1000.0);
+    mTraceEvents.push_back({ mFrame, scope, false, start, duration });
+}
+
+void GpuProfiler::ResolveSlot(FrameSlot& slot)
+{
+    struct Result
+    {
+        GpuProfilerScope scope;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    std::vector<Result> results;
+    uint64_t frameBegin = UINT64_MAX;
+    bool aggregate = (slot.frame >= mStatsFrame);
+
+    for (GpuProfilerScope s = 0; s < slot.written.size(); ++s)
+    {
+        if (!slot.written[s])
+            continue;
+
+        slot.written[s] = false;
+
+        uint64_t timestamps[QUERIES_PER_SCOPE];
+        VkResult result = vkGetQueryPoolResults(mDevice->GetDevice(), slot.queryPool, s * QUERIES_PER_SCOPE,
+                                                QUERIES_PER_SCOPE, sizeof(timestamps), timestamps,
+                                                sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS)
+        {
+            // VK_NOT_READY - frame is still in flight, which should not happen with enough latency
+            mDroppedSamples++;
+            continue;
+        }
+
+        uint64_t mask = mScopes[s].timestampMask;
+        Result r;
+        r.scope = s;
+        r.begin = timestamps[0] & mask;
+        r.end = timestamps[1] & mask;
+        results.push_back(r);
+
+        frameBegin = std::min(frameBegin, r.begin);
+    }
+
+    for (auto& r: results)
+    {
+        uint64_t mask = mScopes[r.scope].timestampMask;
+        double durationUs = static_cast<double>((r.end - r.begin) & mask) * mTimestampPeriod / 1000.0;
+        double offsetUs = static_cast<double>((r.begin - frameBegin) & mask) * mTimestampPeriod / 1000.0;
+
+        if (aggregate)
+            mScopes[r.scope].gpu.Add(durationUs / 1000.0);
+        mTraceEvents.push_back({ slot.frame, r.scope, true, slot.submitTime + offsetUs, durationUs });
+    }
+
+    slot.submitTime = -1.0;
+}
+
+void GpuProfiler::TrimTraceEvents()
+{
+    while (!mTraceEvents.empty() && mTraceEvents.front().frame + mDesc.traceFrames < mFrame)
+        mTraceEvents.pop_front();
+}
+
+void GpuProfiler::NextFrame()
+{
+    if (!IsEnabled())
+        return;
+
+    // time before the first frame is spent on initialization, not rendering
+    double now = GetCpuTime();
+    if (mFrame > 0)
+    {
+        if (mFrame >= mStatsFrame)
+            mFrameTime.Add((now - mFrameStart) / 1000.0);
+        mTraceEvents.push_back({ mFrame, GPU_PROFILER_INVALID_SCOPE, false, mFrameStart, now - mFrameStart });
+    }
+
+    mFrameStart = now;
+    mFrame++;
+
+    // slot of this frame was last used frameLatency frames ago, so its results should be ready
+    mCurrentSlot = static_cast<uint32_t>(mFrame % mSlots.size());
+    ResolveSlot(mSlots[mCurrentSlot]);
+    mSlots[mCurrentSlot].frame = mFrame;
+
+    TrimTraceEvents();
+}
+
+void GpuProfiler::Flush()
+{
+    if (!IsEnabled())
+        return;
+
+    // oldest frames first, so the trace stays ordered
+    for (uint32_t i = 1; i <= mSlots.size(); ++i)
+        ResolveSlot(mSlots[(mCurrentSlot + i) % mSlots.size()]);
+}
+
+void GpuProfiler::ResetStatistics()
+{
+    for (auto& s: mScopes)
+    {
+        s.gpu = Accumulator();
+        s.gpu.keepValues = mDesc.keepSamples;
+        s.cpu = Accumulator();
+        s.cpu.keepValues = mDesc.keepSamples;
+    }
+
+    mFrameTime = Accumulator();
+    mFrameTime.keepValues = mDesc.keepSamples;
+
+    // current frame has already started, so the first full frame is the next one
+    mStatsFrame = mFrame + 1;
+}
+
+GpuProfilerTiming GpuProfiler::GetGpuTiming(GpuProfilerScope scope) const
+{
+    return mScopes[scope].gpu.Get();
+}
+
+GpuProfilerTiming GpuProfiler::GetCpuTiming(GpuProfilerScope scope) const
+{
+    return mScopes[scope].cpu.Get();
+}
+
+GpuProfilerTiming GpuProfiler::GetFrameTiming() const
+{
+    return mFrameTime.Get();
+}
+
+const std::vector<double>& GpuProfiler::GetGpuSamples(GpuProfilerScope scope) const
+{
+    return mScopes[scope].gpu.values;
+}
+
+const std::vector<double>& GpuProfiler::GetCpuSamples(GpuProfilerScope scope) const
+{
+    return mScopes[scope].cpu.values;
+}
+
+const std::vector<double>& GpuProfiler::GetFrameSamples() const
+{
+    return mFrameTime.values;
+}
+
+bool GpuProfiler::ExportCSV(const std::string& path) const
+{
+    std::ofstream file(path, std::ofstream::out | std::ofstream::trunc);
+    if (!file)
+    {
+        LOGE("Unable to open profiler CSV file " << path << " for writing");
+        return false;
+    }
+
+    file << "scope,queue,gpu_samples,gpu_avg_ms,gpu_min_ms,gpu_max_ms,cpu_samples,cpu_avg_ms,cpu_min_ms,cpu_max_ms\n";
+
+    GpuProfilerTiming frame = mFrameTime.Get();
+    file << "Frame,,0,0,0,0," << frame.samples << "," << frame.avgMs << "," << frame.minMs << "," << frame.maxMs << "\n";
+
+    for (auto& s: mScopes)
+    {
+        GpuProfilerTiming gpu = s.gpu.Get();
+        GpuProfilerTiming cpu = s.cpu.Get();
+        file << s.name << "," << QUEUE_NAMES[s.queueType] << ","
+             << gpu.samples << "," << gpu.avgMs << "," << gpu.minMs << "," << gpu.maxMs << ","
+             << cpu.samples << "," << cpu.avgMs << "," << cpu.minMs << "," << cpu.maxMs << "\n";
+    }
+
+    return file.good();
+}
+
+bool GpuProfiler::ExportTrace(const std::string& path) const
+{
+    Common::TraceWriter writer;
+    if (!writer.Open(path))
+        return false;
+
+    writer.SetProcessName(TRACE_CPU_PID, "CPU");
+    writer.SetThreadName(TRACE_CPU_PID, TRACE_CPU_FRAME_TID, "Frames");
+    writer.SetThreadName(TRACE_CPU_PID, TRACE_CPU_PASS_TID, "Passes");
+    writer.SetProcessName(TRACE_GPU_PID, "GPU");
+    for (uint32_t q = 0; q < DeviceQueueType::COUNT; ++q)
+        writer.SetThreadName(TRACE_GPU_PID, q, QUEUE_NAMES[q]);
+
+    for (auto& e: mTraceEvents)
+    {
+        if (e.scope == GPU_PROFILER_INVALID_SCOPE)
+            writer.AddEvent(TRACE_CPU_PID, TRACE_CPU_FRAME_TID, "Frame " + std::to_string(e.frame), e.startUs, e.durationUs);
+        else if (e.gpu)
+            writer.AddEvent(TRACE_GPU_PID, mScopes[e.scope].queueType, mScopes[e.scope].name, e.startUs, e.durationUs);
+        else
+            writer.AddEvent(TRACE_CPU_PID, TRACE_CPU_PASS_TID, mScopes[e.scope].name, e.startUs, e.durationUs);
+    }
+
+    Common::Profiler::Instance().WriteTrace(writer, TRACE_CPU_ZONES_PID);
+
+    return writer.Close();
+}
+
+} // namespace Renderer
+} // namespace ABench
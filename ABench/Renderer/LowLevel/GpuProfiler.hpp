@@ -0,0 +1,190 @@
+#pragma once
+
+#include "Prerequisites.hpp"
+#include "Device.hpp"
+#include "CommandBuffer.hpp"
+#include "VkRAII.hpp"
+
+#include <deque>
+
+
+namespace ABench {
+namespace Renderer {
+
+using GpuProfilerScope = uint32_t;
+const GpuProfilerScope GPU_PROFILER_INVALID_SCOPE = UINT32_MAX;
+
+struct GpuProfilerDesc
+{
+    uint32_t maxScopes;
+    uint32_t frameLatency; // frames after which timestamps are read back, at least 2
+    uint32_t traceFrames; // how many most recent frames are kept for trace export
+    bool keepSamples; // keep every sample for percentile calculation (ex. in benchmark runs)
+
+    GpuProfilerDesc()
+        : maxScopes(16)
+        , frameLatency(3)
+        , traceFrames(600)
+        , keepSamples(false)
+    {
+    }
+};
+
+struct GpuProfilerTiming
+{
+    uint32_t samples;
+    double avgMs;
+    double minMs;
+    double maxMs;
+};
+
+/**
+ * Per-pass GPU timings gathered with timestamp queries.
+ *
+ * Each scope (usually a Frame Graph node) is bracketed with two tiny Command Buffers, submitted
+ * on the scope's queue right before and after the measured work. Every frame uses its own query
+ * pool and results are read back frameLatency frames later, so the CPU never waits for them.
+ * Scopes on queues without timestamp support are skipped.
+ *
+ * Besides GPU time, each scope can measure CPU time (ex. spent recording the pass) between
+ * BeginCpuScope() and EndCpuScope() - both are aggregated and exported side by side. CPU times
+ * use the time base of Common::Profiler, whose zones are exported to the same trace.
+ *
+ * Trace export places GPU events relative to the CPU time of frame's first submission, since
+ * calibrated timestamps are not available in Vulkan headers used by this project. Begin timestamp
+ * is written at top of pipe, so GPU time includes waiting for semaphores of the batch.
+ *
+ * The profiler is not thread-safe - it should be used from the rendering thread, which also
+ * submits the measured work.
+ */
+class GpuProfiler
+{
+    struct Accumulator
+    {
+        uint32_t samples;
+        double sum;
+        double min;
+        double max;
+        bool keepValues;
+        std::vector<double> values;
+
+        Accumulator();
+        void Add(double value);
+        GpuProfilerTiming Get() const;
+    };
+
+    struct Scope
+    {
+        std::string name;
+        DeviceQueueType queueType;
+        bool supported;
+        uint64_t timestampMask;
+        double cpuStart;
+        Accumulator gpu;
+        Accumulator cpu;
+    };
+
+    struct FrameSlot
+    {
+        VkRAII<VkQueryPool> queryPool;
+        std::vector<std::unique_ptr<CommandBuffer>> beginCommandBuffers;
+        std::vector<std::unique_ptr<CommandBuffer>> endCommandBuffers;
+        std::vector<bool> written;
+        uint64_t frame;
+        double submitTime; // CPU time of first submission, negative if nothing was submitted
+    };
+
+    struct TraceEvent
+    {
+        uint64_t frame;
+        GpuProfilerScope scope; // GPU_PROFILER_INVALID_SCOPE marks whole CPU frame
+        bool gpu;
+        double startUs;
+        double durationUs;
+    };
+
+    DevicePtr mDevice;
+    GpuProfilerDesc mDesc;
+    std::vector<Scope> mScopes;
+    std::vector<FrameSlot> mSlots;
+    std::deque<TraceEvent> mTraceEvents;
+    Accumulator mFrameTime;
+    double mFrameStart;
+    uint64_t mFrame;
+    uint64_t mStatsFrame; // first frame included in aggregated statistics
+    uint32_t mCurrentSlot;
+    uint32_t mDroppedSamples;
+    float mTimestampPeriod; // nanoseconds per timestamp tick
+
+    double GetCpuTime() const; // in microseconds
+    bool InitScopeCommandBuffers(GpuProfilerScope scope);
+    void ResolveSlot(FrameSlot& slot);
+    void TrimTraceEvents();
+
+public:
+    GpuProfiler();
+    ~GpuProfiler();
+
+    bool Init(const DevicePtr& device, const GpuProfilerDesc& desc);
+
+    // Scopes should be registered during initialization, their names are used in exported data
+    GpuProfilerScope AddScope(const std::string& name, DeviceQueueType queueType);
+
+    /**
+     * Records and returns a Command Buffer writing begin/end timestamp of a scope in current
+     * frame, or nullptr if the scope cannot be measured. Submit it on scope's queue, right
+     * before/after the measured work.
+     */
+    CommandBuffer* RecordBegin(GpuProfilerScope scope);
+    CommandBuffer* RecordEnd(GpuProfilerScope scope);
+
+    void BeginCpuScope(GpuProfilerScope scope);
+    void EndCpuScope(GpuProfilerScope scope);
+
+    /**
+     * Starts a new frame, reading back results of the frame which used the same query pool.
+     * Should be called once per frame, after CPU waited for previous frame to finish.
+     */
+    void NextFrame();
+
+    // Reads back all remaining results. Requires the GPU to be idle.
+    void Flush();
+
+    /**
+     * Discards aggregated statistics, ex. gathered during warm-up. GPU results of frames started
+     * before the call are ignored when they are read back later.
+     */
+    void ResetStatistics();
+
+    GpuProfilerTiming GetGpuTiming(GpuProfilerScope scope) const;
+    GpuProfilerTiming GetCpuTiming(GpuProfilerScope scope) const;
+    GpuProfilerTiming GetFrameTiming() const;
+
+    // All samples in milliseconds, available only with keepSamples enabled
+    const std::vector<double>& GetGpuSamples(GpuProfilerScope scope) const;
+    const std::vector<double>& GetCpuSamples(GpuProfilerScope scope) const;
+    const std::vector<double>& GetFrameSamples() const;
+
+    // Aggregated per-scope statistics, one row per scope
+    bool ExportCSV(const std::string& path) const;
+    // Timeline of last traceFrames frames and CPU profiler zones in Chrome trace event format
+    bool ExportTrace(const std::string& path) const;
+
+    ABENCH_INLINE bool IsEnabled() const
+    {
+        return mDevice != nullptr;
+    }
+
+    ABENCH_INLINE uint32_t GetScopeCount() const
+    {
+        return static_cast<uint32_t>(mScopes.size());
+    }
+
+    ABENCH_INLINE const std::string& GetScopeName(GpuProfilerScope scope) const
+    {
+        return mScopes[scope].name;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -12,10 +12,35 @@
 namespace ABench {
 namespace Renderer {
 
+namespace {
+
+bool IsExtensionAvailable(const char* name)
+{
+    uint32_t count = 0;
+    VkResult result = vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+    if (result != VK_SUCCESS)
+        return false;
+
+    std::vector<VkExtensionProperties> extensions(count);
+    result = vkEnumerateInstanceExtensionProperties(nullptr, &count, extensions.data());
+    if (result != VK_SUCCESS)
+        return false;
+
+    for (auto& e: extensions)
+        if (strcmp(e.extensionName, name) == 0)
+            return true;
+
+    return false;
+}
+
+} // namespace
+
 Instance::Instance()
     : mInstance(VK_NULL_HANDLE)
     , mVulkanLibrary()
     , mDebuggingEnabled(false)
+    , mHeadless(false)
+    , mPhysicalDeviceProperties2(false)
 {
 }
 
@@ -27,7 +52,7 @@ Instance::~Instance()
         vkDestroyInstance(mInstance, nullptr);
 }
 
-bool Instance::Init(VkDebugReportFlagsEXT debugFlags)
+bool Instance::Init(VkDebugReportFlagsEXT debugFlags, bool headless)
 {
     if (mInstance)
         return true; // already initialized
@@ -63,7 +88,6 @@ bool Instance::Init(VkDebugReportFlagsEXT debugFlags)
     appInfo.applicationVersion = 1;
 
     std::vector<const char*> enabledExtensions;
-    enabledExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 
     if (debugFlags)
     {
@@ -71,13 +95,22 @@ bool Instance::Init(VkDebugReportFlagsEXT debugFlags)
         enabledExtensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
     }
 
+    if (!headless)
+    {
+        enabledExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #ifdef WIN32
-    enabledExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+        enabledExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #elif defined(__linux__) | defined(__LINUX__)
-    enabledExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
+        enabledExtensions.push_back(VK_KHR_XCB_SURFACE_EXTENSION_NAME);
 #else
     #error "Target platform not supported."
 #endif
+    }
+
+    // needed to query memory budget of the Device
+    mPhysicalDeviceProperties2 = IsExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    if (mPhysicalDeviceProperties2)
+        enabledExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
     const char* enabledLayers[] = {
         "VK_LAYER_LUNARG_standard_validation"
@@ -90,13 +123,17 @@ bool Instance::Init(VkDebugReportFlagsEXT debugFlags)
     instInfo.pApplicationInfo = &appInfo;
     instInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
     instInfo.ppEnabledExtensionNames = enabledExtensions.data();
-    instInfo.enabledLayerCount = 1;
-    instInfo.ppEnabledLayerNames = enabledLayers;
+    if (debugFlags)
+    {
+        // validation layer might be missing outside of development machines
+        instInfo.enabledLayerCount = 1;
+        instInfo.ppEnabledLayerNames = enabledLayers;
+    }
 
     VkResult result = vkCreateInstance(&instInfo, nullptr, &mInstance);
     RETURN_FALSE_IF_FAILED(result, "Failed to create Vulkan Instance");
 
-    if (!InitInstanceExtensions(mInstance))
+    if (!InitInstanceExtensions(mInstance, headless))
     {
         LOGE("Failed to initialize all Instance extensions");
         return false;
@@ -110,6 +147,10 @@ bool Instance::Init(VkDebugReportFlagsEXT debugFlags)
         mDebuggingEnabled = true;
     }
 
+    mHeadless = headless;
+    if (mHeadless)
+        LOGI("Vulkan Instance is headless - presenting on screen is unavailable");
+
     LOGI("Vulkan Instance initialized successfully");
     return true;
 }
@@ -124,5 +165,15 @@ bool Instance::IsDebuggingEnabled() const
     return mDebuggingEnabled;
 }
 
+bool Instance::IsHeadless() const
+{
+    return mHeadless;
+}
+
+bool Instance::HasPhysicalDeviceProperties2() const
+{
+    return mPhysicalDeviceProperties2;
+}
+
 } // namespace Renderer
 } // namespace ABench
@@ -16,14 +16,20 @@ class Instance
     VkInstance mInstance;
     Common::Library mVulkanLibrary;
     bool mDebuggingEnabled;
+    bool mHeadless;
+    bool mPhysicalDeviceProperties2;
 
 public:
     Instance();
     ~Instance();
 
-    bool Init(VkDebugReportFlagsEXT debugFlags = 0);
+    // Headless Instance does not enable surface extensions - it can only render offscreen
+    bool Init(VkDebugReportFlagsEXT debugFlags = 0, bool headless = false);
     const VkInstance& GetVkInstance() const;
     bool IsDebuggingEnabled() const;
+    bool IsHeadless() const;
+    // VK_KHR_get_physical_device_properties2 is enabled only when available
+    bool HasPhysicalDeviceProperties2() const;
 };
 
 using InstancePtr = std::shared_ptr<Instance>;
@@ -0,0 +1,226 @@
+#include "PCH.hpp"
+#include "MemoryStatistics.hpp"
+#include "Extensions.hpp"
+
+#include "Common/Common.hpp"
+#include "Common/Logger.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+namespace {
+
+const char* UNOWNED_MEMORY_NAME = "Unowned";
+
+} // namespace
+
+MemoryStatistics::MemoryStatistics()
+    : mPhysicalDevice(VK_NULL_HANDLE)
+    , mMemoryProperties()
+    , mBudgetAvailable(false)
+    , mMutex()
+    , mAllocations()
+    , mThreadOwners()
+    , mTypes()
+    , mOwners()
+    , mRingBuffers()
+{
+    for (auto& o: mObjects)
+        o.store(0, std::memory_order_relaxed);
+}
+
+MemoryStatistics::~MemoryStatistics()
+{
+    if (!mAllocations.empty())
+        LOGW(mAllocations.size() << " Device memory allocations were not freed");
+}
+
+void MemoryStatistics::Init(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceMemoryProperties& memoryProperties,
+                            bool budgetAvailable)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    mPhysicalDevice = physicalDevice;
+    mMemoryProperties = memoryProperties;
+    mBudgetAvailable = budgetAvailable && (vkGetPhysicalDeviceMemoryProperties2KHR != VK_NULL_HANDLE);
+
+    mTypes.resize(mMemoryProperties.memoryTypeCount);
+    for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i)
+    {
+        mTypes[i].flags = mMemoryProperties.memoryTypes[i].propertyFlags;
+        mTypes[i].heapIndex = mMemoryProperties.memoryTypes[i].heapIndex;
+    }
+
+    mOwners.resize(1);
+    mOwners[0].name = UNOWNED_MEMORY_NAME;
+}
+
+uint32_t MemoryStatistics::GetOwner(const std::string& name)
+{
+    for (uint32_t i = 0; i < mOwners.size(); ++i)
+        if (mOwners[i].name == name)
+            return i;
+
+    MemoryOwnerStatistics owner;
+    owner.name = name;
+    mOwners.push_back(owner);
+    return static_cast<uint32_t>(mOwners.size() - 1);
+}
+
+void MemoryStatistics::OnAllocate(VkDeviceMemory memory, uint32_t typeIndex, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (typeIndex >= mTypes.size())
+    {
+        LOGW("Allocation of " << size << " bytes from unknown memory type " << typeIndex << " is not tracked");
+        return;
+    }
+
+    Allocation allocation;
+    allocation.type = typeIndex;
+    allocation.owner = 0;
+    allocation.size = size;
+
+    auto ownerIt = mThreadOwners.find(std::this_thread::get_id());
+    if (ownerIt != mThreadOwners.end() && !ownerIt->second.empty())
+        allocation.owner = ownerIt->second.back();
+
+    mAllocations[memory] = allocation;
+
+    MemoryTypeStatistics& type = mTypes[typeIndex];
+    type.allocations++;
+    type.bytes += size;
+    type.peakBytes = std::max(type.peakBytes, type.bytes);
+
+    MemoryOwnerStatistics& owner = mOwners[allocation.owner];
+    owner.allocations++;
+    owner.bytes += size;
+    owner.peakBytes = std::max(owner.peakBytes, owner.bytes);
+}
+
+void MemoryStatistics::OnFree(VkDeviceMemory memory)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mAllocations.find(memory);
+    if (it == mAllocations.end())
+        return;
+
+    const Allocation& allocation = it->second;
+
+    MemoryTypeStatistics& type = mTypes[allocation.type];
+    type.allocations--;
+    type.bytes -= allocation.size;
+
+    MemoryOwnerStatistics& owner = mOwners[allocation.owner];
+    owner.allocations--;
+    owner.bytes -= allocation.size;
+
+    mAllocations.erase(it);
+}
+
+void MemoryStatistics::PushOwner(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mOwners.empty())
+    {
+        mOwners.resize(1);
+        mOwners[0].name = UNOWNED_MEMORY_NAME;
+    }
+
+    mThreadOwners[std::this_thread::get_id()].push_back(GetOwner(name));
+}
+
+void MemoryStatistics::PopOwner()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = mThreadOwners.find(std::this_thread::get_id());
+    ASSERT(it != mThreadOwners.end() && !it->second.empty(), "PopOwner() called without matching PushOwner()");
+
+    it->second.pop_back();
+    if (it->second.empty())
+        mThreadOwners.erase(it);
+}
+
+uint32_t MemoryStatistics::RegisterRingBuffer(const std::string& name, VkDeviceSize size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    RingBufferStatistics ringBuffer;
+    ringBuffer.name = name;
+    ringBuffer.size = size;
+    mRingBuffers.push_back(ringBuffer);
+    return static_cast<uint32_t>(mRingBuffers.size() - 1);
+}
+
+void MemoryStatistics::ReportRingBufferFrame(uint32_t id, VkDeviceSize reservedBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (id >= mRingBuffers.size())
+        return;
+
+    RingBufferStatistics& ringBuffer = mRingBuffers[id];
+    ringBuffer.lastFrameBytes = reservedBytes;
+    ringBuffer.highWaterBytes = std::max(ringBuffer.highWaterBytes, reservedBytes);
+}
+
+MemoryStatisticsSnapshot MemoryStatistics::Capture(bool queryBudget) const
+{
+    MemoryStatisticsSnapshot snapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        snapshot.types = mTypes;
+        snapshot.owners = mOwners;
+        snapshot.ringBuffers = mRingBuffers;
+        snapshot.allocations = static_cast<uint32_t>(mAllocations.size());
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(TrackedObject::Count); ++i)
+        snapshot.objects[i] = mObjects[i].load(std::memory_order_relaxed);
+
+    snapshot.heaps.resize(mMemoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i)
+    {
+        snapshot.heaps[i].flags = mMemoryProperties.memoryHeaps[i].flags;
+        snapshot.heaps[i].size = mMemoryProperties.memoryHeaps[i].size;
+    }
+
+    for (auto& t: snapshot.types)
+    {
+        snapshot.heaps[t.heapIndex].bytes += t.bytes;
+        snapshot.bytes += t.bytes;
+    }
+
+    if (queryBudget && mBudgetAvailable)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget;
+        ZERO_MEMORY(budget);
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2KHR properties;
+        ZERO_MEMORY(properties);
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        properties.pNext = &budget;
+        vkGetPhysicalDeviceMemoryProperties2KHR(mPhysicalDevice, &properties);
+
+        for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; ++i)
+        {
+            snapshot.heaps[i].budget = budget.heapBudget[i];
+            snapshot.heaps[i].usage = budget.heapUsage[i];
+        }
+
+        snapshot.budgetAvailable = true;
+    }
+
+    return snapshot;
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "Prerequisites.hpp"
+#include "Common/Common.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+enum class TrackedObject: unsigned char
+{
+    Buffer = 0,
+    Image,
+    DescriptorPool,
+    DescriptorSet,
+    Count
+};
+
+struct MemoryTypeStatistics
+{
+    VkMemoryPropertyFlags flags;
+    uint32_t heapIndex;
+    uint32_t allocations;
+    VkDeviceSize bytes;
+    VkDeviceSize peakBytes;
+
+    MemoryTypeStatistics()
+        : flags(0)
+        , heapIndex(0)
+        , allocations(0)
+        , bytes(0)
+        , peakBytes(0)
+    {
+    }
+};
+
+struct MemoryHeapStatistics
+{
+    VkMemoryHeapFlags flags;
+    VkDeviceSize size;
+    VkDeviceSize bytes; // allocated by us, from all memory types of the heap
+    VkDeviceSize budget; // from VK_EXT_memory_budget, 0 if not available
+    VkDeviceSize usage; // whole process usage reported by the driver, 0 if not available
+
+    MemoryHeapStatistics()
+        : flags(0)
+        , size(0)
+        , bytes(0)
+        , budget(0)
+        , usage(0)
+    {
+    }
+};
+
+// Memory allocated while an owner scope was active (ex. during Init of a pass)
+struct MemoryOwnerStatistics
+{
+    std::string name;
+    uint32_t allocations;
+    VkDeviceSize bytes;
+    VkDeviceSize peakBytes;
+
+    MemoryOwnerStatistics()
+        : name()
+        , allocations(0)
+        , bytes(0)
+        , peakBytes(0)
+    {
+    }
+};
+
+struct RingBufferStatistics
+{
+    std::string name;
+    VkDeviceSize size;
+    VkDeviceSize lastFrameBytes; // reserved during last finished frame
+    VkDeviceSize highWaterBytes; // most reserved during a single frame
+
+    RingBufferStatistics()
+        : name()
+        , size(0)
+        , lastFrameBytes(0)
+        , highWaterBytes(0)
+    {
+    }
+};
+
+struct MemoryStatisticsSnapshot
+{
+    std::vector<MemoryTypeStatistics> types;
+    std::vector<MemoryHeapStatistics> heaps;
+    std::vector<MemoryOwnerStatistics> owners;
+    std::vector<RingBufferStatistics> ringBuffers;
+    uint32_t objects[static_cast<size_t>(TrackedObject::Count)];
+    uint32_t allocations;
+    VkDeviceSize bytes;
+    bool budgetAvailable;
+
+    MemoryStatisticsSnapshot()
+        : types()
+        , heaps()
+        , owners()
+        , ringBuffers()
+        , allocations(0)
+        , bytes(0)
+        , budgetAvailable(false)
+    {
+        for (auto& o: objects)
+            o = 0;
+    }
+};
+
+/**
+ * Counts Vulkan memory and objects created by low-level wrappers.
+ *
+ * Every VkDeviceMemory allocation goes through Device::AllocateMemory()/FreeMemory(), which
+ * report here - counts and bytes are kept per memory type, and per owner which was active on
+ * the allocating thread (see MemoryOwnerScope). Ring Buffers report how much they reserved in
+ * each frame, so their size can be tuned against the high-water mark.
+ *
+ * Driver-side budget and usage of heaps are available only with VK_EXT_memory_budget.
+ */
+class MemoryStatistics
+{
+    struct Allocation
+    {
+        uint32_t type;
+        uint32_t owner;
+        VkDeviceSize size;
+    };
+
+    VkPhysicalDevice mPhysicalDevice;
+    VkPhysicalDeviceMemoryProperties mMemoryProperties;
+    bool mBudgetAvailable;
+
+    mutable std::mutex mMutex;
+    std::unordered_map<VkDeviceMemory, Allocation> mAllocations;
+    std::unordered_map<std::thread::id, std::vector<uint32_t>> mThreadOwners;
+    std::vector<MemoryTypeStatistics> mTypes;
+    std::vector<MemoryOwnerStatistics> mOwners; // first one collects allocations without owner
+    std::vector<RingBufferStatistics> mRingBuffers;
+    std::atomic<uint32_t> mObjects[static_cast<size_t>(TrackedObject::Count)];
+
+    uint32_t GetOwner(const std::string& name);
+
+public:
+    MemoryStatistics();
+    ~MemoryStatistics();
+
+    void Init(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceMemoryProperties& memoryProperties,
+              bool budgetAvailable);
+
+    void OnAllocate(VkDeviceMemory memory, uint32_t typeIndex, VkDeviceSize size);
+    void OnFree(VkDeviceMemory memory);
+
+    ABENCH_INLINE void OnCreate(TrackedObject object, uint32_t count = 1)
+    {
+        mObjects[static_cast<size_t>(object)].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    ABENCH_INLINE void OnDestroy(TrackedObject object, uint32_t count = 1)
+    {
+        mObjects[static_cast<size_t>(object)].fetch_sub(count, std::memory_order_relaxed);
+    }
+
+    // Owners nest per thread - allocations are assigned to the innermost one
+    void PushOwner(const std::string& name);
+    void PopOwner();
+
+    // Returns an ID for ReportRingBufferFrame()
+    uint32_t RegisterRingBuffer(const std::string& name, VkDeviceSize size);
+    void ReportRingBufferFrame(uint32_t id, VkDeviceSize reservedBytes);
+
+    // Budget query goes to the driver, so it can be skipped when sampling every frame
+    MemoryStatisticsSnapshot Capture(bool queryBudget = true) const;
+
+    ABENCH_INLINE bool IsBudgetAvailable() const
+    {
+        return mBudgetAvailable;
+    }
+};
+
+// Assigns allocations made by current thread to given owner, until the scope ends
+class MemoryOwnerScope
+{
+    MemoryStatistics& mStatistics;
+
+public:
+    MemoryOwnerScope(MemoryStatistics& statistics, const std::string& name)
+        : mStatistics(statistics)
+    {
+        mStatistics.PushOwner(name);
+    }
+
+    ~MemoryOwnerScope()
+    {
+        mStatistics.PopOwner();
+    }
+
+    MemoryOwnerScope(const MemoryOwnerScope&) = delete;
+    MemoryOwnerScope& operator=(const MemoryOwnerScope&) = delete;
+};
+
+} // namespace Renderer
+} // namespace ABench
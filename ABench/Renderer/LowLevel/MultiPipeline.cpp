@@ -3,16 +3,34 @@
 
 #include "Common/Logger.hpp"
 
+#include <algorithm>
+
 
 namespace ABench {
 namespace Renderer {
 
+namespace {
+
+// limits the Pipeline table to 64k entries
+const uint32_t MAX_KEY_BITS = 16;
+
+} // namespace
+
 MultiPipeline::MultiPipeline()
+    : mKeyBits(0)
+    , mPipelineHandles()
+    , mPipelineStates()
+    , mPipelines()
+    , mFallbackPipeline(VK_NULL_HANDLE)
+    , mCompileThreadPool(nullptr)
+    , mPendingPrecompiles(0)
 {
 }
 
 MultiPipeline::~MultiPipeline()
 {
+    // tasks on worker threads still refer to this object
+    WaitForPrecompile();
 }
 
 uint32_t MultiPipeline::CalculateAllCombinations(const MultiPipelineShaderMacroLimits& macros)
@@ -82,36 +100,269 @@ bool MultiPipeline::GenerateShaderModules(const MultiPipelineShaderDesc& desc, S
     return true;
 }
 
+Shader* MultiPipeline::FindShader(const ShaderMap& map, const ShaderMacros& comb) const
+{
+    auto shader = map.find(comb);
+    if (shader == map.end())
+        return nullptr;
+
+    return shader->second.get();
+}
+
+bool MultiPipeline::InitKeyLayout(ShaderType stage, const MultiPipelineShaderDesc& desc)
+{
+    MacroLayout& layout = mLayouts[static_cast<size_t>(stage)];
+    layout.clear();
+
+    for (auto& m: desc.macros)
+    {
+        uint32_t bits = 0;
+        while ((1u << bits) <= m.maxValue)
+            bits++;
+
+        if (mKeyBits + bits > MAX_KEY_BITS)
+        {
+            LOGE("Macros declared for " << desc.path << " do not fit in " << MAX_KEY_BITS << "-bit Pipeline key");
+            return false;
+        }
+
+        MacroField field;
+        field.name = m.name;
+        field.maxValue = m.maxValue;
+        field.shift = mKeyBits;
+        field.bits = bits;
+        layout.push_back(field);
+
+        mKeyBits += bits;
+    }
+
+    return true;
+}
+
+void MultiPipeline::InitPipelineTable()
+{
+    uint32_t size = 1u << mKeyBits;
+
+    mPipelineHandles.reset(new std::atomic<VkPipeline>[size]);
+    mPipelineStates.reset(new std::atomic<uint8_t>[size]);
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        mPipelineHandles[i].store(VK_NULL_HANDLE, std::memory_order_relaxed);
+        mPipelineStates[i].store(STATE_MISSING, std::memory_order_relaxed);
+    }
+
+    mPipelines.clear();
+    mPipelines.resize(size);
+}
+
+MultiPipelineKey MultiPipeline::EncodeMacros(ShaderType stage, const ShaderMacros& comb) const
+{
+    const MacroLayout& layout = mLayouts[static_cast<size_t>(stage)];
+    MultiPipelineKey key = 0;
+
+    for (auto& m: comb)
+    {
+        auto field = std::find_if(layout.begin(), layout.end(), [&m](const MacroField& f) {
+            return f.name == m.name;
+        });
+
+        if (field == layout.end())
+        {
+            LOGW("Macro " << m.name << " was not declared for this MultiPipeline - ignoring");
+            continue;
+        }
+
+        if (m.value > field->maxValue)
+        {
+            LOGE("Value " << m.value << " of macro " << m.name << " exceeds declared maximum " << field->maxValue);
+            continue;
+        }
+
+        key |= m.value << field->shift;
+    }
+
+    return key;
+}
+
+ShaderMacros MultiPipeline::DecodeMacros(ShaderType stage, MultiPipelineKey key) const
+{
+    ShaderMacros comb;
+
+    // declaration order is kept, so decoded macros match the ones used to generate Shader modules
+    for (auto& f: mLayouts[static_cast<size_t>(stage)])
+        comb.emplace_back(f.name, (key >> f.shift) & ((1u << f.bits) - 1));
+
+    return comb;
+}
+
+bool MultiPipeline::IsKeyValid(MultiPipelineKey key) const
+{
+    if (key >= (1u << mKeyBits))
+        return false;
+
+    for (auto& layout: mLayouts)
+        for (auto& f: layout)
+            if (((key >> f.shift) & ((1u << f.bits) - 1)) > f.maxValue)
+                return false;
+
+    return true;
+}
+
 PipelinePtr MultiPipeline::GenerateNewPipeline(const MultiGraphicsPipelineShaderMacros& comb)
 {
-    PipelinePtr p = std::make_shared<Pipeline>();
+    GraphicsPipelineDesc desc = mBaseGraphicsPipeline.desc;
+    desc.vertexShader = FindShader(mVertexShaders, comb.vertexShader);
+    desc.tessControlShader = FindShader(mTessControlShaders, comb.tessControlShader);
+    desc.tessEvalShader = FindShader(mTessEvalShaders, comb.tessEvalShader);
+    desc.geometryShader = FindShader(mGeometryShaders, comb.geometryShader);
+    desc.fragmentShader = FindShader(mFragmentShaders, comb.fragmentShader);
+
+    if ((!mVertexShaders.empty() && desc.vertexShader == nullptr) ||
+        (!mTessControlShaders.empty() && desc.tessControlShader == nullptr) ||
+        (!mTessEvalShaders.empty() && desc.tessEvalShader == nullptr) ||
+        (!mGeometryShaders.empty() && desc.geometryShader == nullptr) ||
+        (!mFragmentShaders.empty() && desc.fragmentShader == nullptr))
+    {
+        LOGE("Requested shader macro combination has no matching Shader module");
+        return nullptr;
+    }
 
-    mBaseGraphicsPipeline.desc.vertexShader = mVertexShaders[comb.vertexShader].get();
-    mBaseGraphicsPipeline.desc.tessControlShader = mTessControlShaders[comb.tessControlShader].get();
-    mBaseGraphicsPipeline.desc.tessEvalShader = mTessEvalShaders[comb.tessEvalShader].get();
-    mBaseGraphicsPipeline.desc.geometryShader = mGeometryShaders[comb.geometryShader].get();
-    mBaseGraphicsPipeline.desc.fragmentShader = mFragmentShaders[comb.fragmentShader].get();
-    p->Init(mDevice, mBaseGraphicsPipeline.desc);
+    PipelinePtr p = std::make_shared<Pipeline>();
+    if (!p->Init(mDevice, desc))
+        return nullptr;
 
     return p;
 }
 
 PipelinePtr MultiPipeline::GenerateNewPipeline(const ShaderMacros& comb)
 {
+    ComputePipelineDesc desc = mBaseComputePipeline.desc;
+    desc.computeShader = FindShader(mComputeShaders, comb);
+    if (desc.computeShader == nullptr)
+    {
+        LOGE("Requested shader macro combination has no matching Shader module");
+        return nullptr;
+    }
+
     PipelinePtr p = std::make_shared<Pipeline>();
+    if (!p->Init(mDevice, desc))
+        return nullptr;
+
+    return p;
+}
 
-    mBaseComputePipeline.desc.computeShader = mComputeShaders[comb].get();
+void MultiPipeline::BuildPipeline(MultiPipelineKey key)
+{
+    PipelinePtr p;
+    if (!mComputeShaders.empty())
+    {
+        p = GenerateNewPipeline(DecodeMacros(ShaderType::COMPUTE, key));
+    }
+    else
+    {
+        MultiGraphicsPipelineShaderMacros comb;
+        comb.vertexShader = DecodeMacros(ShaderType::VERTEX, key);
+        comb.tessControlShader = DecodeMacros(ShaderType::TESS_CONTROL, key);
+        comb.tessEvalShader = DecodeMacros(ShaderType::TESS_EVAL, key);
+        comb.geometryShader = DecodeMacros(ShaderType::GEOMETRY, key);
+        comb.fragmentShader = DecodeMacros(ShaderType::FRAGMENT, key);
+        p = GenerateNewPipeline(comb);
+    }
 
-    p->Init(mDevice, mBaseComputePipeline.desc);
+    if (!p)
+    {
+        LOGE("Failed to create Pipeline for key " << key);
+        mPipelineStates[key].store(STATE_FAILED, std::memory_order_release);
+        return;
+    }
 
-    return p;
+    // only the thread which moved the key to STATE_BUILDING gets here, so the slot is not shared
+    mPipelines[key] = p;
+    mPipelineHandles[key].store(p->GetPipeline(), std::memory_order_release);
+    mPipelineStates[key].store(STATE_READY, std::memory_order_release);
+}
+
+VkPipeline MultiPipeline::RequestGraphicsPipeline(MultiPipelineKey key)
+{
+    if (!IsKeyValid(key))
+    {
+        LOGE("Requested Graphics Pipeline with invalid key " << key);
+        return mFallbackPipeline;
+    }
+
+    uint8_t expected = STATE_MISSING;
+    if (mPipelineStates[key].compare_exchange_strong(expected, STATE_BUILDING, std::memory_order_acq_rel))
+    {
+        // built on the compile pool - recording thread continues with fallback and never waits for it
+        if (mCompileThreadPool != nullptr)
+        {
+            AddPrecompileTask(mCompileThreadPool, [this, key]() {
+                BuildPipeline(key);
+            });
+        }
+        else
+        {
+            BuildPipeline(key);
+            VkPipeline pipeline = mPipelineHandles[key].load(std::memory_order_acquire);
+            if (pipeline != VK_NULL_HANDLE)
+                return pipeline;
+        }
+    }
+
+    // Pipeline is being created somewhere else (or failed to) - draw with fallback in the meantime
+    return mFallbackPipeline;
+}
+
+VkPipeline MultiPipeline::RequestComputePipeline(MultiPipelineKey key)
+{
+    if (!IsKeyValid(key))
+    {
+        LOGE("Requested Compute Pipeline with invalid key " << key);
+        return VK_NULL_HANDLE;
+    }
+
+    // there is no sensible fallback for a dispatch, so wait for the Pipeline instead
+    uint8_t expected = STATE_MISSING;
+    if (mPipelineStates[key].compare_exchange_strong(expected, STATE_BUILDING, std::memory_order_acq_rel))
+        BuildPipeline(key);
+    else
+        while (mPipelineStates[key].load(std::memory_order_acquire) == STATE_BUILDING)
+            std::this_thread::yield();
+
+    return mPipelineHandles[key].load(std::memory_order_acquire);
+}
+
+void MultiPipeline::AddPrecompileTask(Common::ThreadPool* threadPool, const std::function<void()>& task)
+{
+    if (threadPool == nullptr)
+    {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mPrecompileMutex);
+        mPendingPrecompiles++;
+    }
+
+    threadPool->AddTask([this, task]() {
+        task();
+
+        std::lock_guard<std::mutex> lock(mPrecompileMutex);
+        mPendingPrecompiles--;
+        if (mPendingPrecompiles == 0)
+            mPrecompileFinished.notify_all();
+    });
 }
 
 bool MultiPipeline::Init(const DevicePtr& device, const MultiGraphicsPipelineDesc& desc)
 {
-    mDevice = device;
+    WaitForPrecompile();
 
-    mGraphicsPipelines.clear();
+    mDevice = device;
+    mCompileThreadPool = nullptr;
+    mFallbackPipeline = VK_NULL_HANDLE;
+    mComputeShaders.clear();
 
     if (desc.vertexShader.path.empty())
     {
@@ -119,12 +370,24 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiGraphicsPipelineDes
         return false;
     }
 
+    mKeyBits = 0;
+    for (auto& layout: mLayouts)
+        layout.clear();
+
+    if (!InitKeyLayout(ShaderType::VERTEX, desc.vertexShader) ||
+        !InitKeyLayout(ShaderType::TESS_CONTROL, desc.tessControlShader) ||
+        !InitKeyLayout(ShaderType::TESS_EVAL, desc.tessEvalShader) ||
+        !InitKeyLayout(ShaderType::GEOMETRY, desc.geometryShader) ||
+        !InitKeyLayout(ShaderType::FRAGMENT, desc.fragmentShader))
+        return false;
+
     if (!GenerateShaderModules(desc.vertexShader, ShaderType::VERTEX, &mVertexShaders))
     {
         LOGE("Failed to generate vertex shader modules for MultiPipeline");
         return false;
     }
 
+    mTessControlShaders.clear();
     if (!desc.tessControlShader.path.empty())
     {
         if (!GenerateShaderModules(desc.tessControlShader, ShaderType::TESS_CONTROL, &mTessControlShaders))
@@ -134,6 +397,7 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiGraphicsPipelineDes
         }
     }
 
+    mTessEvalShaders.clear();
     if (!desc.tessEvalShader.path.empty())
     {
         if (!GenerateShaderModules(desc.tessEvalShader, ShaderType::TESS_EVAL, &mTessEvalShaders))
@@ -143,6 +407,7 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiGraphicsPipelineDes
         }
     }
 
+    mGeometryShaders.clear();
     if (!desc.geometryShader.path.empty())
     {
         if (!GenerateShaderModules(desc.geometryShader, ShaderType::GEOMETRY, &mGeometryShaders))
@@ -152,6 +417,7 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiGraphicsPipelineDes
         }
     }
 
+    mFragmentShaders.clear();
     if (!desc.fragmentShader.path.empty())
     {
         if (!GenerateShaderModules(desc.fragmentShader, ShaderType::FRAGMENT, &mFragmentShaders))
@@ -185,14 +451,32 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiGraphicsPipelineDes
     mBaseGraphicsPipeline.desc.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
     mBaseGraphicsPipeline.desc.basePipeline = mBaseGraphicsPipeline.pipeline.GetPipeline();
 
+    // fallback has to be available right away - it is used while other variants are created
+    InitPipelineTable();
+    mPipelineStates[0].store(STATE_BUILDING, std::memory_order_relaxed);
+    BuildPipeline(0);
+    mFallbackPipeline = mPipelineHandles[0].load(std::memory_order_acquire);
+    if (mFallbackPipeline == VK_NULL_HANDLE)
+    {
+        LOGE("Failed to create fallback Graphics Pipeline");
+        return false;
+    }
+
     return true;
 }
 
 bool MultiPipeline::Init(const DevicePtr& device, const MultiComputePipelineDesc& desc)
 {
-    mDevice = device;
+    WaitForPrecompile();
 
-    mComputePipelines.clear();
+    mDevice = device;
+    mCompileThreadPool = nullptr;
+    mFallbackPipeline = VK_NULL_HANDLE;
+    mVertexShaders.clear();
+    mTessControlShaders.clear();
+    mTessEvalShaders.clear();
+    mGeometryShaders.clear();
+    mFragmentShaders.clear();
 
     if (desc.computeShader.path.empty())
     {
@@ -200,6 +484,13 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiComputePipelineDesc
         return false;
     }
 
+    mKeyBits = 0;
+    for (auto& layout: mLayouts)
+        layout.clear();
+
+    if (!InitKeyLayout(ShaderType::COMPUTE, desc.computeShader))
+        return false;
+
     if (!GenerateShaderModules(desc.computeShader, ShaderType::COMPUTE, &mComputeShaders))
     {
         LOGE("Failed to generate compute shader modules for MultiPipeline");
@@ -225,54 +516,60 @@ bool MultiPipeline::Init(const DevicePtr& device, const MultiComputePipelineDesc
     mBaseComputePipeline.desc.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
     mBaseComputePipeline.desc.basePipeline = mBaseComputePipeline.pipeline.GetPipeline();
 
+    InitPipelineTable();
     return true;
 }
 
-VkPipeline MultiPipeline::GetGraphicsPipeline(const MultiGraphicsPipelineShaderMacros& combs)
+MultiPipelineKey MultiPipeline::GetGraphicsKey(const MultiGraphicsPipelineShaderMacros& combs) const
 {
-    // TODO this needs some rethinking. It might turn out that mixing shaders like this is a bad idea,
-    // and will lead to conflicts (will it? we are using one set of shaders with MultiPipeline anyway...)
-    ShaderMacros macros;
-    macros.insert(macros.end(), combs.vertexShader.begin(), combs.vertexShader.end());
-    macros.insert(macros.end(), combs.tessControlShader.begin(), combs.tessControlShader.end());
-    macros.insert(macros.end(), combs.tessEvalShader.begin(), combs.tessEvalShader.end());
-    macros.insert(macros.end(), combs.geometryShader.begin(), combs.geometryShader.end());
-    macros.insert(macros.end(), combs.fragmentShader.begin(), combs.fragmentShader.end());
-
-    auto pipeline = mGraphicsPipelines.find(macros);
-    if (pipeline == mGraphicsPipelines.end())
-    {
-        PipelinePtr p = GenerateNewPipeline(combs);
-        auto result = mGraphicsPipelines.insert(std::make_pair(macros, p));
-        if (!result.second)
-        {
-            LOGE("Failed to create new Graphics Pipeline");
-            return VK_NULL_HANDLE;
-        }
+    return EncodeMacros(ShaderType::VERTEX, combs.vertexShader) |
+           EncodeMacros(ShaderType::TESS_CONTROL, combs.tessControlShader) |
+           EncodeMacros(ShaderType::TESS_EVAL, combs.tessEvalShader) |
+           EncodeMacros(ShaderType::GEOMETRY, combs.geometryShader) |
+           EncodeMacros(ShaderType::FRAGMENT, combs.fragmentShader);
+}
 
-        pipeline = result.first;
-    }
+MultiPipelineKey MultiPipeline::GetComputeKey(const ShaderMacros& comb) const
+{
+    return EncodeMacros(ShaderType::COMPUTE, comb);
+}
 
-    return pipeline->second->GetPipeline();
+MultiPipelineKey MultiPipeline::GetMacroKey(ShaderType stage, const std::string& name, uint32_t value) const
+{
+    ShaderMacros comb;
+    comb.emplace_back(name, value);
+    return EncodeMacros(stage, comb);
 }
 
-VkPipeline MultiPipeline::GetComputePipeline(const ShaderMacros& comb)
+void MultiPipeline::Precompile(Common::ThreadPool* threadPool)
 {
-    auto pipeline = mComputePipelines.find(comb);
-    if (pipeline == mComputePipelines.end())
+    // further misses of Graphics Pipelines will be handled on the same Thread Pool
+    mCompileThreadPool = threadPool;
+
+    uint32_t scheduled = 0;
+    uint32_t size = 1u << mKeyBits;
+    for (MultiPipelineKey key = 0; key < size; ++key)
     {
-        PipelinePtr p = GenerateNewPipeline(comb);
-        auto result = mComputePipelines.insert(std::make_pair(comb, p));
-        if (!result.second)
-        {
-            LOGE("Failed to create new Compute Pipeline");
-            return VK_NULL_HANDLE;
-        }
+        if (!IsKeyValid(key))
+            continue;
 
-        pipeline = result.first;
+        uint8_t expected = STATE_MISSING;
+        if (!mPipelineStates[key].compare_exchange_strong(expected, STATE_BUILDING, std::memory_order_acq_rel))
+            continue;
+
+        AddPrecompileTask(threadPool, [this, key]() {
+            BuildPipeline(key);
+        });
+        scheduled++;
     }
 
-    return pipeline->second->GetPipeline();
+    LOGD("Scheduled precompilation of " << scheduled << " Pipelines");
+}
+
+void MultiPipeline::WaitForPrecompile()
+{
+    std::unique_lock<std::mutex> lock(mPrecompileMutex);
+    mPrecompileFinished.wait(lock, [this]() { return mPendingPrecompiles == 0; });
 }
 
 } // namespace Renderer
@@ -2,6 +2,8 @@
 
 #include "Pipeline.hpp"
 
+#include "Common/ThreadPool.hpp"
+
 namespace ABench {
 namespace Renderer {
 
@@ -19,9 +21,11 @@ struct MultiPipelineShaderMacroDesc
 };
 
 using MultiPipelineShaderMacroLimits = std::vector<MultiPipelineShaderMacroDesc>;
-using PipelineMap = std::map<ShaderMacros, PipelinePtr>;
 using ShaderMap = std::map<ShaderMacros, ShaderPtr>;
 
+// Compact identifier of a macro combination - each declared macro occupies a bit field
+using MultiPipelineKey = uint32_t;
+
 struct MultiPipelineShaderDesc
 {
     std::string path;
@@ -55,18 +59,43 @@ struct MultiComputePipelineDesc
     ComputePipelineDesc pipelineDesc; // shader from this desc is ignored
 };
 
+/**
+ * A set of Pipelines created from all combinations of shader macros.
+ *
+ * Macro combinations are translated to a MultiPipelineKey. Each declared macro gets a bit field
+ * wide enough to hold its maximum value, in stage order (vertex, tess control, tess eval,
+ * geometry, fragment). Keys directly index a table of VkPipeline handles, so acquiring a ready
+ * Pipeline is a single atomic load, safe to do from multiple recording threads.
+ *
+ * Missing Graphics Pipelines are created on the compile Thread Pool provided to Precompile(),
+ * so recording never waits for them. Until they are ready, a fallback Pipeline (all macros set
+ * to 0, created on Init) is returned.
+ * Compute Pipelines are never substituted - missing ones are created on calling thread.
+ */
 class MultiPipeline
 {
+    enum PipelineState: uint8_t
+    {
+        STATE_MISSING = 0,
+        STATE_BUILDING,
+        STATE_READY,
+        STATE_FAILED,
+    };
+
+    struct MacroField
+    {
+        std::string name;
+        uint32_t maxValue;
+        uint32_t shift;
+        uint32_t bits;
+    };
+
+    using MacroLayout = std::vector<MacroField>;
+
     DevicePtr mDevice;
 
     // Graphics Pipeline related stuff
     BasePipeline<GraphicsPipelineDesc> mBaseGraphicsPipeline;
-    PipelineMap mGraphicsPipelines;
-    std::string mVertexShaderPath;
-    std::string mTessControlShaderPath;
-    std::string mTessEvalShaderPath;
-    std::string mGeometryShaderPath;
-    std::string mFragmentShaderPath;
     ShaderMap mVertexShaders;
     ShaderMap mTessControlShaders;
     ShaderMap mTessEvalShaders;
@@ -75,26 +104,101 @@ class MultiPipeline
 
     // Compute Pipeline related stuff
     BasePipeline<ComputePipelineDesc> mBaseComputePipeline;
-    PipelineMap mComputePipelines;
-    std::string mComputeShaderPath;
     ShaderMap mComputeShaders;
 
+    // Key layout - one entry per stage, indexed by ShaderType
+    std::array<MacroLayout, static_cast<size_t>(ShaderType::COMPUTE) + 1> mLayouts;
+    uint32_t mKeyBits;
+
+    // Pipeline table indexed by key. Handles are published only after Pipeline is fully created.
+    std::unique_ptr<std::atomic<VkPipeline>[]> mPipelineHandles;
+    std::unique_ptr<std::atomic<uint8_t>[]> mPipelineStates;
+    std::vector<PipelinePtr> mPipelines;
+    VkPipeline mFallbackPipeline;
+    Common::ThreadPool* mCompileThreadPool;
+
+    // Pipelines created on worker threads
+    std::mutex mPrecompileMutex;
+    std::condition_variable mPrecompileFinished;
+    uint32_t mPendingPrecompiles;
+
     uint32_t CalculateAllCombinations(const MultiPipelineShaderMacroLimits& macros);
     void AdvanceCombinations(ShaderMacros& comb, const MultiPipelineShaderMacroLimits& macros);
     ShaderPtr GenerateShader(const std::string& path, const ShaderMacros& comb, ShaderType type);
     bool GenerateShaderModules(const MultiPipelineShaderDesc& desc, ShaderType type, ShaderMap* targetMap);
+    Shader* FindShader(const ShaderMap& map, const ShaderMacros& comb) const;
+
+    bool InitKeyLayout(ShaderType stage, const MultiPipelineShaderDesc& desc);
+    void InitPipelineTable();
+    MultiPipelineKey EncodeMacros(ShaderType stage, const ShaderMacros& comb) const;
+    ShaderMacros DecodeMacros(ShaderType stage, MultiPipelineKey key) const;
+    bool IsKeyValid(MultiPipelineKey key) const;
 
+    // both are safe to call from multiple threads - base pipeline descs are only read
     PipelinePtr GenerateNewPipeline(const MultiGraphicsPipelineShaderMacros& comb); // for graphics
     PipelinePtr GenerateNewPipeline(const ShaderMacros& comb); // for compute
 
+    // creates Pipeline for a key in STATE_BUILDING and publishes it in the table
+    void BuildPipeline(MultiPipelineKey key);
+    VkPipeline RequestGraphicsPipeline(MultiPipelineKey key);
+    VkPipeline RequestComputePipeline(MultiPipelineKey key);
+
+    void AddPrecompileTask(Common::ThreadPool* threadPool, const std::function<void()>& task);
+
 public:
     MultiPipeline();
     ~MultiPipeline();
 
     bool Init(const DevicePtr& device, const MultiGraphicsPipelineDesc& desc);
     bool Init(const DevicePtr& device, const MultiComputePipelineDesc& desc);
-    VkPipeline GetGraphicsPipeline(const MultiGraphicsPipelineShaderMacros& combs);
-    VkPipeline GetComputePipeline(const ShaderMacros& comb);
+
+    /**
+     * Translate macro values to keys. Intended to be called outside of hot paths - keys of
+     * separate macros can be calculated once and OR'ed together when drawing.
+     */
+    MultiPipelineKey GetGraphicsKey(const MultiGraphicsPipelineShaderMacros& combs) const;
+    MultiPipelineKey GetComputeKey(const ShaderMacros& comb) const;
+    MultiPipelineKey GetMacroKey(ShaderType stage, const std::string& name, uint32_t value) const;
+
+    ABENCH_INLINE VkPipeline GetGraphicsPipeline(MultiPipelineKey key)
+    {
+        VkPipeline pipeline = mPipelineHandles[key].load(std::memory_order_acquire);
+        if (pipeline != VK_NULL_HANDLE)
+            return pipeline;
+
+        return RequestGraphicsPipeline(key);
+    }
+
+    ABENCH_INLINE VkPipeline GetComputePipeline(MultiPipelineKey key)
+    {
+        VkPipeline pipeline = mPipelineHandles[key].load(std::memory_order_acquire);
+        if (pipeline != VK_NULL_HANDLE)
+            return pipeline;
+
+        return RequestComputePipeline(key);
+    }
+
+    ABENCH_INLINE VkPipeline GetGraphicsPipeline(const MultiGraphicsPipelineShaderMacros& combs)
+    {
+        return GetGraphicsPipeline(GetGraphicsKey(combs));
+    }
+
+    ABENCH_INLINE VkPipeline GetComputePipeline(const ShaderMacros& comb)
+    {
+        return GetComputePipeline(GetComputeKey(comb));
+    }
+
+    /**
+     * Creates Pipelines for all declared macro combinations on provided Thread Pool, so
+     * Get*Pipeline calls later on do not have to compile them on the calling thread. Provided
+     * Thread Pool is also used to create Graphics Pipelines requested before their precompile
+     * task finished. Without a Thread Pool all combinations are created on calling thread.
+     *
+     * Thread Pool should be dedicated to compilation - a pool shared with Command Buffer
+     * recording would queue recording tasks behind whole Pipeline compiles.
+     */
+    void Precompile(Common::ThreadPool* threadPool);
+    void WaitForPrecompile();
 };
 
 } // namespace Renderer
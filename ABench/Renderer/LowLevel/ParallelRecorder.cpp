@@ -0,0 +1,131 @@
+#include "PCH.hpp"
+#include "ParallelRecorder.hpp"
+#include "Tools.hpp"
+#include "Extensions.hpp"
+#include "Util.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+ParallelRecorder::ParallelRecorder()
+    : mDevice()
+    , mThreadPool(nullptr)
+    , mRenderPass(VK_NULL_HANDLE)
+    , mFramebuffer(nullptr)
+    , mWorkers()
+{
+}
+
+ParallelRecorder::~ParallelRecorder()
+{
+}
+
+bool ParallelRecorder::Init(const DevicePtr& device, const ParallelRecorderDesc& desc)
+{
+    mDevice = device;
+    mThreadPool = desc.threadPool;
+    mRenderPass = desc.renderPass;
+    mFramebuffer = desc.framebuffer;
+
+    // one Command Buffer per worker thread plus one for the calling thread
+    uint32_t bufferCount = 1;
+    if (mThreadPool)
+        bufferCount += mThreadPool->GetWorkerCount();
+
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        std::unique_ptr<Worker> worker(new Worker());
+
+        worker->pool = Tools::CreateCommandPool(mDevice, desc.queueType, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        if (!worker->pool)
+            return false;
+
+        if (!worker->commandBuffer.Init(mDevice, worker->pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY))
+            return false;
+
+        worker->used = false;
+        mWorkers.push_back(std::move(worker));
+    }
+
+    LOGD("Parallel Recorder initialized with " << bufferCount << " secondary Command Buffers");
+    return true;
+}
+
+bool ParallelRecorder::RecordChunk(Worker* worker, uint32_t begin, uint32_t end, const RecordCallback& callback)
+{
+    // resetting whole pool is cheaper than resetting separate Command Buffers
+    VkResult result = vkResetCommandPool(mDevice->GetDevice(), worker->pool, 0);
+    RETURN_FALSE_IF_FAILED(result, "Failed to reset worker's Command Pool");
+
+    worker->commandBuffer.Begin(mRenderPass, mFramebuffer);
+    callback(&worker->commandBuffer, begin, end);
+    return worker->commandBuffer.End();
+}
+
+bool ParallelRecorder::Record(uint32_t itemCount, const RecordCallback& callback)
+{
+    for (auto& w: mWorkers)
+        w->used = false;
+
+    if (itemCount == 0)
+        return true;
+
+    uint32_t chunkCount = std::min(static_cast<uint32_t>(mWorkers.size()), itemCount);
+    uint32_t chunkSize = itemCount / chunkCount;
+    uint32_t chunkRemainder = itemCount % chunkCount;
+
+    // Thread Pool might be shared with other work, so wait only for chunks of this recording
+    Common::ThreadPoolTaskGroup group;
+    std::atomic<bool> failed(false);
+    uint32_t begin = 0;
+    for (uint32_t i = 0; i < chunkCount; ++i)
+    {
+        uint32_t end = begin + chunkSize + (i < chunkRemainder ? 1 : 0);
+        Worker* worker = mWorkers[i].get();
+        worker->used = true;
+
+        // first chunk is recorded on calling thread after distributing the rest
+        if (i > 0)
+        {
+            mThreadPool->AddTask([this, worker, begin, end, &callback, &failed]() {
+                if (!RecordChunk(worker, begin, end, callback))
+                    failed = true;
+            }, &group);
+        }
+
+        begin = end;
+    }
+
+    uint32_t firstEnd = chunkSize + (chunkRemainder > 0 ? 1 : 0);
+    if (!RecordChunk(mWorkers[0].get(), 0, firstEnd, callback))
+        failed = true;
+
+    if (mThreadPool)
+        mThreadPool->WaitForTasks(group);
+
+    return !failed;
+}
+
+void ParallelRecorder::Execute(CommandBuffer* primary)
+{
+    std::vector<CommandBuffer*> buffers;
+    for (auto& w: mWorkers)
+        if (w->used)
+            buffers.push_back(&w->commandBuffer);
+
+    primary->ExecuteCommands(buffers);
+}
+
+CommandBufferStats ParallelRecorder::GetStats() const
+{
+    CommandBufferStats stats;
+    for (auto& w: mWorkers)
+        if (w->used)
+            stats += w->commandBuffer.GetStats();
+
+    return stats;
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Prerequisites.hpp"
+#include "Device.hpp"
+#include "CommandBuffer.hpp"
+#include "Framebuffer.hpp"
+#include "VkRAII.hpp"
+
+#include "Common/ThreadPool.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+struct ParallelRecorderDesc
+{
+    Common::ThreadPool* threadPool;
+    DeviceQueueType queueType;
+    VkRenderPass renderPass;
+    Framebuffer* framebuffer;
+
+    ParallelRecorderDesc()
+        : threadPool(nullptr)
+        , queueType(DeviceQueueType::GRAPHICS)
+        , renderPass(VK_NULL_HANDLE)
+        , framebuffer(nullptr)
+    {
+    }
+};
+
+// Records range [begin, end) of items to provided secondary Command Buffer
+using RecordCallback = std::function<void(CommandBuffer*, uint32_t begin, uint32_t end)>;
+
+/**
+ * Splits recording of a render pass contents into multiple secondary Command Buffers.
+ *
+ * Each worker owns its own Command Pool, so no external synchronization is needed
+ * while recording. Calling thread records the first chunk alongside the workers.
+ * Recorded buffers must be executed inside a render pass begun with
+ * VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+ */
+class ParallelRecorder
+{
+    struct Worker
+    {
+        VkRAII<VkCommandPool> pool; // must outlive commandBuffer
+        CommandBuffer commandBuffer;
+        bool used;
+    };
+
+    DevicePtr mDevice;
+    Common::ThreadPool* mThreadPool;
+    VkRenderPass mRenderPass;
+    Framebuffer* mFramebuffer;
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+
+    bool RecordChunk(Worker* worker, uint32_t begin, uint32_t end, const RecordCallback& callback);
+
+public:
+    ParallelRecorder();
+    ~ParallelRecorder();
+
+    bool Init(const DevicePtr& device, const ParallelRecorderDesc& desc);
+
+    /**
+     * Records itemCount items, distributing them evenly between available threads.
+     * Blocks until all chunks are recorded.
+     */
+    bool Record(uint32_t itemCount, const RecordCallback& callback);
+
+    /**
+     * Executes recorded secondary Command Buffers in provided primary Command Buffer.
+     */
+    void Execute(CommandBuffer* primary);
+
+    /**
+     * Sums statistics of secondary Command Buffers recorded by last Record() call.
+     */
+    CommandBufferStats GetStats() const;
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -2,6 +2,7 @@
 #include "Pipeline.hpp"
 #include "Util.hpp"
 #include "Extensions.hpp"
+#include "PipelineCache.hpp"
 #include "Renderer/HighLevel/Renderer.hpp"
 
 #include "Common/Common.hpp"
@@ -252,7 +253,7 @@ bool Pipeline::Init(const DevicePtr& device, const GraphicsPipelineDesc& desc)
         pipeInfo.basePipelineIndex = -1;
     }
 
-    VkResult result = vkCreateGraphicsPipelines(mDevice->GetDevice(), VK_NULL_HANDLE, 1,
+    VkResult result = vkCreateGraphicsPipelines(mDevice->GetDevice(), PipelineCache::Instance().GetCache(), 1,
                                                 &pipeInfo, nullptr, &mPipeline);
     RETURN_FALSE_IF_FAILED(result, "Failed to create Graphics Pipeline");
 
@@ -295,7 +296,7 @@ bool Pipeline::Init(const DevicePtr& device, const ComputePipelineDesc& desc)
         pipeInfo.basePipelineIndex = -1;
     }
 
-    VkResult result = vkCreateComputePipelines(mDevice->GetDevice(), VK_NULL_HANDLE, 1,
+    VkResult result = vkCreateComputePipelines(mDevice->GetDevice(), PipelineCache::Instance().GetCache(), 1,
                                                &pipeInfo, nullptr, &mPipeline);
     RETURN_FALSE_IF_FAILED(result, "Failed to create Compute Pipeline");
 
@@ -0,0 +1,172 @@
+#include "PCH.hpp"
+#include "PipelineCache.hpp"
+
+#include "Util.hpp"
+#include "Extensions.hpp"
+
+#include "Common/Common.hpp"
+#include "Common/Logger.hpp"
+#include "Common/FS.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+namespace {
+
+// Header placed by the driver at the beginning of Pipeline Cache data
+struct PipelineCacheHeader
+{
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t cacheUUID[VK_UUID_SIZE];
+};
+
+} // namespace
+
+PipelineCache::PipelineCache()
+    : mDevice()
+    , mCache(VK_NULL_HANDLE)
+    , mPath()
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+    Release();
+}
+
+bool PipelineCache::ValidateHeader(const std::vector<char>& data) const
+{
+    if (data.size() < sizeof(PipelineCacheHeader))
+    {
+        LOGW("Pipeline Cache file is too small to contain a valid header");
+        return false;
+    }
+
+    PipelineCacheHeader header;
+    memcpy(&header, data.data(), sizeof(PipelineCacheHeader));
+
+    const VkPhysicalDeviceProperties& props = mDevice->GetProperties();
+
+    if (header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+    {
+        LOGW("Pipeline Cache header version " << header.headerVersion << " is not supported");
+        return false;
+    }
+
+    if (header.vendorID != props.vendorID || header.deviceID != props.deviceID)
+    {
+        LOGW("Pipeline Cache was created on a different device");
+        return false;
+    }
+
+    if (memcmp(header.cacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        LOGW("Pipeline Cache UUID does not match - driver has probably changed");
+        return false;
+    }
+
+    return true;
+}
+
+bool PipelineCache::LoadData(std::vector<char>& data) const
+{
+    if (!Common::FS::Exists(mPath))
+    {
+        LOGI("Pipeline Cache file " << mPath << " does not exist - starting with empty cache");
+        return false;
+    }
+
+    std::ifstream cacheFile(mPath, std::ifstream::in | std::ifstream::binary);
+    if (!cacheFile.good())
+    {
+        LOGW("Failed to open Pipeline Cache file " << mPath);
+        return false;
+    }
+
+    cacheFile.seekg(0, std::ifstream::end);
+    size_t dataSize = static_cast<size_t>(cacheFile.tellg());
+    cacheFile.seekg(0, std::ifstream::beg);
+
+    data.resize(dataSize);
+    cacheFile.read(data.data(), dataSize);
+    if (!cacheFile.good())
+    {
+        LOGW("Failed to read Pipeline Cache file " << mPath);
+        return false;
+    }
+
+    return ValidateHeader(data);
+}
+
+PipelineCache& PipelineCache::Instance()
+{
+    static PipelineCache instance;
+    return instance;
+}
+
+bool PipelineCache::Init(const DevicePtr& device, const std::string& path)
+{
+    mDevice = device;
+    mPath = path;
+
+    std::vector<char> data;
+    if (!LoadData(data))
+        data.clear();
+
+    VkPipelineCacheCreateInfo info;
+    ZERO_MEMORY(info);
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = data.size();
+    info.pInitialData = data.empty() ? nullptr : data.data();
+    VkResult result = vkCreatePipelineCache(mDevice->GetDevice(), &info, nullptr, &mCache);
+    RETURN_FALSE_IF_FAILED(result, "Failed to create Pipeline Cache");
+
+    if (!data.empty())
+        LOGI("Loaded " << data.size() << " bytes of Pipeline Cache from " << mPath);
+
+    return true;
+}
+
+bool PipelineCache::Save() const
+{
+    if (mCache == VK_NULL_HANDLE)
+        return false;
+
+    size_t dataSize = 0;
+    VkResult result = vkGetPipelineCacheData(mDevice->GetDevice(), mCache, &dataSize, nullptr);
+    RETURN_FALSE_IF_FAILED(result, "Failed to acquire Pipeline Cache data size");
+
+    std::vector<char> data(dataSize);
+    result = vkGetPipelineCacheData(mDevice->GetDevice(), mCache, &dataSize, data.data());
+    RETURN_FALSE_IF_FAILED(result, "Failed to acquire Pipeline Cache data");
+
+    std::ofstream cacheFile(mPath, std::ofstream::out | std::ofstream::binary);
+    if (!cacheFile)
+    {
+        LOGE("Unable to open Pipeline Cache file " << mPath << " for writing");
+        return false;
+    }
+
+    cacheFile.write(data.data(), dataSize);
+    LOGI("Saved " << dataSize << " bytes of Pipeline Cache to " << mPath);
+    return true;
+}
+
+void PipelineCache::Release()
+{
+    if (mCache == VK_NULL_HANDLE)
+        return;
+
+    Save();
+
+    vkDestroyPipelineCache(mDevice->GetDevice(), mCache, nullptr);
+    mCache = VK_NULL_HANDLE;
+    mDevice.reset();
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Prerequisites.hpp"
+#include "Device.hpp"
+
+
+namespace ABench {
+namespace Renderer {
+
+/**
+ * A VkPipelineCache shared by all Pipelines, persisted between application runs.
+ *
+ * Cache data is loaded from a file on Init() and written back on Release(). Loaded data is
+ * dropped when its header does not match current device (vendor, device ID or pipeline
+ * cache UUID, which changes with driver builds).
+ *
+ * Vulkan Pipeline Caches are internally synchronized, so Pipelines can be created on
+ * multiple threads at once.
+ */
+class PipelineCache
+{
+    DevicePtr mDevice;
+    VkPipelineCache mCache;
+    std::string mPath;
+
+    bool ValidateHeader(const std::vector<char>& data) const;
+    bool LoadData(std::vector<char>& data) const;
+
+    PipelineCache();
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache(PipelineCache&&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+    PipelineCache& operator=(PipelineCache&&) = delete;
+    ~PipelineCache();
+
+public:
+    static PipelineCache& Instance();
+
+    bool Init(const DevicePtr& device, const std::string& path);
+    bool Save() const;
+    void Release();
+
+    // VK_NULL_HANDLE when cache was not initialized - Pipelines are then created without it
+    ABENCH_INLINE VkPipelineCache GetCache() const
+    {
+        return mCache;
+    }
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -74,6 +74,12 @@ public:
         return mQueues[queueType].index;
     }
 
+    // 0 means the queue does not support timestamps
+    ABENCH_INLINE uint32_t GetTimestampValidBits(DeviceQueueType queueType) const
+    {
+        return mQueueProperties[mQueues[queueType].index].timestampValidBits;
+    }
+
     ABENCH_INLINE uint32_t GetQueueCount() const
     {
         return static_cast<uint32_t>(mQueueIndices.size());
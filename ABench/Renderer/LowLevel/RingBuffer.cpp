@@ -17,6 +17,8 @@ RingBuffer::RingBuffer()
     , mBufferSize(0)
     , mCurrentOffset(0)
     , mStartOffset(0)
+    , mFrameBytes(0)
+    , mStatisticsID(UINT32_MAX)
     , mMemoryPointer(nullptr)
 {
 }
@@ -26,12 +28,15 @@ RingBuffer::~RingBuffer()
     if (mMemoryPointer)
         vkUnmapMemory(mDevice->GetDevice(), mBufferMemory);
     if (mBufferMemory != VK_NULL_HANDLE)
-        vkFreeMemory(mDevice->GetDevice(), mBufferMemory, nullptr);
+        mDevice->FreeMemory(mBufferMemory);
     if (mBuffer != VK_NULL_HANDLE)
+    {
         vkDestroyBuffer(mDevice->GetDevice(), mBuffer, nullptr);
+        mDevice->GetStatistics().OnDestroy(TrackedObject::Buffer);
+    }
 }
 
-bool RingBuffer::Init(const DevicePtr& device, VkDeviceSize bufferSize)
+bool RingBuffer::Init(const DevicePtr& device, VkDeviceSize bufferSize, const std::string& name)
 {
     mDevice = device;
 
@@ -40,9 +45,12 @@ bool RingBuffer::Init(const DevicePtr& device, VkDeviceSize bufferSize)
     bufInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufInfo.size = bufferSize;
     bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    // storage usage lets shaders index all data written in a frame, ex. bindless transforms
+    bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     VkResult result = vkCreateBuffer(mDevice->GetDevice(), &bufInfo, nullptr, &mBuffer);
     RETURN_FALSE_IF_FAILED(result, "Failed to create device buffer");
+    mDevice->GetStatistics().OnCreate(TrackedObject::Buffer);
 
     VkMemoryRequirements deviceMemReqs;
     vkGetBufferMemoryRequirements(mDevice->GetDevice(), mBuffer, &deviceMemReqs);
@@ -54,7 +62,7 @@ bool RingBuffer::Init(const DevicePtr& device, VkDeviceSize bufferSize)
     memInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     memInfo.allocationSize = deviceMemReqs.size;
     memInfo.memoryTypeIndex = mDevice->GetMemoryTypeIndex(deviceMemReqs.memoryTypeBits, memFlags);
-    result = vkAllocateMemory(mDevice->GetDevice(), &memInfo, nullptr, &mBufferMemory);
+    result = mDevice->AllocateMemory(memInfo, mBufferMemory);
     RETURN_FALSE_IF_FAILED(result, "Failed to allocate device memory");
 
     result = vkBindBufferMemory(mDevice->GetDevice(), mBuffer, mBufferMemory, 0);
@@ -65,33 +73,57 @@ bool RingBuffer::Init(const DevicePtr& device, VkDeviceSize bufferSize)
 
     mBufferSize = deviceMemReqs.size;
     mCurrentOffset = mStartOffset = 0;
+    mFrameBytes = 0;
+    mStatisticsID = mDevice->GetStatistics().RegisterRingBuffer(name, mBufferSize);
 
     return true;
 }
 
 uint32_t RingBuffer::Write(const void* data, size_t dataSize)
 {
-    uint32_t dataHead = mCurrentOffset;
+    uint32_t dataHead;
+    void* ptr = Allocate(dataSize, dataHead);
+    if (ptr == nullptr)
+        return UINT32_MAX;
 
-    if (dataHead + dataSize > mBufferSize)
-        dataHead = 0; // exceeded buffer's capacity, go back to front
+    memcpy(ptr, data, dataSize);
 
-    if (dataHead < mStartOffset && dataHead + dataSize > mStartOffset)
-        return UINT32_MAX; // filled and cannot write.
+    return dataHead;
+}
 
-    memcpy(mMemoryPointer + dataHead, data, dataSize);
+void* RingBuffer::Allocate(size_t dataSize, uint32_t& offset)
+{
+    uint32_t dataHead;
 
-    // update pointers
-    // first, size is converted into multiple of 256 bytes, as required by Vulkan specification
-    dataSize = (dataSize + 255) & ~255;
-    mCurrentOffset = dataHead + static_cast<uint32_t>(dataSize);
+    {
+        std::lock_guard<std::mutex> lock(mOffsetMutex);
 
-    return dataHead;
+        dataHead = mCurrentOffset;
+
+        if (dataHead + dataSize > mBufferSize)
+            dataHead = 0; // exceeded buffer's capacity, go back to front
+
+        if (dataHead < mStartOffset && dataHead + dataSize > mStartOffset)
+            return nullptr; // filled and cannot write.
+
+        // update pointers
+        // first, size is converted into multiple of 256 bytes, as required by Vulkan specification
+        size_t alignedSize = (dataSize + 255) & ~255;
+        mCurrentOffset = dataHead + static_cast<uint32_t>(alignedSize);
+        mFrameBytes += alignedSize;
+    }
+
+    offset = dataHead;
+    return mMemoryPointer + dataHead;
 }
 
 bool RingBuffer::MarkFinishedFrame()
 {
+    std::lock_guard<std::mutex> lock(mOffsetMutex);
     mStartOffset = mCurrentOffset;
+
+    mDevice->GetStatistics().ReportRingBufferFrame(mStatisticsID, mFrameBytes);
+    mFrameBytes = 0;
     return true;
 }
 
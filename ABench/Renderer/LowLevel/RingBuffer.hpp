@@ -16,7 +16,10 @@ class RingBuffer
     VkDeviceSize mBufferSize;
     uint32_t mCurrentOffset;
     uint32_t mStartOffset;
+    VkDeviceSize mFrameBytes; // reserved since last MarkFinishedFrame()
+    uint32_t mStatisticsID;
     char* mMemoryPointer;
+    std::mutex mOffsetMutex; // Write() can be called from multiple recording threads
 
 public:
     RingBuffer();
@@ -29,14 +32,26 @@ public:
      * The Buffer does not loop the data around when the size limit is met.
      * Thus, huge data shouldn't be allocated this way, or the size should
      * be big enough.
+     *
+     * Name identifies the Ring Buffer in Device's Memory Statistics, which keep
+     * the most space reserved in a single frame.
      */
-    bool Init(const DevicePtr& device, const VkDeviceSize bufferSize);
+    bool Init(const DevicePtr& device, const VkDeviceSize bufferSize, const std::string& name = "RingBuffer");
 
     /**
      * Write data to Ring Buffer. Returns offset at which data was allocated.
+     *
+     * Safe to call from multiple threads - only space reservation is serialized,
+     * copying the data happens outside of the lock.
      */
     uint32_t Write(const void* data, size_t dataSize);
 
+    /**
+     * Reserves dataSize bytes without copying anything. Returns pointer to the reserved
+     * space, which caller fills in directly, or nullptr when the buffer is full.
+     */
+    void* Allocate(size_t dataSize, uint32_t& offset);
+
     /**
      * Advances the offsets and marks the beginning of next frame.
      */
@@ -2,48 +2,13 @@
 
 #include "Prerequisites.hpp"
 #include "Device.hpp"
+#include "ShaderCompiler.hpp"
 
 #include <memory>
 
 namespace ABench {
 namespace Renderer {
 
-enum class ShaderType: unsigned char
-{
-    UNKNOWN = 0,
-    VERTEX,
-    TESS_CONTROL,
-    TESS_EVAL,
-    GEOMETRY,
-    FRAGMENT,
-    COMPUTE
-};
-
-struct ShaderMacroDesc
-{
-    std::string name;
-    uint32_t value;
-
-    bool operator<(const ShaderMacroDesc& b) const
-    {
-        return this->value < b.value;
-    }
-
-    ShaderMacroDesc()
-        : name()
-        , value(0)
-    {
-    }
-
-    ShaderMacroDesc(const std::string& name, uint32_t value)
-        : name(name)
-        , value(value)
-    {
-    }
-};
-
-using ShaderMacros = std::vector<ShaderMacroDesc>;
-
 struct ShaderDesc
 {
     ShaderType type;
@@ -58,8 +23,6 @@ class Shader
     DevicePtr mDevice;
     VkShaderModule mShaderModule;
 
-    bool CompileToFile(ShaderType type, const std::string& shaderFile, const std::string& spvShaderFile,
-                       const ShaderMacros& macros, std::vector<uint32_t>& code);
     bool CreateVkShaderModule(const std::vector<uint32_t>& code);
 
 public:
@@ -0,0 +1,379 @@
+#include "PCH.hpp"
+#include "ShaderCache.hpp"
+
+#include "Common/Common.hpp"
+#include "Common/Logger.hpp"
+#include "Common/FS.hpp"
+#include "ResourceDir.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace ABench {
+namespace Renderer {
+
+namespace {
+
+const std::string ARCHIVE_FILE = "Shaders.cache";
+const std::string ARCHIVE_TEMP_SUFFIX = ".tmp";
+const uint32_t ARCHIVE_MAGIC = 0x43534241; // "ABSC"
+const uint32_t ARCHIVE_VERSION = 1;
+
+const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+const uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+// FNV-1a
+uint64_t Hash(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+// terminating null is hashed as well, so that consecutive strings cannot run into each other
+uint64_t Hash(const std::string& str, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    return Hash(str.c_str(), str.size() + 1, hash);
+}
+
+bool CalculateContentHash(ShaderType type, const std::string& path, const ShaderMacros& macros,
+                          uint64_t& contentHash)
+{
+    std::string preprocessed;
+    if (!ShaderCompiler::Preprocess(type, path, macros, preprocessed))
+        return false;
+
+    contentHash = Hash(preprocessed, Hash(ShaderCompiler::GetCompilerSignature()));
+    return true;
+}
+
+} // namespace
+
+struct ShaderCache::ArchiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t padding;
+    uint64_t signatureHash;
+};
+
+struct ShaderCache::ArchiveEntry
+{
+    uint64_t variantKey;
+    uint64_t contentHash;
+    uint64_t offset; // from the beginning of the archive
+    uint64_t size; // in bytes
+};
+
+ShaderCache::ShaderCache()
+    : mArchive()
+    , mIndex(nullptr)
+    , mIndexSize(0)
+    , mNewEntries()
+    , mMutex()
+    , mPath()
+    , mValidateSources(false)
+{
+}
+
+ShaderCache::~ShaderCache()
+{
+    Release();
+}
+
+ShaderCache& ShaderCache::Instance()
+{
+    static ShaderCache instance;
+    return instance;
+}
+
+uint64_t ShaderCache::CalculateVariantKey(const std::string& filename, const ShaderMacros& macros)
+{
+    uint64_t key = Hash(filename);
+    for (auto& m: macros)
+    {
+        key = Hash(m.name, key);
+        key = Hash(&m.value, sizeof(m.value), key);
+    }
+
+    return key;
+}
+
+bool ShaderCache::OpenArchive()
+{
+    if (!Common::FS::Exists(mPath))
+    {
+        LOGI("Shader archive " << mPath << " does not exist - shaders will be compiled on demand");
+        return false;
+    }
+
+    if (!mArchive.Open(mPath))
+        return false;
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(mArchive.GetData());
+    size_t size = mArchive.GetSize();
+
+    ArchiveHeader header;
+    if (size < sizeof(ArchiveHeader))
+    {
+        LOGW("Shader archive " << mPath << " is too small to contain a valid header");
+        mArchive.Close();
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(ArchiveHeader));
+    if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION)
+    {
+        LOGW("Shader archive " << mPath << " has invalid format - discarding");
+        mArchive.Close();
+        return false;
+    }
+
+    if (header.signatureHash != Hash(ShaderCompiler::GetCompilerSignature()))
+    {
+        LOGW("Shader archive " << mPath << " was built with different compiler settings - discarding");
+        mArchive.Close();
+        return false;
+    }
+
+    size_t indexEnd = sizeof(ArchiveHeader) + header.entryCount * sizeof(ArchiveEntry);
+    if (indexEnd > size)
+    {
+        LOGW("Shader archive " << mPath << " is truncated - discarding");
+        mArchive.Close();
+        return false;
+    }
+
+    const ArchiveEntry* index = reinterpret_cast<const ArchiveEntry*>(data + sizeof(ArchiveHeader));
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        if (index[i].offset < indexEnd || index[i].offset + index[i].size > size ||
+            index[i].offset % sizeof(uint32_t) != 0 || index[i].size % sizeof(uint32_t) != 0)
+        {
+            LOGW("Shader archive " << mPath << " has corrupted index - discarding");
+            mArchive.Close();
+            return false;
+        }
+    }
+
+    mIndex = index;
+    mIndexSize = header.entryCount;
+    LOGI("Mapped shader archive " << mPath << " with " << mIndexSize << " shader variants");
+    return true;
+}
+
+const ShaderCache::ArchiveEntry* ShaderCache::FindArchiveEntry(uint64_t variantKey) const
+{
+    if (mIndex == nullptr)
+        return nullptr;
+
+    const ArchiveEntry* end = mIndex + mIndexSize;
+    const ArchiveEntry* entry = std::lower_bound(mIndex, end, variantKey,
+        [](const ArchiveEntry& e, uint64_t key) {
+            return e.variantKey < key;
+        });
+
+    if (entry == end || entry->variantKey != variantKey)
+        return nullptr;
+
+    return entry;
+}
+
+bool ShaderCache::FindEntry(uint64_t variantKey, uint64_t& contentHash, std::vector<uint32_t>& code)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // freshly compiled entries take precedence over what is stored in archive
+    auto it = mNewEntries.find(variantKey);
+    if (it != mNewEntries.end())
+    {
+        contentHash = it->second.contentHash;
+        code = it->second.code;
+        return true;
+    }
+
+    const ArchiveEntry* entry = FindArchiveEntry(variantKey);
+    if (entry == nullptr)
+        return false;
+
+    const uint32_t* data = reinterpret_cast<const uint32_t*>(
+        reinterpret_cast<const uint8_t*>(mArchive.GetData()) + entry->offset);
+    contentHash = entry->contentHash;
+    code.assign(data, data + entry->size / sizeof(uint32_t));
+    return true;
+}
+
+bool ShaderCache::Init(bool validateSources, bool loadArchive)
+{
+    Release();
+
+    mPath = Common::FS::JoinPaths(ResourceDir::SHADER_CACHE, ARCHIVE_FILE);
+    mValidateSources = validateSources;
+
+    if (loadArchive)
+        OpenArchive();
+
+    return true;
+}
+
+bool ShaderCache::GetCode(ShaderType type, const std::string& filename, const ShaderMacros& macros,
+                          std::vector<uint32_t>& code, bool* compiled)
+{
+    if (compiled)
+        *compiled = false;
+
+    uint64_t variantKey = CalculateVariantKey(filename, macros);
+    std::string path = Common::FS::JoinPaths(ResourceDir::SHADERS, filename);
+
+    uint64_t contentHash = 0;
+    if (mValidateSources && !CalculateContentHash(type, path, macros, contentHash))
+        return false;
+
+    uint64_t cachedContentHash = 0;
+    if (FindEntry(variantKey, cachedContentHash, code))
+    {
+        if (!mValidateSources || cachedContentHash == contentHash)
+            return true;
+
+        LOGW("Shader " << filename << " changed since it was cached - recompiling");
+    }
+    else
+    {
+        LOGW("Shader " << filename << " not found in shader archive - compiling");
+        if (!mValidateSources && !CalculateContentHash(type, path, macros, contentHash))
+            return false;
+    }
+
+    if (!ShaderCompiler::Compile(type, path, macros, code))
+    {
+        LOGE("Failed to compile shader " << filename << " to SPIR-V");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        NewEntry& entry = mNewEntries[variantKey];
+        entry.contentHash = contentHash;
+        entry.code = code;
+    }
+
+    if (compiled)
+        *compiled = true;
+
+    return true;
+}
+
+bool ShaderCache::Save()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mNewEntries.empty())
+        return true;
+
+    struct SaveEntry
+    {
+        uint64_t variantKey;
+        uint64_t contentHash;
+        const void* data;
+        uint64_t size;
+    };
+
+    std::vector<SaveEntry> entries;
+    for (uint32_t i = 0; i < mIndexSize; ++i)
+    {
+        if (mNewEntries.find(mIndex[i].variantKey) != mNewEntries.end())
+            continue;
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(mArchive.GetData()) + mIndex[i].offset;
+        entries.push_back({ mIndex[i].variantKey, mIndex[i].contentHash, data, mIndex[i].size });
+    }
+
+    for (auto& e: mNewEntries)
+        entries.push_back({ e.first, e.second.contentHash, e.second.code.data(),
+                            e.second.code.size() * sizeof(uint32_t) });
+
+    std::sort(entries.begin(), entries.end(), [](const SaveEntry& a, const SaveEntry& b) {
+        return a.variantKey < b.variantKey;
+    });
+
+    ArchiveHeader header;
+    ZERO_MEMORY(header);
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.signatureHash = Hash(ShaderCompiler::GetCompilerSignature());
+
+    std::vector<ArchiveEntry> index(entries.size());
+    uint64_t offset = sizeof(ArchiveHeader) + entries.size() * sizeof(ArchiveEntry);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        index[i].variantKey = entries[i].variantKey;
+        index[i].contentHash = entries[i].contentHash;
+        index[i].offset = offset;
+        index[i].size = entries[i].size;
+        offset += entries[i].size;
+    }
+
+    // write to a temporary file first - current archive is still mapped and used as a source
+    std::string tempPath = mPath + ARCHIVE_TEMP_SUFFIX;
+    {
+        std::ofstream archiveFile(tempPath, std::ofstream::out | std::ofstream::binary);
+        if (!archiveFile)
+        {
+            LOGE("Unable to open shader archive " << tempPath << " for writing");
+            return false;
+        }
+
+        archiveFile.write(reinterpret_cast<const char*>(&header), sizeof(ArchiveHeader));
+        archiveFile.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(ArchiveEntry));
+        for (auto& e: entries)
+            archiveFile.write(reinterpret_cast<const char*>(e.data), e.size);
+
+        if (!archiveFile.good())
+        {
+            LOGE("Failed to write shader archive " << tempPath);
+            return false;
+        }
+    }
+
+    mArchive.Close();
+    mIndex = nullptr;
+    mIndexSize = 0;
+
+    if (Common::FS::Exists(mPath))
+        Common::FS::RemoveFile(mPath);
+
+    if (std::rename(tempPath.c_str(), mPath.c_str()) != 0)
+    {
+        LOGE("Failed to replace shader archive " << mPath);
+        return false;
+    }
+
+    LOGI("Saved " << entries.size() << " shader variants (" << mNewEntries.size() << " new) to " << mPath);
+    mNewEntries.clear();
+    OpenArchive();
+    return true;
+}
+
+void ShaderCache::Release()
+{
+    if (!mPath.empty())
+        Save();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mArchive.Close();
+    mIndex = nullptr;
+    mIndexSize = 0;
+    mNewEntries.clear();
+    mPath.clear();
+}
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ShaderCompiler.hpp"
+
+#include "Common/MappedFile.hpp"
+
+#include <map>
+#include <mutex>
+
+
+namespace ABench {
+namespace Renderer {
+
+/**
+ * Single-file archive of compiled SPIR-V shader variants.
+ *
+ * Archive is memory-mapped on Init() and consists of a header, an index sorted by variant key
+ * and SPIR-V blobs. Variant key is a hash of shader file name and macros, so finding a shader
+ * is a binary search over the index - no files are opened or stat'ed on the way.
+ *
+ * Each entry also stores a content hash, calculated from preprocessed source (macros expanded,
+ * includes resolved). When source validation is enabled, sources are preprocessed on every
+ * request and entries with mismatching content hash are recompiled. Without validation, the
+ * archive is trusted as-is - ABenchShaderc is expected to keep it up to date.
+ *
+ * Archive built with a different glslang version or compile settings is discarded entirely.
+ * Newly compiled variants are kept in memory and written out by Save().
+ */
+class ShaderCache
+{
+    struct ArchiveHeader;
+    struct ArchiveEntry;
+
+    struct NewEntry
+    {
+        uint64_t contentHash;
+        std::vector<uint32_t> code;
+    };
+
+    Common::MappedFile mArchive;
+    const ArchiveEntry* mIndex;
+    uint32_t mIndexSize;
+    std::map<uint64_t, NewEntry> mNewEntries;
+    std::mutex mMutex;
+    std::string mPath;
+    bool mValidateSources;
+
+    bool OpenArchive();
+    const ArchiveEntry* FindArchiveEntry(uint64_t variantKey) const;
+    bool FindEntry(uint64_t variantKey, uint64_t& contentHash, std::vector<uint32_t>& code);
+
+    ShaderCache();
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache(ShaderCache&&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+    ShaderCache& operator=(ShaderCache&&) = delete;
+    ~ShaderCache();
+
+public:
+    static ShaderCache& Instance();
+
+    static uint64_t CalculateVariantKey(const std::string& filename, const ShaderMacros& macros);
+
+    /**
+     * Maps the archive from shader cache directory. With loadArchive set to false, existing
+     * archive is ignored and gets overwritten by the next Save().
+     */
+    bool Init(bool validateSources, bool loadArchive = true);
+
+    /**
+     * Provides SPIR-V code of requested shader variant, compiling it when it is missing (or out
+     * of date, if sources are validated). Safe to call from multiple threads.
+     */
+    bool GetCode(ShaderType type, const std::string& filename, const ShaderMacros& macros,
+                 std::vector<uint32_t>& code, bool* compiled = nullptr);
+
+    /**
+     * Writes archive back to disk if any new variants were compiled since Init().
+     */
+    bool Save();
+    void Release();
+};
+
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,349 @@
+#include "PCH.hpp"
+#include "ShaderCompiler.hpp"
+
+#include "Common/Common.hpp"
+#include "Common/Logger.hpp"
+#include "Common/FS.hpp"
+#include "ResourceDir.hpp"
+
+#include <fstream>
+#include <map>
+
+#include <glslang/Public/ShaderLang.h>
+#include <SPIRV/GlslangToSpv.h>
+
+namespace ABench {
+namespace Renderer {
+namespace ShaderCompiler {
+
+namespace {
+
+// default limits for glslang shader resources
+// taken from glslang standalone implementation
+const TBuiltInResource DEFAULT_LIMITS = {
+    /* .MaxLights = */ 32,
+    /* .MaxClipPlanes = */ 6,
+    /* .MaxTextureUnits = */ 32,
+    /* .MaxTextureCoords = */ 32,
+    /* .MaxVertexAttribs = */ 64,
+    /* .MaxVertexUniformComponents = */ 4096,
+    /* .MaxVaryingFloats = */ 64,
+    /* .MaxVertexTextureImageUnits = */ 32,
+    /* .MaxCombinedTextureImageUnits = */ 80,
+    /* .MaxTextureImageUnits = */ 32,
+    /* .MaxFragmentUniformComponents = */ 4096,
+    /* .MaxDrawBuffers = */ 32,
+    /* .MaxVertexUniformVector4s = */ 128,
+    /* .MaxVaryingVector4s = */ 8,
+    /* .MaxFragmentUniformVector4s = */ 16,
+    /* .MaxVertexOutputVector4s = */ 16,
+    /* .MaxFragmentInputVector4s = */ 15,
+    /* .MinProgramTexelOffset = */ -8,
+    /* .MaxProgramTexelOffset = */ 7,
+    /* .MaxClipDistances = */ 8,
+    /* .MaxComputeWorkGroupCountX = */ 65535,
+    /* .MaxComputeWorkGroupCountY = */ 65535,
+    /* .MaxComputeWorkGroupCountZ = */ 65535,
+    /* .MaxComputeWorkGroupSizeX = */ 1024,
+    /* .MaxComputeWorkGroupSizeY = */ 1024,
+    /* .MaxComputeWorkGroupSizeZ = */ 64,
+    /* .MaxComputeUniformComponents = */ 1024,
+    /* .MaxComputeTextureImageUnits = */ 16,
+    /* .MaxComputeImageUniforms = */ 8,
+    /* .MaxComputeAtomicCounters = */ 8,
+    /* .MaxComputeAtomicCounterBuffers = */ 1,
+    /* .MaxVaryingComponents = */ 60,
+    /* .MaxVertexOutputComponents = */ 64,
+    /* .MaxGeometryInputComponents = */ 64,
+    /* .MaxGeometryOutputComponents = */ 128,
+    /* .MaxFragmentInputComponents = */ 128,
+    /* .MaxImageUnits = */ 8,
+    /* .MaxCombinedImageUnitsAndFragmentOutputs = */ 8,
+    /* .MaxCombinedShaderOutputResources = */ 8,
+    /* .MaxImageSamples = */ 0,
+    /* .MaxVertexImageUniforms = */ 0,
+    /* .MaxTessControlImageUniforms = */ 0,
+    /* .MaxTessEvaluationImageUniforms = */ 0,
+    /* .MaxGeometryImageUniforms = */ 0,
+    /* .MaxFragmentImageUniforms = */ 8,
+    /* .MaxCombinedImageUniforms = */ 8,
+    /* .MaxGeometryTextureImageUnits = */ 16,
+    /* .MaxGeometryOutputVertices = */ 256,
+    /* .MaxGeometryTotalOutputComponents = */ 1024,
+    /* .MaxGeometryUniformComponents = */ 1024,
+    /* .MaxGeometryVaryingComponents = */ 64,
+    /* .MaxTessControlInputComponents = */ 128,
+    /* .MaxTessControlOutputComponents = */ 128,
+    /* .MaxTessControlTextureImageUnits = */ 16,
+    /* .MaxTessControlUniformComponents = */ 1024,
+    /* .MaxTessControlTotalOutputComponents = */ 4096,
+    /* .MaxTessEvaluationInputComponents = */ 128,
+    /* .MaxTessEvaluationOutputComponents = */ 128,
+    /* .MaxTessEvaluationTextureImageUnits = */ 16,
+    /* .MaxTessEvaluationUniformComponents = */ 1024,
+    /* .MaxTessPatchComponents = */ 120,
+    /* .MaxPatchVertices = */ 32,
+    /* .MaxTessGenLevel = */ 64,
+    /* .MaxViewports = */ 16,
+    /* .MaxVertexAtomicCounters = */ 0,
+    /* .MaxTessControlAtomicCounters = */ 0,
+    /* .MaxTessEvaluationAtomicCounters = */ 0,
+    /* .MaxGeometryAtomicCounters = */ 0,
+    /* .MaxFragmentAtomicCounters = */ 8,
+    /* .MaxCombinedAtomicCounters = */ 8,
+    /* .MaxAtomicCounterBindings = */ 1,
+    /* .MaxVertexAtomicCounterBuffers = */ 0,
+    /* .MaxTessControlAtomicCounterBuffers = */ 0,
+    /* .MaxTessEvaluationAtomicCounterBuffers = */ 0,
+    /* .MaxGeometryAtomicCounterBuffers = */ 0,
+    /* .MaxFragmentAtomicCounterBuffers = */ 1,
+    /* .MaxCombinedAtomicCounterBuffers = */ 1,
+    /* .MaxAtomicCounterBufferSize = */ 16384,
+    /* .MaxTransformFeedbackBuffers = */ 4,
+    /* .MaxTransformFeedbackInterleavedComponents = */ 64,
+    /* .MaxCullDistances = */ 8,
+    /* .MaxCombinedClipAndCullDistances = */ 8,
+    /* .MaxSamples = */ 4,
+    /* .limits = */ {
+        /* .nonInductiveForLoops = */ 1,
+        /* .whileLoops = */ 1,
+        /* .doWhileLoops = */ 1,
+        /* .generalUniformIndexing = */ 1,
+        /* .generalAttributeMatrixVector4Indexing = */ 1,
+        /* .generalVaryingIndexing = */ 1,
+        /* .generalSamplerIndexing = */ 1,
+        /* .generalVariableIndexing = */ 1,
+        /* .generalConstantMatrixVector4Indexing = */ 1,
+    }};
+
+const int DEFAULT_VERSION = 110;
+const EShMessages DEFAULT_MESSAGES = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+const std::string SHADER_HEADER_START = "#version 450\n\
+#extension GL_ARB_separate_shader_objects: enable\n\
+#extension GL_GOOGLE_include_directive: enable\n";
+const std::string DEFINE_STR = "#define ";
+const std::string SHADER_HEADER_TAIL = "\0";
+
+EShLanguage GetShaderLanguage(ShaderType type)
+{
+    switch (type)
+    {
+    case ShaderType::VERTEX:        return EShLangVertex;
+    case ShaderType::TESS_CONTROL:  return EShLangTessControl;
+    case ShaderType::TESS_EVAL:     return EShLangTessEvaluation;
+    case ShaderType::GEOMETRY:      return EShLangGeometry;
+    case ShaderType::FRAGMENT:      return EShLangFragment;
+    case ShaderType::COMPUTE:       return EShLangCompute;
+    default:                        return EShLangCount;
+    }
+}
+
+const std::map<std::string, ShaderType> EXTENSION_TO_TYPE = {
+    { "vert", ShaderType::VERTEX },
+    { "tesc", ShaderType::TESS_CONTROL },
+    { "tese", ShaderType::TESS_EVAL },
+    { "geom", ShaderType::GEOMETRY },
+    { "frag", ShaderType::FRAGMENT },
+    { "comp", ShaderType::COMPUTE },
+};
+
+void LogMultiline(const char* log)
+{
+    std::stringstream logStream(log);
+    for (std::string line; std::getline(logStream, line); )
+    {
+        LOGE(line);
+    }
+}
+
+// Resolves #include directives relative to shader directory
+class ShaderIncluder: public glslang::TShader::Includer
+{
+public:
+    IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override
+    {
+        std::string path = Common::FS::JoinPaths(ResourceDir::SHADERS, headerName);
+        std::ifstream file(path, std::ifstream::in);
+        if (!file.good())
+        {
+            LOGE("Failed to open file " << path << " included from " << includerName);
+            return nullptr;
+        }
+
+        std::string* content = new std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return new IncludeResult(headerName, content->data(), content->size(), content);
+    }
+
+    IncludeResult* includeSystem(const char* headerName, const char* includerName, size_t inclusionDepth) override
+    {
+        return includeLocal(headerName, includerName, inclusionDepth);
+    }
+
+    void releaseInclude(IncludeResult* result) override
+    {
+        if (result == nullptr)
+            return;
+
+        delete static_cast<std::string*>(result->userData);
+        delete result;
+    }
+};
+
+std::string BuildShaderHeader(const ShaderMacros& macros)
+{
+    std::string shaderHead = SHADER_HEADER_START;
+    for (auto& macro: macros)
+    {
+        shaderHead += DEFINE_STR + macro.name + " " + std::to_string(macro.value) + "\n";
+    }
+    shaderHead += SHADER_HEADER_TAIL;
+    return shaderHead;
+}
+
+bool ReadShaderSource(const std::string& shaderFile, std::string& shaderCode)
+{
+    std::ifstream glslSource(shaderFile, std::ifstream::in);
+    if (!glslSource.good())
+    {
+        LOGE("Failed to open GLSL source file " << shaderFile);
+        return false;
+    }
+
+    shaderCode.assign((std::istreambuf_iterator<char>(glslSource)), std::istreambuf_iterator<char>());
+    shaderCode += SHADER_HEADER_TAIL;
+    return true;
+}
+
+} // namespace
+
+ShaderType GetShaderTypeFromFileName(const std::string& filename)
+{
+    size_t dot = filename.rfind('.');
+    if (dot == std::string::npos)
+        return ShaderType::UNKNOWN;
+
+    auto it = EXTENSION_TO_TYPE.find(filename.substr(dot + 1));
+    if (it == EXTENSION_TO_TYPE.end())
+        return ShaderType::UNKNOWN;
+
+    return it->second;
+}
+
+const std::string& GetCompilerSignature()
+{
+    static const std::string signature = [] {
+        std::string spirvVersion;
+        glslang::GetSpirvVersion(spirvVersion);
+
+        std::stringstream ss;
+        ss << glslang::GetGlslVersionString() << ";" << spirvVersion << ";" << DEFAULT_VERSION << ";"
+           << static_cast<uint32_t>(DEFAULT_MESSAGES) << ";" << SHADER_HEADER_START;
+        return ss.str();
+    }();
+
+    return signature;
+}
+
+bool Preprocess(ShaderType type, const std::string& shaderFile, const ShaderMacros& macros,
+                std::string& output)
+{
+    EShLanguage lang = GetShaderLanguage(type);
+    if (lang == EShLangCount)
+    {
+        LOGE("Incorrect shader type provided");
+        return false;
+    }
+
+    std::string shaderHead = BuildShaderHeader(macros);
+    std::string shaderCode;
+    if (!ReadShaderSource(shaderFile, shaderCode))
+        return false;
+
+    const char* shaderCodeArray[] = { shaderHead.c_str(), shaderCode.c_str() };
+    glslang::TShader shader(lang);
+    shader.setStrings(shaderCodeArray, 2);
+
+    ShaderIncluder includer;
+    if (!shader.preprocess(&DEFAULT_LIMITS, DEFAULT_VERSION, ENoProfile, false, false, DEFAULT_MESSAGES,
+                           &output, includer))
+    {
+        LOGE("Failed to preprocess shader file " << shaderFile << ":");
+        LogMultiline(shader.getInfoLog());
+        return false;
+    }
+
+    return true;
+}
+
+bool Compile(ShaderType type, const std::string& shaderFile, const ShaderMacros& macros,
+             std::vector<uint32_t>& code)
+{
+    EShLanguage lang = GetShaderLanguage(type);
+    if (lang == EShLangCount)
+    {
+        LOGE("Incorrect shader type provided");
+        return false;
+    }
+
+    std::string shaderHead = BuildShaderHeader(macros);
+    std::string shaderCode;
+    if (!ReadShaderSource(shaderFile, shaderCode))
+        return false;
+
+    const char* shaderCodeArray[] = { shaderHead.c_str(), shaderCode.c_str() };
+    std::unique_ptr<glslang::TShader> shader = std::make_unique<glslang::TShader>(lang);
+    if (!shader)
+    {
+        LOGE("Failed to allocate glslang's shader for compilation");
+        return false;
+    }
+
+    shader->setStrings(shaderCodeArray, 2);
+    shader->setEntryPoint("main");
+
+    ShaderIncluder includer;
+    if (!shader->parse(&DEFAULT_LIMITS, DEFAULT_VERSION, ENoProfile, false, false, DEFAULT_MESSAGES, includer))
+    {
+        LOGE("Failed to parse shader file " << shaderFile << ":");
+        LogMultiline(shader->getInfoLog());
+        return false;
+    }
+
+    std::unique_ptr<glslang::TProgram> program = std::make_unique<glslang::TProgram>();
+    if (!program)
+    {
+        LOGE("Failed to allocate glslang's program for compilation");
+        return false;
+    }
+
+    program->addShader(shader.get());
+    if (!program->link(DEFAULT_MESSAGES))
+    {
+        LOGE("Failed to link shader " << shaderFile << ":");
+        LogMultiline(program->getInfoLog());
+        return false;
+    }
+
+    glslang::TIntermediate* intermediate = program->getIntermediate(lang);
+    if (!intermediate)
+    {
+        LOGE("Failed to extract shader's intermediate representation");
+        return false;
+    }
+
+    spv::SpvBuildLogger spvLogger;
+    glslang::GlslangToSpv(*intermediate, code, &spvLogger);
+
+    std::string logs = spvLogger.getAllMessages();
+    if (!logs.empty())
+    {
+        LOGW("GlslangToSpv returned some messages for shader " << shaderFile << ":\n" << logs);
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace ShaderCompiler
+} // namespace Renderer
+} // namespace ABench
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+namespace ABench {
+namespace Renderer {
+
+enum class ShaderType: unsigned char
+{
+    UNKNOWN = 0,
+    VERTEX,
+    TESS_CONTROL,
+    TESS_EVAL,
+    GEOMETRY,
+    FRAGMENT,
+    COMPUTE
+};
+
+struct ShaderMacroDesc
+{
+    std::string name;
+    uint32_t value;
+
+    bool operator<(const ShaderMacroDesc& b) const
+    {
+        return this->value < b.value;
+    }
+
+    ShaderMacroDesc()
+        : name()
+        , value(0)
+    {
+    }
+
+    ShaderMacroDesc(const std::string& name, uint32_t value)
+        : name(name)
+        , value(value)
+    {
+    }
+};
+
+using ShaderMacros = std::vector<ShaderMacroDesc>;
+
+/**
+ * GLSL to SPIR-V compilation, independent from Vulkan Device.
+ *
+ * Used by ShaderCache, both at runtime and in ABenchShaderc offline tool. #include directives
+ * are resolved relative to shader directory.
+ *
+ * Preprocess() and Compile() require glslang process to be initialized on calling thread.
+ */
+namespace ShaderCompiler {
+
+/**
+ * Deduces shader type from file extension (.vert, .tesc, .tese, .geom, .frag, .comp).
+ * Returns ShaderType::UNKNOWN for unrecognized extensions.
+ */
+ShaderType GetShaderTypeFromFileName(const std::string& filename);
+
+/**
+ * Describes glslang version and settings used for compilation. Any change in it invalidates
+ * previously compiled code.
+ */
+const std::string& GetCompilerSignature();
+
+/**
+ * Runs only the preprocessor on GLSL source file. Output has macros expanded and includes
+ * resolved, so it changes whenever anything affecting the compiled code changes.
+ */
+bool Preprocess(ShaderType type, const std::string& shaderFile, const ShaderMacros& macros,
+                std::string& output);
+
+/**
+ * Compiles GLSL source file with provided macros defined in its header.
+ */
+bool Compile(ShaderType type, const std::string& shaderFile, const ShaderMacros& macros,
+             std::vector<uint32_t>& code);
+
+} // namespace ShaderCompiler
+
+} // namespace Renderer
+} // namespace ABench
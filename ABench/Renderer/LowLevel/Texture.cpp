@@ -22,6 +22,7 @@ Texture::Texture()
     , mImageView(VK_NULL_HANDLE)
     , mImageMemory(VK_NULL_HANDLE)
     , mImageLayout(VK_IMAGE_LAYOUT_UNDEFINED)
+    , mImageDescriptorSetLayout(VK_NULL_HANDLE)
     , mImageDescriptorSet(VK_NULL_HANDLE)
 {
 }
@@ -30,12 +31,17 @@ Texture::~Texture()
 {
     LOGM("Destroying Texture (image " << std::hex << mImage << " view " << mImageView << " res " << std::dec << mWidth << "x" << mHeight << ")");
 
+    if (mImageDescriptorSet != VK_NULL_HANDLE)
+        DescriptorAllocator::Instance().FreeDescriptorSet(mImageDescriptorSetLayout, mImageDescriptorSet);
     if (mImageMemory != VK_NULL_HANDLE)
-        vkFreeMemory(mDevice->GetDevice(), mImageMemory, nullptr);
+        mDevice->FreeMemory(mImageMemory);
     if (mImageView != VK_NULL_HANDLE)
         vkDestroyImageView(mDevice->GetDevice(), mImageView, nullptr);
     if (mImage != VK_NULL_HANDLE)
+    {
         vkDestroyImage(mDevice->GetDevice(), mImage, nullptr);
+        mDevice->GetStatistics().OnDestroy(TrackedObject::Image);
+    }
 }
 
 bool Texture::Init(const DevicePtr& device, const TextureDesc& desc)
@@ -59,6 +65,7 @@ bool Texture::Init(const DevicePtr& device, const TextureDesc& desc)
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
     VkResult result = vkCreateImage(mDevice->GetDevice(), &imageInfo, nullptr, &mImage);
     RETURN_FALSE_IF_FAILED(result, "Failed to create Image for texture");
+    mDevice->GetStatistics().OnCreate(TrackedObject::Image);
 
     VkMemoryRequirements memReqs;
     vkGetImageMemoryRequirements(mDevice->GetDevice(), mImage, &memReqs);
@@ -68,7 +75,7 @@ bool Texture::Init(const DevicePtr& device, const TextureDesc& desc)
     memInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     memInfo.memoryTypeIndex = mDevice->GetMemoryTypeIndex(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
     memInfo.allocationSize = memReqs.size;
-    result = vkAllocateMemory(mDevice->GetDevice(), &memInfo, nullptr, &mImageMemory);
+    result = mDevice->AllocateMemory(memInfo, mImageMemory);
     RETURN_FALSE_IF_FAILED(result, "Failed to allocate memory for Image");
 
     result = vkBindImageMemory(mDevice->GetDevice(), mImage, mImageMemory, 0);
@@ -202,6 +209,8 @@ bool Texture::AllocateDescriptorSet(VkDescriptorSetLayout layout)
     if (mImageDescriptorSet == VK_NULL_HANDLE)
         return false;
 
+    mImageDescriptorSetLayout = layout;
+
     Tools::UpdateTextureDescriptorSet(mDevice, mImageDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 0, mImageView);
     return true;
 }
@@ -64,6 +64,7 @@ class Texture
     VkDeviceMemory mImageMemory;
     VkImageLayout mImageLayout;
     VkImageSubresourceRange mSubresourceRange;
+    VkDescriptorSetLayout mImageDescriptorSetLayout;
     VkDescriptorSet mImageDescriptorSet;
 
 public:
@@ -3,6 +3,7 @@
 
 #include "Util.hpp"
 #include "Extensions.hpp"
+#include "DescriptorAllocator.hpp"
 #include "Renderer/HighLevel/Renderer.hpp"
 
 #include "Common/Common.hpp"
@@ -44,22 +45,89 @@ VkRAII<VkSemaphore> Tools::CreateSem(const DevicePtr& device)
     });
 }
 
+VkRAII<VkSemaphore> Tools::CreateTimelineSem(const DevicePtr& device, uint64_t initialValue)
+{
+    VkSemaphore sem;
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo;
+    ZERO_MEMORY(typeInfo);
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = initialValue;
+
+    VkSemaphoreCreateInfo info;
+    ZERO_MEMORY(info);
+    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    info.pNext = &typeInfo;
+
+    VkResult result = vkCreateSemaphore(device->GetDevice(), &info, nullptr, &sem);
+    RETURN_EMPTY_VKRAII_IF_FAILED(VkSemaphore, result, "Failed to create timeline semaphore");
+
+    return VkRAII<VkSemaphore>(sem, [device](VkSemaphore s) {
+        vkDestroySemaphore(device->GetDevice(), s, nullptr);
+    });
+}
+
+VkRAII<VkCommandPool> Tools::CreateCommandPool(const DevicePtr& device, DeviceQueueType queueType, VkCommandPoolCreateFlags flags)
+{
+    VkCommandPool pool;
+
+    VkCommandPoolCreateInfo info;
+    ZERO_MEMORY(info);
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    info.queueFamilyIndex = device->GetQueueIndex(queueType);
+    info.flags = flags;
+
+    VkResult result = vkCreateCommandPool(device->GetDevice(), &info, nullptr, &pool);
+    RETURN_EMPTY_VKRAII_IF_FAILED(VkCommandPool, result, "Failed to create Command Pool");
+
+    return VkRAII<VkCommandPool>(pool, [device](VkCommandPool p) {
+        vkDestroyCommandPool(device->GetDevice(), p, nullptr);
+    });
+}
+
+VkRAII<VkQueryPool> Tools::CreateTimestampQueryPool(const DevicePtr& device, uint32_t queryCount)
+{
+    VkQueryPool pool;
+
+    VkQueryPoolCreateInfo info;
+    ZERO_MEMORY(info);
+    info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    info.queryCount = queryCount;
+
+    VkResult result = vkCreateQueryPool(device->GetDevice(), &info, nullptr, &pool);
+    RETURN_EMPTY_VKRAII_IF_FAILED(VkQueryPool, result, "Failed to create timestamp query pool");
+
+    return VkRAII<VkQueryPool>(pool, [device](VkQueryPool p) {
+        vkDestroyQueryPool(device->GetDevice(), p, nullptr);
+    });
+}
+
 VkRAII<VkDescriptorSetLayout> Tools::CreateDescriptorSetLayout(const DevicePtr& device, const std::vector<DescriptorSetLayoutDesc>& descriptors)
 {
     VkDescriptorSetLayout layout = VK_NULL_HANDLE;
 
     std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<std::vector<VkSampler>> samplerArrays(descriptors.size());
+    uint32_t counts[VK_DESCRIPTOR_TYPE_RANGE_SIZE] = { 0 };
 
     for (uint32_t i = 0; i < descriptors.size(); ++i)
     {
+        counts[descriptors[i].type] += descriptors[i].count;
+
         VkDescriptorSetLayoutBinding binding;
         ZERO_MEMORY(binding);
-        binding.descriptorCount = 1;
+        binding.descriptorCount = descriptors[i].count;
         binding.binding = i;
         binding.descriptorType = descriptors[i].type;
         binding.stageFlags = descriptors[i].stage;
         if (descriptors[i].sampler != VK_NULL_HANDLE)
-            binding.pImmutableSamplers = &descriptors[i].sampler;
+        {
+            // immutable samplers have to be provided for each array element
+            samplerArrays[i].resize(descriptors[i].count, descriptors[i].sampler);
+            binding.pImmutableSamplers = samplerArrays[i].data();
+        }
 
         bindings.push_back(binding);
     }
@@ -72,12 +140,16 @@ VkRAII<VkDescriptorSetLayout> Tools::CreateDescriptorSetLayout(const DevicePtr&
     VkResult result = vkCreateDescriptorSetLayout(device->GetDevice(), &info, nullptr, &layout);
     RETURN_EMPTY_VKRAII_IF_FAILED(VkDescriptorSetLayout, result, "Failed to create Descriptor Set Layout");
 
+    DescriptorAllocator::Instance().RegisterLayout(layout, counts);
+
     return VkRAII<VkDescriptorSetLayout>(layout, [device](VkDescriptorSetLayout dsl) {
+        DescriptorAllocator::Instance().UnregisterLayout(dsl);
         vkDestroyDescriptorSetLayout(device->GetDevice(), dsl, nullptr);
     });
 }
 
-VkRAII<VkPipelineLayout> Tools::CreatePipelineLayout(const DevicePtr& device, const std::vector<VkDescriptorSetLayout>& setLayouts)
+VkRAII<VkPipelineLayout> Tools::CreatePipelineLayout(const DevicePtr& device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                                     const std::vector<VkPushConstantRange>& pushConstants)
 {
     VkPipelineLayout layout = VK_NULL_HANDLE;
 
@@ -86,6 +158,8 @@ VkRAII<VkPipelineLayout> Tools::CreatePipelineLayout(const DevicePtr& device, co
     info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     info.pSetLayouts = setLayouts.data();
     info.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    info.pPushConstantRanges = pushConstants.data();
+    info.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
     VkResult result = vkCreatePipelineLayout(device->GetDevice(), &info, nullptr, &layout);
     RETURN_EMPTY_VKRAII_IF_FAILED(VkPipelineLayout, result, "Failed to create Pipeline Layout");
 
@@ -226,7 +300,8 @@ void Tools::UpdateBufferDescriptorSet(const DevicePtr& device, VkDescriptorSet s
     vkUpdateDescriptorSets(device->GetDevice(), 1, &write, 0, nullptr);
 }
 
-void Tools::UpdateTextureDescriptorSet(const DevicePtr& device, VkDescriptorSet set, VkDescriptorType type, uint32_t binding, VkImageView view)
+void Tools::UpdateTextureDescriptorSet(const DevicePtr& device, VkDescriptorSet set, VkDescriptorType type, uint32_t binding, VkImageView view,
+                                       uint32_t arrayElement)
 {
     VkDescriptorImageInfo imgInfo;
     ZERO_MEMORY(imgInfo);
@@ -237,7 +312,7 @@ void Tools::UpdateTextureDescriptorSet(const DevicePtr& device, VkDescriptorSet
     writeSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     writeSet.dstSet = set;
     writeSet.dstBinding = binding;
-    writeSet.dstArrayElement = 0;
+    writeSet.dstArrayElement = arrayElement;
     writeSet.descriptorCount = 1;
     writeSet.descriptorType = type;
     writeSet.pImageInfo = &imgInfo;
@@ -16,18 +16,21 @@ struct DescriptorSetLayoutDesc
     VkDescriptorType type;
     VkShaderStageFlags stage;
     VkSampler sampler;
+    uint32_t count; // >1 creates an array binding; sampler, if provided, is used for all elements
 
     DescriptorSetLayoutDesc()
         : type(VK_DESCRIPTOR_TYPE_SAMPLER)
         , stage(0)
         , sampler(VK_NULL_HANDLE)
+        , count(1)
     {
     }
 
-    DescriptorSetLayoutDesc(VkDescriptorType type, VkShaderStageFlags stage, VkSampler sampler)
+    DescriptorSetLayoutDesc(VkDescriptorType type, VkShaderStageFlags stage, VkSampler sampler, uint32_t count = 1)
         : type(type)
         , stage(stage)
         , sampler(sampler)
+        , count(count)
     {
     }
 };
@@ -53,11 +56,21 @@ public:
     // Semaphore creation (we cannot call this "CreateSemaphore" >:( WinAPI has the same define )
     static VkRAII<VkSemaphore> CreateSem(const DevicePtr& device);
 
+    // Timeline Semaphore creation, Device must have timeline semaphores enabled
+    static VkRAII<VkSemaphore> CreateTimelineSem(const DevicePtr& device, uint64_t initialValue);
+
+    // Command Pool creation, for queue family matching provided queue type
+    static VkRAII<VkCommandPool> CreateCommandPool(const DevicePtr& device, DeviceQueueType queueType, VkCommandPoolCreateFlags flags);
+
+    // Query Pool creation, for queryCount timestamp queries
+    static VkRAII<VkQueryPool> CreateTimestampQueryPool(const DevicePtr& device, uint32_t queryCount);
+
     // Descriptor Set Layout creation
     static VkRAII<VkDescriptorSetLayout> CreateDescriptorSetLayout(const DevicePtr& device, const std::vector<DescriptorSetLayoutDesc>& descriptors);
 
     // VkPipelineLayout creation, sets and setCount can be null/zero.
-    static VkRAII<VkPipelineLayout> CreatePipelineLayout(const DevicePtr& device, const std::vector<VkDescriptorSetLayout>& setLayouts);
+    static VkRAII<VkPipelineLayout> CreatePipelineLayout(const DevicePtr& device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                                         const std::vector<VkPushConstantRange>& pushConstants = {});
 
     // VkRenderPass creation
     static VkAttachmentDescription CreateAttachmentDescription(VkFormat format, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp,
@@ -73,7 +86,8 @@ public:
 
     // Updating descriptor sets
     static void UpdateBufferDescriptorSet(const DevicePtr& device, VkDescriptorSet set, VkDescriptorType type, uint32_t binding, VkBuffer buffer, VkDeviceSize size);
-    static void UpdateTextureDescriptorSet(const DevicePtr& device, VkDescriptorSet set, VkDescriptorType type, uint32_t binding, VkImageView view);
+    static void UpdateTextureDescriptorSet(const DevicePtr& device, VkDescriptorSet set, VkDescriptorType type, uint32_t binding, VkImageView view,
+                                           uint32_t arrayElement = 0);
 };
 
 } // namespace Renderer
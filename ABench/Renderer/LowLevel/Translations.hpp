@@ -6,6 +6,7 @@ namespace ABench {
 namespace Renderer {
 
 uint32_t TranslateVkFormatToFormatSize(VkFormat format);
+const char* TranslateVkDescriptorTypeToString(VkDescriptorType type);
 const char* TranslateVkFormatToString(VkFormat format);
 const char* TranslateVkPhysicalDeviceTypeToString(VkPhysicalDeviceType type);
 const char* TranslateVkQueueFlagsToString(VkQueueFlags flags);
@@ -10,6 +10,7 @@ const std::string TEXTURES = DATA_ROOT + "/Textures";
 const std::string SCENES = DATA_ROOT + "/FBX";
 const std::string SHADERS = DATA_ROOT + "/Shaders";
 const std::string SHADER_CACHE = DATA_ROOT + "/ShaderCache";
+const std::string BENCHMARKS = DATA_ROOT + "/Benchmarks";
 
 } // namespace ResourceDir
 } // namespace ABench
@@ -9,6 +9,7 @@ extern const std::string TEXTURES;
 extern const std::string SCENES;
 extern const std::string SHADERS;
 extern const std::string SHADER_CACHE;
+extern const std::string BENCHMARKS;
 
 } // namespace ResourceDir
 } // namespace ABench
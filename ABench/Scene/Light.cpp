@@ -4,9 +4,14 @@
 namespace ABench {
 namespace Scene {
 
-Light::Light(const std::string& name)
+Light::Light(const std::string& name, std::vector<LightData>* container, uint32_t* generation)
     : Component(name)
+    , mContainer(container)
+    , mIndex(static_cast<uint32_t>(container->size()))
+    , mGeneration(generation)
 {
+    mContainer->emplace_back();
+    (*mGeneration)++;
 }
 
 Light::~Light()
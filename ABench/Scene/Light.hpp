@@ -4,6 +4,8 @@
 #include "Common/Common.hpp"
 #include "Math/Vector.hpp"
 
+#include <vector>
+
 
 namespace ABench {
 namespace Scene {
@@ -25,14 +27,31 @@ struct LightData
     }
 };
 
+/**
+ * Point light. Its data is not stored in the component, but in Scene's packed array of all
+ * lights, so renderer can upload every light with a single copy.
+ */
 class Light: public Component
 {
     friend class Scene;
 
-    LightData mLightData;
+    std::vector<LightData>* mContainer; // owned by Scene, lights are never removed from it
+    uint32_t mIndex;
+    uint32_t* mGeneration; // Scene's light data generation, bumped when light's bounds change
+
+    ABENCH_INLINE LightData& Data()
+    {
+        return (*mContainer)[mIndex];
+    }
+
+    ABENCH_INLINE const LightData& Data() const
+    {
+        return (*mContainer)[mIndex];
+    }
 
 public:
-    Light(const std::string& name);
+    // Appends new light's data to the container
+    Light(const std::string& name, std::vector<LightData>* container, uint32_t* generation);
     ~Light();
 
     ABENCH_INLINE void SetPosition(float x, float y, float z)
@@ -42,37 +61,39 @@ public:
 
     ABENCH_INLINE void SetPosition(const Math::Vector4& position)
     {
-        mLightData.position = position;
+        Data().position = position;
+        (*mGeneration)++;
     }
 
     ABENCH_INLINE void SetDiffuseIntensity(const Math::Vector3& intensity)
     {
-        mLightData.diffuseIntensity = intensity;
+        Data().diffuseIntensity = intensity;
     }
 
     ABENCH_INLINE void SetRange(float range)
     {
-        mLightData.range = range;
+        Data().range = range;
+        (*mGeneration)++;
     }
 
     ABENCH_INLINE const Math::Vector4& GetPosition() const
     {
-        return mLightData.position;
+        return Data().position;
     }
 
     ABENCH_INLINE const Math::Vector3& GetDiffuseIntensity() const
     {
-        return mLightData.diffuseIntensity;
+        return Data().diffuseIntensity;
     }
 
     ABENCH_INLINE float GetRange() const
     {
-        return mLightData.range;
+        return Data().range;
     }
 
     ABENCH_INLINE const LightData* GetData() const
     {
-        return &mLightData;
+        return &Data();
     }
 
     ABENCH_INLINE ComponentType GetType() const override
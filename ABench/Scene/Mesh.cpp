@@ -3,6 +3,7 @@
 
 #include "Common/Common.hpp"
 #include "Common/Logger.hpp"
+#include "Common/Profiler.hpp"
 
 using namespace ABench::Renderer;
 
@@ -74,6 +75,8 @@ bool Mesh::InitBuffers(const std::vector<Vertex>& vertices,
 
 bool Mesh::InitFromFBX(FbxMesh* mesh, int materialIndex)
 {
+    PROFILER_SCOPE("Mesh::InitFromFBX");
+
     // find UV layer
     FbxLayerElementUV* uvs = nullptr;
     int uvLayer = 0;
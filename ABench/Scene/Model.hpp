@@ -78,6 +78,11 @@ public:
         return &mMeshes[i];
     }
 
+    ABENCH_INLINE uint32_t GetMeshCount() const
+    {
+        return static_cast<uint32_t>(mMeshes.size());
+    }
+
     ABENCH_INLINE const Math::Vector4& GetPosition() const
     {
         return mPosition;
@@ -2,12 +2,14 @@
 #include "Scene.hpp"
 
 #include "Common/Logger.hpp"
+#include "Common/Profiler.hpp"
 
 
 namespace ABench {
 namespace Scene {
 
 Scene::Scene()
+    : mLightDataGeneration(0)
 {
 }
 
@@ -42,6 +44,8 @@ Math::Vector4 Scene::ColorVector4FromMaterial(FbxSurfaceMaterial* material)
 
 bool Scene::Init(const std::string& fbxFile)
 {
+    PROFILER_SCOPE("Scene::Init");
+
     if (!fbxFile.empty())
     {
         LOGD("Loading scene from FBX file");
@@ -158,7 +162,7 @@ GetResult<Component> Scene::GetLightComponent(const std::string& name)
     auto light = mLightComponents.find(name);
     if (light == mLightComponents.end())
     {
-        light = mLightComponents.insert(std::make_pair(name, std::make_unique<Light>(name))).first;
+        light = mLightComponents.insert(std::make_pair(name, std::make_unique<Light>(name, &mLightData, &mLightDataGeneration))).first;
         created = true;
     }
 
@@ -28,6 +28,8 @@ class Scene
     std::vector<Object> mObjects;
     ResourceMap<Model> mModelComponents;
     ResourceMap<Light> mLightComponents;
+    std::vector<LightData> mLightData; // data of all Light components, in order of creation
+    uint32_t mLightDataGeneration;
     ResourceMap<Emitter> mEmitterComponents;
     ResourceMap<Material> mMaterials;
 
@@ -52,6 +54,23 @@ public:
     void ForEachEmitter(Callback<Emitter> func) const;
     void ForEachObject(Callback<Object> func) const;
 
+    // Data of all lights packed one after another, ready to be uploaded with a single copy
+    ABENCH_INLINE const std::vector<LightData>& GetLightData() const
+    {
+        return mLightData;
+    }
+
+    ABENCH_INLINE uint32_t GetLightCount() const
+    {
+        return static_cast<uint32_t>(mLightData.size());
+    }
+
+    // Changes whenever a light is added or its position or range changes
+    ABENCH_INLINE uint32_t GetLightDataGeneration() const
+    {
+        return mLightDataGeneration;
+    }
+
     ABENCH_INLINE uint32_t GetEmitterCount() const
     {
         return static_cast<uint32_t>(mEmitterComponents.size());
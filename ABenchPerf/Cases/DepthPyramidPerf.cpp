@@ -0,0 +1,89 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Renderer/HighLevel/DepthPyramid.hpp"
+
+using namespace ABench::Math;
+using namespace ABench::Renderer;
+using ABench::Perf::DoNotOptimize;
+
+
+namespace {
+
+const uint32_t RANDOM_SEED = 0;
+const uint32_t VIEWPORT_WIDTH = 1280;
+const uint32_t VIEWPORT_HEIGHT = 720;
+const uint32_t CPU_OCCLUSION_FIRST_LEVEL = 2; // same as Renderer
+
+Matrix CreateProjection()
+{
+    return CreateRHProjectionMatrix(60.0f, static_cast<float>(VIEWPORT_WIDTH) / VIEWPORT_HEIGHT, 0.2f, 500.0f);
+}
+
+// wall in the lower half of the screen and far background above it, like arcades of an atrium
+std::vector<float> CreateDepth()
+{
+    std::vector<float> depth(VIEWPORT_WIDTH * VIEWPORT_HEIGHT);
+    for (uint32_t y = 0; y < VIEWPORT_HEIGHT; ++y)
+        for (uint32_t x = 0; x < VIEWPORT_WIDTH; ++x)
+            depth[y * VIEWPORT_WIDTH + x] = (y > VIEWPORT_HEIGHT / 2) ? 0.98f : 0.9999f;
+
+    return depth;
+}
+
+// model sized boxes spread in front of the camera
+std::vector<AABB> RandomBoxes(uint32_t count)
+{
+    std::mt19937 gen(RANDOM_SEED);
+    std::uniform_real_distribution<float> posDist(-30.0f, 30.0f);
+    std::uniform_real_distribution<float> depthDist(-80.0f, -1.0f);
+    std::uniform_real_distribution<float> sizeDist(0.2f, 4.0f);
+
+    std::vector<AABB> boxes(count);
+    for (auto& b: boxes)
+    {
+        Vector4 center(posDist(gen), posDist(gen), depthDist(gen), 1.0f);
+        Vector4 extent(sizeDist(gen), sizeDist(gen), sizeDist(gen), 0.0f);
+        b = AABB(center - extent, center + extent);
+    }
+
+    return boxes;
+}
+
+} // namespace
+
+
+PERF_CASE(DepthPyramid, Build)
+{
+    DepthPyramid pyramid;
+    pyramid.Init(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    std::vector<float> depth = CreateDepth();
+    while (state.KeepRunning())
+    {
+        pyramid.Build(depth.data());
+        DoNotOptimize(pyramid.GetData());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * depth.size());
+}
+
+PERF_CASE_SCALED(DepthPyramid, IsOccluded, 256, 1024, 4096)
+{
+    DepthPyramid pyramid;
+    pyramid.Init(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    std::vector<float> depth = CreateDepth();
+    pyramid.Build(depth.data());
+    pyramid.SetFirstLevel(CPU_OCCLUSION_FIRST_LEVEL);
+
+    Matrix viewProj = CreateProjection();
+    std::vector<AABB> boxes = RandomBoxes(state.GetParam());
+    while (state.KeepRunning())
+    {
+        uint32_t occluded = 0;
+        for (const auto& b: boxes)
+            occluded += pyramid.IsOccluded(b, viewProj) ? 1 : 0;
+        DoNotOptimize(occluded);
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * boxes.size());
+}
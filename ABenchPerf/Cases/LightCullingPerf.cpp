@@ -0,0 +1,175 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Renderer/HighLevel/LightCullingReference.hpp"
+#include "Renderer/HighLevel/ClusterGrid.hpp"
+#include "Renderer/HighLevel/LightBVH.hpp"
+#include "ABenchTest/Tests/RendererTestHelpers.hpp"
+
+using namespace ABench::Math;
+using namespace ABench::Renderer;
+using ABench::Perf::DoNotOptimize;
+
+
+namespace {
+
+const uint32_t RANDOM_SEED = 0;
+const uint32_t VIEWPORT_WIDTH = 640;
+const uint32_t VIEWPORT_HEIGHT = 360;
+
+GridFrustumsGenerationDesc CreateGridDesc()
+{
+    GridFrustumsGenerationDesc desc;
+    desc.projMat = CreateRHProjectionMatrix(60.0f, static_cast<float>(VIEWPORT_WIDTH) / VIEWPORT_HEIGHT, 0.2f, 500.0f);
+    desc.viewportWidth = VIEWPORT_WIDTH;
+    desc.viewportHeight = VIEWPORT_HEIGHT;
+    desc.pixelsPerGridFrustum = 16;
+    return desc;
+}
+
+ClusterGridDesc CreateClusterDesc()
+{
+    ClusterGridDesc desc;
+    desc.projMat = CreateRHProjectionMatrix(60.0f, static_cast<float>(VIEWPORT_WIDTH) / VIEWPORT_HEIGHT, 0.2f, 500.0f);
+    desc.viewportWidth = VIEWPORT_WIDTH;
+    desc.viewportHeight = VIEWPORT_HEIGHT;
+    desc.pixelsPerCluster = 64;
+    desc.depthSlices = 32;
+    desc.nearZ = 0.2f;
+    desc.farZ = 500.0f;
+    return desc;
+}
+
+// small lights spread in front of the camera, like in the light-heavy scenes
+std::vector<LightSphere> CreateLights(uint32_t count)
+{
+    return RandomLights(count, RANDOM_SEED, Vector3(-40.0f, -40.0f, -80.0f), Vector3(40.0f, 40.0f, -1.0f), 0.5f, 3.0f);
+}
+
+// floor sloping away from the camera, so tiles get different depth ranges
+std::vector<float> CreateDepth()
+{
+    std::vector<float> depth(VIEWPORT_WIDTH * VIEWPORT_HEIGHT);
+    for (uint32_t y = 0; y < VIEWPORT_HEIGHT; ++y)
+        for (uint32_t x = 0; x < VIEWPORT_WIDTH; ++x)
+            depth[y * VIEWPORT_WIDTH + x] = 0.999f - 0.02f * y / VIEWPORT_HEIGHT;
+
+    return depth;
+}
+
+} // namespace
+
+
+PERF_CASE(LightCulling, GenerateFrustums)
+{
+    GridFrustumsGenerationDesc desc = CreateGridDesc();
+    LightCullingReference culler;
+    while (state.KeepRunning())
+    {
+        culler.Init(desc);
+        DoNotOptimize(culler.GetFrustums().data());
+    }
+}
+
+PERF_CASE_SCALED(LightCulling, Cull, 1024, 4096, 16384)
+{
+    LightCullingReference culler;
+    culler.Init(CreateGridDesc());
+    std::vector<LightSphere> lights = CreateLights(state.GetParam());
+    std::vector<float> depth = CreateDepth();
+    while (state.KeepRunning())
+    {
+        culler.Cull(MATRIX_IDENTITY, lights.data(), static_cast<uint32_t>(lights.size()), depth.data());
+        DoNotOptimize(culler.GetCulledLights().data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * lights.size());
+}
+
+PERF_CASE(LightCulling, BuildClusters)
+{
+    ClusterGridDesc desc = CreateClusterDesc();
+    ClusterGrid grid;
+    while (state.KeepRunning())
+    {
+        grid.Init(desc);
+        DoNotOptimize(grid.GetClusters().data());
+    }
+}
+
+PERF_CASE_SCALED(LightCulling, CullClustered, 1024, 4096, 16384)
+{
+    ClusterGrid grid;
+    grid.Init(CreateClusterDesc());
+    std::vector<LightSphere> lights = CreateLights(state.GetParam());
+    while (state.KeepRunning())
+    {
+        grid.Cull(MATRIX_IDENTITY, lights.data(), static_cast<uint32_t>(lights.size()));
+        DoNotOptimize(grid.GetCulledLights().data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * lights.size());
+}
+
+// brute force and BVH walk at light counts where the former stops scaling, lists are the same
+PERF_CASE_SCALED(LightCulling, CullBruteForce, 1000, 10000, 100000)
+{
+    LightCullingReference culler;
+    culler.Init(CreateGridDesc());
+    std::vector<LightSphere> lights = CreateLights(state.GetParam());
+    std::vector<float> depth = CreateDepth();
+    while (state.KeepRunning())
+    {
+        culler.Cull(MATRIX_IDENTITY, lights.data(), static_cast<uint32_t>(lights.size()), depth.data());
+        DoNotOptimize(culler.GetCulledLights().data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * lights.size());
+}
+
+PERF_CASE_SCALED(LightCulling, BuildBVH, 1000, 10000, 100000)
+{
+    LightBVH bvh;
+    std::vector<LightSphere> lights = CreateLights(state.GetParam());
+    while (state.KeepRunning())
+    {
+        bvh.Build(lights.data(), static_cast<uint32_t>(lights.size()));
+        DoNotOptimize(bvh.GetNodes().data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * lights.size());
+}
+
+// BVH is built once, as renderer rebuilds it only when lights change
+PERF_CASE_SCALED(LightCulling, CullBVH, 1000, 10000, 100000)
+{
+    LightCullingReference culler;
+    culler.Init(CreateGridDesc());
+    std::vector<LightSphere> lights = CreateLights(state.GetParam());
+    LightBVH bvh;
+    bvh.Build(lights.data(), static_cast<uint32_t>(lights.size()));
+    std::vector<float> depth = CreateDepth();
+    while (state.KeepRunning())
+    {
+        culler.Cull(MATRIX_IDENTITY, bvh, depth.data());
+        DoNotOptimize(culler.GetCulledLights().data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * lights.size());
+}
+
+PERF_CASE_SCALED(LightCulling, CullClusteredBVH, 1000, 10000, 100000)
+{
+    ClusterGrid grid;
+    grid.Init(CreateClusterDesc());
+    std::vector<LightSphere> lights = CreateLights(state.GetParam());
+    LightBVH bvh;
+    bvh.Build(lights.data(), static_cast<uint32_t>(lights.size()));
+    while (state.KeepRunning())
+    {
+        grid.Cull(MATRIX_IDENTITY, bvh);
+        DoNotOptimize(grid.GetCulledLights().data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * lights.size());
+}
@@ -0,0 +1,224 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Math/AABB.hpp"
+#include "Math/Frustum.hpp"
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+#include "Math/Interpolation/LinearInterpolator.hpp"
+#include "Math/Interpolation/CubicInterpolator.hpp"
+
+using namespace ABench::Math;
+using ABench::Perf::DoNotOptimize;
+
+
+namespace {
+
+const uint32_t RANDOM_SEED = 0;
+
+float RandomFloat(std::mt19937& gen, float min, float max)
+{
+    std::uniform_real_distribution<float> dist(min, max);
+    return dist(gen);
+}
+
+Vector4 RandomPoint(std::mt19937& gen, float extent)
+{
+    return Vector4(RandomFloat(gen, -extent, extent), RandomFloat(gen, -extent, extent),
+                   RandomFloat(gen, -extent, extent), 1.0f);
+}
+
+// boxes scattered around the origin, similar in size to scene objects
+std::vector<AABB> RandomAABBs(uint32_t count)
+{
+    std::mt19937 gen(RANDOM_SEED);
+    std::vector<AABB> boxes;
+    boxes.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Vector4 center = RandomPoint(gen, 50.0f);
+        Vector4 halfSize(RandomFloat(gen, 0.1f, 2.0f), RandomFloat(gen, 0.1f, 2.0f), RandomFloat(gen, 0.1f, 2.0f), 0.0f);
+        boxes.emplace_back(center - halfSize, center + halfSize);
+    }
+
+    return boxes;
+}
+
+Frustum CreateFrustum()
+{
+    FrustumDesc desc;
+    desc.fov = 60.0f;
+    desc.ratio = 16.0f / 9.0f;
+    desc.nearZ = 0.2f;
+    desc.farZ = 500.0f;
+
+    Frustum frustum;
+    frustum.Init(desc);
+    frustum.Refresh(Vector3(0.0f, 1.0f, -2.0f), Vector3(0.0f, 1.0f, 1.0f), Vector3(0.0f, -1.0f, 0.0f));
+    return frustum;
+}
+
+} // namespace
+
+
+PERF_CASE(Vector4, Add)
+{
+    Vector4 a(1.0f, 2.0f, 3.0f, 4.0f);
+    Vector4 b(0.5f, 0.25f, 0.125f, 0.0f);
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(a);
+        DoNotOptimize(a + b);
+    }
+}
+
+PERF_CASE(Vector4, Dot)
+{
+    Vector4 a(1.0f, 2.0f, 3.0f, 4.0f);
+    Vector4 b(0.5f, 0.25f, 0.125f, 0.0f);
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(a);
+        DoNotOptimize(a.Dot(b));
+    }
+}
+
+PERF_CASE(Vector4, Cross)
+{
+    Vector4 a(1.0f, 2.0f, 3.0f, 0.0f);
+    Vector4 b(0.5f, 0.25f, 0.125f, 0.0f);
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(a);
+        DoNotOptimize(a.Cross(b));
+    }
+}
+
+PERF_CASE(Vector4, Normalize)
+{
+    Vector4 a(1.0f, 2.0f, 3.0f, 0.0f);
+    while (state.KeepRunning())
+    {
+        Vector4 v = a;
+        DoNotOptimize(v);
+        v.Normalize();
+        DoNotOptimize(v);
+    }
+}
+
+PERF_CASE(Matrix, Multiply)
+{
+    Matrix a = CreateRotationMatrixY(0.3f) * CreateTranslationMatrix(Vector4(1.0f, 2.0f, 3.0f, 1.0f));
+    Matrix b = CreateRHProjectionMatrix(60.0f, 16.0f / 9.0f, 0.2f, 500.0f);
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(a);
+        DoNotOptimize(a * b);
+    }
+}
+
+PERF_CASE(Matrix, TransformVector)
+{
+    Matrix m = CreateRotationMatrixY(0.3f) * CreateTranslationMatrix(Vector4(1.0f, 2.0f, 3.0f, 1.0f));
+    Vector4 v(1.0f, 2.0f, 3.0f, 1.0f);
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(v);
+        DoNotOptimize(m * v);
+    }
+}
+
+PERF_CASE_SCALED(AABB, Transform, 64, 1024, 16384)
+{
+    std::vector<AABB> boxes = RandomAABBs(state.GetParam());
+    Matrix m = CreateTranslationMatrix(Vector4(1.0f, 2.0f, 3.0f, 1.0f)) * CreateScaleMatrix(2.0f);
+    while (state.KeepRunning())
+    {
+        for (auto& b: boxes)
+            DoNotOptimize(m * b);
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * boxes.size());
+}
+
+PERF_CASE_SCALED(Frustum, Intersects, 64, 1024, 16384)
+{
+    std::vector<AABB> boxes = RandomAABBs(state.GetParam());
+    Frustum frustum = CreateFrustum();
+    while (state.KeepRunning())
+    {
+        uint32_t visible = 0;
+        for (auto& b: boxes)
+            visible += frustum.Intersects(b) ? 1 : 0;
+        DoNotOptimize(visible);
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * boxes.size());
+}
+
+// what Renderer does for every model each frame - transform the box and test it
+PERF_CASE_SCALED(Frustum, TransformAndIntersect, 64, 1024, 16384)
+{
+    std::vector<AABB> boxes = RandomAABBs(state.GetParam());
+    Frustum frustum = CreateFrustum();
+    Matrix m = CreateTranslationMatrix(Vector4(1.0f, 0.0f, 3.0f, 1.0f));
+    while (state.KeepRunning())
+    {
+        uint32_t visible = 0;
+        for (auto& b: boxes)
+            visible += frustum.Intersects(m * b) ? 1 : 0;
+        DoNotOptimize(visible);
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * boxes.size());
+}
+
+PERF_CASE(Frustum, Refresh)
+{
+    Frustum frustum = CreateFrustum();
+    Vector3 pos(0.0f, 1.0f, -2.0f);
+    Vector3 at(0.0f, 1.0f, 1.0f);
+    Vector3 up(0.0f, -1.0f, 0.0f);
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(pos);
+        frustum.Refresh(pos, at, up);
+        DoNotOptimize(frustum);
+    }
+}
+
+PERF_CASE_SCALED(Interpolator, Linear, 8, 128)
+{
+    std::mt19937 gen(RANDOM_SEED);
+    LinearInterpolator interpolator;
+    for (uint32_t i = 0; i < state.GetParam(); ++i)
+        interpolator.Add(Vector3(RandomPoint(gen, 20.0f)));
+
+    float range = static_cast<float>(state.GetParam() - 1);
+    float factor = 0.0f;
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(interpolator.Interpolate(factor));
+        factor += 0.01f;
+        if (factor >= range)
+            factor = 0.0f;
+    }
+}
+
+PERF_CASE_SCALED(Interpolator, Cubic, 8, 128)
+{
+    std::mt19937 gen(RANDOM_SEED);
+    CubicInterpolator interpolator;
+    for (uint32_t i = 0; i < state.GetParam(); ++i)
+        interpolator.Add(Vector3(RandomPoint(gen, 20.0f)));
+
+    float range = static_cast<float>(state.GetParam() - 1);
+    float factor = 0.0f;
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(interpolator.Interpolate(factor));
+        factor += 0.01f;
+        if (factor >= range)
+            factor = 0.0f;
+    }
+}
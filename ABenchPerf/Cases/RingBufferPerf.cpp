@@ -0,0 +1,68 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Renderer/LowLevel/Instance.hpp"
+#include "Renderer/LowLevel/Device.hpp"
+#include "Renderer/LowLevel/RingBuffer.hpp"
+
+using namespace ABench;
+using ABench::Perf::DoNotOptimize;
+
+
+namespace {
+
+const VkDeviceSize RING_BUFFER_SIZE = 1024 * 1024;
+const uint32_t WRITES_PER_FRAME = 128;
+
+bool CreateDevice(Perf::State& state, Renderer::DevicePtr& device)
+{
+    Renderer::InstancePtr instance = std::make_shared<Renderer::Instance>();
+    if (!instance->Init(0, true))
+    {
+        state.Skip("Vulkan Instance is not available");
+        return false;
+    }
+
+    device = std::make_shared<Renderer::Device>();
+    if (!device->Init(instance, false))
+    {
+        state.Skip("Vulkan Device is not available");
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+
+// per-object constant data written while recording - param is size of a single write
+PERF_CASE_SCALED(RingBuffer, Write, 64, 256, 4096)
+{
+    Renderer::DevicePtr device;
+    if (!CreateDevice(state, device))
+        return;
+
+    Renderer::RingBuffer ringBuffer;
+    if (!ringBuffer.Init(device, RING_BUFFER_SIZE))
+    {
+        state.Skip("Failed to initialize Ring Buffer");
+        return;
+    }
+
+    std::vector<char> data(state.GetParam(), 1);
+    uint32_t writes = 0;
+    while (state.KeepRunning())
+    {
+        DoNotOptimize(ringBuffer.Write(data.data(), data.size()));
+
+        // frames are finished regularly, so the buffer never fills up
+        if (++writes == WRITES_PER_FRAME)
+        {
+            ringBuffer.MarkFinishedFrame();
+            writes = 0;
+        }
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * state.GetParam());
+}
@@ -0,0 +1,106 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Math/Frustum.hpp"
+#include "Scene/Scene.hpp"
+
+using namespace ABench;
+using ABench::Perf::DoNotOptimize;
+
+
+namespace {
+
+// scene with given number of lights and models, without any geometry loaded
+void BuildScene(Scene::Scene& scene, uint32_t count)
+{
+    scene.Init();
+
+    std::mt19937 gen(0);
+    std::uniform_real_distribution<float> dist(-50.0f, 50.0f);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto lres = scene.GetComponent(Scene::ComponentType::Light, "light" + std::to_string(i));
+        Scene::Light* light = dynamic_cast<Scene::Light*>(lres.first);
+        light->SetPosition(dist(gen), dist(gen), dist(gen));
+        light->SetRange(1.5f);
+        scene.CreateObject()->SetComponent(light);
+
+        auto mres = scene.GetComponent(Scene::ComponentType::Model, "model" + std::to_string(i));
+        Scene::Model* model = dynamic_cast<Scene::Model*>(mres.first);
+        model->SetPosition(dist(gen), dist(gen), dist(gen));
+        scene.CreateObject()->SetComponent(model);
+    }
+}
+
+} // namespace
+
+
+// Renderer::UploadLights copies packed light data of the scene every frame
+PERF_CASE_SCALED(Scene, CopyLightData, 64, 1024, 16384)
+{
+    Scene::Scene scene;
+    BuildScene(scene, state.GetParam());
+
+    // stands in for mapped memory of Light Container
+    std::vector<uint8_t> lightContainer(state.GetParam() * sizeof(Scene::LightData));
+    while (state.KeepRunning())
+    {
+        const std::vector<Scene::LightData>& lights = scene.GetLightData();
+        memcpy(lightContainer.data(), lights.data(), lights.size() * sizeof(Scene::LightData));
+        DoNotOptimize(lightContainer.data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * state.GetParam());
+}
+
+// Renderer::Draw frustum culling loop
+PERF_CASE_SCALED(Scene, CullObjects, 64, 1024, 16384)
+{
+    Scene::Scene scene;
+    BuildScene(scene, state.GetParam());
+
+    Math::FrustumDesc desc;
+    desc.fov = 60.0f;
+    desc.ratio = 16.0f / 9.0f;
+    desc.nearZ = 0.2f;
+    desc.farZ = 500.0f;
+    Math::Frustum frustum;
+    frustum.Init(desc);
+    frustum.Refresh(Math::Vector3(0.0f, 1.0f, -2.0f), Math::Vector3(0.0f, 1.0f, 1.0f), Math::Vector3(0.0f, -1.0f, 0.0f));
+
+    while (state.KeepRunning())
+    {
+        scene.ForEachObject([&](const Scene::Object* o) -> bool {
+            if (o->GetComponent()->GetType() == Scene::ComponentType::Model)
+            {
+                Scene::Model* model = dynamic_cast<Scene::Model*>(o->GetComponent());
+                model->SetToRender(frustum.Intersects(model->GetTransform() * model->GetAABB()));
+            }
+
+            return true;
+        });
+        Perf::ClobberMemory();
+    }
+
+    // objects are lights and models in equal numbers
+    state.SetItemsProcessed(state.GetIterations() * state.GetParam() * 2);
+}
+
+PERF_CASE_SCALED(Scene, ComponentLookup, 64, 1024, 16384)
+{
+    Scene::Scene scene;
+    BuildScene(scene, state.GetParam());
+
+    uint32_t i = 0;
+    std::vector<std::string> names(state.GetParam());
+    for (auto& n: names)
+        n = "light" + std::to_string(i++);
+
+    while (state.KeepRunning())
+    {
+        for (auto& n: names)
+            DoNotOptimize(scene.GetComponent(Scene::ComponentType::Light, n).first);
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * names.size());
+}
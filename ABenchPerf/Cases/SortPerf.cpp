@@ -0,0 +1,129 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Math/Sort.hpp"
+
+using ABench::Perf::DoNotOptimize;
+
+
+namespace {
+
+// Math::QuickSort's partitioning expects distinct keys, so values are a shuffled sequence
+std::vector<float> ShuffledFloats(uint32_t count)
+{
+    std::vector<float> values(count);
+    for (uint32_t i = 0; i < count; ++i)
+        values[i] = static_cast<float>(i);
+
+    std::mt19937 gen(0);
+    std::shuffle(values.begin(), values.end(), gen);
+    return values;
+}
+
+// 64-bit keys with few distinct upper fields, like sort keys of a frame's draws
+std::vector<std::pair<uint64_t, uint32_t>> RandomDrawKeys(uint32_t count)
+{
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<uint64_t> stateDist(0, 255);
+    std::uniform_int_distribution<uint64_t> depthDist(0, 0xFFFF);
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(count);
+    for (uint32_t i = 0; i < count; ++i)
+        keys[i] = std::make_pair((stateDist(gen) << 36) | (stateDist(gen) << 16) | depthDist(gen), i);
+
+    return keys;
+}
+
+} // namespace
+
+
+PERF_CASE_SCALED(Sort, QuickSort, 1024, 16384, 262144)
+{
+    const std::vector<float> source = ShuffledFloats(state.GetParam());
+    std::vector<float> values;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        values = source;
+        state.ResumeTiming();
+
+        ABench::Math::QuickSort(values);
+        DoNotOptimize(values.data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * source.size());
+}
+
+PERF_CASE_SCALED(Sort, BitonicSort, 1024, 16384, 262144)
+{
+    const std::vector<float> source = ShuffledFloats(state.GetParam());
+    std::vector<float> values;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        values = source;
+        state.ResumeTiming();
+
+        ABench::Math::BitonicSort(values, true);
+        DoNotOptimize(values.data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * source.size());
+}
+
+// reference point for custom sorts
+PERF_CASE_SCALED(Sort, StdSort, 1024, 16384, 262144)
+{
+    const std::vector<float> source = ShuffledFloats(state.GetParam());
+    std::vector<float> values;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        values = source;
+        state.ResumeTiming();
+
+        std::sort(values.begin(), values.end());
+        DoNotOptimize(values.data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * source.size());
+}
+
+PERF_CASE_SCALED(Sort, RadixSortDrawKeys, 1024, 16384, 262144)
+{
+    const std::vector<std::pair<uint64_t, uint32_t>> source = RandomDrawKeys(state.GetParam());
+    std::vector<std::pair<uint64_t, uint32_t>> values;
+    std::vector<std::pair<uint64_t, uint32_t>> temp;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        values = source;
+        state.ResumeTiming();
+
+        ABench::Math::RadixSort(values, temp, [](const std::pair<uint64_t, uint32_t>& v) { return v.first; });
+        DoNotOptimize(values.data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * source.size());
+}
+
+// reference point for radix sort of draw keys
+PERF_CASE_SCALED(Sort, StdSortDrawKeys, 1024, 16384, 262144)
+{
+    const std::vector<std::pair<uint64_t, uint32_t>> source = RandomDrawKeys(state.GetParam());
+    std::vector<std::pair<uint64_t, uint32_t>> values;
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        values = source;
+        state.ResumeTiming();
+
+        std::sort(values.begin(), values.end(),
+            [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+                return a.first < b.first;
+            });
+        DoNotOptimize(values.data());
+    }
+
+    state.SetItemsProcessed(state.GetIterations() * source.size());
+}
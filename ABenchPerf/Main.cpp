@@ -0,0 +1,67 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Common/FS.hpp"
+#include "Common/Logger.hpp"
+
+
+namespace {
+
+const std::string FILTER_OPTION = "--filter=";
+const std::string OUTPUT_OPTION = "--out=";
+const std::string MIN_TIME_OPTION = "--min-time=";
+const std::string REPETITIONS_OPTION = "--repetitions=";
+
+bool ParseOption(const std::string& arg, const std::string& option, std::string& value)
+{
+    if (arg.compare(0, option.size(), option) != 0)
+        return false;
+
+    value = arg.substr(option.size());
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+    ABench::Perf::RunnerDesc desc;
+    std::string output = "abench_perf.json";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg(argv[i]);
+        std::string value;
+
+        if (ParseOption(arg, FILTER_OPTION, value))
+            desc.filter = value;
+        else if (ParseOption(arg, OUTPUT_OPTION, value))
+            output = value;
+        else if (ParseOption(arg, MIN_TIME_OPTION, value))
+            desc.minTime = std::stod(value);
+        else if (ParseOption(arg, REPETITIONS_OPTION, value))
+            desc.repetitions = std::stoi(value);
+        else
+        {
+            std::cout << "Usage: ABenchPerf [--filter=<substring>] [--out=<results.json>] "
+                      << "[--min-time=<seconds>] [--repetitions=<count>]" << std::endl;
+            return -1;
+        }
+    }
+
+    // same working directory as ABench, so cases can load resources from Data directory
+    std::string path = ABench::Common::FS::GetParentDir(ABench::Common::FS::GetExecutablePath());
+    if (!ABench::Common::FS::SetCWD(path + "/../../.."))
+        return -1;
+
+    ABench::Perf::Runner runner;
+    if (!runner.Run(desc))
+        return -1;
+
+    if (!runner.ExportJSON(output))
+        return -1;
+
+    LOGI("Perf results written to " << output);
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include "PCH.hpp"
+#include "Perf.hpp"
+
+#include "Common/Logger.hpp"
+
+#include <algorithm>
+
+
+namespace ABench {
+namespace Perf {
+
+namespace Impl {
+
+const volatile void* volatile gSink = nullptr;
+
+} // namespace Impl
+
+namespace {
+
+const uint64_t MAX_ITERATIONS = 1000000000;
+const double CALIBRATION_MARGIN = 1.4; // aim a bit above minTime, so next try likely reaches it
+const double MAX_CALIBRATION_GROWTH = 10.0;
+
+std::string GetResultName(const PerfCase& perfCase, uint32_t param)
+{
+    if (perfCase.params.empty())
+        return perfCase.name;
+
+    return perfCase.name + "/" + std::to_string(param);
+}
+
+std::string EscapeJSON(const std::string& str)
+{
+    std::string result;
+    for (char c: str)
+    {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+
+    return result;
+}
+
+} // namespace
+
+
+State::State(uint64_t iterations, uint32_t param)
+    : mIterations(iterations)
+    , mRemaining(iterations)
+    , mParam(param)
+    , mItemsProcessed(0)
+    , mStart()
+    , mElapsed(Clock::duration::zero())
+    , mStarted(false)
+    , mSkipReason()
+{
+}
+
+void State::StartTimer()
+{
+    mStarted = true;
+    mStart = Clock::now();
+}
+
+void State::StopTimer()
+{
+    if (!mStarted)
+        return;
+
+    mElapsed += Clock::now() - mStart;
+    mStarted = false;
+}
+
+void State::PauseTiming()
+{
+    StopTimer();
+}
+
+void State::ResumeTiming()
+{
+    StartTimer();
+}
+
+void State::Skip(const std::string& reason)
+{
+    mSkipReason = reason;
+    mRemaining = 0;
+}
+
+
+Registry::Registry()
+    : mCases()
+{
+}
+
+Registry::~Registry()
+{
+}
+
+Registry& Registry::Instance()
+{
+    static Registry instance;
+    return instance;
+}
+
+bool Registry::Add(const std::string& name, PerfFunction function, const std::vector<uint32_t>& params)
+{
+    mCases.push_back({ name, function, params });
+    return true;
+}
+
+
+Runner::Runner()
+    : mDesc()
+    , mResults()
+{
+}
+
+Runner::~Runner()
+{
+}
+
+uint64_t Runner::Calibrate(const PerfCase& perfCase, uint32_t param, bool& skipped)
+{
+    uint64_t iterations = 1;
+
+    while (true)
+    {
+        State state(iterations, param);
+        perfCase.function(state);
+
+        skipped = state.IsSkipped();
+        if (skipped)
+        {
+            LOGW(GetResultName(perfCase, param) << " skipped: " << state.GetSkipReason());
+            return 0;
+        }
+
+        double elapsed = state.GetElapsedNs() * 1e-9;
+        if (elapsed >= mDesc.minTime || iterations >= MAX_ITERATIONS)
+            return iterations;
+
+        double growth = MAX_CALIBRATION_GROWTH;
+        if (elapsed > 0.0)
+            growth = std::min(growth, mDesc.minTime * CALIBRATION_MARGIN / elapsed);
+
+        uint64_t next = static_cast<uint64_t>(static_cast<double>(iterations) * growth);
+        iterations = std::min(std::max(next, iterations + 1), MAX_ITERATIONS);
+    }
+}
+
+PerfResult Runner::Measure(const PerfCase& perfCase, uint32_t param)
+{
+    PerfResult result;
+    result.name = GetResultName(perfCase, param);
+    result.param = param;
+    result.itemsPerIteration = 0.0;
+    result.iterations = Calibrate(perfCase, param, result.skipped);
+    if (result.skipped)
+        return result;
+
+    std::vector<double> samples;
+    for (uint32_t r = 0; r < mDesc.repetitions; ++r)
+    {
+        State state(result.iterations, param);
+        perfCase.function(state);
+
+        samples.push_back(state.GetElapsedNs() / static_cast<double>(result.iterations));
+        result.itemsPerIteration = static_cast<double>(state.GetItemsProcessed()) / static_cast<double>(result.iterations);
+    }
+
+    result.ns = Math::CalculateStatistics(samples);
+    return result;
+}
+
+bool Runner::Run(const RunnerDesc& desc)
+{
+    if (desc.repetitions == 0)
+    {
+        LOGE("Perf Runner needs at least one repetition");
+        return false;
+    }
+
+    mDesc = desc;
+    mResults.clear();
+
+    for (auto& c: Registry::Instance().GetCases())
+    {
+        // cases without params are run once
+        std::vector<uint32_t> params = c.params;
+        if (params.empty())
+            params.push_back(0);
+
+        for (uint32_t p: params)
+        {
+            if (GetResultName(c, p).find(mDesc.filter) == std::string::npos)
+                continue;
+
+            PerfResult result = Measure(c, p);
+            if (!result.skipped)
+            {
+                LOGI(result.name << ": " << result.ns.median << " ns (mean " << result.ns.mean << " ns, +/- "
+                     << (result.ns.ciHigh - result.ns.mean) << " ns), " << result.iterations << " iterations");
+            }
+
+            mResults.push_back(result);
+        }
+    }
+
+    return true;
+}
+
+bool Runner::ExportJSON(const std::string& path) const
+{
+    std::ofstream file(path, std::ofstream::out | std::ofstream::trunc);
+    if (!file)
+    {
+        LOGE("Unable to open perf results file " << path << " for writing");
+        return false;
+    }
+
+    file.precision(3);
+    file.setf(std::ios::fixed);
+
+#ifdef _DEBUG
+    const char* build = "Debug";
+#else
+    const char* build = "Release";
+#endif
+
+    file << "{\n\"context\":{\"build\":\"" << build << "\",\"minTime\":" << mDesc.minTime
+         << ",\"repetitions\":" << mDesc.repetitions << "},\n\"unit\":\"ns\",\n\"results\":[";
+
+    for (size_t i = 0; i < mResults.size(); ++i)
+    {
+        const PerfResult& r = mResults[i];
+
+        file << ((i > 0) ? ",\n" : "\n");
+        file << "{\"name\":\"" << EscapeJSON(r.name) << "\",\"skipped\":" << (r.skipped ? "true" : "false");
+        if (!r.skipped)
+        {
+            file << ",\"iterations\":" << r.iterations
+                 << ",\"itemsPerIteration\":" << r.itemsPerIteration
+                 << ",\"median\":" << r.ns.median
+                 << ",\"mean\":" << r.ns.mean
+                 << ",\"min\":" << r.ns.min
+                 << ",\"max\":" << r.ns.max
+                 << ",\"stddev\":" << r.ns.stdDev
+                 << ",\"ci95\":[" << r.ns.ciLow << "," << r.ns.ciHigh << "]";
+        }
+        file << "}";
+    }
+
+    file << "\n]}\n";
+    return file.good();
+}
+
+} // namespace Perf
+} // namespace ABench
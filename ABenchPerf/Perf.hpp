@@ -0,0 +1,223 @@
+#pragma once
+
+#include "Common/Common.hpp"
+#include "Math/Statistics.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#include <intrin.h>
+#endif
+
+
+namespace ABench {
+namespace Perf {
+
+namespace Impl {
+
+extern const volatile void* volatile gSink;
+
+} // namespace Impl
+
+// Prevents the compiler from optimizing away computation of given value
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+#ifdef WIN32
+    Impl::gSink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Forces all pending memory writes to be treated as observable
+inline void ClobberMemory()
+{
+#ifdef WIN32
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+/**
+ * State of a single measurement, passed to measured function.
+ *
+ * Only the time spent inside of KeepRunning() loop is measured, so setup done before the loop
+ * does not affect results. Per-iteration setup can be excluded with PauseTiming()/ResumeTiming().
+ */
+class State
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t mIterations;
+    uint64_t mRemaining;
+    uint32_t mParam;
+    uint64_t mItemsProcessed;
+    Clock::time_point mStart;
+    Clock::duration mElapsed;
+    bool mStarted;
+    std::string mSkipReason;
+
+    void StartTimer();
+    void StopTimer();
+
+public:
+    State(uint64_t iterations, uint32_t param);
+
+    ABENCH_INLINE bool KeepRunning()
+    {
+        if (mRemaining > 0)
+        {
+            if (!mStarted)
+                StartTimer();
+
+            mRemaining--;
+            return true;
+        }
+
+        StopTimer();
+        return false;
+    }
+
+    void PauseTiming();
+    void ResumeTiming();
+
+    // Marks the case as not runnable in current environment, ex. when there is no Vulkan device
+    void Skip(const std::string& reason);
+
+    ABENCH_INLINE uint32_t GetParam() const
+    {
+        return mParam;
+    }
+
+    ABENCH_INLINE uint64_t GetIterations() const
+    {
+        return mIterations;
+    }
+
+    // Items processed in all iterations - used to report throughput
+    ABENCH_INLINE void SetItemsProcessed(uint64_t items)
+    {
+        mItemsProcessed = items;
+    }
+
+    ABENCH_INLINE uint64_t GetItemsProcessed() const
+    {
+        return mItemsProcessed;
+    }
+
+    ABENCH_INLINE double GetElapsedNs() const
+    {
+        return std::chrono::duration<double, std::nano>(mElapsed).count();
+    }
+
+    ABENCH_INLINE bool IsSkipped() const
+    {
+        return !mSkipReason.empty();
+    }
+
+    ABENCH_INLINE const std::string& GetSkipReason() const
+    {
+        return mSkipReason;
+    }
+};
+
+using PerfFunction = std::function<void(State&)>;
+
+struct PerfCase
+{
+    std::string name;
+    PerfFunction function;
+    std::vector<uint32_t> params; // each param is measured separately, ex. scene scale - can be empty
+};
+
+class Registry
+{
+    std::vector<PerfCase> mCases;
+
+    Registry();
+    Registry(const Registry&) = delete;
+    Registry(Registry&&) = delete;
+    Registry& operator=(const Registry&) = delete;
+    Registry& operator=(Registry&&) = delete;
+    ~Registry();
+
+public:
+    static Registry& Instance();
+
+    bool Add(const std::string& name, PerfFunction function, const std::vector<uint32_t>& params);
+
+    ABENCH_INLINE const std::vector<PerfCase>& GetCases() const
+    {
+        return mCases;
+    }
+};
+
+struct RunnerDesc
+{
+    std::string filter; // only cases containing this string are run
+    double minTime; // minimal time of a single repetition, in seconds
+    uint32_t repetitions;
+
+    RunnerDesc()
+        : filter()
+        , minTime(0.1)
+        , repetitions(5)
+    {
+    }
+};
+
+struct PerfResult
+{
+    std::string name;
+    uint32_t param;
+    bool skipped;
+    uint64_t iterations; // per repetition
+    double itemsPerIteration;
+    Math::Statistics ns; // nanoseconds per iteration, one sample per repetition
+};
+
+/**
+ * Runs registered cases. Number of iterations is first calibrated, so that a single repetition
+ * takes at least minTime, then all repetitions run with the same number of iterations.
+ */
+class Runner
+{
+    RunnerDesc mDesc;
+    std::vector<PerfResult> mResults;
+
+    uint64_t Calibrate(const PerfCase& perfCase, uint32_t param, bool& skipped);
+    PerfResult Measure(const PerfCase& perfCase, uint32_t param);
+
+public:
+    Runner();
+    ~Runner();
+
+    bool Run(const RunnerDesc& desc);
+    bool ExportJSON(const std::string& path) const;
+
+    ABENCH_INLINE const std::vector<PerfResult>& GetResults() const
+    {
+        return mResults;
+    }
+};
+
+} // namespace Perf
+} // namespace ABench
+
+#define PERF_CASE_IMPL(group, name, params) \
+    static void Perf##group##name(ABench::Perf::State& state); \
+    static const bool gPerf##group##name##Registered = \
+        ABench::Perf::Registry::Instance().Add(#group "/" #name, Perf##group##name, params); \
+    static void Perf##group##name(ABench::Perf::State& state)
+
+// Defines and registers a measured function named "group/name"
+#define PERF_CASE(group, name) PERF_CASE_IMPL(group, name, std::vector<uint32_t>())
+
+// Same as PERF_CASE, but measured separately for each param (available via state.GetParam())
+#define PERF_CASE_SCALED(group, name, ...) PERF_CASE_IMPL(group, name, (std::vector<uint32_t>{ __VA_ARGS__ }))
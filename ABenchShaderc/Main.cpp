@@ -0,0 +1,216 @@
+#include "PCH.hpp"
+#include "VariantList.hpp"
+
+#include "Common/Common.hpp"
+#include "Common/Logger.hpp"
+#include "Common/FS.hpp"
+#include "Common/ThreadPool.hpp"
+#include "Renderer/LowLevel/ShaderCache.hpp"
+#include "ResourceDir.hpp"
+
+#include <glslang/Public/ShaderLang.h>
+
+using namespace ABench;
+
+
+namespace {
+
+const std::string VARIANTS_FILE = "Variants.txt";
+const std::string MANIFEST_FILE = "Manifest.txt";
+
+const std::string FORCE_COMMAND = "-f";
+const std::string JOBS_COMMAND = "-j";
+
+struct CompileJob
+{
+    std::string filename;
+    Renderer::ShaderType type;
+    Renderer::ShaderMacros macros;
+    bool compiled;
+    bool success;
+
+    CompileJob()
+        : filename()
+        , type(Renderer::ShaderType::UNKNOWN)
+        , macros()
+        , compiled(false)
+        , success(false)
+    {
+    }
+};
+
+void ProcessJob(CompileJob& job)
+{
+    // glslang keeps some of its state per-thread and needs to be initialized on each of them
+    if (!glslang::InitializeProcess())
+    {
+        LOGE("Failed to initialize glslang on worker thread");
+        return;
+    }
+
+    std::vector<uint32_t> code;
+    job.success = Renderer::ShaderCache::Instance().GetCode(job.type, job.filename, job.macros, code,
+                                                            &job.compiled);
+
+    glslang::FinalizeProcess();
+}
+
+bool WriteManifest(const std::vector<CompileJob>& jobs)
+{
+    std::string path = Common::FS::JoinPaths(ResourceDir::SHADER_CACHE, MANIFEST_FILE);
+    std::ofstream manifest(path, std::ofstream::out);
+    if (!manifest)
+    {
+        LOGE("Unable to open manifest file " << path << " for writing");
+        return false;
+    }
+
+    manifest << "# Generated by ABenchShaderc - do not edit\n";
+    manifest << "# <variant key> <source file> [<macro>=<value>]...\n";
+    for (auto& job: jobs)
+    {
+        if (!job.success)
+            continue;
+
+        manifest << std::hex << std::setw(16) << std::setfill('0')
+                 << Renderer::ShaderCache::CalculateVariantKey(job.filename, job.macros) << std::dec
+                 << " " << job.filename;
+        for (auto& m: job.macros)
+            manifest << " " << m.name << "=" << m.value;
+        manifest << "\n";
+    }
+
+    return manifest.good();
+}
+
+void PrintUsage(const char* executable)
+{
+    LOGI("Usage: " << executable << " [" << FORCE_COMMAND << "] [" << JOBS_COMMAND << " <threads>]");
+}
+
+} // namespace
+
+
+int main(int argc, char* argv[])
+{
+    bool force = false;
+    uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (FORCE_COMMAND == argv[i])
+            force = true;
+        else if (JOBS_COMMAND == argv[i])
+        {
+            if (i + 1 >= argc)
+            {
+                LOGE("Missing thread count after " << JOBS_COMMAND);
+                PrintUsage(argv[0]);
+                return -1;
+            }
+
+            char* end = nullptr;
+            long jobs = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || jobs < 1 || jobs > UINT16_MAX)
+            {
+                LOGE("Invalid thread count " << argv[i]);
+                PrintUsage(argv[0]);
+                return -1;
+            }
+
+            threadCount = static_cast<uint32_t>(jobs);
+        }
+        else
+        {
+            LOGE("Unknown argument " << argv[i]);
+            PrintUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    std::string path = Common::FS::GetParentDir(Common::FS::GetExecutablePath());
+    if (!Common::FS::SetCWD(path + "/../../.."))
+        return -1;
+
+    if (!Common::FS::Exists(ResourceDir::SHADER_CACHE))
+        Common::FS::CreateDir(ResourceDir::SHADER_CACHE);
+
+    Shaderc::VariantList variants;
+    std::string variantsPath = Common::FS::JoinPaths(ResourceDir::SHADERS, VARIANTS_FILE);
+    if (Common::FS::Exists(variantsPath))
+    {
+        if (!variants.Load(variantsPath))
+            return -1;
+    }
+    else
+    {
+        LOGW("Variant list " << variantsPath << " not found - compiling shaders without macros");
+    }
+
+    std::vector<std::string> files;
+    if (!Common::FS::ListFiles(ResourceDir::SHADERS, files))
+        return -1;
+
+    std::vector<CompileJob> jobs;
+    for (auto& file: files)
+    {
+        Renderer::ShaderType type = Renderer::ShaderCompiler::GetShaderTypeFromFileName(file);
+        if (type == Renderer::ShaderType::UNKNOWN)
+            continue;
+
+        for (auto& macros: variants.Expand(file))
+        {
+            CompileJob job;
+            job.filename = file;
+            job.type = type;
+            job.macros = macros;
+            jobs.push_back(job);
+        }
+    }
+
+    if (!glslang::InitializeProcess())
+    {
+        LOGE("Failed to initialize glslang");
+        return -1;
+    }
+
+    // sources are always validated, so only changed variants get recompiled
+    if (!Renderer::ShaderCache::Instance().Init(true, !force))
+        return -1;
+
+    // calling thread only waits, so spawn a worker for each requested thread
+    Common::ThreadPool pool;
+    if (!pool.Init(threadCount))
+        return -1;
+
+    LOGI("Processing " << jobs.size() << " shader variants on " << threadCount << " threads");
+
+    for (auto& job: jobs)
+        pool.AddTask(std::bind(ProcessJob, std::ref(job)));
+    pool.WaitForTasks();
+    pool.Release();
+
+    uint32_t compiled = 0;
+    uint32_t failed = 0;
+    for (auto& job: jobs)
+    {
+        if (job.compiled && job.success)
+            compiled++;
+        if (!job.success)
+        {
+            LOGE("Failed to compile a variant of " << job.filename);
+            failed++;
+        }
+    }
+
+    bool saved = Renderer::ShaderCache::Instance().Save();
+    Renderer::ShaderCache::Instance().Release();
+    glslang::FinalizeProcess();
+
+    if (!saved || !WriteManifest(jobs))
+        return -1;
+
+    LOGI("Compiled " << compiled << " variants, " << (jobs.size() - compiled - failed) <<
+         " up to date, " << failed << " failed");
+    return (failed > 0) ? -1 : 0;
+}
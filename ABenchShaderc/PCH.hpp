@@ -0,0 +1,31 @@
+#pragma once
+
+#ifdef WIN32
+// WinAPI & other Windows internals
+#define NOMINMAX
+#include <Windows.h>
+#elif defined(__linux__) || defined(__LINUX__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "Target platform not defined"
+#endif
+
+// C library
+#include <cassert>
+
+// STL
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
@@ -0,0 +1,138 @@
+#include "PCH.hpp"
+#include "VariantList.hpp"
+
+#include "Common/Common.hpp"
+#include "Common/Logger.hpp"
+
+
+namespace ABench {
+namespace Shaderc {
+
+namespace {
+
+const char COMMENT_CHAR = '#';
+const char VALUE_SEPARATOR = '=';
+const std::string RANGE_SEPARATOR = "..";
+
+bool ParseValue(const std::string& str, uint32_t& value)
+{
+    if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+
+    value = static_cast<uint32_t>(std::stoul(str));
+    return true;
+}
+
+} // namespace
+
+bool VariantList::ParseMacroRange(const std::string& token, ShaderMacroRangeDesc& range) const
+{
+    size_t separator = token.find(VALUE_SEPARATOR);
+    if (separator == std::string::npos || separator == 0)
+        return false;
+
+    range.name = token.substr(0, separator);
+    std::string values = token.substr(separator + 1);
+
+    size_t rangeSeparator = values.find(RANGE_SEPARATOR);
+    if (rangeSeparator == std::string::npos)
+    {
+        if (!ParseValue(values, range.minValue))
+            return false;
+
+        range.maxValue = range.minValue;
+        return true;
+    }
+
+    if (!ParseValue(values.substr(0, rangeSeparator), range.minValue) ||
+        !ParseValue(values.substr(rangeSeparator + RANGE_SEPARATOR.size()), range.maxValue))
+        return false;
+
+    return range.minValue <= range.maxValue;
+}
+
+bool VariantList::Load(const std::string& path)
+{
+    std::ifstream file(path, std::ifstream::in);
+    if (!file.good())
+    {
+        LOGE("Failed to open variant list " << path);
+        return false;
+    }
+
+    uint32_t lineNumber = 0;
+    for (std::string line; std::getline(file, line); )
+    {
+        lineNumber++;
+
+        size_t comment = line.find(COMMENT_CHAR);
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::stringstream lineStream(line);
+        std::string shaderFile;
+        if (!(lineStream >> shaderFile))
+            continue; // empty line
+
+        ShaderVariantSet set;
+        for (std::string token; lineStream >> token; )
+        {
+            ShaderMacroRangeDesc range;
+            if (!ParseMacroRange(token, range))
+            {
+                LOGE(path << ":" << lineNumber << ": invalid macro declaration \"" << token << "\"");
+                return false;
+            }
+
+            set.push_back(range);
+        }
+
+        mVariantSets[shaderFile].push_back(set);
+    }
+
+    return true;
+}
+
+std::vector<Renderer::ShaderMacros> VariantList::Expand(const std::string& shaderFile) const
+{
+    std::vector<Renderer::ShaderMacros> result;
+
+    auto it = mVariantSets.find(shaderFile);
+    if (it == mVariantSets.end())
+    {
+        result.emplace_back();
+        return result;
+    }
+
+    for (auto& set: it->second)
+    {
+        Renderer::ShaderMacros comb;
+        for (auto& m: set)
+            comb.emplace_back(m.name, m.minValue);
+
+        // iterate like an odometer - the last macro changes most frequently
+        bool finished = false;
+        while (!finished)
+        {
+            result.push_back(comb);
+
+            finished = true;
+            for (size_t i = comb.size(); i > 0; --i)
+            {
+                if (comb[i - 1].value < set[i - 1].maxValue)
+                {
+                    comb[i - 1].value++;
+                    finished = false;
+                    break;
+                }
+
+                comb[i - 1].value = set[i - 1].minValue;
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace Shaderc
+} // namespace ABench
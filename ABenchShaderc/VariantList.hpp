@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Renderer/LowLevel/ShaderCompiler.hpp"
+
+#include <map>
+
+
+namespace ABench {
+namespace Shaderc {
+
+struct ShaderMacroRangeDesc
+{
+    std::string name;
+    uint32_t minValue;
+    uint32_t maxValue;
+
+    ShaderMacroRangeDesc()
+        : name()
+        , minValue(0)
+        , maxValue(0)
+    {
+    }
+};
+
+using ShaderVariantSet = std::vector<ShaderMacroRangeDesc>;
+
+/**
+ * Shader variant sets declared in Data/Shaders/Variants.txt.
+ *
+ * Each shader can have multiple variant sets declared. A variant set is a list of macros with
+ * a range of values - expanding it produces a cartesian product of all these values.
+ */
+class VariantList
+{
+    std::map<std::string, std::vector<ShaderVariantSet>> mVariantSets;
+
+    bool ParseMacroRange(const std::string& token, ShaderMacroRangeDesc& range) const;
+
+public:
+    bool Load(const std::string& path);
+
+    /**
+     * Expands all variant sets declared for given shader file into macro combinations.
+     * Shader without any declared variant set results in a single combination with no macros.
+     */
+    std::vector<Renderer::ShaderMacros> Expand(const std::string& shaderFile) const;
+};
+
+} // namespace Shaderc
+} // namespace ABench
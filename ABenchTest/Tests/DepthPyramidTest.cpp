@@ -0,0 +1,134 @@
+#include "PCH.hpp"
+#include "Renderer/HighLevel/DepthPyramid.hpp"
+#include "RendererTestHelpers.hpp"
+
+using namespace ABench::Math;
+using namespace ABench::Renderer;
+
+static_assert((TEST_VIEWPORT_HEIGHT & (TEST_VIEWPORT_HEIGHT - 1)) != 0,
+              "Height must not be a power of two to cover odd level sizes");
+
+const uint32_t DEPTH_PYRAMID_TEST_TILE_SIZE = 16;
+
+namespace {
+
+// depth buffer value of a point at given view space distance in front of the camera
+float GetDepthAt(float distance)
+{
+    Vector4 clip = GetTestProjection() * Vector4(0.0f, 0.0f, -distance, 1.0f);
+    return clip[2] / clip[3];
+}
+
+AABB CreateBox(float x, float y, float nearDistance, float farDistance)
+{
+    return AABB(Vector4(x - 1.0f, y - 1.0f, -farDistance, 1.0f), Vector4(x + 1.0f, y + 1.0f, -nearDistance, 1.0f));
+}
+
+} // namespace
+
+TEST(DepthPyramid, Levels)
+{
+    DepthPyramid pyramid;
+    EXPECT_FALSE(pyramid.Init(0, TEST_VIEWPORT_HEIGHT));
+    ASSERT_TRUE(pyramid.Init(TEST_VIEWPORT_WIDTH, TEST_VIEWPORT_HEIGHT));
+
+    const uint32_t widths[] = { 160, 80, 40, 20, 10, 5, 3, 2, 1 };
+    const uint32_t heights[] = { 100, 50, 25, 13, 7, 4, 2, 1, 1 };
+    ASSERT_EQ(9u, pyramid.GetLevelCount());
+
+    uint32_t offset = 0;
+    for (uint32_t l = 0; l < pyramid.GetLevelCount(); ++l)
+    {
+        EXPECT_EQ(widths[l], pyramid.GetLevel(l).width) << "level " << l;
+        EXPECT_EQ(heights[l], pyramid.GetLevel(l).height) << "level " << l;
+        EXPECT_EQ(offset, pyramid.GetLevel(l).offset) << "level " << l;
+        offset += widths[l] * heights[l];
+    }
+    EXPECT_EQ(offset, pyramid.GetSize());
+
+    // light culling tiles match texels of a single level
+    EXPECT_EQ(0u, DepthPyramid::GetLevelForTexelSize(2));
+    EXPECT_EQ(3u, DepthPyramid::GetLevelForTexelSize(DEPTH_PYRAMID_TEST_TILE_SIZE));
+    uint32_t tileLevel = DepthPyramid::GetLevelForTexelSize(DEPTH_PYRAMID_TEST_TILE_SIZE);
+    EXPECT_EQ(20u, pyramid.GetLevel(tileLevel).width);
+    EXPECT_EQ(13u, pyramid.GetLevel(tileLevel).height);
+}
+
+TEST(DepthPyramid, TileBounds)
+{
+    DepthPyramid pyramid;
+    ASSERT_TRUE(pyramid.Init(TEST_VIEWPORT_WIDTH, TEST_VIEWPORT_HEIGHT));
+
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<float> depthDist(0.9f, 1.0f);
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT);
+    for (auto& d: depth)
+        d = depthDist(gen);
+
+    pyramid.Build(depth.data());
+
+    // every texel of tile level holds exactly the bounds of its tile, partial edge tiles included
+    uint32_t tileLevel = DepthPyramid::GetLevelForTexelSize(DEPTH_PYRAMID_TEST_TILE_SIZE);
+    for (uint32_t tileY = 0; tileY < pyramid.GetLevel(tileLevel).height; ++tileY)
+    {
+        for (uint32_t tileX = 0; tileX < pyramid.GetLevel(tileLevel).width; ++tileX)
+        {
+            float minDepth = 1.0f;
+            float maxDepth = 0.0f;
+            for (uint32_t y = tileY * DEPTH_PYRAMID_TEST_TILE_SIZE;
+                 y < std::min((tileY + 1) * DEPTH_PYRAMID_TEST_TILE_SIZE, TEST_VIEWPORT_HEIGHT); ++y)
+            {
+                for (uint32_t x = tileX * DEPTH_PYRAMID_TEST_TILE_SIZE;
+                     x < std::min((tileX + 1) * DEPTH_PYRAMID_TEST_TILE_SIZE, TEST_VIEWPORT_WIDTH); ++x)
+                {
+                    minDepth = std::min(minDepth, depth[y * TEST_VIEWPORT_WIDTH + x]);
+                    maxDepth = std::max(maxDepth, depth[y * TEST_VIEWPORT_WIDTH + x]);
+                }
+            }
+
+            EXPECT_EQ(minDepth, pyramid.GetTexel(tileLevel, tileX, tileY).min) << "tile " << tileX << "x" << tileY;
+            EXPECT_EQ(maxDepth, pyramid.GetTexel(tileLevel, tileX, tileY).max) << "tile " << tileX << "x" << tileY;
+        }
+    }
+
+    // last level covers the whole viewport
+    const DepthBounds& top = pyramid.GetTexel(pyramid.GetLevelCount() - 1, 0, 0);
+    EXPECT_EQ(*std::min_element(depth.begin(), depth.end()), top.min);
+    EXPECT_EQ(*std::max_element(depth.begin(), depth.end()), top.max);
+}
+
+TEST(DepthPyramid, Occlusion)
+{
+    DepthPyramid pyramid;
+    ASSERT_TRUE(pyramid.Init(TEST_VIEWPORT_WIDTH, TEST_VIEWPORT_HEIGHT));
+
+    Matrix viewProj = GetTestProjection();
+    AABB hidden = CreateBox(0.0f, 0.0f, 20.0f, 30.0f);
+    AABB inFront = CreateBox(0.0f, 0.0f, 3.0f, 5.0f);
+    AABB crossingWall = CreateBox(0.0f, 0.0f, 5.0f, 30.0f);
+    AABB aroundCamera = CreateBox(0.0f, 0.0f, -5.0f, 30.0f);
+    AABB offScreen = CreateBox(1000.0f, 0.0f, 20.0f, 30.0f);
+
+    // pyramid which was never built does not hide anything
+    EXPECT_FALSE(pyramid.IsOccluded(hidden, viewProj));
+
+    // wall 10 units in front of the camera
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT, GetDepthAt(10.0f));
+    pyramid.Build(depth.data());
+    EXPECT_TRUE(pyramid.IsOccluded(hidden, viewProj));
+    EXPECT_FALSE(pyramid.IsOccluded(inFront, viewProj));
+    EXPECT_FALSE(pyramid.IsOccluded(crossingWall, viewProj));
+    EXPECT_FALSE(pyramid.IsOccluded(aroundCamera, viewProj));
+    EXPECT_FALSE(pyramid.IsOccluded(offScreen, viewProj));
+
+    // hole in the middle of the wall uncovers the hidden box
+    for (uint32_t y = TEST_VIEWPORT_HEIGHT / 2 - 2; y < TEST_VIEWPORT_HEIGHT / 2 + 2; ++y)
+        for (uint32_t x = TEST_VIEWPORT_WIDTH / 2 - 2; x < TEST_VIEWPORT_WIDTH / 2 + 2; ++x)
+            depth[y * TEST_VIEWPORT_WIDTH + x] = 1.0f;
+    pyramid.Build(depth.data());
+    EXPECT_FALSE(pyramid.IsOccluded(hidden, viewProj));
+
+    // coarser levels only, as after a partial read back - the hole still counts
+    pyramid.SetFirstLevel(2);
+    EXPECT_FALSE(pyramid.IsOccluded(hidden, viewProj));
+}
@@ -0,0 +1,30 @@
+#include "PCH.hpp"
+#include "Renderer/HighLevel/DrawSortKey.hpp"
+
+using namespace ABench::Renderer;
+
+TEST(DrawSortKey, FieldOrder)
+{
+    // pipeline variant outweighs all other fields
+    EXPECT_LT(MakeDrawSortKey(0, 1000, 1000, 500.0f), MakeDrawSortKey(1, 0, 0, 0.0f));
+
+    // then material, vertex buffer and distance
+    EXPECT_LT(MakeDrawSortKey(2, 3, 1000, 500.0f), MakeDrawSortKey(2, 4, 0, 0.0f));
+    EXPECT_LT(MakeDrawSortKey(2, 3, 7, 500.0f), MakeDrawSortKey(2, 3, 8, 0.0f));
+    EXPECT_LT(MakeDrawSortKey(2, 3, 7, 1.0f), MakeDrawSortKey(2, 3, 7, 2.0f));
+    EXPECT_LT(MakeDrawSortKey(2, 3, 7, 0.25f), MakeDrawSortKey(2, 3, 7, 300.0f));
+
+    // camera inside model's bounds
+    EXPECT_EQ(MakeDrawSortKey(2, 3, 7, 0.0f), MakeDrawSortKey(2, 3, 7, -1.0f));
+}
+
+TEST(DrawSortKey, ClampedIdentifiers)
+{
+    const uint32_t maxMaterial = (1u << DRAW_SORT_KEY_MATERIAL_BITS) - 1;
+    const uint32_t maxVertexBuffer = (1u << DRAW_SORT_KEY_VERTEX_BUFFER_BITS) - 1;
+
+    // identifiers too wide for their field do not spill into fields above them
+    EXPECT_EQ(MakeDrawSortKey(0, maxMaterial, 0, 0.0f), MakeDrawSortKey(0, maxMaterial + 5, 0, 0.0f));
+    EXPECT_LT(MakeDrawSortKey(0, 0, maxVertexBuffer + 5, 0.0f), MakeDrawSortKey(0, 1, 0, 0.0f));
+    EXPECT_LT(MakeDrawSortKey(0, maxMaterial + 5, 0, 0.0f), MakeDrawSortKey(1, 0, 0, 0.0f));
+}
@@ -0,0 +1,97 @@
+#include "PCH.hpp"
+#include "Renderer/LowLevel/FrameGraphPlan.hpp"
+
+using namespace ABench::Renderer;
+
+namespace {
+
+FrameGraphPlanNode Node(DeviceQueueType queueType, bool hasFence, std::vector<uint32_t> dependencies)
+{
+    FrameGraphPlanNode node;
+    node.queueType = queueType;
+    node.hasFence = hasFence;
+    node.dependencies = dependencies;
+    return node;
+}
+
+} // namespace
+
+TEST(FrameGraph, EmptyPlan)
+{
+    std::vector<FrameGraphPlanGroup> groups;
+    EXPECT_TRUE(PlanFrameGraphSubmission(std::vector<FrameGraphPlanNode>(), groups));
+    EXPECT_TRUE(groups.empty());
+}
+
+TEST(FrameGraph, MergesConsecutiveWorkOnQueue)
+{
+    std::vector<FrameGraphPlanNode> nodes;
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, {}));
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, { 1 }));
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, { 2 }));
+
+    std::vector<FrameGraphPlanGroup> groups;
+    ASSERT_TRUE(PlanFrameGraphSubmission(nodes, groups));
+    ASSERT_EQ(3u, groups.size());
+    EXPECT_EQ(DeviceQueueType::GRAPHICS, groups[0].queueType);
+    EXPECT_EQ(std::vector<uint32_t>({ 0, 1 }), groups[0].nodes);
+    EXPECT_EQ(DeviceQueueType::COMPUTE, groups[1].queueType);
+    EXPECT_EQ(std::vector<uint32_t>({ 2 }), groups[1].nodes);
+    EXPECT_EQ(DeviceQueueType::GRAPHICS, groups[2].queueType);
+    EXPECT_EQ(std::vector<uint32_t>({ 3 }), groups[2].nodes);
+}
+
+TEST(FrameGraph, FenceClosesGroup)
+{
+    // Renderer's first Submit() - object culling and depth pass on graphics queue, then
+    // particle simulation (with a fence waited on by Particle Pass), particle sort,
+    // depth pyramid and light culling on compute queue
+    std::vector<FrameGraphPlanNode> nodes;
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, {}));
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, true, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, { 2 }));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, { 1 }));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, { 4 }));
+
+    std::vector<FrameGraphPlanGroup> groups;
+    ASSERT_TRUE(PlanFrameGraphSubmission(nodes, groups));
+    ASSERT_EQ(3u, groups.size());
+    EXPECT_EQ(std::vector<uint32_t>({ 0, 1 }), groups[0].nodes);
+
+    // fence covers only the simulation, the rest of compute work goes in the next submit
+    EXPECT_EQ(DeviceQueueType::COMPUTE, groups[1].queueType);
+    EXPECT_EQ(std::vector<uint32_t>({ 2 }), groups[1].nodes);
+    EXPECT_EQ(DeviceQueueType::COMPUTE, groups[2].queueType);
+    EXPECT_EQ(std::vector<uint32_t>({ 3, 4, 5 }), groups[2].nodes);
+}
+
+TEST(FrameGraph, FenceCoversPrecedingWork)
+{
+    std::vector<FrameGraphPlanNode> nodes;
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, true, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, true, {}));
+
+    // every group ends with its only fenced node
+    std::vector<FrameGraphPlanGroup> groups;
+    ASSERT_TRUE(PlanFrameGraphSubmission(nodes, groups));
+    ASSERT_EQ(2u, groups.size());
+    EXPECT_EQ(std::vector<uint32_t>({ 0, 1 }), groups[0].nodes);
+    EXPECT_EQ(std::vector<uint32_t>({ 2, 3 }), groups[1].nodes);
+}
+
+TEST(FrameGraph, DependencyCycle)
+{
+    std::vector<FrameGraphPlanNode> nodes;
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, {}));
+    nodes.push_back(Node(DeviceQueueType::COMPUTE, false, { 2 }));
+    nodes.push_back(Node(DeviceQueueType::GRAPHICS, false, { 1 }));
+
+    std::vector<FrameGraphPlanGroup> groups;
+    EXPECT_FALSE(PlanFrameGraphSubmission(nodes, groups));
+    ASSERT_EQ(1u, groups.size());
+    EXPECT_EQ(std::vector<uint32_t>({ 0 }), groups[0].nodes);
+}
@@ -0,0 +1,216 @@
+#include "PCH.hpp"
+#include "Renderer/HighLevel/LightBVH.hpp"
+#include "Renderer/HighLevel/LightCullingReference.hpp"
+#include "Renderer/HighLevel/ClusterGrid.hpp"
+#include "RendererTestHelpers.hpp"
+
+using namespace ABench::Math;
+using namespace ABench::Renderer;
+
+namespace {
+
+Matrix GetTestView()
+{
+    return CreateRHLookAtMatrix(Vector4(3.0f, 2.0f, 10.0f, 1.0f), Vector4(0.0f, 0.0f, 0.0f, 1.0f),
+                                Vector4(0.0f, -1.0f, 0.0f, 0.0f));
+}
+
+// lights all around the camera, world space
+std::vector<LightSphere> RandomSceneLights(uint32_t count, uint32_t seed)
+{
+    return RandomLights(count, seed, Vector3(-50.0f, -50.0f, -50.0f), Vector3(50.0f, 50.0f, 50.0f), 0.2f, 4.0f);
+}
+
+bool Encloses(const LightBVHNode& outer, const float* innerMin, const float* innerMax)
+{
+    for (int axis = 0; axis < 3; ++axis)
+        if (innerMin[axis] < outer.min[axis] || innerMax[axis] > outer.max[axis])
+            return false;
+    return true;
+}
+
+// lists of every tile or cluster, sorted, as BVH finds lights in a different order
+template <typename Culler>
+std::vector<std::vector<uint32_t>> GetSortedLists(const Culler& culler)
+{
+    std::vector<std::vector<uint32_t>> lists;
+    for (const GridLight& g: culler.GetGridLights())
+    {
+        const uint32_t* begin = culler.GetCulledLights().data() + g.offset;
+        lists.emplace_back(begin, begin + g.count);
+        std::sort(lists.back().begin(), lists.back().end());
+    }
+
+    return lists;
+}
+
+} // namespace
+
+TEST(LightBVH, Structure)
+{
+    const uint32_t lightCount = 1000;
+
+    EXPECT_EQ(0u, LightBVH::GetNodeCount(0));
+    EXPECT_EQ(1u, LightBVH::GetNodeCount(LIGHT_BVH_LEAF_SIZE));
+    EXPECT_EQ(3u, LightBVH::GetNodeCount(LIGHT_BVH_LEAF_SIZE + 1));
+    EXPECT_EQ(255u, LightBVH::GetNodeCount(lightCount)); // 125 leaves padded to 128
+
+    std::vector<LightSphere> lights = RandomSceneLights(lightCount, 1234);
+    LightBVH bvh;
+    bvh.Build(lights.data(), lightCount);
+    ASSERT_EQ(255u, bvh.GetNodes().size());
+    ASSERT_EQ(lightCount, bvh.GetLights().size());
+    EXPECT_EQ(7u, bvh.GetDepth());
+    EXPECT_EQ(127u, bvh.GetFirstLeaf());
+
+    // every light is there once, in world space, inside bounds of its leaf
+    const std::vector<LightBVHNode>& nodes = bvh.GetNodes();
+    std::vector<bool> found(lightCount, false);
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        const LightBVHLight& l = bvh.GetLights()[i];
+        ASSERT_LT(l.index, lightCount);
+        EXPECT_FALSE(found[l.index]) << "light " << l.index;
+        found[l.index] = true;
+
+        for (int axis = 0; axis < 3; ++axis)
+            EXPECT_EQ(lights[l.index].position[axis], l.position[axis]);
+        EXPECT_EQ(lights[l.index].range, l.range);
+
+        const float sphereMin[] = { l.position[0] - l.range, l.position[1] - l.range, l.position[2] - l.range };
+        const float sphereMax[] = { l.position[0] + l.range, l.position[1] + l.range, l.position[2] + l.range };
+        EXPECT_TRUE(Encloses(nodes[bvh.GetFirstLeaf() + i / LIGHT_BVH_LEAF_SIZE], sphereMin, sphereMax))
+            << "light " << i;
+    }
+
+    // parents enclose their children, padding leaves are empty
+    for (uint32_t n = 0; n < bvh.GetFirstLeaf(); ++n)
+    {
+        for (uint32_t c = n * 2 + 1; c <= n * 2 + 2; ++c)
+        {
+            if (nodes[c].min[0] > nodes[c].max[0])
+                continue;
+
+            EXPECT_TRUE(Encloses(nodes[n], nodes[c].min, nodes[c].max)) << "node " << c;
+        }
+    }
+
+    for (uint32_t n = bvh.GetFirstLeaf() + 125; n < nodes.size(); ++n)
+        EXPECT_GT(nodes[n].min[0], nodes[n].max[0]) << "node " << n;
+
+    // Morton order keeps leaves small compared to the whole scene
+    float sceneSize = nodes[0].max[0] - nodes[0].min[0];
+    float leafSizes = 0.0f;
+    for (uint32_t n = bvh.GetFirstLeaf(); n < bvh.GetFirstLeaf() + 125; ++n)
+        leafSizes += nodes[n].max[0] - nodes[n].min[0];
+    EXPECT_LT(leafSizes / 125.0f, sceneSize / 3.0f);
+}
+
+TEST(LightBVH, Traversal)
+{
+    std::vector<LightSphere> lights = RandomSceneLights(100, 4321);
+    LightBVH bvh;
+    bvh.Build(lights.data(), 100);
+
+    // accepting every node visits each of them once, in depth-first order
+    std::vector<uint32_t> visited;
+    const LightBVHNode* first = bvh.GetNodes().data();
+    uint32_t lightsVisited = 0;
+    bvh.Traverse([&](const LightBVHNode& node) { visited.push_back(static_cast<uint32_t>(&node - first)); return true; },
+                 [&](const LightBVHLight&) { lightsVisited++; });
+    EXPECT_EQ(100u, lightsVisited);
+    ASSERT_EQ(bvh.GetNodes().size(), visited.size());
+    EXPECT_EQ(0u, visited[0]);
+    EXPECT_EQ(1u, visited[1]);
+    EXPECT_EQ(3u, visited[2]);
+
+    // rejecting the root ends the walk right away
+    visited.clear();
+    lightsVisited = 0;
+    bvh.Traverse([&](const LightBVHNode&) { visited.push_back(0); return false; },
+                 [&](const LightBVHLight&) { lightsVisited++; });
+    EXPECT_EQ(1u, visited.size());
+    EXPECT_EQ(0u, lightsVisited);
+
+    // next node after a subtree
+    EXPECT_EQ(2u, LightBVH::GetNextNode(1, 0));
+    EXPECT_EQ(0u, LightBVH::GetNextNode(2, 0));
+    EXPECT_EQ(4u, LightBVH::GetNextNode(3, 0));
+    EXPECT_EQ(2u, LightBVH::GetNextNode(4, 0));
+    EXPECT_EQ(6u, LightBVH::GetNextNode(5, 0));
+    EXPECT_EQ(1u, LightBVH::GetNextNode(4, 1));
+
+    // empty BVH has nothing to walk
+    bvh.Build(lights.data(), 0);
+    EXPECT_TRUE(bvh.GetNodes().empty());
+    bvh.Traverse([](const LightBVHNode&) { return true; }, [&](const LightBVHLight&) { lightsVisited++; });
+    EXPECT_EQ(0u, lightsVisited);
+}
+
+TEST(LightBVH, TiledMatchesBruteForce)
+{
+    const uint32_t lightCount = 5000;
+
+    GridFrustumsGenerationDesc desc;
+    desc.projMat = GetTestProjection();
+    desc.viewportWidth = TEST_VIEWPORT_WIDTH;
+    desc.viewportHeight = TEST_VIEWPORT_HEIGHT;
+    desc.pixelsPerGridFrustum = 16;
+
+    LightCullingReference bruteForce;
+    LightCullingReference traversal;
+    ASSERT_TRUE(bruteForce.Init(desc));
+    ASSERT_TRUE(traversal.Init(desc));
+
+    // uneven depth, so tiles have different depth ranges
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT);
+    for (uint32_t y = 0; y < TEST_VIEWPORT_HEIGHT; ++y)
+        for (uint32_t x = 0; x < TEST_VIEWPORT_WIDTH; ++x)
+            depth[y * TEST_VIEWPORT_WIDTH + x] = (x % 40 < 8) ? 0.95f : 0.999f - 0.01f * y / TEST_VIEWPORT_HEIGHT;
+
+    Matrix view = GetTestView();
+    std::vector<LightSphere> lights = RandomSceneLights(lightCount, 1111);
+    LightBVH bvh;
+    bvh.Build(lights.data(), lightCount);
+
+    bruteForce.Cull(view, lights.data(), lightCount, depth.data());
+    traversal.Cull(view, bvh, depth.data());
+    EXPECT_GT(bruteForce.GetCulledLights().size(), 0u);
+    EXPECT_EQ(bruteForce.GetCulledLights().size(), traversal.GetCulledLights().size());
+    EXPECT_TRUE(GetSortedLists(bruteForce) == GetSortedLists(traversal));
+
+    // without depth every tile spans whole depth range
+    bruteForce.Cull(view, lights.data(), lightCount, nullptr);
+    traversal.Cull(view, bvh, nullptr);
+    EXPECT_TRUE(GetSortedLists(bruteForce) == GetSortedLists(traversal));
+}
+
+TEST(LightBVH, ClusteredMatchesBruteForce)
+{
+    const uint32_t lightCount = 5000;
+
+    ClusterGridDesc desc;
+    desc.projMat = GetTestProjection();
+    desc.viewportWidth = TEST_VIEWPORT_WIDTH;
+    desc.viewportHeight = TEST_VIEWPORT_HEIGHT;
+    desc.pixelsPerCluster = 32;
+    desc.depthSlices = 24;
+    desc.nearZ = TEST_NEAR_Z;
+    desc.farZ = TEST_FAR_Z;
+
+    ClusterGrid bruteForce;
+    ClusterGrid traversal;
+    ASSERT_TRUE(bruteForce.Init(desc));
+    ASSERT_TRUE(traversal.Init(desc));
+
+    Matrix view = GetTestView();
+    std::vector<LightSphere> lights = RandomSceneLights(lightCount, 2222);
+    LightBVH bvh;
+    bvh.Build(lights.data(), lightCount);
+
+    bruteForce.Cull(view, lights.data(), lightCount);
+    traversal.Cull(view, bvh);
+    EXPECT_GT(bruteForce.GetCulledLights().size(), 0u);
+    EXPECT_EQ(bruteForce.GetCulledLights().size(), traversal.GetCulledLights().size());
+    EXPECT_TRUE(GetSortedLists(bruteForce) == GetSortedLists(traversal));
+}
@@ -0,0 +1,452 @@
+#include "PCH.hpp"
+#include "Renderer/HighLevel/LightCullingReference.hpp"
+#include "Renderer/HighLevel/ClusterGrid.hpp"
+#include "RendererTestHelpers.hpp"
+
+using namespace ABench::Math;
+using namespace ABench::Renderer;
+
+// viewport's height is not a multiple of tile size to cover partial tiles at the edge
+const uint32_t LIGHT_CULLING_TEST_TILE_SIZE = 16;
+const uint32_t LIGHT_CULLING_TEST_CLUSTER_SIZE = 32;
+const uint32_t LIGHT_CULLING_TEST_DEPTH_SLICES = 24;
+
+namespace {
+
+GridFrustumsGenerationDesc GetTestGridDesc()
+{
+    GridFrustumsGenerationDesc desc;
+    desc.projMat = GetTestProjection();
+    desc.viewportWidth = TEST_VIEWPORT_WIDTH;
+    desc.viewportHeight = TEST_VIEWPORT_HEIGHT;
+    desc.pixelsPerGridFrustum = LIGHT_CULLING_TEST_TILE_SIZE;
+    return desc;
+}
+
+ClusterGridDesc GetTestClusterDesc()
+{
+    ClusterGridDesc desc;
+    desc.projMat = GetTestProjection();
+    desc.viewportWidth = TEST_VIEWPORT_WIDTH;
+    desc.viewportHeight = TEST_VIEWPORT_HEIGHT;
+    desc.pixelsPerCluster = LIGHT_CULLING_TEST_CLUSTER_SIZE;
+    desc.depthSlices = LIGHT_CULLING_TEST_DEPTH_SLICES;
+    desc.nearZ = TEST_NEAR_Z;
+    desc.farZ = TEST_FAR_Z;
+    return desc;
+}
+
+float GetPlaneDistance(const Plane& plane, const Vector3& point)
+{
+    return plane.GetNormal().Dot(point) - plane.GetDistance();
+}
+
+template <typename Culler>
+bool IsLightInTile(const Culler& culler, uint32_t tile, uint32_t light)
+{
+    const GridLight& gridLight = culler.GetGridLights()[tile];
+    const uint32_t* begin = culler.GetCulledLights().data() + gridLight.offset;
+    return std::find(begin, begin + gridLight.count, light) != begin + gridLight.count;
+}
+
+} // namespace
+
+TEST(LightCulling, Inverse)
+{
+    Matrix proj = GetTestGridDesc().projMat;
+    Matrix identity = proj * proj.Inverse();
+
+    for (int i = 0; i < 4; ++i)
+    {
+        Vector4 column = identity * Vector4(i == 0 ? 1.0f : 0.0f, i == 1 ? 1.0f : 0.0f,
+                                            i == 2 ? 1.0f : 0.0f, i == 3 ? 1.0f : 0.0f);
+        for (int j = 0; j < 4; ++j)
+            EXPECT_NEAR(i == j ? 1.0f : 0.0f, column[j], 1e-5f);
+    }
+
+    Matrix singular;
+    Matrix zero = singular.Inverse();
+    for (int i = 0; i < 16; ++i)
+        EXPECT_EQ(0.0f, zero.Data()[i]);
+}
+
+TEST(LightCulling, GridSize)
+{
+    LightCullingReference culler;
+    EXPECT_FALSE(culler.Init(GridFrustumsGenerationDesc()));
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    EXPECT_EQ(20u, culler.GetTilesX());
+    EXPECT_EQ(13u, culler.GetTilesY());
+    EXPECT_EQ(20u * 13u, culler.GetFrustums().size());
+    EXPECT_EQ(20u * 13u - 1, culler.GetTileIndex(TEST_VIEWPORT_WIDTH - 1, TEST_VIEWPORT_HEIGHT - 1));
+}
+
+TEST(LightCulling, FrustumPlanesPointInside)
+{
+    LightCullingReference culler;
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    for (uint32_t y = 0; y < culler.GetTilesY(); ++y)
+    {
+        for (uint32_t x = 0; x < culler.GetTilesX(); ++x)
+        {
+            const GridFrustum& f = culler.GetFrustums()[y * culler.GetTilesX() + x];
+            float centerX = (x + 0.5f) * LIGHT_CULLING_TEST_TILE_SIZE;
+            float centerY = (y + 0.5f) * LIGHT_CULLING_TEST_TILE_SIZE;
+
+            Vector3 center = culler.Unproject(centerX, centerY, 0.5f);
+            for (uint32_t p = 0; p < GridFrustum::COUNT; ++p)
+                EXPECT_GT(GetPlaneDistance(f.planes[p], center), 0.0f) << "tile " << x << "x" << y << ", plane " << p;
+
+            // centers of neighbouring tiles are outside of the planes they share
+            float step = static_cast<float>(LIGHT_CULLING_TEST_TILE_SIZE);
+            EXPECT_LT(GetPlaneDistance(f.planes[GridFrustum::LEFT], culler.Unproject(centerX - step, centerY, 0.5f)), 0.0f);
+            EXPECT_LT(GetPlaneDistance(f.planes[GridFrustum::RIGHT], culler.Unproject(centerX + step, centerY, 0.5f)), 0.0f);
+            EXPECT_LT(GetPlaneDistance(f.planes[GridFrustum::TOP], culler.Unproject(centerX, centerY - step, 0.5f)), 0.0f);
+            EXPECT_LT(GetPlaneDistance(f.planes[GridFrustum::BOTTOM], culler.Unproject(centerX, centerY + step, 0.5f)), 0.0f);
+        }
+    }
+}
+
+TEST(LightCulling, LightLandsInItsTile)
+{
+    LightCullingReference culler;
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    // top-left quarter of the screen, to catch flipped Y
+    const uint32_t tileX = 3;
+    const uint32_t tileY = 2;
+    Vector3 pos = culler.Unproject((tileX + 0.5f) * LIGHT_CULLING_TEST_TILE_SIZE,
+                                   (tileY + 0.5f) * LIGHT_CULLING_TEST_TILE_SIZE, 0.9f);
+
+    // tiny light seen from far away covers only one tile
+    LightSphere light(Vector4(pos, 1.0f), 0.001f);
+    culler.Cull(MATRIX_IDENTITY, &light, 1, nullptr);
+
+    for (uint32_t t = 0; t < culler.GetGridLights().size(); ++t)
+        EXPECT_EQ(t == tileY * culler.GetTilesX() + tileX ? 1u : 0u, culler.GetGridLights()[t].count) << "tile " << t;
+}
+
+TEST(LightCulling, DepthBoundsCullHiddenLights)
+{
+    LightCullingReference culler;
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT, 0.99f);
+    float wallZ = culler.Unproject(0.0f, 0.0f, 0.99f)[2];
+
+    // one light right behind the wall, one touching it, one in front of it
+    LightSphere lights[3];
+    lights[0] = LightSphere(Vector4(0.0f, 0.0f, wallZ - 2.0f, 1.0f), 1.0f);
+    lights[1] = LightSphere(Vector4(0.0f, 0.0f, wallZ - 0.5f, 1.0f), 1.0f);
+    lights[2] = LightSphere(Vector4(0.0f, 0.0f, wallZ * 0.5f, 1.0f), 1.0f);
+
+    uint32_t centerTile = culler.GetTileIndex(TEST_VIEWPORT_WIDTH / 2, TEST_VIEWPORT_HEIGHT / 2);
+
+    culler.Cull(MATRIX_IDENTITY, lights, 3, depth.data());
+    EXPECT_FALSE(IsLightInTile(culler, centerTile, 0));
+    EXPECT_TRUE(IsLightInTile(culler, centerTile, 1));
+    EXPECT_FALSE(IsLightInTile(culler, centerTile, 2));
+
+    // without depth all of them are visible
+    culler.Cull(MATRIX_IDENTITY, lights, 3, nullptr);
+    EXPECT_TRUE(IsLightInTile(culler, centerTile, 0));
+    EXPECT_TRUE(IsLightInTile(culler, centerTile, 1));
+    EXPECT_TRUE(IsLightInTile(culler, centerTile, 2));
+}
+
+TEST(LightCulling, NoFalseNegatives)
+{
+    const uint32_t lightCount = 400;
+
+    LightCullingReference culler;
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    Matrix view = CreateRHLookAtMatrix(Vector4(3.0f, 2.0f, 10.0f, 1.0f), Vector4(0.0f, 0.0f, 0.0f, 1.0f),
+                                       Vector4(0.0f, -1.0f, 0.0f, 0.0f));
+    Matrix invView = view.Inverse();
+
+    // sloped depth buffer with a step, so tiles get different and uneven depth ranges
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT);
+    for (uint32_t y = 0; y < TEST_VIEWPORT_HEIGHT; ++y)
+        for (uint32_t x = 0; x < TEST_VIEWPORT_WIDTH; ++x)
+            depth[y * TEST_VIEWPORT_WIDTH + x] = 0.98f + 0.015f * x / TEST_VIEWPORT_WIDTH +
+                                                       (y > TEST_VIEWPORT_HEIGHT / 3 ? 0.004f : 0.0f);
+
+    // lights scattered around visible geometry, placed in view space and moved to world space
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<float> screenX(-20.0f, TEST_VIEWPORT_WIDTH + 20.0f);
+    std::uniform_real_distribution<float> screenY(-20.0f, TEST_VIEWPORT_HEIGHT + 20.0f);
+    std::uniform_real_distribution<float> depthDist(0.95f, 0.999f);
+    std::uniform_real_distribution<float> rangeDist(0.05f, 2.0f);
+
+    std::vector<LightSphere> lights(lightCount);
+    std::vector<Vector3> viewLights(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        viewLights[i] = culler.Unproject(screenX(gen), screenY(gen), depthDist(gen));
+        lights[i] = LightSphere(invView * Vector4(viewLights[i], 1.0f), rangeDist(gen));
+    }
+
+    culler.Cull(view, lights.data(), lightCount, depth.data());
+
+    // every light reaching a visible surface must be in the list of surface's tile
+    uint32_t litPixels = 0;
+    for (uint32_t y = 0; y < TEST_VIEWPORT_HEIGHT; ++y)
+    {
+        for (uint32_t x = 0; x < TEST_VIEWPORT_WIDTH; ++x)
+        {
+            Vector3 surface = culler.Unproject(x + 0.5f, y + 0.5f, depth[y * TEST_VIEWPORT_WIDTH + x]);
+            uint32_t tile = culler.GetTileIndex(x, y);
+
+            for (uint32_t i = 0; i < lightCount; ++i)
+            {
+                if ((surface - viewLights[i]).Length() < lights[i].range * 0.999f)
+                {
+                    ASSERT_TRUE(IsLightInTile(culler, tile, i)) << "light " << i << " missing at pixel " << x << "x" << y;
+                    litPixels++;
+                }
+            }
+        }
+    }
+
+    // make sure the test exercised something, and that culling removed most of the lights
+    EXPECT_GT(litPixels, 0u);
+    EXPECT_LT(culler.GetMaxLightsPerTile(), lightCount / 10);
+}
+
+TEST(LightCulling, ManyLights)
+{
+    const uint32_t lightCount = 10000;
+
+    LightCullingReference culler;
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    std::vector<LightSphere> lights = RandomLights(lightCount, 4321, Vector3(-50.0f, -50.0f, -100.0f),
+                                                   Vector3(50.0f, 50.0f, 0.0f), 0.5f, 2.0f);
+
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT, 0.999f);
+    culler.Cull(MATRIX_IDENTITY, lights.data(), lightCount, depth.data());
+
+    uint32_t total = 0;
+    for (auto& g: culler.GetGridLights())
+        total += g.count;
+
+    EXPECT_EQ(total, culler.GetCulledLights().size());
+    EXPECT_GT(culler.GetAverageLightsPerPixel(), 0.0f);
+    EXPECT_LT(culler.GetAverageLightsPerPixel(), lightCount / 100.0f);
+    EXPECT_LT(culler.GetMaxLightsPerTile(), lightCount / 10);
+}
+
+TEST(LightCulling, ClusterSlices)
+{
+    ClusterGrid grid;
+    EXPECT_FALSE(grid.Init(ClusterGridDesc()));
+    ASSERT_TRUE(grid.Init(GetTestClusterDesc()));
+
+    EXPECT_EQ(10u, grid.GetClustersX());
+    EXPECT_EQ(7u, grid.GetClustersY());
+    EXPECT_EQ(10u * 7u * LIGHT_CULLING_TEST_DEPTH_SLICES, grid.GetClusterCount());
+
+    EXPECT_NEAR(TEST_NEAR_Z, grid.GetViewDepth(0.0f), 1e-4f);
+    EXPECT_NEAR(TEST_FAR_Z, grid.GetViewDepth(1.0f), 1e-2f);
+    EXPECT_EQ(0u, grid.GetSlice(TEST_NEAR_Z));
+    EXPECT_EQ(LIGHT_CULLING_TEST_DEPTH_SLICES - 1, grid.GetSlice(TEST_FAR_Z));
+
+    // exponential slices - each one is the same number of times deeper than the previous one
+    float ratio = powf(TEST_FAR_Z / TEST_NEAR_Z, 1.0f / LIGHT_CULLING_TEST_DEPTH_SLICES);
+    float sliceStart = TEST_NEAR_Z;
+    for (uint32_t z = 0; z < LIGHT_CULLING_TEST_DEPTH_SLICES; ++z)
+    {
+        EXPECT_EQ(z, grid.GetSlice(sliceStart * sqrtf(ratio)));
+        sliceStart *= ratio;
+    }
+}
+
+TEST(LightCulling, ClustersContainTheirPixels)
+{
+    ClusterGrid grid;
+    ASSERT_TRUE(grid.Init(GetTestClusterDesc()));
+
+    LightCullingReference unprojector;
+    ASSERT_TRUE(unprojector.Init(GetTestGridDesc()));
+
+    const float epsilon = 1e-3f;
+    for (uint32_t y = 0; y < TEST_VIEWPORT_HEIGHT; y += 7)
+    {
+        for (uint32_t x = 0; x < TEST_VIEWPORT_WIDTH; x += 7)
+        {
+            for (float depth = 0.0f; depth < 1.0f; depth += 0.0625f)
+            {
+                Vector3 p = unprojector.Unproject(x + 0.5f, y + 0.5f, depth);
+                const ClusterAABB& cluster = grid.GetClusters()[grid.GetClusterIndex(x, y, grid.GetViewDepth(depth))];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    float tolerance = epsilon * std::max(1.0f, fabsf(p[axis]));
+                    EXPECT_GE(p[axis], cluster.min[axis] - tolerance) << x << "x" << y << ", depth " << depth;
+                    EXPECT_LE(p[axis], cluster.max[axis] + tolerance) << x << "x" << y << ", depth " << depth;
+                }
+            }
+        }
+    }
+}
+
+TEST(LightCulling, ClustersNoFalseNegatives)
+{
+    const uint32_t lightCount = 400;
+
+    ClusterGrid grid;
+    ASSERT_TRUE(grid.Init(GetTestClusterDesc()));
+
+    LightCullingReference unprojector;
+    ASSERT_TRUE(unprojector.Init(GetTestGridDesc()));
+
+    Matrix view = CreateRHLookAtMatrix(Vector4(-4.0f, 1.0f, 6.0f, 1.0f), Vector4(0.0f, 0.0f, 0.0f, 1.0f),
+                                       Vector4(0.0f, -1.0f, 0.0f, 0.0f));
+    Matrix invView = view.Inverse();
+
+    std::mt19937 gen(5678);
+    std::uniform_real_distribution<float> screenX(-20.0f, TEST_VIEWPORT_WIDTH + 20.0f);
+    std::uniform_real_distribution<float> screenY(-20.0f, TEST_VIEWPORT_HEIGHT + 20.0f);
+    std::uniform_real_distribution<float> depthDist(0.9f, 0.999f);
+    std::uniform_real_distribution<float> rangeDist(0.05f, 2.0f);
+
+    std::vector<LightSphere> lights(lightCount);
+    std::vector<Vector3> viewLights(lightCount);
+    for (uint32_t i = 0; i < lightCount; ++i)
+    {
+        viewLights[i] = unprojector.Unproject(screenX(gen), screenY(gen), depthDist(gen));
+        lights[i] = LightSphere(invView * Vector4(viewLights[i], 1.0f), rangeDist(gen));
+    }
+
+    grid.Cull(view, lights.data(), lightCount);
+
+    // surfaces at many depths, including ones a tile would merge into a single range
+    uint32_t litPixels = 0;
+    for (uint32_t y = 0; y < TEST_VIEWPORT_HEIGHT; y += 3)
+    {
+        for (uint32_t x = 0; x < TEST_VIEWPORT_WIDTH; x += 3)
+        {
+            float depth = 0.9f + 0.099f * ((x * 7 + y * 13) % 64) / 64.0f;
+            Vector3 surface = unprojector.Unproject(x + 0.5f, y + 0.5f, depth);
+            uint32_t cluster = grid.GetClusterIndex(x, y, grid.GetViewDepth(depth));
+
+            for (uint32_t i = 0; i < lightCount; ++i)
+            {
+                if ((surface - viewLights[i]).Length() < lights[i].range * 0.999f)
+                {
+                    ASSERT_TRUE(IsLightInTile(grid, cluster, i)) << "light " << i << " missing at pixel " << x << "x" << y;
+                    litPixels++;
+                }
+            }
+        }
+    }
+
+    EXPECT_GT(litPixels, 0u);
+    EXPECT_LT(grid.GetMaxLightsPerCluster(), lightCount);
+}
+
+TEST(LightCulling, ClustersHandleDepthDiscontinuities)
+{
+    const uint32_t lightCount = 2000;
+
+    LightCullingReference tiled;
+    ASSERT_TRUE(tiled.Init(GetTestGridDesc()));
+
+    ClusterGrid clustered;
+    ASSERT_TRUE(clustered.Init(GetTestClusterDesc()));
+
+    // thin columns close to the camera in front of a distant wall - every tile spans both
+    std::vector<float> depth(TEST_VIEWPORT_WIDTH * TEST_VIEWPORT_HEIGHT);
+    for (uint32_t y = 0; y < TEST_VIEWPORT_HEIGHT; ++y)
+        for (uint32_t x = 0; x < TEST_VIEWPORT_WIDTH; ++x)
+            depth[y * TEST_VIEWPORT_WIDTH + x] = (x % 8 < 2) ? 0.95f : 0.9995f;
+
+    // lights fill the space between the columns and the wall
+    std::mt19937 gen(8765);
+    std::uniform_real_distribution<float> screenX(0.0f, static_cast<float>(TEST_VIEWPORT_WIDTH));
+    std::uniform_real_distribution<float> screenY(0.0f, static_cast<float>(TEST_VIEWPORT_HEIGHT));
+    std::uniform_real_distribution<float> depthDist(0.95f, 0.9995f);
+
+    std::vector<LightSphere> lights(lightCount);
+    for (auto& l: lights)
+        l = LightSphere(Vector4(tiled.Unproject(screenX(gen), screenY(gen), depthDist(gen)), 1.0f), 1.0f);
+
+    tiled.Cull(MATRIX_IDENTITY, lights.data(), lightCount, depth.data());
+    clustered.Cull(MATRIX_IDENTITY, lights.data(), lightCount);
+
+    EXPECT_LT(clustered.GetAverageLightsPerPixel(depth.data()), tiled.GetAverageLightsPerPixel());
+}
+
+TEST(LightCulling, ScanLightCounts)
+{
+    std::vector<GridLight> gridLights(4);
+    const uint32_t counts[] = { 3, 0, 5, 1 };
+    for (uint32_t i = 0; i < 4; ++i)
+        gridLights[i].count = counts[i];
+
+    // lists crossing the capacity are trimmed, required size counts all of them
+    EXPECT_EQ(9u, ScanLightCounts(gridLights.data(), 4, 6));
+
+    const uint32_t offsets[] = { 0, 3, 3, 8 };
+    const uint32_t trimmed[] = { 3, 0, 3, 0 };
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(offsets[i], gridLights[i].offset);
+        EXPECT_EQ(trimmed[i], gridLights[i].count);
+    }
+}
+
+TEST(LightCulling, ListsArePacked)
+{
+    const uint32_t lightCount = 400;
+
+    LightCullingReference tiled;
+    ASSERT_TRUE(tiled.Init(GetTestGridDesc()));
+
+    ClusterGrid clustered;
+    ASSERT_TRUE(clustered.Init(GetTestClusterDesc()));
+
+    std::vector<LightSphere> lights = RandomLights(lightCount, 2468, Vector3(-20.0f, -20.0f, -40.0f),
+                                                   Vector3(20.0f, 20.0f, -1.0f), 0.5f, 4.0f);
+
+    tiled.Cull(MATRIX_IDENTITY, lights.data(), lightCount, nullptr);
+    clustered.Cull(MATRIX_IDENTITY, lights.data(), lightCount);
+
+    // scanning counts of the first pass gives the same layout as the reference
+    for (const auto* ref: { &tiled.GetGridLights(), &clustered.GetGridLights() })
+    {
+        std::vector<GridLight> scanned(*ref);
+        for (auto& g: scanned)
+            g.offset = 0;
+
+        uint32_t total = ScanLightCounts(scanned.data(), static_cast<uint32_t>(scanned.size()), UINT32_MAX);
+        EXPECT_GT(total, 0u);
+        for (size_t i = 0; i < scanned.size(); ++i)
+        {
+            EXPECT_EQ((*ref)[i].offset, scanned[i].offset);
+            EXPECT_EQ((*ref)[i].count, scanned[i].count);
+        }
+    }
+
+    EXPECT_EQ(tiled.GetCulledLights().size(), tiled.GetGridLights().back().offset + tiled.GetGridLights().back().count);
+    EXPECT_EQ(clustered.GetCulledLights().size(),
+              clustered.GetGridLights().back().offset + clustered.GetGridLights().back().count);
+}
+
+TEST(LightCulling, NoLightLimitPerTile)
+{
+    // more lights than a tile could hold when lists were gathered in shared memory
+    const uint32_t lightCount = 5000;
+
+    LightCullingReference culler;
+    ASSERT_TRUE(culler.Init(GetTestGridDesc()));
+
+    Vector4 center(culler.Unproject(8.0f, 8.0f, 0.99f), 1.0f);
+    std::vector<LightSphere> lights(lightCount, LightSphere(center, 0.1f));
+    culler.Cull(MATRIX_IDENTITY, lights.data(), lightCount, nullptr);
+
+    EXPECT_EQ(lightCount, culler.GetGridLights()[culler.GetTileIndex(8, 8)].count);
+    EXPECT_EQ(lightCount, culler.GetMaxLightsPerTile());
+}
@@ -0,0 +1,103 @@
+#include "PCH.hpp"
+#include "Common/MPSCQueue.hpp"
+#include <thread>
+
+using namespace ABench::Common;
+
+const size_t MPSC_QUEUE_TEST_CAPACITY = 64;
+const uint32_t MPSC_QUEUE_TEST_PRODUCERS = 4;
+const uint32_t MPSC_QUEUE_TEST_ITEMS = 10000; // per producer
+
+TEST(MPSCQueue, InitCapacity)
+{
+    MPSCQueue<uint32_t> queue;
+    EXPECT_FALSE(queue.Init(0));
+    EXPECT_FALSE(queue.Init(100));
+    ASSERT_TRUE(queue.Init(MPSC_QUEUE_TEST_CAPACITY));
+    EXPECT_EQ(MPSC_QUEUE_TEST_CAPACITY, queue.GetCapacity());
+}
+
+TEST(MPSCQueue, PopEmpty)
+{
+    MPSCQueue<uint32_t> queue;
+    ASSERT_TRUE(queue.Init(MPSC_QUEUE_TEST_CAPACITY));
+
+    uint32_t value = 0;
+    EXPECT_FALSE(queue.Pop(value));
+}
+
+TEST(MPSCQueue, FirstInFirstOut)
+{
+    MPSCQueue<uint32_t> queue;
+    ASSERT_TRUE(queue.Init(MPSC_QUEUE_TEST_CAPACITY));
+
+    // go around the ring a few times to cover wrapping of positions
+    for (uint32_t round = 0; round < 3; ++round)
+    {
+        for (uint32_t i = 0; i < MPSC_QUEUE_TEST_CAPACITY; ++i)
+            ASSERT_TRUE(queue.Push(i));
+
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < MPSC_QUEUE_TEST_CAPACITY; ++i)
+        {
+            ASSERT_TRUE(queue.Pop(value));
+            EXPECT_EQ(i, value);
+        }
+        EXPECT_FALSE(queue.Pop(value));
+    }
+}
+
+TEST(MPSCQueue, PushFull)
+{
+    MPSCQueue<uint32_t> queue;
+    ASSERT_TRUE(queue.Init(MPSC_QUEUE_TEST_CAPACITY));
+
+    for (uint32_t i = 0; i < MPSC_QUEUE_TEST_CAPACITY; ++i)
+        ASSERT_TRUE(queue.Push(i));
+    EXPECT_FALSE(queue.Push(0));
+
+    uint32_t value = 0;
+    ASSERT_TRUE(queue.Pop(value));
+    EXPECT_TRUE(queue.Push(0));
+}
+
+TEST(MPSCQueue, MultipleProducers)
+{
+    MPSCQueue<uint32_t> queue;
+    ASSERT_TRUE(queue.Init(MPSC_QUEUE_TEST_CAPACITY));
+
+    // each value encodes its producer and sequence number
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < MPSC_QUEUE_TEST_PRODUCERS; ++p)
+    {
+        producers.emplace_back([&queue, p]() {
+            for (uint32_t i = 0; i < MPSC_QUEUE_TEST_ITEMS; ++i)
+                while (!queue.Push(p * MPSC_QUEUE_TEST_ITEMS + i))
+                    std::this_thread::yield();
+        });
+    }
+
+    // every item arrives exactly once, in order within its producer
+    std::vector<uint32_t> nextItem(MPSC_QUEUE_TEST_PRODUCERS, 0);
+    uint32_t received = 0;
+    uint32_t value = 0;
+    while (received < MPSC_QUEUE_TEST_PRODUCERS * MPSC_QUEUE_TEST_ITEMS)
+    {
+        if (!queue.Pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        uint32_t producer = value / MPSC_QUEUE_TEST_ITEMS;
+        ASSERT_LT(producer, MPSC_QUEUE_TEST_PRODUCERS);
+        EXPECT_EQ(nextItem[producer], value % MPSC_QUEUE_TEST_ITEMS);
+        nextItem[producer]++;
+        received++;
+    }
+
+    for (auto& t: producers)
+        t.join();
+
+    EXPECT_FALSE(queue.Pop(value));
+}
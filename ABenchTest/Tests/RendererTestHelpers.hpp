@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Math/Matrix.hpp"
+#include "Math/Vector.hpp"
+#include "Renderer/HighLevel/LightCullingReference.hpp"
+
+#include <random>
+#include <vector>
+
+
+// Viewport shared by light culling, light BVH and depth pyramid tests. Height is neither
+// a multiple of 16 nor a power of two, so partial tiles and odd pyramid levels are covered.
+const uint32_t TEST_VIEWPORT_WIDTH = 320;
+const uint32_t TEST_VIEWPORT_HEIGHT = 200;
+const float TEST_NEAR_Z = 0.1f;
+const float TEST_FAR_Z = 100.0f;
+
+inline ABench::Math::Matrix GetTestProjection()
+{
+    return ABench::Math::CreateRHProjectionMatrix(60.0f, static_cast<float>(TEST_VIEWPORT_WIDTH) / TEST_VIEWPORT_HEIGHT,
+                                                  TEST_NEAR_Z, TEST_FAR_Z);
+}
+
+// Lights with positions spread uniformly between given corners and ranges between given limits
+inline std::vector<ABench::Renderer::LightSphere> RandomLights(uint32_t count, uint32_t seed,
+                                                               const ABench::Math::Vector3& minPos,
+                                                               const ABench::Math::Vector3& maxPos,
+                                                               float minRange, float maxRange)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> xDist(minPos[0], maxPos[0]);
+    std::uniform_real_distribution<float> yDist(minPos[1], maxPos[1]);
+    std::uniform_real_distribution<float> zDist(minPos[2], maxPos[2]);
+    std::uniform_real_distribution<float> rangeDist(minRange, maxRange);
+
+    std::vector<ABench::Renderer::LightSphere> lights(count);
+    for (auto& l: lights)
+    {
+        float x = xDist(gen);
+        float y = yDist(gen);
+        float z = zDist(gen);
+        l = ABench::Renderer::LightSphere(ABench::Math::Vector4(x, y, z, 1.0f), rangeDist(gen));
+    }
+
+    return lights;
+}
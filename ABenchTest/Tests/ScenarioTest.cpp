@@ -0,0 +1,99 @@
+#include "PCH.hpp"
+#include "Benchmark/Scenario.hpp"
+
+using namespace ABench::Benchmark;
+
+namespace {
+
+const std::string SCENARIO_CAMERA = "camera = 0 1 2  3 4 5\n"
+                                    "camera = 6 7 8  9 10 11\n";
+
+} // namespace
+
+TEST(Scenario, Defaults)
+{
+    std::stringstream ss("name = test\n" + SCENARIO_CAMERA);
+    Scenario scenario;
+    ASSERT_TRUE(scenario.Parse(ss));
+    EXPECT_EQ("test", scenario.GetName());
+    ASSERT_EQ(1u, scenario.GetRuns().size());
+
+    const ScenarioRun& run = scenario.GetRuns()[0];
+    EXPECT_EQ("test", run.name);
+    EXPECT_TRUE(run.async);
+    EXPECT_EQ(ABench::Renderer::LightCullingMode::Tiled, run.lightCulling);
+    EXPECT_FALSE(run.gpuCulling);
+    EXPECT_FALSE(run.occlusion);
+    EXPECT_FALSE(run.lightBVH);
+    ASSERT_EQ(2u, run.cameraPath.size());
+    EXPECT_EQ(6.0f, run.cameraPath[1].pos[0]);
+    EXPECT_EQ(11.0f, run.cameraPath[1].at[2]);
+}
+
+TEST(Scenario, Parameters)
+{
+    std::stringstream ss("# comment\n"
+                         "lights = 256   # trailing comment\n"
+                         "\n"
+                         "frames=100\n"
+                         "async = off\n"
+                         "framesInFlight = 3\n"
+                         "culling = clustered\n"
+                         "gpuCulling = on\n"
+                         "occlusion = on\n"
+                         "lightBvh = on\n" + SCENARIO_CAMERA);
+    Scenario scenario;
+    ASSERT_TRUE(scenario.Parse(ss));
+    ASSERT_EQ(1u, scenario.GetRuns().size());
+
+    const ScenarioRun& run = scenario.GetRuns()[0];
+    EXPECT_EQ(256u, run.lights);
+    EXPECT_EQ(100u, run.measuredFrames);
+    EXPECT_FALSE(run.async);
+    EXPECT_EQ(3u, run.framesInFlight);
+    EXPECT_EQ(ABench::Renderer::LightCullingMode::Clustered, run.lightCulling);
+    EXPECT_TRUE(run.gpuCulling);
+    EXPECT_TRUE(run.occlusion);
+    EXPECT_TRUE(run.lightBVH);
+}
+
+TEST(Scenario, Sweep)
+{
+    std::stringstream ss("name = s\n"
+                         "sweep = lights 1 2 3\n"
+                         "sweep = async off on\n" + SCENARIO_CAMERA);
+    Scenario scenario;
+    ASSERT_TRUE(scenario.Parse(ss));
+
+    const std::vector<ScenarioRun>& runs = scenario.GetRuns();
+    ASSERT_EQ(6u, runs.size());
+    EXPECT_EQ("s_lights=1_async=off", runs[0].name);
+    EXPECT_EQ(1u, runs[0].lights);
+    EXPECT_FALSE(runs[0].async);
+    EXPECT_EQ("s_lights=3_async=on", runs[5].name);
+    EXPECT_EQ(3u, runs[5].lights);
+    EXPECT_TRUE(runs[5].async);
+}
+
+TEST(Scenario, Invalid)
+{
+    Scenario scenario;
+
+    std::stringstream noCamera("lights = 1\n");
+    EXPECT_FALSE(scenario.Parse(noCamera));
+
+    std::stringstream unknownKey("foo = 1\n" + SCENARIO_CAMERA);
+    EXPECT_FALSE(scenario.Parse(unknownKey));
+
+    std::stringstream badValue("lights = many\n" + SCENARIO_CAMERA);
+    EXPECT_FALSE(scenario.Parse(badValue));
+
+    std::stringstream badCulling("culling = deferred\n" + SCENARIO_CAMERA);
+    EXPECT_FALSE(scenario.Parse(badCulling));
+
+    std::stringstream badSweep("sweep = frames 10 0\n" + SCENARIO_CAMERA);
+    EXPECT_FALSE(scenario.Parse(badSweep));
+
+    std::stringstream shortCamera("camera = 1 2 3\n");
+    EXPECT_FALSE(scenario.Parse(shortCamera));
+}
@@ -125,3 +125,48 @@ TEST(BitonicSort, FloatPerfTest)
         std::cout << averageTime / static_cast<double>(REPEAT_COUNT) << std::endl;
     }
 }
+
+TEST(RadixSort, SimpleUintArray)
+{
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    std::vector<uint32_t> sorted;
+    for (uint32_t i = 0; i < 1000; ++i)
+        sorted.push_back(i * 2654435761u);
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<uint32_t> unsorted = sorted;
+    std::shuffle(unsorted.begin(), unsorted.end(), gen);
+
+    ABench::Math::RadixSort(unsorted);
+    ASSERT_TRUE(unsorted == sorted);
+}
+
+TEST(RadixSort, StableKeyValuePairs)
+{
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<uint64_t> keyDist(0, 15);
+
+    // few distinct keys spread over all bytes, so stability of every pass matters
+    std::vector<std::pair<uint64_t, uint32_t>> pairs;
+    for (uint32_t i = 0; i < 4096; ++i)
+    {
+        uint64_t k = keyDist(gen);
+        pairs.emplace_back((k << 60) | (k << 30) | k, i);
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> expected = pairs;
+    std::stable_sort(expected.begin(), expected.end(),
+        [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) {
+            return a.first < b.first;
+        });
+
+    std::vector<std::pair<uint64_t, uint32_t>> temp;
+    ABench::Math::RadixSort(pairs, temp, [](const std::pair<uint64_t, uint32_t>& p) { return p.first; });
+    ASSERT_TRUE(pairs == expected);
+
+    // already sorted input and single byte keys skip most of the passes
+    ABench::Math::RadixSort(pairs, temp, [](const std::pair<uint64_t, uint32_t>& p) { return p.first; });
+    ASSERT_TRUE(pairs == expected);
+}
@@ -0,0 +1,71 @@
+#include "PCH.hpp"
+#include "Math/Statistics.hpp"
+
+using namespace ABench::Math;
+
+const double STATISTICS_TEST_EPSILON = 1e-9;
+
+TEST(Statistics, Empty)
+{
+    Statistics stats = CalculateStatistics(std::vector<double>());
+    EXPECT_EQ(0u, stats.count);
+    EXPECT_EQ(0.0, stats.mean);
+    EXPECT_EQ(0.0, stats.p99);
+}
+
+TEST(Statistics, SingleSample)
+{
+    Statistics stats = CalculateStatistics({ 4.0 });
+    EXPECT_EQ(1u, stats.count);
+    EXPECT_EQ(4.0, stats.mean);
+    EXPECT_EQ(4.0, stats.median);
+    EXPECT_EQ(4.0, stats.p99);
+    EXPECT_EQ(0.0, stats.stdDev);
+
+    // no spread can be estimated from a single sample
+    EXPECT_EQ(4.0, stats.ciLow);
+    EXPECT_EQ(4.0, stats.ciHigh);
+}
+
+TEST(Statistics, Unsorted)
+{
+    Statistics stats = CalculateStatistics({ 5.0, 1.0, 4.0, 2.0, 3.0 });
+    EXPECT_EQ(5u, stats.count);
+    EXPECT_NEAR(3.0, stats.mean, STATISTICS_TEST_EPSILON);
+    EXPECT_NEAR(3.0, stats.median, STATISTICS_TEST_EPSILON);
+    EXPECT_EQ(1.0, stats.min);
+    EXPECT_EQ(5.0, stats.max);
+    EXPECT_NEAR(std::sqrt(2.5), stats.stdDev, STATISTICS_TEST_EPSILON);
+
+    // t(4) = 2.776
+    double margin = 2.776 * std::sqrt(2.5) / std::sqrt(5.0);
+    EXPECT_NEAR(3.0 - margin, stats.ciLow, STATISTICS_TEST_EPSILON);
+    EXPECT_NEAR(3.0 + margin, stats.ciHigh, STATISTICS_TEST_EPSILON);
+}
+
+TEST(Statistics, Percentile)
+{
+    std::vector<double> sorted(101);
+    for (size_t i = 0; i < sorted.size(); ++i)
+        sorted[i] = static_cast<double>(i);
+
+    EXPECT_NEAR(0.0, Percentile(sorted, 0.0), STATISTICS_TEST_EPSILON);
+    EXPECT_NEAR(50.0, Percentile(sorted, 0.5), STATISTICS_TEST_EPSILON);
+    EXPECT_NEAR(99.0, Percentile(sorted, 0.99), STATISTICS_TEST_EPSILON);
+    EXPECT_NEAR(100.0, Percentile(sorted, 1.0), STATISTICS_TEST_EPSILON);
+
+    // in between ranks values are interpolated
+    EXPECT_NEAR(2.5, Percentile({ 2.0, 3.0 }, 0.5), STATISTICS_TEST_EPSILON);
+}
+
+TEST(Statistics, OutlierAffectsTailOnly)
+{
+    std::vector<double> samples(1000, 16.0);
+    samples[500] = 100.0;
+
+    Statistics stats = CalculateStatistics(samples);
+    EXPECT_NEAR(16.0, stats.median, STATISTICS_TEST_EPSILON);
+    EXPECT_NEAR(16.0, stats.p99, STATISTICS_TEST_EPSILON);
+    EXPECT_EQ(100.0, stats.max);
+    EXPECT_GT(stats.mean, 16.0);
+}
@@ -0,0 +1,162 @@
+#include "PCH.hpp"
+#include "Common/ThreadPool.hpp"
+#include <atomic>
+
+using namespace ABench::Common;
+
+const uint32_t THREAD_POOL_TEST_WORKERS = 4;
+const uint32_t THREAD_POOL_TEST_TASKS = 1000;
+
+TEST(ThreadPool, InitRelease)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(THREAD_POOL_TEST_WORKERS));
+    EXPECT_EQ(THREAD_POOL_TEST_WORKERS, pool.GetWorkerCount());
+    EXPECT_FALSE(pool.Init(THREAD_POOL_TEST_WORKERS));
+
+    pool.Release();
+    EXPECT_EQ(0u, pool.GetWorkerCount());
+}
+
+TEST(ThreadPool, AutoWorkerCount)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init());
+    EXPECT_GE(pool.GetWorkerCount(), 1u);
+}
+
+TEST(ThreadPool, ExecuteAllTasks)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(THREAD_POOL_TEST_WORKERS));
+
+    std::atomic<uint32_t> counter(0);
+    for (uint32_t i = 0; i < THREAD_POOL_TEST_TASKS; ++i)
+        pool.AddTask([&counter]() { counter++; });
+
+    pool.WaitForTasks();
+    EXPECT_EQ(THREAD_POOL_TEST_TASKS, counter.load());
+}
+
+TEST(ThreadPool, WaitWithoutTasks)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(THREAD_POOL_TEST_WORKERS));
+
+    // should return immediately
+    pool.WaitForTasks();
+}
+
+TEST(ThreadPool, DisjointRanges)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(THREAD_POOL_TEST_WORKERS));
+
+    // emulates how passes split their object lists between workers
+    std::vector<uint32_t> data(THREAD_POOL_TEST_TASKS, 0);
+    const uint32_t chunkSize = THREAD_POOL_TEST_TASKS / THREAD_POOL_TEST_WORKERS;
+    for (uint32_t c = 0; c < THREAD_POOL_TEST_WORKERS; ++c)
+    {
+        pool.AddTask([&data, c, chunkSize]() {
+            for (uint32_t i = c * chunkSize; i < (c + 1) * chunkSize; ++i)
+                data[i] = i;
+        });
+    }
+
+    pool.WaitForTasks();
+    for (uint32_t i = 0; i < THREAD_POOL_TEST_TASKS; ++i)
+        EXPECT_EQ(i, data[i]);
+}
+
+TEST(ThreadPool, WaitForGroup)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(THREAD_POOL_TEST_WORKERS));
+
+    // unrelated task occupies one worker until released
+    std::atomic<bool> release(false);
+    std::atomic<bool> unrelatedFinished(false);
+    pool.AddTask([&release, &unrelatedFinished]() {
+        while (!release)
+            std::this_thread::yield();
+        unrelatedFinished = true;
+    });
+
+    ThreadPoolTaskGroup group;
+    std::atomic<uint32_t> counter(0);
+    for (uint32_t i = 0; i < THREAD_POOL_TEST_TASKS; ++i)
+        pool.AddTask([&counter]() { counter++; }, &group);
+
+    pool.WaitForTasks(group);
+    EXPECT_EQ(THREAD_POOL_TEST_TASKS, counter.load());
+    EXPECT_FALSE(unrelatedFinished.load());
+
+    release = true;
+    pool.WaitForTasks();
+    EXPECT_TRUE(unrelatedFinished.load());
+}
+
+TEST(ThreadPool, ReleaseWithRunningTask)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(1));
+
+    // first task is picked up by the only worker, the rest stays in queue and is dropped
+    std::atomic<bool> started(false);
+    std::atomic<uint32_t> counter(0);
+    pool.AddTask([&started, &counter]() {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        counter++;
+    });
+    for (uint32_t i = 0; i < THREAD_POOL_TEST_WORKERS; ++i)
+        pool.AddTask([&counter]() { counter++; });
+
+    while (!started)
+        std::this_thread::yield();
+
+    pool.Release();
+    EXPECT_EQ(1u, counter.load());
+
+    // running task was still counted properly, so waiting on a reinitialized pool works
+    ASSERT_TRUE(pool.Init(1));
+    pool.AddTask([&counter]() { counter++; });
+    pool.WaitForTasks();
+    EXPECT_EQ(2u, counter.load());
+}
+
+TEST(ThreadPool, WaitForGroupIgnoresTasksAddedByIt)
+{
+    ThreadPool pool;
+    ASSERT_TRUE(pool.Init(THREAD_POOL_TEST_WORKERS));
+
+    // emulates a Pipeline miss while recording - a chunk queues a long build and goes on,
+    // so waiting for recorded chunks must not wait for the build
+    std::atomic<bool> release(false);
+    std::atomic<bool> buildFinished(false);
+    std::atomic<uint32_t> chunks(0);
+    ThreadPoolTaskGroup group;
+    for (uint32_t c = 0; c < THREAD_POOL_TEST_WORKERS; ++c)
+    {
+        pool.AddTask([&pool, &release, &buildFinished, &chunks, c]() {
+            if (c == 0)
+            {
+                pool.AddTask([&release, &buildFinished]() {
+                    while (!release)
+                        std::this_thread::yield();
+                    buildFinished = true;
+                });
+            }
+
+            chunks++;
+        }, &group);
+    }
+
+    pool.WaitForTasks(group);
+    EXPECT_EQ(THREAD_POOL_TEST_WORKERS, chunks.load());
+    EXPECT_FALSE(buildFinished.load());
+
+    release = true;
+    pool.WaitForTasks();
+    EXPECT_TRUE(buildFinished.load());
+}
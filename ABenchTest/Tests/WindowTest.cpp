@@ -169,3 +169,30 @@ TEST(Window, OnCloseCallback)
     w.Close();
     EXPECT_TRUE(w.OnCloseCalled());
 }
+
+TEST(Window, OpenHeadless)
+{
+    // headless window needs no platform connection, so Init() is not required
+    Window w;
+    EXPECT_TRUE(w.OpenHeadless(TEST_WINDOW_WIDTH, TEST_WINDOW_HEIGHT));
+    EXPECT_TRUE(w.IsOpen());
+    EXPECT_EQ(TEST_WINDOW_WIDTH, w.GetWidth());
+    EXPECT_EQ(TEST_WINDOW_HEIGHT, w.GetHeight());
+
+    // already opened
+    EXPECT_FALSE(w.OpenHeadless(TEST_WINDOW_WIDTH, TEST_WINDOW_HEIGHT));
+}
+
+TEST(Window, HeadlessCallbacks)
+{
+    CallbackTestWindow w;
+    EXPECT_TRUE(w.OpenHeadless(TEST_WINDOW_WIDTH, TEST_WINDOW_HEIGHT));
+    EXPECT_TRUE(w.OnOpenCalled());
+
+    w.Update(TEST_WINDOW_UPDATE_DELTA_TIME);
+    EXPECT_TRUE(w.OnUpdateCalled());
+
+    w.Close();
+    EXPECT_TRUE(w.OnCloseCalled());
+    EXPECT_FALSE(w.IsOpen());
+}
@@ -4,10 +4,10 @@ layout (early_fragment_tests) in;
 layout (location = 0) in vec3 VertNorm;
 layout (location = 1) in vec2 VertUV;
 layout (location = 2) in vec3 VertPosWorld;
-#if HAS_NORMAL == 1
+#if HAS_NORMAL == 1 || BINDLESS == 1
 layout (location = 3) in vec3 VertTang;
 layout (location = 4) in vec3 VertBitang;
-#endif // HAS_NORMAL == 1
+#endif // HAS_NORMAL == 1 || BINDLESS == 1
 
 layout (location = 0) out vec4 color;
 
@@ -28,12 +28,24 @@ struct GridLight
 };
 
 
+// must match LightCullingMode enum in LightCullingReference.hpp
+#define LIGHT_CULLING_TILED 0
+#define LIGHT_CULLING_CLUSTERED 1
+
+
 // Set numbering starts from 1 because Set binding slots are common with VS
 // light-related buffers
 layout (set = 1, binding = 0) uniform _lightParams
 {
     uvec2 viewport;
     uint pixelsPerViewFrustum;
+    uint cullingMode;
+    uvec3 clusterCount;
+    uint pixelsPerCluster;
+    float nearZ;
+    float farZ;
+    float sliceScale; // slices are exponential, see ClusterGrid class
+    float sliceBias;
 } lightParams;
 
 layout (set = 1, binding = 1) uniform _materialParams
@@ -57,16 +69,58 @@ layout (set = 1, binding = 4) buffer _gridLightData
 } gridBuffer;
 
 
+#if BINDLESS == 1
+// all material textures and parameters, selected per draw by materialIndex
+// must match BINDLESS_TEXTURE_LIMIT in ForwardPass.cpp
+#define BINDLESS_TEXTURE_LIMIT 256
+#define MATERIAL_HAS_NORMAL 0x1
+#define MATERIAL_HAS_MASK 0x2
+
+struct MaterialData
+{
+    vec4 color;
+    uint diffuse;
+    uint normal;
+    uint mask;
+    uint flags;
+};
+
+layout (set = 2, binding = 0) uniform sampler2D textures[BINDLESS_TEXTURE_LIMIT];
+layout (set = 2, binding = 1) buffer _materials
+{
+    MaterialData data[];
+} materials;
+
+// first four bytes hold vertex shader's transformIndex
+layout (push_constant) uniform _drawParams
+{
+    layout (offset = 4) uint materialIndex;
+} drawParams;
+#else // BINDLESS == 1
 // texture uniforms
 layout (set = 2, binding = 0) uniform sampler2D diffTex;
 layout (set = 3, binding = 0) uniform sampler2D normTex;
 layout (set = 4, binding = 0) uniform sampler2D maskTex;
+#endif // BINDLESS == 1
 
 vec4 lightAmbient = vec4(0.2, 0.2, 0.2, 1.0);
 
 
 void main()
 {
+#if BINDLESS == 1
+    // materialIndex comes from a push constant, so indexing is dynamically uniform
+    MaterialData material = materials.data[drawParams.materialIndex];
+    bool hasNormal = (material.flags & MATERIAL_HAS_NORMAL) != 0;
+
+    if ((material.flags & MATERIAL_HAS_MASK) != 0)
+    {
+        float mask = texture(textures[material.mask], VertUV).r;
+        if (mask < 0.5)
+            discard;
+    }
+#endif // BINDLESS == 1
+
 #if HAS_COLOR_MASK == 1
     float mask = texture(maskTex, VertUV).r;
     if (mask.r < 0.5)
@@ -75,14 +129,33 @@ void main()
 
     color = lightAmbient;
 
-    uvec2 gridCoords = uvec2(gl_FragCoord.x / lightParams.pixelsPerViewFrustum,
-                             gl_FragCoord.y / lightParams.pixelsPerViewFrustum);
-    uint gridID = gridCoords.y * (lightParams.viewport.x / lightParams.pixelsPerViewFrustum)
-                + gridCoords.x;
+    uint gridID;
+    if (lightParams.cullingMode == LIGHT_CULLING_CLUSTERED)
+    {
+        uvec3 clusterCoords;
+        clusterCoords.xy = uvec2(gl_FragCoord.xy) / lightParams.pixelsPerCluster;
+
+        // reverse depth mapping of the projection matrix to get view-space distance
+        float viewDepth = lightParams.nearZ * lightParams.farZ /
+                          (lightParams.farZ + gl_FragCoord.z * (lightParams.nearZ - lightParams.farZ));
+        float slice = floor(log(viewDepth) * lightParams.sliceScale - lightParams.sliceBias);
+        clusterCoords.z = uint(clamp(slice, 0.0f, float(lightParams.clusterCount.z - 1)));
+
+        gridID = (clusterCoords.z * lightParams.clusterCount.y + clusterCoords.y) * lightParams.clusterCount.x
+               + clusterCoords.x;
+    }
+    else
+    {
+        uvec2 gridCoords = uvec2(gl_FragCoord.x / lightParams.pixelsPerViewFrustum,
+                                 gl_FragCoord.y / lightParams.pixelsPerViewFrustum);
+        // partially covered tiles at the right edge also have their grid entries
+        uint gridWidth = (lightParams.viewport.x + lightParams.pixelsPerViewFrustum - 1) / lightParams.pixelsPerViewFrustum;
+        gridID = gridCoords.y * gridWidth + gridCoords.x;
+    }
 
-    #if HAS_NORMAL == 1
+    #if HAS_NORMAL == 1 || BINDLESS == 1
         mat3 TBN = transpose(mat3(VertTang, VertBitang, VertNorm));
-    #endif // HAS_NORMAL == 1
+    #endif // HAS_NORMAL == 1 || BINDLESS == 1
 
     for (uint i = 0; i < gridBuffer.data[gridID].count; ++i)
     {
@@ -91,7 +164,21 @@ void main()
         vec3 lightDir = curLight.pos.xyz - VertPosWorld;
         float distance = length(lightDir);
 
-        #if HAS_NORMAL == 1
+        #if BINDLESS == 1
+            float coeff;
+            if (hasNormal)
+            {
+                lightDir = TBN * normalize(lightDir);
+                vec3 texNorm = normalize(texture(textures[material.normal], VertUV).rgb * 2.0 - 1.0);
+                texNorm.y = -texNorm.y;
+                coeff = dot(lightDir, texNorm);
+            }
+            else
+            {
+                lightDir = normalize(lightDir);
+                coeff = dot(lightDir, VertNorm);
+            }
+        #elif HAS_NORMAL == 1
             lightDir = TBN * normalize(lightDir);
             vec3 texNorm = normalize(texture(normTex, VertUV).rgb * 2.0 - 1.0);
             texNorm.y = -texNorm.y;
@@ -112,9 +199,15 @@ void main()
         color += vec4(curLight.diffuse * coeff * att, 1.0f);
     }
 
+#if BINDLESS == 1
+    // materials without diffuse texture point to a white default texture
+    color *= material.color;
+    color *= texture(textures[material.diffuse], VertUV);
+#else // BINDLESS == 1
     color *= materialParams.color;
 
 #if HAS_TEXTURE == 1
     color *= texture(diffTex, VertUV);
 #endif // HAS_TEXTURE == 1
+#endif // BINDLESS == 1
 }
@@ -12,10 +12,23 @@ layout (location = 4) out vec3 VertBitang;
 #endif // HAS_NORMAL == 1
 
 
+#if BINDLESS == 1
+// world matrices of all drawn models, selected per draw by transformIndex
+layout (set = 0, binding = 2) readonly buffer _transforms
+{
+    mat4 worldMatrices[];
+} transforms;
+
+layout (push_constant) uniform _drawParams
+{
+    uint transformIndex;
+} drawParams;
+#else // BINDLESS == 1
 layout (set = 0, binding = 0) uniform dynamicCb
 {
     mat4 worldMatrix;
 } dynamicCBuffer;
+#endif // BINDLESS == 1
 
 layout (set = 0, binding = 1) uniform cb
 {
@@ -31,17 +44,23 @@ out gl_PerVertex
 
 void main()
 {
-    mat4 worldView = CBuffer.viewMatrix * dynamicCBuffer.worldMatrix;
+#if BINDLESS == 1
+    mat4 worldMatrix = transforms.worldMatrices[drawParams.transformIndex];
+#else // BINDLESS == 1
+    mat4 worldMatrix = dynamicCBuffer.worldMatrix;
+#endif // BINDLESS == 1
+
+    mat4 worldView = CBuffer.viewMatrix * worldMatrix;
     mat4 worldViewProj = CBuffer.projMatrix * worldView;
 
-    VertNorm = normalize(mat3(dynamicCBuffer.worldMatrix) * InNorm);
+    VertNorm = normalize(mat3(worldMatrix) * InNorm);
     VertUV = InUV;
     gl_Position = worldViewProj * vec4(InPos, 1.0);
 
-    VertPosWorld = mat3(dynamicCBuffer.worldMatrix) * InPos;
+    VertPosWorld = mat3(worldMatrix) * InPos;
 
 #if HAS_NORMAL == 1
-    VertTang = normalize(mat3(dynamicCBuffer.worldMatrix) * InTangent);
-    VertBitang = normalize(mat3(dynamicCBuffer.worldMatrix) * cross(VertTang, VertNorm));
+    VertTang = normalize(mat3(worldMatrix) * InTangent);
+    VertBitang = normalize(mat3(worldMatrix) * cross(VertTang, VertNorm));
 #endif // HAS_NORMAL == 1
 }
@@ -0,0 +1,69 @@
+# Compares ABenchPerf results against a stored baseline and reports slowdowns.
+#
+# HOW TO USE:
+#   Store a baseline by keeping results of a run on a known-good revision:
+#     ABenchPerf --out=baseline.json
+#   After a change, run ABenchPerf again on the same machine and compare:
+#     python3 perf_compare.py baseline.json abench_perf.json [--threshold 0.05]
+#
+# A case is reported as a regression when its median got slower by more than the threshold
+# (relative, 0.05 = 5%) and confidence intervals of both runs do not overlap, so that noise alone
+# does not fail the comparison. Exit code is 1 if any regression was found.
+
+import argparse
+import json
+import sys
+
+
+def load_results(path):
+    with open(path) as f:
+        data = json.load(f)
+
+    return { r['name']: r for r in data['results'] if not r['skipped'] }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare ABenchPerf results against a baseline')
+    parser.add_argument('baseline', help='JSON results of the baseline run')
+    parser.add_argument('current', help='JSON results of the run to check')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='allowed relative slowdown of median time (default: 0.05)')
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    current = load_results(args.current)
+
+    regressions = 0
+    print('{:<48} {:>14} {:>14} {:>9}'.format('Case', 'Baseline [ns]', 'Current [ns]', 'Change'))
+    for name in sorted(baseline.keys() | current.keys()):
+        if name not in current:
+            print('{:<48} {:>14.3f} {:>14} {:>9}'.format(name, baseline[name]['median'], '-', 'MISSING'))
+            continue
+        if name not in baseline:
+            print('{:<48} {:>14} {:>14.3f} {:>9}'.format(name, '-', current[name]['median'], 'NEW'))
+            continue
+
+        base = baseline[name]
+        cur = current[name]
+        change = (cur['median'] - base['median']) / base['median'] if base['median'] > 0.0 else 0.0
+
+        status = ''
+        if change > args.threshold and cur['ci95'][0] > base['ci95'][1]:
+            status = '  <-- REGRESSION'
+            regressions += 1
+        elif change < -args.threshold and cur['ci95'][1] < base['ci95'][0]:
+            status = '  (improved)'
+
+        print('{:<48} {:>14.3f} {:>14.3f} {:>+8.1f}%{}'.format(name, base['median'], cur['median'],
+                                                            change * 100.0, status))
+
+    if regressions > 0:
+        print('{} case(s) regressed by more than {:.1f}%'.format(regressions, args.threshold * 100.0))
+        return 1
+
+    print('No regressions above {:.1f}%'.format(args.threshold * 100.0))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())